@@ -0,0 +1,155 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+export LC_ALL=C
+
+# For reproducible corpora and output
+export SOURCE_DATE_EPOCH=609165296
+
+cd "$(dirname "$0")"
+
+usage() {
+	echo "Runs performance benchmarks on RGBDS, printing one CSV line per benchmark:"
+	echo "    name,tool,wall_seconds,peak_rss_kib,throughput,unit"
+	echo "Options:"
+	echo "    -h, --help      show this help message"
+	echo "Environment:"
+	echo "    RGBDS           directory containing the binaries to benchmark (default: ..)"
+	echo "    BENCH_SCALE     corpus size multiplier (default: 1)"
+}
+
+while [[ $# -gt 0 ]]; do
+	case "$1" in
+		-h|--help)
+			usage
+			exit 0
+			;;
+		*)
+			usage
+			exit 1
+			;;
+	esac
+done
+
+RGBDS="${RGBDS:-..}"
+RGBASM="$RGBDS/rgbasm"
+RGBLINK="$RGBDS/rgblink"
+RGBGFX="$RGBDS/rgbgfx"
+SCALE="${BENCH_SCALE:-1}"
+
+corpus="$(mktemp -d)"
+trap 'rm -rf "$corpus"' EXIT
+
+# Figure out how to measure wall time and peak RSS; fall back to wall time only
+timestyle=none
+if /usr/bin/time -f '%e %M' true >/dev/null 2>&1; then
+	timestyle=gnu # Linux: %e = wall seconds, %M = peak RSS in KiB
+elif /usr/bin/time -l true >/dev/null 2>&1; then
+	timestyle=bsd # macOS: "-l" reports the peak RSS in bytes
+fi
+
+# measure <name> <tool> <throughput> <unit> <command...>
+measure() {
+	local name="$1" tool="$2" throughput="$3" unit="$4"
+	shift 4
+	local wall rss
+	case "$timestyle" in
+	gnu)
+		/usr/bin/time -f '%e %M' -o "$corpus/time.out" "$@" >/dev/null
+		read -r wall rss < "$corpus/time.out"
+		;;
+	bsd)
+		/usr/bin/time -l "$@" >/dev/null 2> "$corpus/time.out"
+		wall="$(awk 'NR == 1 { print $1 }' "$corpus/time.out")"
+		rss="$(awk '/maximum resident set size/ { print int($1 / 1024) }' "$corpus/time.out")"
+		;;
+	none)
+		local begin end
+		begin="$(date +%s%N)"
+		"$@" >/dev/null
+		end="$(date +%s%N)"
+		wall="$(awk -v b="$begin" -v e="$end" 'BEGIN { printf "%.2f", (e - b) / 1e9 }')"
+		rss=
+		;;
+	esac
+	echo "$name,$tool,$wall,$rss,$throughput,$unit"
+	echo "$name: ${wall}s, ${rss:-?} KiB peak RSS ($throughput $unit)" >&2
+}
+
+# --- rgbasm: macro-heavy assembly ---
+
+nb_macros=$((100000 * SCALE))
+{
+	echo 'DEF V = 0'
+	echo 'MACRO accum'
+	echo '	DEF V = V + (\1) ** 2 % 7 - (\2)'
+	echo 'ENDM'
+	echo "FOR I, $nb_macros"
+	echo '	accum I, I / 2'
+	echo 'ENDR'
+} > "$corpus/macros.asm"
+measure asm-macros rgbasm "$nb_macros" "invocations" \
+	"$RGBASM" -o /dev/null "$corpus/macros.asm"
+
+# --- rgbasm: charmap-heavy text ---
+
+nb_strings=$((400 * SCALE))
+{
+	for c in {A..Z} {a..z}; do
+		echo "charmap \"$c\", $(printf '%d' "'$c")"
+	done
+	echo 'charmap "th", 1'
+	echo 'charmap "qu", 2'
+	echo "FOR S, $SCALE * 40"
+	echo 'SECTION "text{d:S}", ROMX'
+	echo "	REPT $nb_strings"
+	echo '		db "theQuickBrownFoxJumpsOverTheLazyDog"'
+	echo '	ENDR'
+	echo 'ENDR'
+} > "$corpus/charmap.asm"
+measure asm-charmap rgbasm "$((nb_strings * SCALE * 40))" "strings" \
+	"$RGBASM" -o /dev/null "$corpus/charmap.asm"
+
+# --- rgbasm: huge db tables ---
+
+nb_rows=$((4000 * SCALE))
+awk -v rows="$nb_rows" 'BEGIN {
+	for (i = 0; i < rows; ++i) {
+		if (i % 500 == 0) {
+			printf "SECTION \"table%d\", ROMX\n", i / 500
+		}
+		printf "\tdb"
+		for (j = 0; j < 16; ++j) {
+			printf "%s $%02x", j ? "," : "", (i * 16 + j) % 256
+		}
+		printf "\n"
+	}
+}' > "$corpus/dbtable.asm"
+measure asm-dbtable rgbasm "$((nb_rows * 16))" "bytes" \
+	"$RGBASM" -o /dev/null "$corpus/dbtable.asm"
+
+# --- rgblink: many small objects with cross-references ---
+
+nb_objects=$((200 * SCALE))
+for ((i = 0; i < nb_objects; ++i)); do
+	{
+		echo "SECTION \"code$i\", ROMX"
+		echo "Label$i::"
+		echo "	dw Label$(((i + 1) % nb_objects))"
+		echo '	REPT 64'
+		echo "		dw Label$(((i + 7) % nb_objects))"
+		echo '	ENDR'
+	} > "$corpus/obj$i.asm"
+	"$RGBASM" -o "$corpus/obj$i.o" "$corpus/obj$i.asm"
+done
+measure link-objects rgblink "$nb_objects" "objects" \
+	"$RGBLINK" -o "$corpus/linked.gb" "$corpus"/obj*.o
+
+# --- rgbgfx: large PNG ---
+
+nb_tiles=$((16384 * SCALE))
+head -c "$((nb_tiles * 16))" /dev/urandom > "$corpus/big.2bpp"
+# Reconstruct a PNG from the tile data, then benchmark converting it back
+"$RGBGFX" -r 128 -o "$corpus/big.2bpp" "$corpus/big.png"
+measure gfx-large-png rgbgfx "$nb_tiles" "tiles" \
+	"$RGBGFX" -O -o /dev/null "$corpus/big.png"
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_ARENA_HPP
+#define RGBDS_ARENA_HPP
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "helpers.hpp" // assume
+
+// Small shared allocators for subsystems that churn through many short-lived or
+// uniformly-typed buffers. `BumpArena` hands out raw bytes with no per-allocation
+// bookkeeping and frees everything wholesale; `RecyclePool` recycles values of one type
+// through a free list. Both expose counters so adopters can report high-water marks
+// through `--mem-stats`.
+
+class BumpArena {
+	static constexpr size_t DEFAULT_CHUNK_SIZE = 65536;
+
+	std::vector<std::unique_ptr<char[]>> chunks;
+	size_t chunkSize;
+	size_t capacity = 0; // Size of the newest chunk
+	size_t offset = 0;   // Cursor into the newest chunk
+	size_t liveBytes = 0;
+	size_t peakBytes_ = 0;
+
+public:
+	explicit BumpArena(size_t chunkSize_ = DEFAULT_CHUNK_SIZE) : chunkSize(chunkSize_) {}
+
+	void *alloc(size_t size, size_t align = alignof(max_align_t)) {
+		// `make_unique<char[]>` only guarantees the default `new` alignment
+		assume(align != 0 && (align & (align - 1)) == 0 && align <= alignof(max_align_t));
+
+		size_t aligned = (offset + align - 1) & ~(align - 1);
+		if (aligned + size > capacity || chunks.empty()) {
+			// Allocations larger than the chunk size get a dedicated chunk
+			capacity = size > chunkSize ? size : chunkSize;
+			chunks.push_back(std::make_unique<char[]>(capacity));
+			aligned = 0;
+		}
+		offset = aligned + size;
+
+		liveBytes += size;
+		if (liveBytes > peakBytes_) {
+			peakBytes_ = liveBytes;
+		}
+		return &chunks.back()[aligned];
+	}
+
+	template<typename T>
+	T *allocArray(size_t count) {
+		return static_cast<T *>(alloc(count * sizeof(T), alignof(T)));
+	}
+
+	// Frees every allocation made so far at once. No destructors are run, so only use the
+	// arena for trivially-destructible contents!
+	void reset() {
+		chunks.clear();
+		capacity = 0;
+		offset = 0;
+		liveBytes = 0;
+	}
+
+	size_t allocatedBytes() const { return liveBytes; }
+	size_t peakBytes() const { return peakBytes_; }
+};
+
+// `acquire` pops a previously-recycled value (or default-constructs one when the free list
+// is empty), and `recycle` stores a no-longer-needed value for later reuse. The free list's
+// size is bounded by the maximum number of simultaneously live values.
+template<typename T>
+class RecyclePool {
+	std::vector<T> spares;
+	uint64_t nbAcquired_ = 0;
+	uint64_t nbReused_ = 0;
+
+public:
+	T acquire() {
+		++nbAcquired_;
+		if (spares.empty()) {
+			return T();
+		}
+		++nbReused_;
+		T value = std::move(spares.back());
+		spares.pop_back();
+		return value;
+	}
+
+	void recycle(T &&value) { spares.push_back(std::move(value)); }
+
+	uint64_t nbAcquired() const { return nbAcquired_; }
+	uint64_t nbReused() const { return nbReused_; }
+	size_t nbSpares() const { return spares.size(); }
+};
+
+#endif // RGBDS_ARENA_HPP
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_ASM_CACHE_HPP
+#define RGBDS_ASM_CACHE_HPP
+
+#include <optional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Records the serialized command-line options, which are part of the cache key
+void cache_Init(std::string const &optionsKey);
+
+// Hashes a buffer with the same function the cache applies to file contents
+uint64_t cache_HashContents(void const *data, size_t size);
+
+// Returns the serialized pre-lexed token stream cached for this content hash, if any
+std::optional<std::vector<uint8_t>> cache_LoadTokenStream(uint64_t contentHash);
+
+// Stores a serialized pre-lexed token stream under this content hash
+void cache_StoreTokenStream(uint64_t contentHash, std::vector<uint8_t> const &contents);
+
+// Records that a timestamp built-in (`__ISO_8601_*__`, `__UTC_*__`, ...) was used, which
+// makes the object being assembled unfit for caching
+void cache_MarkTimestampUse();
+
+// Returns whether the cache held an object for this input whose whole input closure is
+// unchanged, and replayed it to the output object file
+bool cache_TryReplay(std::string const &mainFileName);
+
+// Stores the object file that was just produced, along with its input closure's hashes
+void cache_Store(std::string const &mainFileName);
+
+#endif // RGBDS_ASM_CACHE_HPP
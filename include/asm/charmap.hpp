@@ -21,6 +21,7 @@ void charmap_Set(std::string const &name);
 void charmap_Push();
 void charmap_Pop();
 void charmap_CheckStack();
+void charmap_Reset();
 void charmap_Add(std::string const &mapping, std::vector<int32_t> &&value);
 bool charmap_HasChar(std::string const &mapping);
 size_t charmap_CharSize(std::string const &mapping);
@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_ASM_CONTEXT_HPP
+#define RGBDS_ASM_CONTEXT_HPP
+
+#include <time.h>
+
+// rgbasm historically assembles exactly one file per process, so per-assembly state lives
+// in statics spread across the modules. `ctx_ResetAssembly` returns all of it to a
+// pristine state and re-creates the built-in symbols, so independent assemblies can run
+// back-to-back in one process (e.g. when embedding the assembler). Process-level
+// configuration — parsed options, include paths, and warning flags — is left untouched.
+//
+// Note that this provides sequential reuse, not concurrent reentrancy: the state is still
+// global, merely resettable.
+void ctx_ResetAssembly(time_t now);
+
+#endif // RGBDS_ASM_CONTEXT_HPP
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -34,6 +35,10 @@ struct FileStackNode {
 	// Set only if referenced: ID within the object file, `UINT32_MAX` if not output yet
 	uint32_t ID = UINT32_MAX;
 
+	// Expanded backtrace, cached for repeated diagnostics from the same context; only the
+	// last entry's line number varies between them (`mutable` since printing is `const`)
+	mutable std::vector<std::pair<std::string, uint32_t>> traceCache{};
+
 	// REPT iteration counts since last named node, in reverse depth order
 	std::vector<uint32_t> &iters() { return std::get<std::vector<uint32_t>>(data); }
 	std::vector<uint32_t> const &iters() const { return std::get<std::vector<uint32_t>>(data); }
@@ -63,6 +68,7 @@ MacroArgs *fstk_GetCurrentMacroArgs();
 void fstk_AddIncludePath(std::string const &path);
 void fstk_AddPreIncludeFile(std::string const &path);
 std::optional<std::string> fstk_FindFile(std::string const &path);
+std::vector<std::string> const &fstk_OpenedFiles();
 bool fstk_FileError(std::string const &path, char const *functionName);
 bool fstk_FailedOnMissingInclude();
 
@@ -84,6 +90,9 @@ void fstk_RunFor(
 bool fstk_Break();
 
 void fstk_NewRecursionDepth(size_t newDepth);
+void fstk_Reset();
 void fstk_Init(std::string const &mainPath);
+// Like `fstk_Init`, but the main input is an in-memory buffer; used by the embedding API
+void fstk_InitBuffer(std::string const &name, ContentSpan const &span);
 
 #endif // RGBDS_ASM_FSTACK_HPP
@@ -16,7 +16,9 @@
 
 // This value is a compromise between `LexerState` allocation performance when reading the entire
 // file works, and buffering performance when it doesn't (e.g. when piping a file into RGBASM).
-static constexpr size_t LEXER_BUF_SIZE = 64;
+// It needs to be large enough that a producer piping code into us can make progress while we lex
+// what was already buffered, instead of ping-ponging one tiny `read()` at a time.
+static constexpr size_t LEXER_BUF_SIZE = 8192;
 // The buffer needs to be large enough for the maximum `lexerState->peek()` lookahead distance
 static_assert(LEXER_BUF_SIZE > 1, "Lexer buffer size is too small");
 // This caps the size of buffer reads, and according to POSIX, passing more than SSIZE_MAX is UB
@@ -57,6 +59,22 @@ struct ViewedContent {
 	}
 };
 
+// Captured text (macro and `REPT` bodies that cannot alias the file buffer) accumulates
+// into chained fixed-size slabs, so streaming in a large body never reallocates and copies
+// what was already captured; the slabs themselves are recycled across captures.
+struct CaptureSlabs {
+	static constexpr size_t SLAB_SIZE = 8192;
+
+	std::vector<std::unique_ptr<char[]>> slabs;
+	size_t offset = SLAB_SIZE; // Cursor into the newest slab
+
+	~CaptureSlabs(); // Returns the slabs to the pool
+
+	void append(char c);
+	// Copies the first `size` captured chars into one contiguous buffer
+	std::shared_ptr<char[]> flatten(size_t size) const;
+};
+
 struct BufferedContent {
 	int fd;                        // File from which to read chars
 	char buf[LEXER_BUF_SIZE] = {}; // Circular buffer of chars
@@ -78,6 +96,10 @@ struct IfStackEntry {
 	bool reachedElseBlock; // Whether an ELSE block ran already
 };
 
+// Defined in lexer.cpp; caches the token stream lexed from a `ContentSpan` (e.g. a macro
+// body) so later invocations can replay the tokens instead of re-lexing the characters
+struct TokenStream;
+
 struct LexerState {
 	std::string path;
 
@@ -91,7 +113,7 @@ struct LexerState {
 
 	bool capturing;     // Whether the text being lexed should be captured
 	size_t captureSize; // Amount of text captured
-	std::shared_ptr<std::vector<char>> captureBuf; // Buffer to send the captured text to if set
+	std::unique_ptr<CaptureSlabs> captureSlabs; // Slabs to send the captured text to if set
 
 	bool disableExpansions;
 	size_t expansionScanDistance; // Max distance already scanned for expansions
@@ -100,18 +122,26 @@ struct LexerState {
 
 	std::variant<std::monostate, ViewedContent, BufferedContent> content;
 
+	// Set when `content` is a view whose token stream is being recorded (`replayIndex` is
+	// then `SIZE_MAX`) or replayed (`replayIndex` is the next token to replay)
+	std::shared_ptr<TokenStream> tokenStream;
+	size_t replayIndex;
+	bool replaySuspended; // Replay fell back to char lexing until positions re-converge
+
+	// The destructor below suppresses the implicit move operations, which `Context`
+	// construction relies on (and which `captureSlabs` makes move-only)
+	LexerState() = default;
+	LexerState(LexerState &&) = default;
+	LexerState &operator=(LexerState &&) = default;
 	~LexerState();
 
 	int peekChar();
 	int peekCharAhead();
 
-	std::shared_ptr<char[]> makeSharedCaptureBufPtr() const {
-		return std::shared_ptr<char[]>(captureBuf, captureBuf->data());
-	}
-
 	void setAsCurrentState();
 	void setFileAsNextState(std::string const &filePath, bool updateStateNow);
 	void setViewAsNextState(char const *name, ContentSpan const &span, uint32_t lineNo_);
+	void setBufferAsNextState(std::string const &name, ContentSpan const &span);
 
 	void clear(uint32_t lineNo_);
 };
@@ -135,6 +165,10 @@ void lexer_ReachELSEBlock();
 void lexer_CheckRecursionDepth();
 uint32_t lexer_GetLineNo();
 void lexer_TraceStringExpansions();
+void lexer_Reset();
+
+// Cumulative bytes of source content mapped, read, or captured (reported by `--mem-stats`)
+uint64_t lexer_CountBufferedBytes();
 
 struct Capture {
 	uint32_t lineNo;
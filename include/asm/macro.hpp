@@ -3,20 +3,22 @@
 #ifndef RGBDS_ASM_MACRO_HPP
 #define RGBDS_ASM_MACRO_HPP
 
+#include <deque>
 #include <memory>
 #include <stdint.h>
 #include <string>
-#include <vector>
 
-struct MacroArgs {
+// Arguments are stored directly in a per-invocation deque; its stable storage lets
+// `getArg` hand out views into it instead of heap-allocating each argument separately.
+struct MacroArgs : std::enable_shared_from_this<MacroArgs> {
 	uint32_t shift;
-	std::vector<std::shared_ptr<std::string>> args;
+	std::deque<std::string> args;
 
 	uint32_t nbArgs() const { return args.size() - shift; }
-	std::shared_ptr<std::string> getArg(int32_t i) const;
+	std::shared_ptr<std::string> getArg(int32_t i);
 	std::shared_ptr<std::string> getAllArgs() const;
 
-	void appendArg(std::shared_ptr<std::string> arg);
+	void appendArg(std::string &&arg);
 	void shiftArgs(int32_t count);
 };
 
@@ -15,6 +15,7 @@ enum MissingInclude {
 
 struct Options {
 	bool exportAll = false;                         // -E
+	bool exportFiltered = false;                    // -x
 	uint8_t fixPrecision = 16;                      // -Q
 	size_t maxRecursionDepth = 64;                  // -r
 	char binDigits[2] = {'0', '1'};                 // -b
@@ -24,8 +25,13 @@ struct Options {
 	MissingInclude missingIncludeState = INC_ERROR; // -MC, -MG
 	bool generatePhonyDeps = false;                 // -MP
 	std::string objectFileName;                     // -o
+	bool objectV2 = false;                          // --obj-v2
+	bool objectCompress = false;                    // --obj-compress (implies `--obj-v2`)
+	std::string cacheDir;                           // --cache
+	bool profile = false;                           // --profile
 	uint8_t padByte = 0;                            // -p
 	uint64_t maxErrors = 0;                         // -X
+	bool dedupDiagnostics = false;                  // --dedup-diagnostics
 
 	~Options() {
 		if (dependFile) {
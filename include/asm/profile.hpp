@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_ASM_PROFILE_HPP
+#define RGBDS_ASM_PROFILE_HPP
+
+#include <stdint.h>
+
+// Wall-clock phases reported by `--profile`. rgbasm is single-pass, so lexing, parsing,
+// expansion, and section emission all happen inside the assembly pass; the event counters
+// below break that pass down where separate timers would be too intrusive.
+enum ProfilePhase {
+	PROFILE_PASS,      // The whole assembly pass (lexing, parsing, emission)
+	PROFILE_OBJ_WRITE, // Object file write-out
+	NB_PROFILE_PHASES
+};
+
+enum ProfileCounter {
+	PROFILE_TOKENS,     // Tokens handed to the parser (including replayed ones)
+	PROFILE_EXPANSIONS, // Macro arg, `EQUS`, and interpolation expansions begun
+	PROFILE_MACROS,     // Macro invocations
+	PROFILE_LOOPS,      // `REPT`/`FOR` blocks entered
+	PROFILE_SECTIONS,   // Sections created
+	PROFILE_PATCHES,    // Patches emitted
+	PROFILE_SYMBOLS,    // Symbols created
+	NB_PROFILE_COUNTERS
+};
+
+extern uint64_t profileCounters[NB_PROFILE_COUNTERS];
+
+// Counting is a single increment, cheap enough to stay unconditional; only the report is
+// gated on `--profile`
+inline void profile_Count(ProfileCounter counter) {
+	++profileCounters[counter];
+}
+
+void profile_BeginPhase(ProfilePhase phase);
+void profile_EndPhase(ProfilePhase phase);
+
+// Prints the timing/counter report to standard error if `--profile` was given
+void profile_Report();
+
+// Zeroes the counters and phase times, for a fresh assembly
+void profile_Reset();
+
+#endif // RGBDS_ASM_PROFILE_HPP
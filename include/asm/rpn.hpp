@@ -21,6 +21,16 @@ struct Expression {
 	bool isSymbol = false; // Whether the expression represents a symbol suitable for const diffing
 	std::vector<uint8_t> rpn{}; // Bytes serializing the RPN expression
 	uint32_t rpnPatchSize = 0;  // Size the expression will take in the object file
+	// Whether `rpn` ends with `RPN_CONST <v>; RPN_ADD`; this lets further constant
+	// additions and subtractions fold into that trailing constant in place
+	bool hasConstAddTail = false;
+
+	Expression() = default;
+	Expression(Expression const &) = default;
+	Expression(Expression &&) = default;
+	Expression &operator=(Expression const &) = default;
+	Expression &operator=(Expression &&) = default;
+	~Expression(); // Recycles the `rpn` buffer (see `spareRpnBuffers` in rpn.cpp)
 
 	bool isKnown() const { return std::holds_alternative<int32_t>(data); }
 	int32_t value() const { return std::get<int32_t>(data); }
@@ -48,10 +58,14 @@ struct Expression {
 
 private:
 	void clear();
+	int32_t constAddTailValue() const;
 	uint8_t *reserveSpace(uint32_t size);
 	uint8_t *reserveSpace(uint32_t size, uint32_t patchSize);
 };
 
 bool checkNBit(int32_t v, uint8_t n, char const *name);
 
+// How many RPN buffers were recycled through the expression pool (reported by `--mem-stats`)
+uint64_t rpn_CountBufferReuses();
+
 #endif // RGBDS_ASM_RPN_HPP
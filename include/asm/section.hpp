@@ -38,11 +38,14 @@ struct Section {
 	uint32_t bank;
 	uint8_t align; // Exactly as specified in `ALIGN[]`
 	uint16_t alignOfs;
-	std::deque<Patch> patches;
+	// Ranges of contiguous patches in the shared patch pool (`sect_PatchPool`), as
+	// `{first index, count}`; one span per run of patches created while this section was active
+	std::vector<std::pair<uint32_t, uint32_t>> patchSpans;
 	std::vector<uint8_t> data;
 
 	uint32_t getID() const; // ID of the section in the object file (`UINT32_MAX` if none)
 	bool isSizeKnown() const;
+	size_t countPatches() const;
 };
 
 struct SectionSpec {
@@ -52,6 +55,7 @@ struct SectionSpec {
 };
 
 size_t sect_CountSections();
+uint64_t sect_CountDataBytes(); // Bytes of section data storage (reported by `--mem-stats`)
 void sect_ForEach(void (*callback)(Section &));
 
 Section *sect_FindSectionByName(std::string const &name);
@@ -77,6 +81,7 @@ uint32_t sect_GetSymbolOffset();
 uint32_t sect_GetOutputOffset();
 std::optional<uint32_t> sect_GetOutputBank();
 
+std::deque<Patch> &sect_PatchPool();
 Patch *sect_AddOutputPatch();
 
 uint32_t sect_GetAlignBytes(uint8_t alignment, uint16_t offset);
@@ -90,9 +95,9 @@ void sect_EndUnion();
 void sect_CheckUnionClosed();
 
 void sect_ConstByte(uint8_t byte);
-void sect_ByteString(std::vector<int32_t> const &str);
-void sect_WordString(std::vector<int32_t> const &str);
-void sect_LongString(std::vector<int32_t> const &str);
+void sect_ByteString(std::string const &str);
+void sect_WordString(std::string const &str);
+void sect_LongString(std::string const &str);
 void sect_Skip(uint32_t skip, bool ds);
 void sect_RelByte(Expression const &expr, uint32_t pcShift);
 void sect_RelBytes(uint32_t n, std::vector<Expression> const &exprs);
@@ -106,6 +111,7 @@ void sect_EndSection();
 void sect_PushSection();
 void sect_PopSection();
 void sect_CheckStack();
+void sect_Reset();
 
 std::string sect_PushSectionFragmentLiteral();
 
@@ -4,6 +4,7 @@
 #define RGBDS_ASM_SYMBOL_HPP
 
 #include <memory>
+#include <stddef.h>
 #include <stdint.h>
 #include <string>
 #include <time.h>
@@ -27,6 +28,7 @@ bool sym_IsPC(Symbol const *sym); // Forward declaration for `getSection`
 
 struct Symbol {
 	std::string name;
+	uint32_t nameID; // Dense ID assigned when the name was interned (see `sym_InternName`)
 	SymbolType type;
 	bool isBuiltin;
 	bool isExported; // Not relevant for SYM_MACRO or SYM_EQUS
@@ -69,6 +71,15 @@ struct Symbol {
 };
 
 void sym_ForEach(void (*callback)(Symbol &));
+size_t sym_CountSymbols();
+
+// Intern a symbol name, assigning it a dense 32-bit ID on first sight; the same name always
+// maps to the same ID, which can be used to refer to the symbol without copying the name
+uint32_t sym_InternName(std::string const &symName);
+std::string const &sym_GetInternedName(uint32_t nameID);
+
+// Returns how many symbols have been purged so far (see `purgeCount`)
+uint64_t sym_PurgeCount();
 
 Symbol *sym_AddLocalLabel(std::string const &symName);
 Symbol *sym_AddLabel(std::string const &symName);
@@ -82,6 +93,7 @@ int32_t sym_GetRSValue();
 void sym_SetRSValue(int32_t value);
 // Find a symbol by exact name, bypassing expansion checks
 Symbol *sym_FindExactSymbol(std::string const &symName);
+Symbol *sym_FindSymbolByNameID(uint32_t nameID);
 // Find a symbol, possibly scoped, by name
 Symbol *sym_FindScopedSymbol(std::string const &symName);
 // Find a scoped symbol by name; do not return `@` or `_NARG` when they have no value
@@ -96,6 +108,7 @@ Symbol *sym_RedefString(std::string const &symName, std::shared_ptr<std::string>
 void sym_Purge(std::string const &symName);
 bool sym_IsPurgedExact(std::string const &symName);
 bool sym_IsPurgedScoped(std::string const &symName);
+void sym_Reset();
 void sym_Init(time_t now);
 
 // Functions to save and restore the current label scopes.
@@ -60,6 +60,20 @@ extern Diagnostics<WarningLevel, WarningID> warnings;
 [[gnu::format(printf, 2, 3)]]
 void warning(WarningID id, char const *fmt, ...);
 
+// Like `warning` above, except that the message body is printed to `stderr` by `callback`,
+// which is only invoked if the warning is visible. Use this when formatting the message
+// is expensive enough that it shouldn't be paid for disabled warnings.
+void warning(WarningID id, std::function<void()> callback);
+
+// Total number of diagnostics (errors and printed warnings) emitted so far.
+// This lets callers detect whether some operation emitted any.
+uint64_t warning_GetDiagnosticsCount();
+
+// With `--dedup-diagnostics`, prints a "repeated N more times" summary for each diagnostic
+// whose repeats were suppressed, and forgets the counts.
+void warning_PrintRepeatSummary();
+void warning_Reset();
+
 // Used for errors that compromise the whole assembly process by affecting the
 // following code, potencially making the assembler generate errors caused by
 // the first one and unrelated to the code that the assembler complains about.
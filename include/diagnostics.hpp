@@ -60,6 +60,11 @@ struct Diagnostics {
 	std::vector<ParamWarning<W>> paramWarnings;
 	DiagnosticsState<W> state;
 	uint64_t nbErrors;
+	// The behavior of each warning flag is flattened into this cache, so that the hot
+	// "is this warning enabled" check is a single indexed load; it is rebuilt lazily
+	// whenever the warning state changes (`mutable` since reads are logically `const`)
+	mutable WarningBehavior behaviors[W::NB_WARNINGS];
+	mutable bool behaviorsCached = false;
 
 	void incrementErrors() {
 		if (nbErrors != UINT64_MAX) {
@@ -67,12 +72,25 @@ struct Diagnostics {
 		}
 	}
 
-	WarningBehavior getWarningBehavior(W id) const;
+	// Must be called whenever `state` is modified other than via `processWarningFlag`
+	void flushWarningCache() { behaviorsCached = false; }
+
+	WarningBehavior getWarningBehavior(W id) const {
+		if (!behaviorsCached) {
+			for (W flagID : EnumSeq(W::NB_WARNINGS)) {
+				behaviors[flagID] = computeWarningBehavior(flagID);
+			}
+			behaviorsCached = true;
+		}
+		return behaviors[id];
+	}
+
+	WarningBehavior computeWarningBehavior(W id) const;
 	void processWarningFlag(char const *flag);
 };
 
 template<typename L, typename W>
-WarningBehavior Diagnostics<L, W>::getWarningBehavior(W id) const {
+WarningBehavior Diagnostics<L, W>::computeWarningBehavior(W id) const {
 	// Check if warnings are globally disabled
 	if (!state.warningsEnabled) {
 		return WarningBehavior::DISABLED;
@@ -122,6 +140,8 @@ WarningBehavior Diagnostics<L, W>::getWarningBehavior(W id) const {
 
 template<typename L, typename W>
 void Diagnostics<L, W>::processWarningFlag(char const *flag) {
+	flushWarningCache();
+
 	std::string rootFlag = flag;
 
 	// Check for `-Werror` or `-Wno-error` to return early
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_EMBED_HPP
+#define RGBDS_EMBED_HPP
+
+// Stable C API for embedding the assembler and linker in a long-lived process, such as a
+// build daemon, skipping process startup and the filesystem round trip between them.
+// Each call runs in a forked worker (the same isolation rgbasm's batch mode uses), so a
+// fatal error in one input cannot take down the host process; like batch mode, this is
+// not available on platforms without `fork`.
+// Configuration not exposed here (warning flags, linker scripts, etc.) uses the tools'
+// defaults; the command-line tools remain the interface for anything fancier.
+
+#include <stddef.h>
+
+// The libraries are built with hidden visibility (the assembler and linker define many
+// identically-named internal symbols), so the API is exported explicitly
+#ifdef __GNUC__
+	#define RGBDS_API __attribute__((visibility("default")))
+#else
+	#define RGBDS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct RGBDSObjectBuffer {
+	char const *name;          // Name to report the object as in diagnostics
+	unsigned char const *data; // Object file contents
+	size_t size;
+} RGBDSObjectBuffer;
+
+// Assembles `source` (reported in diagnostics as `name`) into an object file.
+// On success, returns 0 and stores a buffer holding the object file contents into
+// `*object` and its size into `*objectSize`; the buffer must be released with
+// `rgbds_free`. On failure, returns nonzero, with diagnostics printed to stderr.
+RGBDS_API int rgbasm_assemble(
+    char const *name, char const *source, size_t sourceSize, unsigned char **object,
+    size_t *objectSize
+);
+
+// Links `nbObjects` object files into a ROM image, with the same semantics as running
+// `rgblink` without options. On success, returns 0 and stores a buffer holding the ROM
+// image into `*rom` and its size into `*romSize`; the buffer must be released with
+// `rgbds_free`. On failure, returns nonzero, with diagnostics printed to stderr.
+RGBDS_API int rgblink_link(
+    RGBDSObjectBuffer const *objects, size_t nbObjects, unsigned char **rom, size_t *romSize
+);
+
+// Releases a buffer returned by `rgbasm_assemble` or `rgblink_link`.
+RGBDS_API void rgbds_free(void *buffer);
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <functional>
+
+// Runs `childFn` in a forked worker with its standard output redirected into a pipe, and
+// captures everything it writes into a `malloc`ed buffer. Returns the worker's exit code,
+// or -1 if the worker could not be run or read from.
+int embed_RunWorker(std::function<void()> const &childFn, unsigned char **out, size_t *outSize);
+#endif // __cplusplus
+
+#endif // RGBDS_EMBED_HPP
@@ -3,15 +3,25 @@
 #ifndef RGBDS_FILE_HPP
 #define RGBDS_FILE_HPP
 
+#include <errno.h>
 #include <fcntl.h>
 #include <fstream>
 #include <ios>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <stdint.h>
 #include <streambuf>
+#include <string.h>
 #include <string>
+#include <sys/stat.h>
 #include <variant>
 
-#include "helpers.hpp" // assume
+#ifndef _MSC_VER
+	#include <sys/mman.h>
+#endif
+
+#include "helpers.hpp" // assume, Defer
 #include "platform.hpp"
 
 class File {
@@ -58,4 +68,164 @@ public:
 	}
 };
 
+// Read-only contents of a regular file, memory-mapped when the platform supports it, and
+// otherwise read whole into a heap buffer. `open` fails on non-regular files (pipes, devices,
+// standard input...), which each tool keeps reading through its streaming fallback.
+class MappedFile {
+	std::shared_ptr<char[]> _contents;
+	size_t _size = 0;
+	bool _mapped = false;
+
+public:
+	// Attempts to map or read `path`; returns `false` on failure, with `errno` describing it.
+	[[nodiscard]]
+	bool open(std::string const &path) {
+		int fd = ::open(path.c_str(), O_RDONLY | O_BINARY);
+		if (fd < 0) {
+			return false;
+		}
+		Defer closeFd{[&] { close(fd); }};
+
+		struct stat statBuf;
+		if (fstat(fd, &statBuf) != 0) {
+			return false; // LCOV_EXCL_LINE
+		}
+		if (!S_ISREG(statBuf.st_mode)) {
+			errno = ESPIPE;
+			return false;
+		}
+		size_t size = statBuf.st_size;
+
+#ifndef _MSC_VER
+		// The mapping pages the file in lazily, and lets concurrent processes reading the same
+		// file share the pages; it remains valid after the fd is closed
+		if (size > 0) {
+			if (void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			    mapping != MAP_FAILED) {
+				_contents = std::shared_ptr<char[]>(
+				    static_cast<char *>(mapping), [size](char *addr) { munmap(addr, size); }
+				);
+				_size = size;
+				_mapped = true;
+				return true;
+			}
+		}
+#endif
+
+		// Fall back to reading the whole file into a buffer
+		auto contents = std::shared_ptr<char[]>(new (std::nothrow) char[size > 0 ? size : 1]);
+		if (!contents) {
+			// LCOV_EXCL_START
+			errno = ENOMEM;
+			return false;
+			// LCOV_EXCL_STOP
+		}
+		for (size_t ofs = 0; ofs < size;) {
+			ssize_t ret = read(fd, &contents[ofs], size - ofs);
+			if (ret == -1 && errno != EINTR) {
+				return false; // LCOV_EXCL_LINE
+			}
+			if (ret == 0) {
+				size = ofs; // The file shrank since it was `stat`ed
+				break;      // LCOV_EXCL_LINE
+			}
+			if (ret != -1) {
+				ofs += ret;
+			}
+		}
+		_contents = std::move(contents);
+		_size = size;
+		return true;
+	}
+
+	char const *data() const { return _contents.get(); }
+	uint8_t const *bytes() const { return reinterpret_cast<uint8_t const *>(_contents.get()); }
+	size_t size() const { return _size; }
+	bool isMapped() const { return _mapped; }
+	// Shares ownership of the contents, e.g. to keep a mapping alive beyond this object
+	std::shared_ptr<char[]> const &share() const { return _contents; }
+
+	// Hints the OS that the contents are about to be read from front to back
+	void adviseSequential() const {
+#if !defined(_MSC_VER) && defined(MADV_SEQUENTIAL)
+		if (_mapped) {
+			madvise(_contents.get(), _size, MADV_SEQUENTIAL);
+		}
+#endif
+	}
+};
+
+// Bounds-checked cursor over a `MappedFile`'s contents (or any in-memory byte range).
+// Reads report truncation through their return values instead of aborting, so each tool
+// can diagnose it in its own fashion.
+class FileCursor {
+	uint8_t const *_data = nullptr;
+	size_t _size = 0;
+	size_t _pos = 0;
+
+public:
+	FileCursor() = default;
+	explicit FileCursor(MappedFile const &file) : _data(file.bytes()), _size(file.size()) {}
+	FileCursor(uint8_t const *data, size_t size) : _data(data), _size(size) {}
+
+	uint8_t const *data() const { return _data; }
+	size_t size() const { return _size; }
+	size_t tell() const { return _pos; }
+	size_t remaining() const { return _size - _pos; }
+	// Points at the next byte to be read; only valid while `remaining()` is non-zero
+	uint8_t const *ptr() const { return &_data[_pos]; }
+
+	[[nodiscard]]
+	bool seek(size_t ofs) {
+		if (ofs > _size) {
+			return false;
+		}
+		_pos = ofs;
+		return true;
+	}
+
+	std::optional<uint8_t> getByte() {
+		if (remaining() < 1) {
+			return std::nullopt;
+		}
+		return _data[_pos++];
+	}
+
+	// Little-endian
+	std::optional<uint32_t> getLong() {
+		if (remaining() < 4) {
+			return std::nullopt;
+		}
+		uint32_t value = _data[_pos] | _data[_pos + 1] << 8 | _data[_pos + 2] << 16
+		                 | static_cast<uint32_t>(_data[_pos + 3]) << 24;
+		_pos += 4;
+		return value;
+	}
+
+	[[nodiscard]]
+	bool getData(void *dest, size_t size) {
+		if (remaining() < size) {
+			return false;
+		}
+		memcpy(dest, &_data[_pos], size);
+		_pos += size;
+		return true;
+	}
+
+	// Reads a NUL-terminated string, not including the terminator
+	[[nodiscard]]
+	bool getString(std::string &dest) {
+		size_t end = _pos;
+		while (end < _size && _data[end] != '\0') {
+			++end;
+		}
+		if (end == _size) {
+			return false;
+		}
+		dest.assign(reinterpret_cast<char const *>(&_data[_pos]), end - _pos);
+		_pos = end + 1;
+		return true;
+	}
+};
+
 #endif // RGBDS_FILE_HPP
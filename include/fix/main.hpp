@@ -20,6 +20,7 @@ enum Model { DMG, BOTH, CGB };
 
 struct Options {
 	uint8_t fixSpec = 0;                // -f, -v
+	bool verify = false;                // --verify
 	Model model = DMG;                  // -C, -c
 	bool japanese = true;               // -j
 	uint16_t oldLicensee = UNSPECIFIED; // -l
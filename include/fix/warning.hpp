@@ -4,6 +4,7 @@
 #define RGBDS_FIX_WARNING_HPP
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include "diagnostics.hpp"
 
@@ -41,4 +42,13 @@ void fatal(char const *fmt, ...);
 
 uint32_t checkErrors(char const *filename);
 
+// Redirects the calling thread's diagnostics to `output`, counting its errors in `nbErrors`;
+// pass null pointers to revert to stderr and the global error count. This lets worker threads
+// fixing files in parallel buffer their output, so per-file diagnostics stay ordered.
+void setThreadDiagnostics(FILE *output, uint64_t *nbErrors);
+
+// The error count that `error` increments on the calling thread (the global count, unless
+// redirected by `setThreadDiagnostics`)
+uint64_t &threadNbErrors();
+
 #endif // RGBDS_FIX_WARNING_HPP
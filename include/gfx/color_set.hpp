@@ -4,6 +4,7 @@
 #define RGBDS_GFX_COLOR_SET_HPP
 
 #include <array>
+#include <bit>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -21,6 +22,22 @@ public:
 	// Adds the specified color to the set, or **silently drops it** if the set is full.
 	void add(uint16_t color);
 
+	// The whole set, viewed as a single machine word with the four slots as 16-bit lanes;
+	// equality and membership tests thus boil down to single-word bit operations, which the
+	// palette packing inner loops perform a great many of
+	uint64_t word() const { return std::bit_cast<uint64_t>(_colorIndices); }
+
+	bool contains(uint16_t color) const {
+		// Broadcast the color to all four lanes, then look for an all-zero lane in the XOR;
+		// a lane is zero iff subtracting 1 from it borrows into its top bit while that bit
+		// was clear. Empty slots can never match, since colors are 15-bit.
+		uint64_t diff = word() ^ (color * UINT64_C(0x0001'0001'0001'0001));
+		return ((diff - UINT64_C(0x0001'0001'0001'0001)) & ~diff & UINT64_C(0x8000'8000'8000'8000))
+		       != 0;
+	}
+
+	bool operator==(ColorSet const &other) const { return word() == other.word(); }
+
 	enum ComparisonResult {
 		NEITHER,
 		WE_BIGGER,
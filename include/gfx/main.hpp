@@ -32,8 +32,10 @@ struct Options {
 	} palSpecType = NO_SPEC; // -c
 	std::vector<std::array<std::optional<Rgba>, 4>> palSpec{};
 	uint8_t palSpecDmg = 0;
+	std::string container{};    // --container
 	uint8_t bitDepth = 2;       // -d
-	std::string inputTileset{}; // -i
+	std::string inputTileset{};  // -i
+	std::string sharedTileset{}; // --shared-tileset
 	struct {
 		uint16_t left;
 		uint16_t top;
@@ -76,6 +78,10 @@ struct Palette {
 
 	void addColor(uint16_t color);
 	uint8_t indexOf(uint16_t color) const;
+	// Computes the indices of a whole tile row of already-converted colors; same results as
+	// `indexOf` per color, but with branchless compares against every slot that the compiler
+	// can lower to SIMD
+	void indicesOf(uint16_t const *rowColors, uint8_t *indices) const;
 	uint16_t &operator[](size_t index) { return colors[index]; }
 	uint16_t const &operator[](size_t index) const { return colors[index]; }
 
@@ -3,19 +3,41 @@
 #ifndef RGBDS_GFX_PNG_HPP
 #define RGBDS_GFX_PNG_HPP
 
+#include <functional>
 #include <stdint.h>
 #include <streambuf>
+#include <string>
 #include <vector>
 
 #include "gfx/rgba.hpp"
 
+struct PngInput; // Internal to `png.cpp`
+
 struct Png {
 	uint32_t width, height;
 	std::vector<Rgba> pixels{};
 	std::vector<Rgba> palette{};
 
+	// Called with each decoded row (in top-to-bottom order) right after its conversion to
+	// `Rgba`, while the row is still cache-hot; rows outside the decoded range are not visited
+	using RowCallback = std::function<void(Rgba const *row, uint32_t width, uint32_t y)>;
+
 	Png() {}
+	// Reads the image at `path`, memory-mapping it when possible; "-" reads standard input.
+	// Only rows in `[firstRow, lastRow)` (clamped to the image height) are decoded; pixels
+	// outside that range are left transparent, and rows past it are not even decompressed.
+	// Interlaced images are always decoded in full.
+	explicit Png(
+	    std::string const &path,
+	    uint32_t firstRow = 0,
+	    uint32_t lastRow = UINT32_MAX,
+	    RowCallback rowCallback = nullptr
+	);
+	// Reads the image from an already-opened stream
 	Png(char const *filename, std::streambuf &file);
+
+private:
+	Png(PngInput &&input, uint32_t firstRow, uint32_t lastRow, RowCallback rowCallback);
 };
 
 #endif // RGBDS_GFX_PNG_HPP
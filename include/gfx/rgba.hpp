@@ -3,6 +3,7 @@
 #ifndef RGBDS_GFX_RGBA_HPP
 #define RGBDS_GFX_RGBA_HPP
 
+#include <stddef.h>
 #include <stdint.h>
 
 struct Rgba {
@@ -51,6 +52,10 @@ struct Rgba {
 	bool isOpaque() const { return alpha >= opacity_threshold; }
 	// Computes the equivalent CGB color, respects the color curve depending on options
 	uint16_t cgbColor() const;
+	// Converts a contiguous row of pixels at once; same results as calling `cgbColor` per
+	// pixel, but the color curve check is hoisted out of the loop and the common path is
+	// branchless so the compiler can vectorize it
+	static void cgbColorRow(Rgba const *pixels, uint16_t *colors, size_t count);
 
 	bool isGray() const { return red == green && green == blue; }
 	uint8_t grayIndex() const;
@@ -11,9 +11,12 @@
 #include <unordered_map>
 #include <utility>
 
-template<typename T>
+// The default container is a `std::deque` so that references into `list` stay valid as items
+// are added; users that never keep such references can pick `std::vector` instead, to iterate
+// over a dense array.
+template<typename T, template<typename...> typename Container = std::deque>
 class InsertionOrderedMap {
-	std::deque<T> list;
+	Container<T> list;
 	std::unordered_map<std::string, size_t> map; // Indexes into `list`
 
 public:
@@ -21,6 +24,18 @@ public:
 
 	bool empty() const { return list.empty(); }
 
+	void reserve(size_t n) {
+		if constexpr (requires { list.reserve(n); }) {
+			list.reserve(n);
+		}
+		map.reserve(n);
+	}
+
+	void clear() {
+		list.clear();
+		map.clear();
+	}
+
 	bool contains(std::string const &name) const { return map.find(name) != map.end(); }
 
 	T &operator[](size_t i) { return list[i]; }
@@ -3,7 +3,13 @@
 #ifndef RGBDS_LINK_ASSIGN_HPP
 #define RGBDS_LINK_ASSIGN_HPP
 
+#include <stddef.h>
+
 // Assigns all sections a slice of the address space
 void assign_AssignSections();
 
+// Assigns only the sections registered from the `firstSectIdx`th one onward, in the free
+// space the shared assignment left over (`--profile`)
+void assign_AssignExtraSections(size_t firstSectIdx);
+
 #endif // RGBDS_LINK_ASSIGN_HPP
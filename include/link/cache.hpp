@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_LINK_CACHE_HPP
+#define RGBDS_LINK_CACHE_HPP
+
+#include <stdint.h>
+
+struct Section;
+
+// Loads the placements recorded by the previous link (`--placement-cache`)
+void cache_ReadPlacements();
+
+// Returns whether `section` may reuse the location the previous link gave it, and if so,
+// writes that location to `bank` and `org`
+bool cache_GetPlacement(Section const &section, uint32_t &bank, uint16_t &org);
+
+// Records this link's placements for the next run (`--placement-cache`)
+void cache_WritePlacements();
+
+#endif // RGBDS_LINK_CACHE_HPP
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_LINK_LIBRARY_HPP
+#define RGBDS_LINK_LIBRARY_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Whether the buffer begins with the `!<arch>` magic of a library archive (.lib).
+bool lib_IsArchive(uint8_t const *data, size_t size);
+
+// Registers a library archive and indexes which symbols each member defines; no member is
+// parsed as an object until `lib_ResolveSymbols` decides it is needed.
+void lib_RegisterArchive(char const *fileName);
+
+// Loads every archive member that defines a symbol some object imported but nothing
+// defines, repeating for the imports those members add until no more can be resolved.
+void lib_ResolveSymbols();
+
+#endif // RGBDS_LINK_LIBRARY_HPP
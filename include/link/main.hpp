@@ -6,12 +6,18 @@
 #include <stdint.h>
 
 struct Options {
+	bool bestFit;                // -b
 	bool isDmgMode;              // -d
+	bool gcSections;             // -g
 	char const *mapFileName;     // -m
+	bool binaryMapFormat;        // --map-format
 	bool noSymInMap;             // -M
 	char const *symFileName;     // -n
 	char const *overlayFileName; // -O
 	char const *outputFileName;  // -o
+	char const *placementCacheName; // --placement-cache
+	char const *layoutPlanName;  // --layout-plan
+	bool dedupDiagnostics;       // --dedup-diagnostics
 	uint8_t padValue;            // -p
 	bool hasPadValue = false;
 	// Setting these three to 0 disables the functionality
@@ -3,9 +3,59 @@
 #ifndef RGBDS_LINK_OBJECT_HPP
 #define RGBDS_LINK_OBJECT_HPP
 
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "link/section.hpp" // RPNPayload
+
+// Returns an empty staging buffer for an RPN payload, recycled from a previously-dropped
+// duplicate when possible. Thread-safe.
+std::vector<uint8_t> obj_AcquireRPNBuffer();
+
+// How many RPN staging buffers were recycled (reported by `--mem-stats`). Thread-safe.
+uint64_t obj_CountRPNBufferReuses();
+
+// Returns the one shared copy of an RPN payload, so byte-identical expressions are stored
+// only once no matter how many patches carry them. Thread-safe.
+std::shared_ptr<RPNPayload const> obj_InternRPN(std::vector<uint8_t> &&rpnExpression);
+
+// Like `obj_InternRPN`, but borrows `size` bytes at `data` instead of copying them; `owner`
+// is whatever keeps those bytes alive (e.g. an object file image). Thread-safe.
+std::shared_ptr<RPNPayload const>
+    obj_AdoptRPN(uint8_t const *data, uint32_t size, std::shared_ptr<void> owner);
+
+// Parses and registers a symbol record that the v2 object reader skipped over (most local
+// symbols are never referenced by any patch); no-op if the record was read eagerly already.
+// Writes into the shared symbol tables, so it is NOT thread-safe.
+void obj_MaterializeSymbol(std::vector<Symbol> const &fileSymbols, uint32_t index);
+
+// Parses and registers every symbol record still deferred, for name-based lookups (e.g.
+// tracing unexported symbols on an error path).
+void obj_MaterializeAllSymbols();
+
+// Whether any symbol records were deferred at all (see `obj_MaterializeSymbol`).
+bool obj_HasDeferredSymbols();
+
+// Like `obj_ReadFile`, but for an object file already in memory; used by the embedding API.
+void obj_ReadBuffer(char const *name, uint8_t const *data, size_t size, unsigned int fileID);
+
 // Read an object (.o) file, and add its info to the data structures.
 void obj_ReadFile(char const *fileName, unsigned int fileID);
 
+// Reads one library archive member that `lib_ResolveSymbols` decided to load, allocating it
+// a fresh file ID.
+void obj_ReadLibraryMember(char const *name, uint8_t const *data, size_t size);
+
+// Read all object files, parsing them concurrently where possible, and add their info to
+// the data structures in command-line order.
+void obj_ReadFiles(std::vector<char const *> const &fileNames);
+
+// Reads a profile's object files after the shared link's (`--profile`), continuing their
+// file ID numbering.
+void obj_ReadExtraFiles(std::vector<char const *> const &fileNames);
+
 // Sets up object file reading
 void obj_Setup(unsigned int nbFiles);
 
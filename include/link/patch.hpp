@@ -20,6 +20,10 @@ struct Assertion {
 
 Assertion &patch_AddAssertion();
 
+// Discards sections not reachable, through patches' RPN references, from any
+// fixed-address section or assertion (`-g`)
+void patch_PruneSections();
+
 // Checks all assertions
 void patch_CheckAssertions();
 
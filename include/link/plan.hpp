@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_LINK_PLAN_HPP
+#define RGBDS_LINK_PLAN_HPP
+
+#include <stdint.h>
+#include <string>
+
+// Starts recording the layout commands executed by the linker script, so they can be
+// written out with `plan_Write` (`--layout-plan`)
+void plan_StartRecording();
+
+// Records a file of the linker script's include closure; its content hash decides whether
+// the plan may be replayed by a later link
+void plan_RecordFile(std::string const &path);
+
+// Records one numeric layout command; see `plan.cpp` for the opcodes
+void plan_RecordCommand(char op, uint32_t arg1 = 0, uint32_t arg2 = 0);
+
+// Records a section placement command
+void plan_RecordPlace(std::string const &name, bool isOptional);
+
+// Replays the recorded layout commands if the plan file exists and the script it was
+// compiled from is unchanged; returns whether that happened
+bool plan_TryReplay(char const *linkerScriptName);
+
+// Writes the recorded commands to the plan file for the next link to replay
+void plan_Write();
+
+#endif // RGBDS_LINK_PLAN_HPP
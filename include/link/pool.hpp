@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_LINK_POOL_HPP
+#define RGBDS_LINK_POOL_HPP
+
+#include <functional>
+#include <stddef.h>
+
+// Sets how many threads the pool spreads work over, including the submitting thread
+// (`--threads`); 0 picks the hardware's concurrency. Only effective before the pool's
+// first use.
+void pool_SetNbThreads(size_t nbThreads);
+
+// How many threads `pool_ForEach` spreads work over (at least 1).
+size_t pool_GetNbThreads();
+
+// Runs `task(0)` through `task(nbItems - 1)` over the pool's threads, and returns once all
+// of them have finished; the calling thread participates in the work. The pool's threads
+// are started on first use and kept for the next phase, rather than paying a spawn and
+// teardown per phase.
+void pool_ForEach(size_t nbItems, std::function<void(size_t)> const &task);
+
+#endif // RGBDS_LINK_POOL_HPP
@@ -4,6 +4,7 @@
 #define RGBDS_LINK_SECTION_HPP
 
 #include <memory>
+#include <stddef.h>
 #include <stdint.h>
 #include <string>
 #include <vector>
@@ -14,6 +15,16 @@ struct FileStackNode;
 struct Section;
 struct Symbol;
 
+// One immutable RPN payload, shared between patches: identical payloads are interned, since
+// the same `BANK(X)` / `Y + const` patterns repeat at thousands of call sites. The bytes
+// are either owned (when a reader built them up) or borrowed straight out of a kept-alive
+// object file image (`obj_AdoptRPN`), adopting the serialized form without copying it.
+struct RPNPayload {
+	std::shared_ptr<void> owner; // Keeps `bytes` alive: owned storage, or an object file image
+	uint8_t const *bytes;
+	uint32_t size;
+};
+
 struct Patch {
 	FileStackNode const *src;
 	uint32_t lineNo;
@@ -22,7 +33,7 @@ struct Patch {
 	uint32_t pcSectionID;
 	uint32_t pcOffset;
 	PatchType type;
-	std::vector<uint8_t> rpnExpression;
+	std::shared_ptr<RPNPayload const> rpnExpression;
 };
 
 struct Section {
@@ -48,20 +59,48 @@ struct Section {
 	// Extra info computed during linking
 	std::vector<Symbol> *fileSymbols;
 	std::vector<Symbol *> symbols;
-	std::unique_ptr<Section> nextu; // The next "component" of this unionized sect
+	Section *nextu; // The next "component" of this unionized sect
 };
 
 // Execute a callback for each section currently registered.
 // This is to avoid exposing the data structure in which sections are stored.
 void sect_ForEach(void (*callback)(Section &));
 
+// Returns the `i`th section in registration order; the incremental passes that `--profile`
+// runs after the shared link use this to only visit sections a profile added.
+Section &sect_GetNthSection(size_t i);
+
+// Counts over the registered sections, reported by `--mem-stats`.
+size_t sect_CountSections();
+uint64_t sect_CountPatches();
+uint64_t sect_CountDataBytes();
+
+// Pre-sizes the section map for the given total number of sections.
+void sect_Reserve(size_t nbSections);
+
+// Moves a file's sections into permanent storage, in one block. The returned vector must
+// not be resized, since sections are referenced by address from then on.
+std::vector<Section> &sect_AdoptPool(std::vector<Section> &&pool);
+
+// Permanently allocates a single section, for formats whose section count is not known
+// up front (SDCC objects).
+Section &sect_MakeSection();
+
 // Registers a section to be processed.
-void sect_AddSection(std::unique_ptr<Section> &&section);
+void sect_AddSection(Section &section);
+
+// Drops every registered section for which `callback` returns `false` (`-g`).
+void sect_KeepIf(bool (*callback)(Section &));
 
 // Finds a section by its name.
 Section *sect_GetSection(std::string const &name);
 
-// Checks if all sections meet reasonable criteria, such as max size
-void sect_DoSanityChecks();
+// Marks every section registered so far as belonging to the shared link (`--profile`);
+// profile objects may reference them, but no longer merge into them.
+void sect_SealSharedSections();
+
+// Checks if all sections (from the `firstIdx`th one onward) meet reasonable criteria, such
+// as max size
+void sect_DoSanityChecks(size_t firstIdx = 0);
 
 #endif // RGBDS_LINK_SECTION_HPP
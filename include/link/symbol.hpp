@@ -5,6 +5,7 @@
 
 // GUIDELINE: external code MUST NOT BE AWARE of the data structure used!
 
+#include <stddef.h>
 #include <stdint.h>
 #include <string>
 #include <variant>
@@ -24,6 +25,7 @@ struct Label {
 struct Symbol {
 	// Info contained in the object files
 	std::string name;
+	uint64_t nameHash; // FNV-1a of `name`; stored in v2 objects, computed by the other readers
 	ExportLevel type;
 	FileStackNode const *src;
 	int32_t lineNo;
@@ -33,12 +35,26 @@ struct Symbol {
 	    >
 	    data;
 
+	// Extra info computed during linking
+	Symbol *nextLocal; // Next unexported symbol with the same name, if any
+
 	Label &label() { return std::get<Label>(data); }
 	Label const &label() const { return std::get<Label>(data); }
 };
 
 void sym_ForEach(void (*callback)(Symbol &));
 
+// Counts the exported symbols, reported by `--mem-stats`.
+size_t sym_CountSymbols();
+
+// The imported symbols, in registration order; library resolution (`lib_ResolveSymbols`)
+// walks these to decide which archive members to load.
+size_t sym_CountImports();
+Symbol const &sym_GetNthImport(size_t i);
+
+// Pre-sizes the symbol tables for the given total number of symbols.
+void sym_Reserve(size_t nbSymbols);
+
 void sym_AddSymbol(Symbol &symbol);
 
 // Finds a symbol in all the defined symbols.
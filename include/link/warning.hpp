@@ -3,6 +3,7 @@
 #ifndef RGBDS_LINK_WARNING_HPP
 #define RGBDS_LINK_WARNING_HPP
 
+#include <setjmp.h>
 #include <stdarg.h>
 #include <stdint.h>
 
@@ -39,6 +40,12 @@ enum WarningID {
 
 extern Diagnostics<WarningLevel, WarningID> warnings;
 
+// Makes every diagnostic raised on the calling thread `longjmp` to `env` instead of
+// printing (and, for fatal ones, exiting); pass `nullptr` to restore normal reporting.
+// The parallel phases use this so a worker never writes diagnostics or `exit`s: the
+// failing item is re-run sequentially on the submitting thread, which reports for real.
+void warnings_SetAbortJump(jmp_buf *env);
+
 struct FileStackNode;
 
 [[gnu::format(printf, 4, 5)]]
@@ -72,4 +79,8 @@ void fatalTwo(
 
 void requireZeroErrors();
 
+// With `--dedup-diagnostics`, prints a "repeated N more times" summary for each diagnostic
+// whose repeats were suppressed, and forgets the counts.
+void warning_PrintRepeatSummary();
+
 #endif // RGBDS_LINK_WARNING_HPP
@@ -9,7 +9,11 @@
 #include "helpers.hpp" // assume
 
 #define RGBDS_OBJECT_VERSION_STRING "RGB9"
-#define RGBDS_OBJECT_REV            13U
+#define RGBDS_OBJECT_REV            15U
+
+// Magic for the v2 object container (same record contents as the above revision, but laid
+// out with a header-level table of contents and a deduplicated string table)
+#define RGBDS_OBJECT_V2_MAGIC "RGB2"
 
 enum AssertionType { ASSERT_WARN, ASSERT_ERROR, ASSERT_FATAL };
 
@@ -81,6 +85,9 @@ enum SectionType {
 static constexpr uint8_t SECTTYPE_TYPE_MASK = 0b111;
 static constexpr uint8_t SECTTYPE_UNION_BIT = 7;
 static constexpr uint8_t SECTTYPE_FRAGMENT_BIT = 6;
+// v2 container only: the section's data is stored as an LZ4 block (`--obj-compress`),
+// prefixed with its compressed size (the uncompressed size is the section's size)
+static constexpr uint8_t SECTTYPE_COMPRESSED_BIT = 5;
 
 enum FileStackNodeType {
 	NODE_REPT,
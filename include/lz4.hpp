@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_LZ4_HPP
+#define RGBDS_LZ4_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// A self-contained LZ4 block codec, used for the object files' optional compressed section
+// data. Only the raw block format is implemented (no frame headers or checksums): the object
+// file records the compressed and uncompressed sizes itself.
+
+// Compresses `size` bytes at `src` into one LZ4 block. The output is only useful if it came
+// out smaller than the input; callers should fall back to storing the input raw otherwise.
+std::vector<uint8_t> lz4_Compress(uint8_t const *src, size_t size);
+
+// Decompresses one LZ4 block into exactly `dstSize` bytes at `dst`; returns whether the
+// block was well-formed and yielded exactly that many bytes.
+bool lz4_Decompress(uint8_t const *src, size_t srcSize, uint8_t *dst, size_t dstSize);
+
+#endif // RGBDS_LZ4_HPP
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_MEM_STATS_HPP
+#define RGBDS_MEM_STATS_HPP
+
+#include <initializer_list>
+#include <stdint.h>
+#include <utility>
+
+// Heap and peak-memory statistics, reported by each tool's `--mem-stats` option.
+// Counting allocations is a couple of relaxed atomic increments, cheap enough to stay
+// unconditional; only the report is gated on the option.
+
+void mem_EnableStats();
+
+// Prints heap totals, the given per-subsystem counters, and the peak memory usage to
+// standard error if `--mem-stats` was given
+void mem_ReportStats(std::initializer_list<std::pair<char const *, uint64_t>> counters = {});
+
+#endif // RGBDS_MEM_STATS_HPP
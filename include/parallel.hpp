@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MIT
+
+#ifndef RGBDS_PARALLEL_HPP
+#define RGBDS_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+// Runs `work(index)` for every index in `[0; nbItems[`, spreading the work over a small thread
+// pool. Only suitable for items that are independent (color extraction, 2bpp encoding, strip
+// rendering); anything order-dependent (color set merging, deduplication, PNG encoding) must
+// stay sequential so the output remains deterministic.
+// `minItemsPerThread` throttles the pool so small workloads are not worth less than the thread
+// startup cost; it also sizes the batches that workers claim at once.
+template<typename F>
+void forEachParallel(size_t nbItems, size_t minItemsPerThread, F const &work) {
+	size_t nbThreads =
+	    std::min<size_t>(std::thread::hardware_concurrency(), nbItems / minItemsPerThread);
+	if (nbThreads < 2) {
+		for (size_t index = 0; index < nbItems; ++index) {
+			work(index);
+		}
+		return;
+	}
+
+	size_t const batchSize = std::max<size_t>(minItemsPerThread / 8, 1);
+	std::atomic<size_t> nextItem = 0;
+	auto workerLoop = [&] {
+		// Items are claimed in batches to limit contention on the shared counter
+		for (;;) {
+			size_t base = nextItem.fetch_add(batchSize);
+			if (base >= nbItems) {
+				break;
+			}
+			size_t batchEnd = std::min(base + batchSize, nbItems);
+			for (size_t index = base; index < batchEnd; ++index) {
+				work(index);
+			}
+		}
+	};
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < nbThreads; ++i) {
+		workers.emplace_back(workerLoop);
+	}
+	workerLoop(); // This thread may as well help out
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+}
+
+#endif // RGBDS_PARALLEL_HPP
@@ -3,7 +3,9 @@
 #ifndef RGBDS_STYLE_HPP
 #define RGBDS_STYLE_HPP
 
+#include <stdarg.h>
 #include <stdio.h>
+#include <string>
 
 #if defined(_MSC_VER) || defined(__MINGW32__) || defined(__CYGWIN__)
 	#define STYLE_ANSI 0
@@ -39,4 +41,25 @@ bool style_Parse(char const *arg);
 void style_Set(FILE *file, StyleColor color, bool bold);
 void style_Reset(FILE *file);
 
+// Assembles one styled message in memory, and writes it out in a single call when flushed
+// or destroyed: fewer write syscalls per message, and writers sharing a stream (e.g. worker
+// threads sharing `stderr`) cannot interleave within one flush.
+class StyleSink {
+	FILE *file;
+	std::string buf;
+
+public:
+	explicit StyleSink(FILE *file_) : file(file_) {}
+	~StyleSink() { flush(); }
+
+	void set(StyleColor color, bool bold);
+	void reset();
+	[[gnu::format(printf, 2, 3)]]
+	void printf(char const *fmt, ...);
+	void vprintf(char const *fmt, va_list args);
+	void append(char const *str) { buf.append(str); }
+	void append(char c) { buf.push_back(c); }
+	void flush();
+};
+
 #endif // RGBDS_STYLE_HPP
@@ -4,29 +4,130 @@
 #define RGBDS_UTIL_HPP
 
 #include <algorithm>
+#include <array>
 #include <ctype.h>
 #include <numeric>
 #include <stddef.h>
+#include <stdint.h>
 #include <string>
 #include <unordered_map>
 
 #include "helpers.hpp"
 
-bool isNewline(int c);
-bool isBlankSpace(int c);
-bool isWhitespace(int c);
-bool isPrintable(int c);
-bool isLetter(int c);
-bool isDigit(int c);
-bool isOctDigit(int c);
-bool isHexDigit(int c);
-bool isAlphanumeric(int c);
+// Character class bitmasks; each predicate below is a single table load and mask test, and
+// scanners can test a character against several classes in one probe by combining masks.
+enum CharClass : uint16_t {
+	CHAR_NEWLINE     = 1 << 0, // '\r' or '\n'
+	CHAR_BLANK_SPACE = 1 << 1, // ' ' or '\t'
+	CHAR_PRINTABLE   = 1 << 2, // ' ' to '~'
+	CHAR_LETTER      = 1 << 3, // 'A'-'Z' or 'a'-'z'
+	CHAR_DIGIT       = 1 << 4, // '0'-'9'
+	CHAR_OCT_DIGIT   = 1 << 5, // '0'-'7'
+	CHAR_HEX_DIGIT   = 1 << 6, // '0'-'9', 'A'-'F', or 'a'-'f'
+	CHAR_IDENT_START = 1 << 7, // Letters, '.', or '_'
+	CHAR_IDENT_CONT  = 1 << 8, // Identifier starters, digits, '#', '$', or '@'
+};
+
+constexpr std::array<uint16_t, 256> charClasses = [] {
+	std::array<uint16_t, 256> classes{};
+	for (int c = 0; c < 256; ++c) {
+		uint16_t mask = 0;
+		if (c == '\r' || c == '\n') {
+			mask |= CHAR_NEWLINE;
+		}
+		if (c == ' ' || c == '\t') {
+			mask |= CHAR_BLANK_SPACE;
+		}
+		if (c >= ' ' && c <= '~') {
+			mask |= CHAR_PRINTABLE;
+		}
+		if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+			mask |= CHAR_LETTER;
+		}
+		if (c >= '0' && c <= '9') {
+			mask |= CHAR_DIGIT;
+		}
+		if (c >= '0' && c <= '7') {
+			mask |= CHAR_OCT_DIGIT;
+		}
+		if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f')) {
+			mask |= CHAR_HEX_DIGIT;
+		}
+		if (mask & CHAR_LETTER || c == '.' || c == '_') {
+			mask |= CHAR_IDENT_START;
+		}
+		if (mask & (CHAR_IDENT_START | CHAR_DIGIT) || c == '#' || c == '$' || c == '@') {
+			mask |= CHAR_IDENT_CONT;
+		}
+		classes[c] = mask;
+	}
+	return classes;
+}();
+
+// Tests a character against one or more classes with a single table probe.
+// `EOF` and other out-of-range values belong to no class.
+constexpr bool charIs(int c, uint16_t mask) {
+	return c >= 0 && c <= 0xFF && (charClasses[c] & mask);
+}
+
+constexpr bool isNewline(int c) {
+	return charIs(c, CHAR_NEWLINE);
+}
+
+constexpr bool isBlankSpace(int c) {
+	return charIs(c, CHAR_BLANK_SPACE);
+}
+
+constexpr bool isWhitespace(int c) {
+	return charIs(c, CHAR_BLANK_SPACE | CHAR_NEWLINE);
+}
+
+constexpr bool isPrintable(int c) {
+	return charIs(c, CHAR_PRINTABLE);
+}
 
-bool startsIdentifier(int c);
-bool continuesIdentifier(int c);
+constexpr bool isLetter(int c) {
+	return charIs(c, CHAR_LETTER);
+}
+
+constexpr bool isDigit(int c) {
+	return charIs(c, CHAR_DIGIT);
+}
+
+constexpr bool isOctDigit(int c) {
+	return charIs(c, CHAR_OCT_DIGIT);
+}
+
+constexpr bool isHexDigit(int c) {
+	return charIs(c, CHAR_HEX_DIGIT);
+}
+
+constexpr bool isAlphanumeric(int c) {
+	return charIs(c, CHAR_LETTER | CHAR_DIGIT);
+}
+
+// This returns false for anonymous labels, which internally start with a '!',
+// and for section fragment literal labels, which internally start with a '$'.
+constexpr bool startsIdentifier(int c) {
+	return charIs(c, CHAR_IDENT_START);
+}
+
+constexpr bool continuesIdentifier(int c) {
+	return charIs(c, CHAR_IDENT_CONT);
+}
 
 char const *printChar(int c);
 
+// 64-bit FNV-1a hash. The writer and reader of the v2 object format must agree on this
+// function, since names are stored pre-hashed alongside their characters.
+constexpr uint64_t fnv1a64(char const *data, size_t size) {
+	uint64_t hash = 0xCBF29CE484222325;
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001B3;
+	}
+	return hash;
+}
+
 struct Uppercase {
 	// FNV-1a hash of an uppercased string
 	constexpr size_t operator()(std::string const &str) const {
@@ -5,13 +5,27 @@
 
 #include "style.hpp"
 
+// Compile-time cap on verbosity: `verbosePrint` calls above this level are removed
+// entirely, including their runtime check, which matters for the trace-level calls
+// sitting in per-token and per-section loops. Build with e.g.
+// `-DRGBDS_MAX_VERBOSITY=VERB_NOTICE` to strip the higher levels; the runtime `-v`
+// switch still selects levels up to the cap.
+#ifndef RGBDS_MAX_VERBOSITY
+	#define RGBDS_MAX_VERBOSITY VERB_VVVVVV
+#endif
+
 // This macro does not evaluate its arguments unless the condition is true.
+// The message is assembled in memory and written out in one go, so verbose notes from
+// processes or threads sharing `stderr` do not interleave.
 #define verbosePrint(level, ...) \
 	do { \
-		if (checkVerbosity(level)) { \
-			style_Set(stderr, STYLE_MAGENTA, false); \
-			fprintf(stderr, __VA_ARGS__); \
-			style_Reset(stderr); \
+		if constexpr ((level) <= RGBDS_MAX_VERBOSITY) { \
+			if (checkVerbosity(level)) { \
+				StyleSink verboseSink(stderr); \
+				verboseSink.set(STYLE_MAGENTA, false); \
+				verboseSink.printf(__VA_ARGS__); \
+				verboseSink.reset(); \
+			} \
 		} \
 	} while (0)
 
@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: MIT
+
+#include "asm/cache.hpp"
+
+#include <errno.h>
+#include <fstream>
+#include <inttypes.h>
+#include <optional>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+
+#include "diagnostics.hpp" // warnx
+#include "helpers.hpp"     // Defer
+#include "verbosity.hpp"
+
+#include "asm/fstack.hpp"
+#include "asm/main.hpp"
+
+#ifdef _MSC_VER
+	#include <direct.h>
+	#define makeCacheDir(path) _mkdir(path)
+#else
+	#define makeCacheDir(path) mkdir(path, 0755)
+#endif
+
+// Cache entries are keyed by a 64-bit FNV-1a hash of the command line and input file name.
+// A hit additionally verifies the content hash of every file in the input closure, so a
+// stale entry only costs a miss; replaying a wrong object would take a full key collision.
+static constexpr uint64_t fnvOffsetBasis = 0xCBF29CE484222325;
+
+static uint64_t hashBytes(uint64_t hash, void const *data, size_t size) {
+	uint8_t const *bytes = static_cast<uint8_t const *>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ bytes[i]) * 0x100000001B3;
+	}
+	return hash;
+}
+
+uint64_t cache_HashContents(void const *data, size_t size) {
+	return hashBytes(fnvOffsetBasis, data, size);
+}
+
+static std::string commandLine; // Serialized CLI options, part of the cache key
+
+// Whether a `__TIME__`-style built-in was used; such an object bakes in this assembly's
+// timestamps, which nothing in the input closure reflects, so it must not be stored
+static bool timestampsUsed = false;
+
+void cache_Init(std::string const &optionsKey) {
+	commandLine = optionsKey;
+}
+
+void cache_MarkTimestampUse() {
+	timestampsUsed = true;
+}
+
+static std::optional<uint64_t> hashFileContents(std::string const &path) {
+	FILE *file = fopen(path.c_str(), "rb");
+	if (!file) {
+		return std::nullopt;
+	}
+	Defer closeFile{[&] { fclose(file); }};
+
+	uint64_t hash = fnvOffsetBasis;
+	for (uint8_t chunk[65536];;) {
+		size_t n = fread(chunk, 1, sizeof(chunk), file);
+		hash = hashBytes(hash, chunk, n);
+		if (n < sizeof(chunk)) {
+			break;
+		}
+	}
+	return ferror(file) ? std::nullopt : std::optional<uint64_t>(hash);
+}
+
+// Returns the path of this input's cache entry with the given extension
+static std::string cachePath(std::string const &mainFileName, char const *ext) {
+	uint64_t key = hashBytes(fnvOffsetBasis, commandLine.data(), commandLine.length());
+	key = hashBytes(key, mainFileName.data(), mainFileName.length());
+
+	char keyStr[17];
+	snprintf(keyStr, sizeof(keyStr), "%016" PRIx64, key);
+	return options.cacheDir + '/' + keyStr + ext;
+}
+
+static bool copyFile(std::string const &from, std::string const &to) {
+	FILE *src = fopen(from.c_str(), "rb");
+	if (!src) {
+		return false;
+	}
+	Defer closeSrc{[&] { fclose(src); }};
+
+	FILE *dest = fopen(to.c_str(), "wb");
+	if (!dest) {
+		return false;
+	}
+	Defer closeDest{[&] { fclose(dest); }};
+
+	for (uint8_t chunk[65536];;) {
+		size_t n = fread(chunk, 1, sizeof(chunk), src);
+		if (fwrite(chunk, 1, n, dest) != n) {
+			return false;
+		}
+		if (n < sizeof(chunk)) {
+			break;
+		}
+	}
+	return !ferror(src);
+}
+
+// Pre-lexed token streams are keyed by their source's content hash and the command line.
+// Recorded tokens that depend on more than the source text are re-lexed on replay, but the
+// diagnostics settings influence which tokens were recorded that way, and those are part of
+// the command line.
+static std::string tokenStreamPath(uint64_t contentHash) {
+	uint64_t key = hashBytes(contentHash, commandLine.data(), commandLine.length());
+
+	char keyStr[17];
+	snprintf(keyStr, sizeof(keyStr), "%016" PRIx64, key);
+	return options.cacheDir + '/' + keyStr + ".lex";
+}
+
+std::optional<std::vector<uint8_t>> cache_LoadTokenStream(uint64_t contentHash) {
+	if (options.cacheDir.empty()) {
+		return std::nullopt;
+	}
+
+	FILE *file = fopen(tokenStreamPath(contentHash).c_str(), "rb");
+	if (!file) {
+		return std::nullopt;
+	}
+	Defer closeFile{[&] { fclose(file); }};
+
+	std::vector<uint8_t> contents;
+	for (uint8_t chunk[65536];;) {
+		size_t n = fread(chunk, 1, sizeof(chunk), file);
+		contents.insert(contents.end(), chunk, chunk + n);
+		if (n < sizeof(chunk)) {
+			break;
+		}
+	}
+	return ferror(file) ? std::nullopt : std::optional<std::vector<uint8_t>>(std::move(contents));
+}
+
+void cache_StoreTokenStream(uint64_t contentHash, std::vector<uint8_t> const &contents) {
+	// As for object files, a failure to populate the cache should not fail the build; and
+	// since lexing is deterministic, concurrent writers for the same key (e.g. batch mode
+	// children sharing a header) write identical bytes, so no locking is needed either
+	if (makeCacheDir(options.cacheDir.c_str()) != 0 && errno != EEXIST) {
+		return; // `cache_Store` warns about this when storing the object
+	}
+
+	FILE *file = fopen(tokenStreamPath(contentHash).c_str(), "wb");
+	if (!file) {
+		return;
+	}
+	Defer closeFile{[&] { fclose(file); }};
+	fwrite(contents.data(), 1, contents.size(), file);
+}
+
+bool cache_TryReplay(std::string const &mainFileName) {
+	std::ifstream manifest(cachePath(mainFileName, ".d"));
+	if (!manifest) {
+		return false;
+	}
+
+	// Each manifest line is "<16 hex digit content hash> <path>"
+	for (std::string line; std::getline(manifest, line);) {
+		if (line.empty()) {
+			continue;
+		}
+		size_t space = line.find(' ');
+		if (space != 16 || line.length() < 18) {
+			return false; // Malformed (e.g. truncated) manifests are treated as misses
+		}
+
+		uint64_t expected = strtoull(line.c_str(), nullptr, 16);
+		std::optional<uint64_t> actual = hashFileContents(line.substr(space + 1));
+		if (!actual || *actual != expected) {
+			return false;
+		}
+	}
+
+	if (!copyFile(cachePath(mainFileName, ".o"), options.objectFileName)) {
+		return false;
+	}
+	// LCOV_EXCL_START
+	verbosePrint(
+	    VERB_NOTICE, "Replayed cached object file for \"%s\"\n", mainFileName.c_str()
+	);
+	// LCOV_EXCL_STOP
+	return true;
+}
+
+void cache_Store(std::string const &mainFileName) {
+	if (timestampsUsed) {
+		// Replaying this object later would replay today's timestamps
+		verbosePrint(
+		    VERB_NOTICE,
+		    "Not caching \"%s\": a timestamp built-in was used\n",
+		    mainFileName.c_str()
+		);
+		return;
+	}
+
+	// A failure to populate the cache should not fail the build, only warn
+	if (makeCacheDir(options.cacheDir.c_str()) != 0 && errno != EEXIST) {
+		warnx("Failed to create cache directory \"%s\": %s", options.cacheDir.c_str(), strerror(errno));
+		return;
+	}
+
+	if (!copyFile(options.objectFileName, cachePath(mainFileName, ".o"))) {
+		warnx("Failed to store object file in cache directory \"%s\"", options.cacheDir.c_str());
+		return;
+	}
+
+	std::string manifestContents;
+	for (std::string const &path : fstk_OpenedFiles()) {
+		std::optional<uint64_t> hash = hashFileContents(path);
+		if (!hash) {
+			return; // An unreadable input (e.g. stdin) makes the entry unverifiable
+		}
+		char hashStr[17];
+		snprintf(hashStr, sizeof(hashStr), "%016" PRIx64, *hash);
+		manifestContents.append(hashStr).append(1, ' ').append(path).append(1, '\n');
+	}
+
+	// The manifest is written last, and in one go, so its presence implies a valid entry
+	std::ofstream manifest(cachePath(mainFileName, ".d"), std::ios::trunc);
+	manifest << manifestContents;
+}
@@ -2,7 +2,9 @@
 
 #include "asm/charmap.hpp"
 
+#include <algorithm>
 #include <map>
+#include <memory>
 #include <optional>
 #include <stack>
 #include <stdint.h>
@@ -26,33 +28,82 @@
 // whether there exists a mapping that ends at the current character,
 struct CharmapNode {
 	std::vector<int32_t> value; // The mapped value, if there exists a mapping that ends here
+	// Outgoing edges, sorted by byte; nodes typically have only a handful of edges, so this
+	// stays small enough to fit in a cache line or two, unlike a 256-way child table.
 	// These MUST be indexes and not pointers, because pointers get invalidated by reallocation!
-	size_t next[256]; // Indexes of where to go next, 0 = nowhere
+	std::vector<std::pair<uint8_t, size_t>> next; // Indexes of where to go next, 0 = nowhere
 
 	bool isTerminal() const { return !value.empty(); }
+
+	// Returns the index of the child reached by `c`, or 0 if there is none
+	size_t nextIdx(uint8_t c) const {
+		auto search = std::lower_bound(RANGE(next), c, [](std::pair<uint8_t, size_t> const &edge, uint8_t b) {
+			return edge.first < b;
+		});
+		return search != next.end() && search->first == c ? search->second : 0;
+	}
 };
 
 struct Charmap {
 	std::string name;
-	std::vector<CharmapNode> nodes; // first node is reserved for the root node
+	// Nodes frozen into an immutable snapshot when this charmap is derived from; shared by
+	// every charmap derived from the same state of the same base (may be null)
+	std::shared_ptr<std::vector<CharmapNode>> base;
+	size_t baseSize = 0; // `base->size()`, cached for the hot lookup path
+	size_t root = 0;     // Index of the root node (owned once the charmap is modified)
+	// Nodes owned by this charmap; a node's index is `baseSize` plus its position here.
+	// Modifying a shared node copies its whole path into this overlay (see `charmap_Add`).
+	std::vector<CharmapNode> own;
+
+	// Lazily-built value-to-mapping index for `charmap_Reverse`; the flag is reset when a
+	// mapping is added (the index itself is only rebuilt on the next reverse lookup)
+	std::map<std::vector<int32_t>, std::pair<std::string, bool>> reverseIndex;
+	bool reverseIndexBuilt = false;
+
+	CharmapNode const &node(size_t nodeIdx) const {
+		return nodeIdx < baseSize ? (*base)[nodeIdx] : own[nodeIdx - baseSize];
+	}
 };
 
+// Flattens a charmap's nodes into a single immutable snapshot that derived charmaps share.
+// Deriving several charmaps from the same unmodified base thus reuses one snapshot, making
+// derivation O(changes) in time and memory.
+static void freezeNodes(Charmap &charmap) {
+	if (charmap.own.empty() && charmap.base) {
+		return; // Unmodified since the last freeze; reuse the existing snapshot
+	}
+
+	auto flat = std::make_shared<std::vector<CharmapNode>>();
+	if (charmap.base) {
+		*flat = *charmap.base; // Node indices are preserved, so edges stay valid
+		flat->insert(
+		    flat->end(),
+		    std::make_move_iterator(charmap.own.begin()),
+		    std::make_move_iterator(charmap.own.end())
+		);
+	} else {
+		*flat = std::move(charmap.own);
+	}
+	charmap.base = std::move(flat);
+	charmap.baseSize = charmap.base->size();
+	charmap.own.clear();
+}
+
 // Traverse the trie depth-first to derive the character mappings in definition order
 template<typename F>
 bool forEachChar(Charmap const &charmap, F callback) {
 	// clang-format off: nested initializers
-	for (std::stack<std::pair<size_t, std::string>> prefixes({{0, ""}}); !prefixes.empty();) {
+	for (std::stack<std::pair<size_t, std::string>> prefixes({{charmap.root, ""}});
+	     !prefixes.empty();) {
 		// clang-format on
 		auto [nodeIdx, mapping] = std::move(prefixes.top());
 		prefixes.pop();
-		CharmapNode const &node = charmap.nodes[nodeIdx];
+		CharmapNode const &node = charmap.node(nodeIdx);
 		if (node.isTerminal() && !callback(nodeIdx, mapping)) {
 			return false;
 		}
-		for (unsigned c = 0; c < std::size(node.next); ++c) {
-			if (size_t nextIdx = node.next[c]; nextIdx) {
-				prefixes.push({nextIdx, mapping + static_cast<char>(c)});
-			}
+		for (auto const &[c, nextIdx] : node.next) {
+			prefixes.push({nextIdx, mapping + static_cast<char>(c)});
 		}
 	}
 	return true;
@@ -76,7 +127,7 @@ bool charmap_ForEach(
 
 		mapFunc(charmap.name);
 		for (auto const &[nodeIdx, mapping] : mappings) {
-			charFunc(mapping, charmap.nodes[nodeIdx].value);
+			charFunc(mapping, charmap.node(nodeIdx).value);
 		}
 	}
 	return !charmaps.empty();
@@ -101,9 +152,14 @@ void charmap_New(std::string const &name, std::string const *baseName) {
 	Charmap &charmap = charmaps.add(name);
 	charmap.name = name;
 	if (baseIdx) {
-		charmap.nodes = charmaps[*baseIdx].nodes; // Copies `charmaps[*baseIdx].nodes`
+		Charmap &baseMap = charmaps[*baseIdx];
+		freezeNodes(baseMap);
+		charmap.base = baseMap.base;
+		charmap.baseSize = charmap.base->size();
+		charmap.own.push_back((*charmap.base)[baseMap.root]); // Own the root right away
+		charmap.root = charmap.baseSize;
 	} else {
-		charmap.nodes.emplace_back(); // Zero-init the root node
+		charmap.own.emplace_back(); // Zero-init the root node
 	}
 
 	currentCharmap = &charmap;
@@ -137,6 +193,14 @@ void charmap_CheckStack() {
 	}
 }
 
+// Forget every charmap, so a fresh assembly starts from scratch; the default charmap must
+// be re-created afterwards via `charmap_New`
+void charmap_Reset() {
+	charmaps.clear();
+	currentCharmap = nullptr;
+	charmapStack = {};
+}
+
 void charmap_Add(std::string const &mapping, std::vector<int32_t> &&value) {
 	if (mapping.empty()) {
 		error("Cannot map an empty string");
@@ -144,61 +208,86 @@ void charmap_Add(std::string const &mapping, std::vector<int32_t> &&value) {
 	}
 
 	Charmap &charmap = *currentCharmap;
-	size_t nodeIdx = 0;
 
+	// Adding a mapping modifies every node along its path, so any shared node visited is
+	// first copied into the charmap's own overlay ("path copying"), re-pointing its
+	// parent's edge; charmaps sharing the base snapshot are unaffected.
+	if (charmap.root < charmap.baseSize) {
+		// Re-own the root after this charmap was frozen by a derivation
+		charmap.own.push_back((*charmap.base)[charmap.root]);
+		charmap.root = charmap.baseSize + charmap.own.size() - 1;
+	}
+
+	size_t nodeIdx = charmap.root;
 	for (char c : mapping) {
-		size_t &nextIdxRef = charmap.nodes[nodeIdx].next[static_cast<uint8_t>(c)];
-		size_t nextIdx = nextIdxRef;
+		uint8_t byte = static_cast<uint8_t>(c);
+		size_t nextIdx = charmap.node(nodeIdx).nextIdx(byte);
+		std::vector<std::pair<uint8_t, size_t>> &edges = charmap.own[nodeIdx - charmap.baseSize].next;
 
 		if (!nextIdx) {
-			// Switch to and zero-init the new node
-			nextIdxRef = charmap.nodes.size();
-			nextIdx = nextIdxRef;
-			// This may reallocate `charmap.nodes` and invalidate `nextIdxRef`,
-			// which is why we keep the actual value in `nextIdx`
-			charmap.nodes.emplace_back();
+			// Add an edge to a new zero-init node, keeping the edges sorted by byte
+			nextIdx = charmap.baseSize + charmap.own.size();
+			edges.insert(
+			    std::lower_bound(
+			        RANGE(edges),
+			        byte,
+			        [](std::pair<uint8_t, size_t> const &edge, uint8_t b) {
+				        return edge.first < b;
+			        }
+			    ),
+			    {byte, nextIdx}
+			);
+			charmap.own.emplace_back();
+		} else if (nextIdx < charmap.baseSize) {
+			// Copy the shared child into the overlay before descending into it
+			charmap.own.push_back((*charmap.base)[nextIdx]);
+			nextIdx = charmap.baseSize + charmap.own.size() - 1;
+			std::find_if(RANGE(edges), [byte](std::pair<uint8_t, size_t> const &edge) {
+				return edge.first == byte;
+			})->second = nextIdx;
 		}
 
 		nodeIdx = nextIdx;
 	}
 
-	CharmapNode &node = charmap.nodes[nodeIdx];
+	CharmapNode &node = charmap.own[nodeIdx - charmap.baseSize]; // Owned by construction
 
 	if (node.isTerminal()) {
 		warning(WARNING_CHARMAP_REDEF, "Overriding charmap mapping");
 	}
 
 	std::swap(node.value, value);
+	charmap.reverseIndexBuilt = false;
 }
 
 bool charmap_HasChar(std::string const &mapping) {
 	Charmap const &charmap = *currentCharmap;
-	size_t nodeIdx = 0;
+	size_t nodeIdx = charmap.root;
 
 	for (char c : mapping) {
-		nodeIdx = charmap.nodes[nodeIdx].next[static_cast<uint8_t>(c)];
+		nodeIdx = charmap.node(nodeIdx).nextIdx(static_cast<uint8_t>(c));
 
 		if (!nodeIdx) {
 			return false;
 		}
 	}
 
-	return charmap.nodes[nodeIdx].isTerminal();
+	return charmap.node(nodeIdx).isTerminal();
 }
 
 static CharmapNode const *charmapEntry(std::string const &mapping) {
 	Charmap const &charmap = *currentCharmap;
-	size_t nodeIdx = 0;
+	size_t nodeIdx = charmap.root;
 
 	for (char c : mapping) {
-		nodeIdx = charmap.nodes[nodeIdx].next[static_cast<uint8_t>(c)];
+		nodeIdx = charmap.node(nodeIdx).nextIdx(static_cast<uint8_t>(c));
 
 		if (!nodeIdx) {
 			return nullptr;
 		}
 	}
 
-	return &charmap.nodes[nodeIdx];
+	return &charmap.node(nodeIdx);
 }
 
 size_t charmap_CharSize(std::string const &mapping) {
@@ -230,8 +319,8 @@ size_t charmap_ConvertNext(std::string_view &input, std::vector<int32_t> *output
 	size_t rewindDistance = 0;
 	size_t inputIdx = 0;
 
-	for (size_t nodeIdx = 0; inputIdx < input.length();) {
-		nodeIdx = charmap.nodes[nodeIdx].next[static_cast<uint8_t>(input[inputIdx])];
+	for (size_t nodeIdx = charmap.root; inputIdx < input.length();) {
+		nodeIdx = charmap.node(nodeIdx).nextIdx(static_cast<uint8_t>(input[inputIdx]));
 
 		if (!nodeIdx) {
 			break;
@@ -239,7 +328,7 @@ size_t charmap_ConvertNext(std::string_view &input, std::vector<int32_t> *output
 
 		++inputIdx; // Consume that char
 
-		if (charmap.nodes[nodeIdx].isTerminal()) {
+		if (charmap.node(nodeIdx).isTerminal()) {
 			matchIdx = nodeIdx; // This node matches, register it
 			rewindDistance = 0; // If no longer match is found, rewind here
 		} else {
@@ -253,7 +342,7 @@ size_t charmap_ConvertNext(std::string_view &input, std::vector<int32_t> *output
 
 	size_t matchLen = 0;
 	if (matchIdx) { // A match was found, use it
-		std::vector<int32_t> const &value = charmap.nodes[matchIdx].value;
+		std::vector<int32_t> const &value = charmap.node(matchIdx).value;
 
 		if (output) {
 			output->insert(output->end(), RANGE(value));
@@ -282,15 +371,20 @@ size_t charmap_ConvertNext(std::string_view &input, std::vector<int32_t> *output
 			);
 		}
 
-		// Warn if this character is not mapped but any others are
-		if (int firstChar = input[inputIdx]; charmap.nodes.size() > 1) {
-			warning(WARNING_UNMAPPED_CHAR_1, "Unmapped character %s", printChar(firstChar));
+		// Warn if this character is not mapped but any others are; this runs for every
+		// character of every unmapped string, so the message is formatted lazily
+		if (int firstChar = input[inputIdx]; !charmap.node(charmap.root).next.empty()) {
+			warning(WARNING_UNMAPPED_CHAR_1, [&]() {
+				fprintf(stderr, "Unmapped character %s", printChar(firstChar));
+			});
 		} else if (charmap.name != DEFAULT_CHARMAP_NAME) {
-			warning(
-			    WARNING_UNMAPPED_CHAR_2,
-			    "Unmapped character %s not in `" DEFAULT_CHARMAP_NAME "` charmap",
-			    printChar(firstChar)
-			);
+			warning(WARNING_UNMAPPED_CHAR_2, [&]() {
+				fprintf(
+				    stderr,
+				    "Unmapped character %s not in `" DEFAULT_CHARMAP_NAME "` charmap",
+				    printChar(firstChar)
+				);
+			});
 		}
 
 		inputIdx += codepointLen;
@@ -302,18 +396,28 @@ size_t charmap_ConvertNext(std::string_view &input, std::vector<int32_t> *output
 }
 
 std::string charmap_Reverse(std::vector<int32_t> const &value, bool &unique) {
-	Charmap const &charmap = *currentCharmap;
-	std::string revMapping;
-	unique = forEachChar(charmap, [&](size_t nodeIdx, std::string const &mapping) {
-		if (charmap.nodes[nodeIdx].value == value) {
-			if (revMapping.empty()) {
-				revMapping = mapping;
-			} else {
-				revMapping.clear();
-				return false;
+	Charmap &charmap = *currentCharmap;
+
+	// Walk the trie once, then answer reverse lookups from the index until the next `CHARMAP`
+	if (!charmap.reverseIndexBuilt) {
+		charmap.reverseIndex.clear();
+		forEachChar(charmap, [&charmap](size_t nodeIdx, std::string const &mapping) {
+			auto [slot, inserted] = charmap.reverseIndex.try_emplace(
+			    charmap.node(nodeIdx).value, mapping, true
+			);
+			if (!inserted) {
+				slot->second.second = false; // Several mappings share this value
 			}
-		}
-		return true;
-	});
-	return revMapping;
+			return true;
+		});
+		charmap.reverseIndexBuilt = true;
+	}
+
+	auto search = charmap.reverseIndex.find(value);
+	if (search == charmap.reverseIndex.end()) {
+		unique = true; // An absent value is not ambiguous, only unmatched
+		return "";
+	}
+	unique = search->second.second;
+	return unique ? search->second.first : "";
 }
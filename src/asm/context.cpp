@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+
+#include "asm/context.hpp"
+
+#include <time.h>
+
+#include "asm/charmap.hpp"
+#include "asm/fstack.hpp"
+#include "asm/lexer.hpp"
+#include "asm/opt.hpp"
+#include "asm/output.hpp"
+#include "asm/profile.hpp"
+#include "asm/section.hpp"
+#include "asm/symbol.hpp"
+#include "asm/warning.hpp"
+
+void ctx_ResetAssembly(time_t now) {
+	// The lexer states are owned by the file stack contexts, so forget them first
+	lexer_Reset();
+	fstk_Reset();
+
+	opt_Reset();
+	charmap_Reset();
+	sect_Reset();
+	out_Reset();
+	warning_Reset();
+	profile_Reset();
+
+	sym_Reset();
+	sym_Init(now);
+}
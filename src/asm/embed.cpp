@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MIT
+
+#include "embed.hpp"
+
+#include <memory>
+#include <stdlib.h>
+#include <time.h>
+
+#include "parser.hpp" // Generated from parser.y
+
+#include "asm/charmap.hpp"
+#include "asm/context.hpp"
+#include "asm/fstack.hpp"
+#include "asm/lexer.hpp"
+#include "asm/main.hpp"
+#include "asm/opt.hpp"
+#include "asm/output.hpp"
+#include "asm/section.hpp"
+#include "asm/warning.hpp"
+
+// Defined here rather than in `main.cpp` so `librgbasm`, which omits the CLI entry point,
+// still links
+Options options;
+
+int rgbasm_assemble(
+    char const *name, char const *source, size_t sourceSize, unsigned char **object,
+    size_t *objectSize
+) {
+	return embed_RunWorker(
+	    [&] {
+		    // Support SOURCE_DATE_EPOCH for reproducible builds
+		    // https://reproducible-builds.org/docs/source-date-epoch/
+		    time_t now = time(nullptr);
+		    if (char const *sourceDateEpoch = getenv("SOURCE_DATE_EPOCH"); sourceDateEpoch) {
+			    now = static_cast<time_t>(strtoul(sourceDateEpoch, nullptr, 0));
+		    }
+		    ctx_ResetAssembly(now);
+		    options.objectFileName = "-"; // The worker's stdout is the capture pipe
+
+		    charmap_New(DEFAULT_CHARMAP_NAME, nullptr);
+
+		    // The worker shares (copy-on-write) memory with the caller, so the source can be
+		    // lexed in place without copying it
+		    fstk_InitBuffer(
+		        name,
+		        {.ptr = std::shared_ptr<char[]>(const_cast<char *>(source), [](char *) {}),
+		         .size = sourceSize}
+		    );
+
+		    // Perform parse (`yy::parser` is auto-generated from `parser.y`)
+		    if (yy::parser parser; parser.parse() != 0 && warnings.nbErrors == 0) {
+			    warnings.nbErrors = 1;
+		    }
+
+		    sect_CheckUnionClosed();
+		    sect_CheckLoadClosed();
+		    sect_CheckSizes();
+
+		    charmap_CheckStack();
+		    opt_CheckStack();
+		    sect_CheckStack();
+
+		    requireZeroErrors();
+
+		    out_WriteObject();
+	    },
+	    object,
+	    objectSize
+	);
+}
@@ -32,6 +32,15 @@ static double rad2turn(double r) {
 	return r / tau;
 }
 
+// Shifts `value` right by `q` bits, rounding half away from zero like `round()`
+static constexpr int64_t roundedShift(int64_t value, int32_t q) {
+	if (q == 0) {
+		return value;
+	}
+	int64_t half = INT64_C(1) << (q - 1);
+	return value < 0 ? -((-value + half) >> q) : (value + half) >> q;
+}
+
 int32_t fix_Sin(int32_t i, int32_t q) {
 	return double2fix(sin(turn2rad(fix2double(i, q))), q);
 }
@@ -61,20 +70,42 @@ int32_t fix_ATan2(int32_t i, int32_t j, int32_t q) {
 }
 
 int32_t fix_Mul(int32_t i, int32_t j, int32_t q) {
+	// Up to 2^53, the product is exactly representable in a double, so the pure-integer
+	// computation is bit-identical to the floating-point one and stays in integer
+	// registers; beyond that (or if the result overflows), defer to the double path
+	if (int64_t product = static_cast<int64_t>(i) * j;
+	    product >= -(INT64_C(1) << 53) && product <= INT64_C(1) << 53) {
+		if (int64_t result = roundedShift(product, q);
+		    result >= INT32_MIN && result <= INT32_MAX) {
+			return static_cast<int32_t>(result);
+		}
+	}
 	return double2fix(fix2double(i, q) * fix2double(j, q), q);
 }
 
 int32_t fix_Div(int32_t i, int32_t j, int32_t q) {
-	double dividend = fix2double(i, q);
-	double divisor = fix2double(j, q);
-	if (fpclassify(divisor) == FP_ZERO) {
-		return dividend < 0 ? INT32_MIN : dividend > 0 ? INT32_MAX : 0;
+	if (j == 0) {
+		return i < 0 ? INT32_MIN : i > 0 ? INT32_MAX : 0;
+	}
+	// When the scaled dividend divides exactly, the quotient needs no rounding at all, so
+	// the pure-integer computation is bit-identical to the floating-point one; inexact
+	// quotients defer to the double path, whose 53-bit rounding is observable
+	if (int64_t num = static_cast<int64_t>(i) << q; num % j == 0) {
+		if (int64_t result = num / j; result >= INT32_MIN && result <= INT32_MAX) {
+			return static_cast<int32_t>(result);
+		}
 	}
-	return double2fix(dividend / divisor, q);
+	return double2fix(fix2double(i, q) / fix2double(j, q), q);
 }
 
-int32_t fix_Mod(int32_t i, int32_t j, int32_t q) {
-	return double2fix(fmod(fix2double(i, q), fix2double(j, q)), q);
+int32_t fix_Mod(int32_t i, int32_t j, [[maybe_unused]] int32_t q) {
+	// `fmod()` is exact, so the double path reduces to C's truncated integer remainder;
+	// `fmod()` by zero is NaN, which `double2fix()` turned into 0, and the remainder by
+	// -1 is always 0 (computing it would overflow for INT32_MIN)
+	if (j == 0 || j == -1) {
+		return 0;
+	}
+	return i % j;
 }
 
 int32_t fix_Pow(int32_t i, int32_t j, int32_t q) {
@@ -89,14 +120,17 @@ int32_t fix_Log(int32_t i, int32_t j, int32_t q) {
 	return double2fix(log(fix2double(i, q)) / divisor, q);
 }
 
+// Rounding to a whole number only manipulates the value's low `q` bits, so these three
+// are computed purely in integers; a double represents the operand and result exactly
 int32_t fix_Round(int32_t i, int32_t q) {
-	return double2fix(round(fix2double(i, q)), q);
+	return static_cast<int32_t>(roundedShift(i, q) << q);
 }
 
 int32_t fix_Ceil(int32_t i, int32_t q) {
-	return double2fix(ceil(fix2double(i, q)), q);
+	int64_t whole = (static_cast<int64_t>(i) >> q) + ((i & ((INT64_C(1) << q) - 1)) != 0);
+	return static_cast<int32_t>(whole << q);
 }
 
 int32_t fix_Floor(int32_t i, int32_t q) {
-	return double2fix(floor(fix2double(i, q)), q);
+	return static_cast<int32_t>((static_cast<int64_t>(i) >> q) << q);
 }
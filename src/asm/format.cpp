@@ -145,7 +145,9 @@ void FormatSpec::appendString(std::string &str, std::string const &value) const
 		error("Formatting string as type '%c'", useType);
 	}
 
-	std::string useValue = exact ? escapeString(value) : value;
+	// Only the (rare) exact flag needs a temporary; otherwise append the value itself
+	std::string escaped = exact ? escapeString(value) : std::string();
+	std::string const &useValue = exact ? escaped : value;
 	size_t valueLen = useValue.length();
 	size_t totalLen = width > valueLen ? width : valueLen;
 	size_t padLen = totalLen - valueLen;
@@ -202,20 +204,21 @@ void FormatSpec::appendNumber(std::string &str, uint32_t value) const {
 	                                   : 0;
 
 	char valueBuf[262]; // Max 5 digits + decimal + 255 fraction digits + terminator
+	size_t valueLen;
 
-	if (useType == 'b') {
-		// Special case for binary
+	// Emits the digits of `value` into `valueBuf`, most significant first
+	auto emitDigits = [&valueBuf, &valueLen](uint32_t v, uint32_t base, char const *digits) {
 		char *ptr = valueBuf;
-
 		do {
-			*ptr++ = (value & 1) + '0';
-			value >>= 1;
-		} while (value);
-
-		// Reverse the digits
+			*ptr++ = digits[v % base];
+			v /= base;
+		} while (v);
 		std::reverse(valueBuf, ptr);
+		valueLen = ptr - valueBuf;
+	};
 
-		*ptr = '\0';
+	if (useType == 'b') {
+		emitDigits(value, 2, "01");
 	} else if (useType == 'f') {
 		// Special case for fixed-point
 
@@ -237,30 +240,30 @@ void FormatSpec::appendNumber(std::string &str, uint32_t value) const {
 			usePrec = defaultPrec;
 		}
 
+		// Floating-point output is the one case still best left to `snprintf`
 		double fval = fabs(value / pow(2.0, usePrec));
 		if (int fracWidthArg = static_cast<int>(useFracWidth); useExact) {
 			snprintf(valueBuf, sizeof(valueBuf), "%.*fq%zu", fracWidthArg, fval, usePrec);
 		} else {
 			snprintf(valueBuf, sizeof(valueBuf), "%.*f", fracWidthArg, fval);
 		}
+		valueLen = strlen(valueBuf);
 	} else if (useType == 'd') {
-		// Decimal numbers may be formatted with a '-' sign by `snprintf`, so `abs` prevents that,
-		// with a special case for `INT32_MIN` since `labs(INT32_MIN)` is UB. The sign will be
-		// printed later from `signChar`.
-		uint32_t uval =
-		    value != static_cast<uint32_t>(INT32_MIN) ? labs(static_cast<int32_t>(value)) : value;
-		snprintf(valueBuf, sizeof(valueBuf), "%" PRIu32, uval);
+		// Emit the magnitude only, with a special case for `INT32_MIN` since negating it is
+		// UB; the sign will be printed later from `signChar`.
+		uint32_t uval = value != static_cast<uint32_t>(INT32_MIN)
+		                    ? labs(static_cast<int32_t>(value))
+		                    : value;
+		emitDigits(uval, 10, "0123456789");
+	} else if (useType == 'X') {
+		emitDigits(value, 16, "0123456789ABCDEF");
+	} else if (useType == 'x') {
+		emitDigits(value, 16, "0123456789abcdef");
+	} else if (useType == 'o') {
+		emitDigits(value, 8, "01234567");
 	} else {
-		char const *spec = useType == 'u'   ? "%" PRIu32
-		                   : useType == 'X' ? "%" PRIX32
-		                   : useType == 'x' ? "%" PRIx32
-		                   : useType == 'o' ? "%" PRIo32
-		                                    : "%" PRIu32;
-
-		snprintf(valueBuf, sizeof(valueBuf), spec, value);
+		emitDigits(value, 10, "0123456789");
 	}
-
-	size_t valueLen = strlen(valueBuf);
 	size_t numLen = (signChar != 0) + (prefixChar != 0) + valueLen;
 	size_t totalLen = width > numLen ? width : numLen;
 	size_t padLen = totalLen - numLen;
@@ -273,7 +276,7 @@ void FormatSpec::appendNumber(std::string &str, uint32_t value) const {
 		if (prefixChar) {
 			str += prefixChar;
 		}
-		str.append(valueBuf);
+		str.append(valueBuf, valueLen);
 		str.append(padLen, ' ');
 	} else {
 		if (padZero) {
@@ -295,6 +298,6 @@ void FormatSpec::appendNumber(std::string &str, uint32_t value) const {
 				str += prefixChar;
 			}
 		}
-		str.append(valueBuf);
+		str.append(valueBuf, valueLen);
 	}
 }
@@ -14,10 +14,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "arena.hpp" // RecyclePool
 #include "backtrace.hpp"
 #include "helpers.hpp"
 #include "linkdefs.hpp"
@@ -27,11 +29,10 @@
 #include "asm/lexer.hpp"
 #include "asm/macro.hpp"
 #include "asm/main.hpp"
+#include "asm/profile.hpp"
 #include "asm/symbol.hpp"
 #include "asm/warning.hpp"
 
-using namespace std::literals;
-
 struct Context {
 	std::shared_ptr<FileStackNode> fileInfo;
 	LexerState lexerState{};
@@ -47,6 +48,8 @@ struct Context {
 	int32_t forValue = 0;
 	int32_t forStep = 0;
 	std::string forName{};
+	Symbol *forSym = nullptr;      // Cached `FOR` variable, updated in place between iterations
+	uint64_t forSymPurgeCount = 0; // `forSym` is only safe to use if no purge happened since
 };
 
 static std::stack<Context> contextStack;
@@ -56,6 +59,29 @@ static std::vector<std::string> includePaths = {""}; // -I
 static std::deque<std::string> preIncludeNames;      // -P
 static bool failedOnMissingInclude = false;
 
+static uint64_t nextUniqueID = 1; // See `fstk_GetUniqueIDStr`
+
+// `\@` strings are recycled through this pool once their last owner pops, so steady
+// macro/`REPT` churn reuses a handful of string allocations instead of making one per
+// invocation
+static RecyclePool<std::shared_ptr<std::string>> uniqueIDStrPool;
+
+static std::shared_ptr<std::string> acquireUniqueIDStr() {
+	std::shared_ptr<std::string> str = uniqueIDStrPool.acquire();
+	if (!str) {
+		return std::make_shared<std::string>();
+	}
+	str->clear(); // Mark the ID as not yet generated; the string keeps its capacity
+	return str;
+}
+
+static void releaseUniqueIDStr(std::shared_ptr<std::string> &&str) {
+	// Only recycle an ID with no other owner; `INCLUDE` contexts share their parent's
+	if (str && str.use_count() == 1) {
+		uniqueIDStrPool.recycle(std::move(str));
+	}
+}
+
 static std::string reptChain(FileStackNode const &node) {
 	std::string chain;
 	std::vector<uint32_t> const &nodeIters = node.iters();
@@ -97,11 +123,46 @@ static std::vector<TraceNode> backtrace(FileStackNode const &node, uint32_t curL
 }
 
 void FileStackNode::printBacktrace(uint32_t curLineNo) const {
-	trace_PrintBacktrace(
-	    backtrace(*this, curLineNo),
-	    [](TraceNode const &node) { return node.first.c_str(); },
-	    [](TraceNode const &node) { return node.second; }
-	);
+	// Resolve quiet nodes to the ancestor that will head the trace, the same way `backtrace`
+	// does, so the cache below is keyed on the node whose trace is actually printed
+	FileStackNode const *node = this;
+	while (node->isQuiet && !tracing.loud) {
+		if (!node->parent) {
+			return; // LCOV_EXCL_LINE
+		}
+		curLineNo = node->type == NODE_REPT ? curLineNo : node->lineNo;
+		node = node->parent.get();
+	}
+
+	// REPT nodes mutate their iteration counts in place as the loop advances, which would
+	// make a cached trace stale, so only cache traces whose entries are all invariant
+	bool cacheable = true;
+	for (FileStackNode const *ancestor = node; ancestor; ancestor = ancestor->parent.get()) {
+		if (ancestor->type == NODE_REPT && (!ancestor->isQuiet || tracing.loud)) {
+			cacheable = false;
+			break;
+		}
+	}
+
+	auto print = [](std::vector<TraceNode> const &traceNodes) {
+		trace_PrintBacktrace(
+		    traceNodes,
+		    [](TraceNode const &traceNode) { return traceNode.first.c_str(); },
+		    [](TraceNode const &traceNode) { return traceNode.second; }
+		);
+	};
+
+	if (!cacheable) {
+		print(backtrace(*node, curLineNo));
+		return;
+	}
+
+	if (node->traceCache.empty()) {
+		node->traceCache = backtrace(*node, curLineNo);
+	}
+	// Everything but the diagnostic's own line number is invariant for a given node
+	node->traceCache.back().second = curLineNo;
+	print(node->traceCache);
 }
 
 void fstk_TraceCurrent() {
@@ -139,13 +200,15 @@ std::shared_ptr<FileStackNode> fstk_GetFileStack() {
 }
 
 std::shared_ptr<std::string> fstk_GetUniqueIDStr() {
-	static uint64_t nextUniqueID = 1;
-
 	std::shared_ptr<std::string> &str = contextStack.top().uniqueIDStr;
 
 	// If a unique ID is allowed but has not been generated yet, generate one now.
+	// The ID is always `_u<number>`, so it is formatted into a fixed-size buffer and copied
+	// into the pooled string, which keeps its capacity across reuses.
 	if (str && str->empty()) {
-		*str = "_u"s + std::to_string(nextUniqueID++);
+		char idBuf[sizeof("_u") + 20]; // 20 chars is enough for any 64-bit number
+		int idLen = snprintf(idBuf, sizeof(idBuf), "_u%" PRIu64, nextUniqueID++);
+		str->assign(idBuf, idLen);
 	}
 
 	return str;
@@ -177,6 +240,13 @@ static bool isValidFilePath(std::string const &path) {
 	return stat(path.c_str(), &statBuf) == 0 && !S_ISDIR(statBuf.st_mode); // Reject directories
 }
 
+// Every input file opened so far, forming the input closure that the object cache hashes
+static std::vector<std::string> openedFiles;
+
+std::vector<std::string> const &fstk_OpenedFiles() {
+	return openedFiles;
+}
+
 static void printDep(std::string const &path) {
 	options.printDep(path);
 	if (options.dependFile && options.generatePhonyDeps && isValidFilePath(path)) {
@@ -185,13 +255,27 @@ static void printDep(std::string const &path) {
 }
 
 std::optional<std::string> fstk_FindFile(std::string const &path) {
-	for (std::string &incPath : includePaths) {
-		if (std::string fullPath = incPath + path; isValidFilePath(fullPath)) {
-			printDep(fullPath);
-			return fullPath;
+	// Resolutions (including definitive misses) are memoized, so each distinct name only
+	// walks the include path list once per process, no matter how often it is referenced.
+	// This is sound because the include path list is fixed once options are parsed.
+	static std::unordered_map<std::string, std::optional<std::string>> resolutionCache;
+
+	auto [slot, inserted] = resolutionCache.try_emplace(path);
+	if (inserted) {
+		for (std::string &incPath : includePaths) {
+			if (std::string fullPath = incPath + path; isValidFilePath(fullPath)) {
+				slot->second = std::move(fullPath);
+				break;
+			}
 		}
 	}
 
+	if (std::optional<std::string> const &fullPath = slot->second; fullPath) {
+		printDep(*fullPath);
+		openedFiles.push_back(*fullPath);
+		return fullPath;
+	}
+
 	errno = ENOENT;
 	if (options.missingIncludeState != INC_ERROR) {
 		printDep(path);
@@ -229,11 +313,19 @@ bool yywrap() {
 			    static_cast<uint32_t>(context.forValue) + static_cast<uint32_t>(context.forStep);
 			context.forValue =
 			    forValue <= INT32_MAX ? forValue : -static_cast<int32_t>(~forValue) - 1;
-			Symbol *sym = sym_AddVar(context.forName, context.forValue);
-
-			// This error message will refer to the current iteration
-			if (sym->type != SYM_VAR) {
-				fatal("Failed to update `FOR` symbol value");
+			if (context.forSym && sym_PurgeCount() == context.forSymPurgeCount
+			    && context.forSym->type == SYM_VAR) {
+				// The variable is still the one we defined, so mutate it in place
+				context.forSym->data = context.forValue;
+			} else {
+				Symbol *sym = sym_AddVar(context.forName, context.forValue);
+
+				// This error message will refer to the current iteration
+				if (sym->type != SYM_VAR) {
+					fatal("Failed to update `FOR` symbol value");
+				}
+				context.forSym = sym;
+				context.forSymPurgeCount = sym_PurgeCount();
 			}
 		}
 		// Advance to the next iteration
@@ -248,6 +340,7 @@ bool yywrap() {
 		return true;
 	}
 
+	releaseUniqueIDStr(std::move(contextStack.top().uniqueIDStr));
 	contextStack.pop();
 	contextStack.top().lexerState.setAsCurrentState();
 
@@ -311,7 +404,7 @@ static void
 
 	Context &context = contextStack.emplace(Context{
 	    .fileInfo = fileInfo,
-	    .uniqueIDStr = std::make_shared<std::string>(), // Create a new, not-yet-generated ID
+	    .uniqueIDStr = acquireUniqueIDStr(), // Acquire a new, not-yet-generated ID
 	    .macroArgs = macroArgs,
 	});
 
@@ -337,7 +430,7 @@ static Context &
 
 	Context &context = contextStack.emplace(Context{
 	    .fileInfo = fileInfo,
-	    .uniqueIDStr = std::make_shared<std::string>(), // Create a new, not-yet-generated ID
+	    .uniqueIDStr = acquireUniqueIDStr(), // Acquire a new, not-yet-generated ID
 	    .macroArgs = oldContext.macroArgs,
 	});
 
@@ -405,6 +498,7 @@ static char const *suggestDef(std::shared_ptr<MacroArgs> const macroArgs) {
 void fstk_RunMacro(
     std::string const &macroName, std::shared_ptr<MacroArgs> macroArgs, bool isQuiet
 ) {
+	profile_Count(PROFILE_MACROS);
 	Symbol *macro = sym_FindExactSymbol(macroName);
 
 	if (!macro) {
@@ -434,6 +528,7 @@ void fstk_RunRept(uint32_t count, int32_t reptLineNo, ContentSpan const &span, b
 	if (count == 0) {
 		return;
 	}
+	profile_Count(PROFILE_LOOPS);
 
 	newReptContext(reptLineNo, span, count, isQuiet);
 }
@@ -469,12 +564,15 @@ void fstk_RunFor(
 	if (count == 0) {
 		return;
 	}
+	profile_Count(PROFILE_LOOPS);
 
 	Context &context = newReptContext(reptLineNo, span, count, isQuiet);
 	context.isForLoop = true;
 	context.forValue = start;
 	context.forStep = step;
 	context.forName = symName;
+	context.forSym = sym_FindExactSymbol(symName);
+	context.forSymPurgeCount = sym_PurgeCount();
 }
 
 bool fstk_Break() {
@@ -494,7 +592,17 @@ void fstk_NewRecursionDepth(size_t newDepth) {
 	options.maxRecursionDepth = newDepth;
 }
 
+// Forget the context stack and opened-file list, so a fresh assembly can `fstk_Init` anew;
+// the include paths and pre-included files are configuration, and stay
+void fstk_Reset() {
+	contextStack = {};
+	failedOnMissingInclude = false;
+	openedFiles.clear();
+	nextUniqueID = 1;
+}
+
 void fstk_Init(std::string const &mainPath) {
+	openedFiles.push_back(mainPath);
 	newFileContext(mainPath, false, true);
 
 	for (std::string const &name : preIncludeNames) {
@@ -505,3 +613,28 @@ void fstk_Init(std::string const &mainPath) {
 		}
 	}
 }
+
+// Like `fstk_Init`, but the main input is an in-memory buffer; used by the embedding API
+void fstk_InitBuffer(std::string const &name, ContentSpan const &span) {
+	openedFiles.push_back(name);
+
+	auto fileInfo = std::make_shared<FileStackNode>(NODE_FILE, name, false);
+	assume(contextStack.empty()); // Buffers can only be main inputs
+
+	Context &context = contextStack.emplace(Context{
+	    .fileInfo = fileInfo,
+	    .uniqueIDStr = nullptr,
+	    .macroArgs = nullptr,
+	});
+	context.lexerState.setBufferAsNextState(name, span);
+
+	for (std::string const &preInclude : preIncludeNames) {
+		if (std::optional<std::string> fullPath = fstk_FindFile(preInclude); fullPath) {
+			newFileContext(*fullPath, false, false);
+		} else {
+			error(
+			    "Error reading pre-included file \"%s\": %s", preInclude.c_str(), strerror(errno)
+			);
+		}
+	}
+}
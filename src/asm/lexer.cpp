@@ -4,36 +4,40 @@
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <array>
 #include <errno.h>
 #include <fcntl.h>
-#include <fstream>
 #include <inttypes.h>
-#include <ios>
 #include <limits.h>
 #include <math.h>
 #include <memory>
-#include <new> // nothrow
 #include <optional>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "arena.hpp" // RecyclePool
+#include "file.hpp"
 #include "helpers.hpp"
 #include "platform.hpp"
 #include "style.hpp"
 #include "util.hpp"
 #include "verbosity.hpp"
+#include "version.hpp"
 
+#include "asm/cache.hpp"
 #include "asm/format.hpp"
 #include "asm/fstack.hpp"
 #include "asm/macro.hpp"
 #include "asm/main.hpp"
+#include "asm/profile.hpp"
 #include "asm/rpn.hpp"
 #include "asm/symbol.hpp"
 #include "asm/warning.hpp"
@@ -54,9 +58,50 @@ struct Token {
 	Token(int type_, std::string &&value_) : type(type_), value(value_) {}
 };
 
-// This map lists all RGBASM keywords which `yylex_NORMAL` lexes as identifiers.
+// A cached token stream for a `ContentSpan` of source, such as a macro body: the span is
+// lexed normally once while its tokens are recorded, and later invocations replay the
+// recorded tokens without re-lexing the characters.
+// A token whose lexing depended on anything besides the source text itself (macro args,
+// `\@`, interpolations, EQUS expansions, anonymous label refs, digit options, skipped
+// conditional blocks, or anything that emitted a diagnostic) is recorded as "dynamic":
+// replay suspends right before it and falls back to lexing chars, which resolves expansions
+// against the current invocation, and resumes once the read cursor converges with a
+// recorded static token boundary again.
+struct TokenStream {
+	struct RecordedToken {
+		Token token;
+		size_t endOffset;   // The view's offset right after the token was lexed, or
+		                    // `SIZE_MAX` if an expansion was still active then
+		uint32_t endLineNo; // The line number right after the token was lexed
+		bool dynamic;       // Whether the token must be re-lexed on every replay
+	};
+
+	ContentSpan span;     // Keeps the source alive (and its address stable) while cached
+	uint32_t startLineNo; // The line number the span starts at
+	std::vector<RecordedToken> tokens;
+	uint64_t contentHash = 0; // Nonzero for a whole file's stream, which `--cache` can store
+	bool complete = false;    // Whether recording reached the end of the span
+	bool recording = false;   // Whether some lexer state is currently recording
+};
+
+// Keyed by the address of the span's contents, which `TokenStream::span` keeps stable.
+// An incomplete entry that is not being recorded failed to record, and is never retried.
+static std::unordered_map<char const *, std::shared_ptr<TokenStream>> tokenStreamCache;
+
+// Token streams for whole files, keyed by a hash of their contents. A recorded static token
+// depends only on the source bytes, so these streams remain valid across assemblies: the
+// cache outlives `lexer_Reset`, letting in-process reuse (such as the embedding API, or a
+// file `INCLUDE`d several times) skip re-lexing a file already seen.
+static std::unordered_map<uint64_t, std::shared_ptr<TokenStream>> fileStreamCache;
+
+static void attachFileTokenStream(LexerState &state);
+
+// Set whenever the token currently being lexed depends on more than the source text
+static bool lexedDynamicToken;
+
+// This list contains all RGBASM keywords which `yylex_NORMAL` lexes as identifiers.
 // All non-identifier tokens are lexed separately.
-static UpperMap<int> const keywordDict{
+static constexpr std::pair<std::string_view, int> keywords[] = {
     {"ADC",           T_(SM83_ADC)         },
     {"ADD",           T_(SM83_ADD)         },
     {"AND",           T_(SM83_AND)         },
@@ -257,13 +302,122 @@ static UpperMap<int> const keywordDict{
     {"OPT",           T_(POP_OPT)          },
 };
 
+// The keyword set is frozen at compile time, so identifiers are classified against a
+// constexpr open-addressing hash table built from `keywords`, rather than a runtime map.
+// A lookup is a couple of probes, uppercasing the query on the fly as it is hashed
+// instead of making a case-folded copy.
+static constexpr char upperChar(char c) {
+	return c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c;
+}
+
+struct KeywordDict {
+	// Must be a power of two, and large enough to keep the load factor low
+	static constexpr size_t nbSlots = 1024;
+	static_assert(nbSlots >= 2 * std::size(keywords), "Keyword dictionary is too full");
+
+	std::array<std::pair<std::string_view, int>, nbSlots> slots{};
+
+	// FNV-1a hash of an uppercased string (keywords are already stored uppercase)
+	static constexpr size_t hash(std::string_view str) {
+		size_t hashValue = 0x811C9DC5;
+		for (char c : str) {
+			hashValue = (hashValue ^ upperChar(c)) * 16777619;
+		}
+		return hashValue;
+	}
+
+	consteval KeywordDict() {
+		for (std::pair<std::string_view, int> const &keyword : keywords) {
+			size_t slot = hash(keyword.first) % nbSlots;
+			while (!slots[slot].first.empty()) {
+				slot = (slot + 1) % nbSlots; // Linear probing
+			}
+			slots[slot] = keyword;
+		}
+	}
+
+	// Returns the keyword's token type, or `nullptr` if the identifier is not a keyword
+	int const *find(std::string const &str) const {
+		for (size_t slot = hash(str) % nbSlots;; slot = (slot + 1) % nbSlots) {
+			std::pair<std::string_view, int> const &candidate = slots[slot];
+			if (candidate.first.empty()) {
+				return nullptr; // Empty slot, so no keyword has this hash
+			}
+			if (candidate.first.length() == str.length()
+			    && std::equal(RANGE(str), candidate.first.begin(), [](char c1, char c2) {
+				       return upperChar(c1) == c2;
+			       })) {
+				return &candidate.second;
+			}
+		}
+	}
+};
+
+static constexpr KeywordDict keywordDict{};
+
 static LexerState *lexerState = nullptr;
 static LexerState *lexerStateEOL = nullptr;
 
+// Cumulative bytes of source content mapped, read, or captured (reported by `--mem-stats`)
+static uint64_t bufferedBytes = 0;
+
+uint64_t lexer_CountBufferedBytes() {
+	return bufferedBytes;
+}
+
+// Capture slabs are recycled here once a capture ends, so successive macro and `REPT`
+// bodies within one assembly reuse the same handful of allocations
+static RecyclePool<std::unique_ptr<char[]>> captureSlabPool;
+
+CaptureSlabs::~CaptureSlabs() {
+	for (std::unique_ptr<char[]> &slab : slabs) {
+		captureSlabPool.recycle(std::move(slab));
+	}
+}
+
+void CaptureSlabs::append(char c) {
+	if (offset == SLAB_SIZE) {
+		std::unique_ptr<char[]> slab = captureSlabPool.acquire();
+		if (!slab) {
+			slab = std::make_unique<char[]>(SLAB_SIZE);
+		}
+		slabs.push_back(std::move(slab));
+		offset = 0;
+	}
+	slabs.back()[offset++] = c;
+}
+
+std::shared_ptr<char[]> CaptureSlabs::flatten(size_t size) const {
+	auto contents = std::make_shared<char[]>(size);
+	size_t copied = 0;
+	for (std::unique_ptr<char[]> const &slab : slabs) {
+		size_t chunk = std::min(size - copied, SLAB_SIZE);
+		memcpy(&contents[copied], slab.get(), chunk);
+		copied += chunk;
+		if (copied == size) {
+			break;
+		}
+	}
+	bufferedBytes += size;
+	return contents;
+}
+
 bool lexer_AtTopLevel() {
 	return lexerState == nullptr;
 }
 
+// Forget all lexer state, so a fresh assembly starts from scratch; the states themselves
+// are owned by the file stack contexts, which `fstk_Reset` destroys
+void lexer_Reset() {
+	// `fileStreamCache` purposely survives resets: it is keyed by content hash, and its
+	// streams do not depend on the state of the assembly that recorded them
+	tokenStreamCache.clear();
+	lexedDynamicToken = false;
+	lexerState = nullptr;
+	lexerStateEOL = nullptr;
+	bufferedBytes = 0;
+}
+
 void LexerState::clear(uint32_t lineNo_) {
 	mode = LEXER_NORMAL;
 	atLineStart = true;
@@ -273,7 +427,7 @@ void LexerState::clear(uint32_t lineNo_) {
 	ifStack.clear();
 
 	capturing = false;
-	captureBuf = nullptr;
+	captureSlabs = nullptr;
 
 	disableExpansions = false;
 	expansionScanDistance = 0;
@@ -281,6 +435,14 @@ void LexerState::clear(uint32_t lineNo_) {
 
 	expansions.clear();
 
+	if (tokenStream && !tokenStream->complete) {
+		// An abandoned recording stays in the cache as incomplete, and is never retried
+		tokenStream->recording = false;
+	}
+	tokenStream = nullptr;
+	replayIndex = SIZE_MAX;
+	replaySuspended = false;
+
 	lineNo = lineNo_; // Will be incremented at next line start
 }
 
@@ -331,6 +493,7 @@ void LexerState::setFileAsNextState(std::string const &filePath, bool updateStat
 	if (filePath == "-") {
 		path = "<stdin>";
 		content.emplace<BufferedContent>(STDIN_FILENO);
+		bufferedBytes += LEXER_BUF_SIZE;
 		verbosePrint(VERB_INFO, "Opening stdin\n"); // LCOV_EXCL_LINE
 	} else {
 		struct stat statBuf;
@@ -341,25 +504,25 @@ void LexerState::setFileAsNextState(std::string const &filePath, bool updateStat
 		}
 		path = filePath;
 
-		if (std::streamsize size = statBuf.st_size; statBuf.st_size > 0) {
-			// Read the entire file for better performance
-			// Ideally we'd use C++20 `auto ptr = std::make_shared<char[]>(size)`,
-			// but it has insufficient compiler support
-			auto ptr = std::shared_ptr<char[]>(new (std::nothrow) char[size]);
-
-			if (std::ifstream fs(path, std::ios::binary); !fs) {
+		if (S_ISREG(statBuf.st_mode) && statBuf.st_size > 0) {
+			// Mapping the file pages large files in lazily, and lets concurrent processes
+			// assembling the same sources share the pages
+			MappedFile file;
+			if (!file.open(path)) {
 				// LCOV_EXCL_START
 				fatal("Failed to open file \"%s\": %s", path.c_str(), strerror(errno));
 				// LCOV_EXCL_STOP
-			} else if (!fs.read(ptr.get(), size) || fs.gcount() != size) {
-				// LCOV_EXCL_START
-				fatal("Failed to read file \"%s\": %s", path.c_str(), strerror(errno));
-				// LCOV_EXCL_STOP
 			}
-			content.emplace<ViewedContent>(ptr, size);
+			content.emplace<ViewedContent>(file.share(), file.size());
+			bufferedBytes += file.size();
 
 			// LCOV_EXCL_START
-			verbosePrint(VERB_INFO, "File \"%s\" is fully read\n", path.c_str());
+			verbosePrint(
+			    VERB_INFO,
+			    "File \"%s\" is %s\n",
+			    path.c_str(),
+			    file.isMapped() ? "memory-mapped" : "fully read"
+			);
 			// LCOV_EXCL_STOP
 		} else {
 			// LCOV_EXCL_START
@@ -380,12 +543,18 @@ void LexerState::setFileAsNextState(std::string const &filePath, bool updateStat
 				// LCOV_EXCL_STOP
 			}
 			content.emplace<BufferedContent>(fd);
+			bufferedBytes += LEXER_BUF_SIZE;
 
 			verbosePrint(VERB_INFO, "File \"%s\" is opened\n", path.c_str()); // LCOV_EXCL_LINE
 		}
 	}
 
 	clear(0);
+	if (std::holds_alternative<ViewedContent>(content)) {
+		// Whole files get their token streams cached too: `INCLUDE`ing a file already seen
+		// (by this process, or by a previous one populating `--cache`) replays its tokens
+		attachFileTokenStream(*this);
+	}
 	if (updateStateNow) {
 		lexerState = this;
 	} else {
@@ -393,18 +562,238 @@ void LexerState::setFileAsNextState(std::string const &filePath, bool updateStat
 	}
 }
 
+static void startRecording(LexerState &state, std::shared_ptr<TokenStream> const &stream) {
+	stream->recording = true;
+	state.tokenStream = stream;
+	state.replayIndex = SIZE_MAX;
+}
+
+static void attachReplay(LexerState &state, std::shared_ptr<TokenStream> const &stream) {
+	state.tokenStream = stream;
+	state.replayIndex = 0;
+	state.replaySuspended = false;
+}
+
+// If the span's token stream has already been recorded, schedule it for replay; if the
+// span has never been seen before, start recording its token stream
+static void attachTokenStream(LexerState &state, ContentSpan const &span, uint32_t lineNo) {
+	auto [slot, inserted] = tokenStreamCache.try_emplace(span.ptr.get());
+	if (inserted) {
+		slot->second = std::make_shared<TokenStream>();
+		slot->second->span = span;
+		slot->second->startLineNo = lineNo;
+		startRecording(state, slot->second);
+	} else if (std::shared_ptr<TokenStream> const &stream = slot->second;
+	           stream->complete && stream->startLineNo == lineNo) {
+		attachReplay(state, stream);
+	}
+}
+
+// Serialized token streams begin with this magic, followed by the version string (parsing a
+// blob serialized by a different version is not worth attempting), the span's size, the
+// token count, and then each recorded token
+static constexpr char tokenBlobMagic[8] = {'R', 'G', 'B', 'L', 'E', 'X', '\0', '\1'};
+
+template<typename T>
+static void serializeValue(std::vector<uint8_t> &blob, T value) {
+	uint8_t const *bytes = reinterpret_cast<uint8_t const *>(&value);
+	blob.insert(blob.end(), bytes, bytes + sizeof(value));
+}
+
+static void serializeString(std::vector<uint8_t> &blob, std::string_view str) {
+	serializeValue<uint64_t>(blob, str.length());
+	blob.insert(blob.end(), str.begin(), str.end());
+}
+
+static std::vector<uint8_t> serializeTokenStream(TokenStream const &stream) {
+	std::vector<uint8_t> blob;
+	blob.insert(blob.end(), std::begin(tokenBlobMagic), std::end(tokenBlobMagic));
+	serializeString(blob, get_package_version_string());
+	serializeValue<uint64_t>(blob, stream.span.size);
+	serializeValue<uint64_t>(blob, stream.tokens.size());
+	for (TokenStream::RecordedToken const &rec : stream.tokens) {
+		serializeValue<int32_t>(blob, rec.token.type);
+		if (std::holds_alternative<uint32_t>(rec.token.value)) {
+			serializeValue<uint8_t>(blob, 1);
+			serializeValue<uint32_t>(blob, std::get<uint32_t>(rec.token.value));
+		} else if (std::holds_alternative<std::string>(rec.token.value)) {
+			serializeValue<uint8_t>(blob, 2);
+			serializeString(blob, std::get<std::string>(rec.token.value));
+		} else {
+			serializeValue<uint8_t>(blob, 0);
+		}
+		serializeValue<uint64_t>(blob, rec.endOffset == SIZE_MAX ? UINT64_MAX : rec.endOffset);
+		serializeValue<uint32_t>(blob, rec.endLineNo);
+		serializeValue<uint8_t>(blob, rec.dynamic);
+	}
+	return blob;
+}
+
+struct TokenBlobReader {
+	uint8_t const *ptr;
+	size_t remaining;
+
+	bool read(void *dest, size_t size) {
+		if (size > remaining) {
+			return false;
+		}
+		memcpy(dest, ptr, size);
+		ptr += size;
+		remaining -= size;
+		return true;
+	}
+
+	template<typename T>
+	std::optional<T> read() {
+		T value;
+		return read(&value, sizeof(value)) ? std::optional<T>(value) : std::nullopt;
+	}
+
+	std::optional<std::string> readString() {
+		std::optional<uint64_t> length = read<uint64_t>();
+		if (!length || *length > remaining) {
+			return std::nullopt;
+		}
+		std::string str(reinterpret_cast<char const *>(ptr), *length);
+		ptr += *length;
+		remaining -= *length;
+		return str;
+	}
+};
+
+// Returns `nullptr` if the blob is malformed or does not describe the span; both would take
+// a content hash collision, but a corrupt cache must not crash the assembler
+static std::shared_ptr<TokenStream> deserializeTokenStream(
+    std::vector<uint8_t> const &blob, ContentSpan const &span, uint64_t contentHash
+) {
+	TokenBlobReader reader{blob.data(), blob.size()};
+
+	char magic[sizeof(tokenBlobMagic)];
+	if (!reader.read(magic, sizeof(magic)) || memcmp(magic, tokenBlobMagic, sizeof(magic)) != 0) {
+		return nullptr;
+	}
+	if (std::optional<std::string> version = reader.readString();
+	    !version || *version != get_package_version_string()) {
+		return nullptr;
+	}
+	if (std::optional<uint64_t> spanSize = reader.read<uint64_t>();
+	    !spanSize || *spanSize != span.size) {
+		return nullptr;
+	}
+	std::optional<uint64_t> nbTokens = reader.read<uint64_t>();
+	// The serialization of a token takes at least 18 bytes, which bounds a sane count
+	if (!nbTokens || *nbTokens > reader.remaining / 18) {
+		return nullptr;
+	}
+
+	auto stream = std::make_shared<TokenStream>();
+	stream->span = span;
+	stream->startLineNo = 0;
+	stream->contentHash = contentHash;
+	stream->tokens.reserve(*nbTokens);
+	for (uint64_t i = 0; i < *nbTokens; ++i) {
+		std::optional<int32_t> type = reader.read<int32_t>();
+		std::optional<uint8_t> kind = reader.read<uint8_t>();
+		if (!type || !kind) {
+			return nullptr;
+		}
+		Token token(*type);
+		if (*kind == 1) {
+			std::optional<uint32_t> value = reader.read<uint32_t>();
+			if (!value) {
+				return nullptr;
+			}
+			token.value = *value;
+		} else if (*kind == 2) {
+			std::optional<std::string> value = reader.readString();
+			if (!value) {
+				return nullptr;
+			}
+			token.value = std::move(*value);
+		} else if (*kind != 0) {
+			return nullptr;
+		}
+		std::optional<uint64_t> endOffset = reader.read<uint64_t>();
+		std::optional<uint32_t> endLineNo = reader.read<uint32_t>();
+		std::optional<uint8_t> dynamic = reader.read<uint8_t>();
+		if (!endOffset || !endLineNo || !dynamic
+		    || (*endOffset != UINT64_MAX && *endOffset > span.size)) {
+			return nullptr;
+		}
+		stream->tokens.push_back({
+		    .token = std::move(token),
+		    .endOffset = *endOffset == UINT64_MAX ? SIZE_MAX : static_cast<size_t>(*endOffset),
+		    .endLineNo = *endLineNo,
+		    .dynamic = *dynamic != 0,
+		});
+	}
+	// Only complete streams get serialized, so a valid blob ends at its `EOB` token
+	if (reader.remaining != 0 || stream->tokens.empty()
+	    || stream->tokens.back().token.type != T_(EOB)) {
+		return nullptr;
+	}
+	stream->complete = true;
+	return stream;
+}
+
+// Attaches the token stream for a whole file's contents, recording it on first sight; with
+// `--cache`, completed streams are also stored on disk, so even a fresh process can replay
+// the tokens of a header another invocation already lexed
+static void attachFileTokenStream(LexerState &state) {
+	auto const &view = std::get<ViewedContent>(state.content);
+	uint64_t contentHash = cache_HashContents(view.span.ptr.get(), view.span.size);
+
+	auto [slot, inserted] = fileStreamCache.try_emplace(contentHash);
+	if (inserted) {
+		if (std::optional<std::vector<uint8_t>> blob = cache_LoadTokenStream(contentHash); blob) {
+			if (std::shared_ptr<TokenStream> stream =
+			        deserializeTokenStream(*blob, view.span, contentHash);
+			    stream) {
+				slot->second = stream;
+				attachReplay(state, stream);
+				return;
+			}
+		}
+		slot->second = std::make_shared<TokenStream>();
+		slot->second->span = view.span;
+		slot->second->startLineNo = 0;
+		slot->second->contentHash = contentHash;
+		startRecording(state, slot->second);
+	} else if (std::shared_ptr<TokenStream> const &stream = slot->second; stream->complete) {
+		attachReplay(state, stream);
+	}
+}
+
 void LexerState::setViewAsNextState(char const *name, ContentSpan const &span, uint32_t lineNo_) {
 	path = name; // Used to report read errors in `.peek()`
 	content.emplace<ViewedContent>(span);
 	clear(lineNo_);
+	if (!strcmp(name, "MACRO") || !strcmp(name, "REPT")) {
+		attachTokenStream(*this, span, lineNo_);
+	}
 	lexerStateEOL = this;
 }
 
+// Lexes from an in-memory buffer as if it were a file's contents; used by the embedding API
+void LexerState::setBufferAsNextState(std::string const &name, ContentSpan const &span) {
+	path = name;
+	content.emplace<ViewedContent>(span);
+	bufferedBytes += span.size;
+	clear(0);
+	lexerState = this;
+}
+
 void lexer_RestartRept(uint32_t lineNo) {
 	if (std::holds_alternative<ViewedContent>(lexerState->content)) {
-		std::get<ViewedContent>(lexerState->content).offset = 0;
+		ViewedContent &view = std::get<ViewedContent>(lexerState->content);
+		view.offset = 0;
+		lexerState->clear(lineNo);
+		// The first iteration recorded the body's token stream (unless it bailed);
+		// further iterations replay it, re-lexing only what depends on the iteration
+		attachTokenStream(*lexerState, view.span, lineNo);
+	} else {
+		lexerState->clear(lineNo);
 	}
-	lexerState->clear(lineNo);
 }
 
 LexerState::~LexerState() {
@@ -420,6 +809,12 @@ LexerState::~LexerState() {
 	// It could be argued that deleting a state that's scheduled for EOF could simply clear
 	// `lexerStateEOL`, but there's currently no situation in which this should happen.
 	assume(this != lexerStateEOL);
+
+	if (tokenStream && !tokenStream->complete) {
+		// Recording ended early (e.g. the context was exited by `fatal`);
+		// the incomplete cache entry is never retried
+		tokenStream->recording = false;
+	}
 }
 
 bool Expansion::advance() {
@@ -496,6 +891,9 @@ void lexer_ToggleStringExpansion(bool enable) {
 // Functions for the actual lexer to obtain characters
 
 static void beginExpansion(std::shared_ptr<std::string> str, std::optional<std::string> name) {
+	lexedDynamicToken = true; // Expanded contents are not part of the source text
+	profile_Count(PROFILE_EXPANSIONS);
+
 	if (name) {
 		lexer_CheckRecursionDepth();
 	}
@@ -596,6 +994,8 @@ static uint32_t readBracketedMacroArgNum() {
 }
 
 static std::shared_ptr<std::string> readMacroArg() {
+	lexedDynamicToken = true; // Macro args differ between invocations
+
 	if (int c = bumpChar(); c == '@') {
 		std::shared_ptr<std::string> str = fstk_GetUniqueIDStr();
 		if (!str) {
@@ -759,10 +1159,10 @@ static int peek() {
 
 static void shiftChar() {
 	if (lexerState->capturing) {
-		if (lexerState->captureBuf) {
+		if (lexerState->captureSlabs) {
 			int c = peek();
 			assume(c != EOF); // Avoid calling `shiftChar()` when it could be EOF while capturing
-			lexerState->captureBuf->push_back(c);
+			lexerState->captureSlabs->append(c);
 		}
 		++lexerState->captureSize;
 	}
@@ -830,6 +1230,45 @@ static void handleCRLF(int c) {
 	}
 }
 
+// The `peek()` / `shiftChar()` funnel above performs expansion and bounds checks for every
+// single char. When lexing from a fully-buffered file with no active expansion, runs of
+// "plain" bytes (comment bodies, blank space, string literal contents...) can instead be
+// consumed in bulk by scanning the underlying buffer directly.
+// `isPlain` receives the raw byte; a byte that needs slow-path handling (in particular '\\'
+// and '{', which may begin an expansion) must not be "plain", so that the scan stops right
+// before it. Returns the consumed run, which points into the (stable) file buffer.
+template<typename P>
+static std::string_view bulkConsumePlainChars(P isPlain) {
+	if (lexerState->capturing || !lexerState->expansions.empty()
+	    || !std::holds_alternative<ViewedContent>(lexerState->content)) {
+		return {};
+	}
+
+	ViewedContent &view = std::get<ViewedContent>(lexerState->content);
+	char const *ptr = view.span.ptr.get();
+	size_t const start = view.offset, size = view.span.size;
+	size_t offset = start;
+	while (offset < size && isPlain(static_cast<uint8_t>(ptr[offset]))) {
+		++offset;
+	}
+
+	view.offset = offset;
+	// The run was consumed without `shiftChar()`, so account for any chars that `peek()`
+	// had already scanned for expansions
+	lexerState->expansionScanDistance -=
+	    std::min(lexerState->expansionScanDistance, offset - start);
+	return std::string_view(&ptr[start], offset - start);
+}
+
+// SWAR helpers for scanning a buffer a 64-bit word at a time:
+// broadcast a byte to all 8 lanes, and detect a zero byte in a word (Mycroft's algorithm)
+static constexpr uint64_t broadcastByte(uint8_t c) {
+	return UINT64_C(0x0101010101010101) * c;
+}
+static constexpr uint64_t hasZeroByte(uint64_t word) {
+	return (word - UINT64_C(0x0101010101010101)) & ~word & UINT64_C(0x8080808080808080);
+}
+
 static auto scopedDisableExpansions() {
 	lexerState->disableExpansions = true;
 	return Defer{[&] { lexerState->disableExpansions = false; }};
@@ -896,6 +1335,30 @@ static void discardBlockComment() {
 
 static void discardComment() {
 	Defer reenableExpansions = scopedDisableExpansions();
+	// Comments can only end at a newline (or EOF), so when lexing from a fully-buffered
+	// file, look for the newline a whole word at a time instead of char by char
+	if (!lexerState->capturing && lexerState->expansions.empty()
+	    && std::holds_alternative<ViewedContent>(lexerState->content)) {
+		ViewedContent &view = std::get<ViewedContent>(lexerState->content);
+		char const *ptr = view.span.ptr.get();
+		size_t const start = view.offset, size = view.span.size;
+		size_t offset = start;
+		while (offset + sizeof(uint64_t) <= size) {
+			uint64_t word;
+			memcpy(&word, &ptr[offset], sizeof(word));
+			if (hasZeroByte(word ^ broadcastByte('\n'))
+			    || hasZeroByte(word ^ broadcastByte('\r'))) {
+				break;
+			}
+			offset += sizeof(uint64_t);
+		}
+		while (offset < size && !isNewline(static_cast<uint8_t>(ptr[offset]))) {
+			++offset;
+		}
+		view.offset = offset;
+		lexerState->expansionScanDistance -=
+		    std::min(lexerState->expansionScanDistance, offset - start);
+	}
 	skipChars([](int c) { return c != EOF && !isNewline(c); });
 }
 
@@ -923,6 +1386,8 @@ static void discardLineContinuation() {
 // Functions to read tokenizable values
 
 static std::string readAnonLabelRef(char c) {
+	lexedDynamicToken = true; // The name depends on how many anonymous labels exist
+
 	// We come here having already peeked at one char, so no need to do it again
 	uint32_t n = 1;
 	while (nextChar() == c) {
@@ -932,6 +1397,7 @@ static std::string readAnonLabelRef(char c) {
 }
 
 static uint32_t readFractionalPart(uint32_t integer) {
+	lexedDynamicToken = true; // The value depends on the current `OPT Q` precision
 	uint32_t value = 0, divisor = 1;
 	uint8_t precision = 0;
 	enum {
@@ -1047,10 +1513,41 @@ void lexer_SetGfxDigits(char const digits[4]) {
 }
 
 static uint32_t readBinaryNumber(char const *prefix) {
+	lexedDynamicToken = true; // The value depends on the current `OPT b` digits
 	uint32_t value = 0;
 	bool empty = true;
 	bool nonDigit = false;
 
+	// Fold a directly-addressable run of digits and separators in bulk; the per-char loop
+	// below picks up whatever follows it (e.g. an expansion continuing the literal)
+	for (char c : bulkConsumePlainChars([](uint8_t b) {
+		     return b == '0' || b == '1' || b == options.binDigits[0]
+		            || b == options.binDigits[1] || b == '_';
+	     })) {
+		if (c == '_') {
+			if (nonDigit) {
+				error("Invalid integer constant, '_' after another '_'");
+			}
+			nonDigit = true;
+			continue;
+		}
+
+		int bit = c == '1' || c == options.binDigits[1] ? 1 : 0;
+		empty = false;
+		nonDigit = false;
+
+		if (value > (UINT32_MAX - bit) / 2) {
+			warning(WARNING_LARGE_CONSTANT, "Integer constant is too large");
+			// Discard any additional digits
+			skipChars([](int d) {
+				return d == '0' || d == '1' || d == options.binDigits[0]
+				       || d == options.binDigits[1] || d == '_';
+			});
+			return 0;
+		}
+		value = value * 2 + bit;
+	}
+
 	for (int c = peek();; c = nextChar()) {
 		if (c == '_') {
 			if (nonDigit) {
@@ -1098,6 +1595,27 @@ static uint32_t readOctalNumber(char const *prefix) {
 	bool empty = true;
 	bool nonDigit = false;
 
+	for (char c : bulkConsumePlainChars([](uint8_t b) { return isOctDigit(b) || b == '_'; })) {
+		if (c == '_') {
+			if (nonDigit) {
+				error("Invalid integer constant, '_' after another '_'");
+			}
+			nonDigit = true;
+			continue;
+		}
+
+		empty = false;
+		nonDigit = false;
+
+		if (value > (UINT32_MAX - (c - '0')) / 8) {
+			warning(WARNING_LARGE_CONSTANT, "Integer constant is too large");
+			// Discard any additional digits
+			skipChars([](int d) { return isOctDigit(d) || d == '_'; });
+			return 0;
+		}
+		value = value * 8 + (c - '0');
+	}
+
 	for (int c = peek();; c = nextChar()) {
 		if (c == '_') {
 			if (nonDigit) {
@@ -1139,6 +1657,26 @@ static uint32_t readDecimalNumber(int initial) {
 	uint32_t value = initial - '0';
 	bool nonDigit = false;
 
+	for (char c : bulkConsumePlainChars([](uint8_t b) { return isDigit(b) || b == '_'; })) {
+		if (c == '_') {
+			if (nonDigit) {
+				error("Invalid integer constant, '_' after another '_'");
+			}
+			nonDigit = true;
+			continue;
+		}
+
+		nonDigit = false;
+
+		if (value > (UINT32_MAX - (c - '0')) / 10) {
+			warning(WARNING_LARGE_CONSTANT, "Integer constant is too large");
+			// Discard any additional digits
+			skipChars([](int d) { return isDigit(d) || d == '_'; });
+			return 0;
+		}
+		value = value * 10 + (c - '0');
+	}
+
 	for (int c = peek();; c = nextChar()) {
 		if (c == '_') {
 			if (nonDigit) {
@@ -1176,6 +1714,35 @@ static uint32_t readHexNumber(char const *prefix) {
 	bool empty = true;
 	bool nonDigit = false;
 
+	for (char c : bulkConsumePlainChars([](uint8_t b) { return isHexDigit(b) || b == '_'; })) {
+		if (c == '_') {
+			if (nonDigit) {
+				error("Invalid integer constant, '_' after another '_'");
+			}
+			nonDigit = true;
+			continue;
+		}
+
+		int digit;
+		if (c >= 'a' && c <= 'f') {
+			digit = c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			digit = c - 'A' + 10;
+		} else {
+			digit = c - '0';
+		}
+		empty = false;
+		nonDigit = false;
+
+		if (value > (UINT32_MAX - digit) / 16) {
+			warning(WARNING_LARGE_CONSTANT, "Integer constant is too large");
+			// Discard any additional digits
+			skipChars([](int d) { return isHexDigit(d) || d == '_'; });
+			return 0;
+		}
+		value = value * 16 + digit;
+	}
+
 	for (int c = peek();; c = nextChar()) {
 		if (c == '_') {
 			if (nonDigit) {
@@ -1217,6 +1784,7 @@ static uint32_t readHexNumber(char const *prefix) {
 }
 
 static uint32_t readGfxConstant() {
+	lexedDynamicToken = true; // The value depends on the current `OPT g` digits
 	uint32_t bitPlaneLower = 0, bitPlaneUpper = 0;
 	uint8_t width = 0;
 	bool nonDigit = false;
@@ -1285,8 +1853,8 @@ static Token readIdentifier(char firstChar, bool raw) {
 
 	// Attempt to check for a keyword if the identifier is not raw or a local label
 	if (!raw && tokenType != T_(LOCAL)) {
-		if (auto search = keywordDict.find(identifier); search != keywordDict.end()) {
-			return Token(search->second);
+		if (int const *tokenType = keywordDict.find(identifier); tokenType) {
+			return Token(*tokenType);
 		}
 	}
 
@@ -1300,7 +1868,14 @@ static Token readIdentifier(char firstChar, bool raw) {
 
 // Functions to read strings
 
+// Memoized text of default-format numeric interpolations, keyed by the symbol's interned
+// name ID and holding the value the text was formatted from (see `readInterpolation`)
+static std::unordered_map<uint32_t, std::pair<uint32_t, std::shared_ptr<std::string>>>
+    interpolationCache;
+
 static std::pair<Symbol const *, std::shared_ptr<std::string>> readInterpolation(size_t depth) {
+	lexedDynamicToken = true; // Interpolations depend on current symbol values
+
 	if (depth > options.maxRecursionDepth) {
 		fatal("Recursion limit (%zu) exceeded", options.maxRecursionDepth);
 	}
@@ -1338,7 +1913,7 @@ static std::pair<Symbol const *, std::shared_ptr<std::string>> readInterpolation
 	if (identifier.starts_with('#')) {
 		// Skip a '#' raw symbol prefix, but after expanding any nested interpolations.
 		identifier.erase(0, 1);
-	} else if (keywordDict.find(identifier) != keywordDict.end()) {
+	} else if (keywordDict.find(identifier)) {
 		// Don't allow symbols that alias keywords without a '#' prefix.
 		error(
 		    "Interpolated symbol `%s` is a reserved keyword; add a '#' prefix to use it as a raw "
@@ -1356,10 +1931,29 @@ static std::pair<Symbol const *, std::shared_ptr<std::string>> readInterpolation
 		}
 		return {sym, nullptr};
 	} else if (sym->type == SYM_EQUS) {
+		if (!fmt.isParsed()) {
+			// A default format spec appends the string unchanged, so the symbol's own
+			// buffer can be shared instead of copied; reassigning the symbol swaps in a
+			// fresh buffer, which leaves any still-active expansion unaffected
+			return {sym, sym->getEqus()};
+		}
 		auto buf = std::make_shared<std::string>();
 		fmt.appendString(*buf, *sym->getEqus());
 		return {sym, buf};
 	} else if (sym->isNumeric()) {
+		if (!fmt.isParsed() && sym->isConstant()) {
+			// Memoize default-format numeric interpolations per symbol; the cached text
+			// is validated against the current value, so it is reused until the symbol
+			// is reassigned (common for configuration constants referenced in loops)
+			auto [slot, inserted] = interpolationCache.try_emplace(sym->nameID);
+			if (uint32_t value = sym->getConstantValue();
+			    inserted || slot->second.first != value) {
+				auto buf = std::make_shared<std::string>();
+				fmt.appendNumber(*buf, value);
+				slot->second = {value, buf};
+			}
+			return {sym, slot->second.second};
+		}
 		auto buf = std::make_shared<std::string>();
 		fmt.appendNumber(*buf, sym->getConstantValue());
 		return {sym, buf};
@@ -1531,6 +2125,15 @@ static void readString(std::string &str, bool rawString) {
 	}
 
 	for (;;) {
+		// Consume a run of chars that need no special handling in bulk; the scan stops
+		// before quotes, newlines, and anything `appendCharInLiteral` treats specially
+		if (std::string_view run = bulkConsumePlainChars([](uint8_t b) {
+			    return b != '"' && b != '\\' && b != '{' && b != '\r' && b != '\n';
+		    });
+		    !run.empty()) {
+			str.append(run);
+		}
+
 		int c = peek();
 
 		// '\r', '\n' or EOF ends a single-line string early
@@ -1596,6 +2199,15 @@ static void readCharacter(std::string &str) {
 	}
 
 	for (;;) {
+		// Consume a run of chars that need no special handling in bulk; the scan stops
+		// before quotes, newlines, and anything `appendCharInLiteral` treats specially
+		if (std::string_view run = bulkConsumePlainChars([](uint8_t b) {
+			    return b != '\'' && b != '\\' && b != '{' && b != '\r' && b != '\n';
+		    });
+		    !run.empty()) {
+			str.append(run);
+		}
+
 		switch (int c = peek(); c) {
 		case '\r':
 		case '\n':
@@ -1694,6 +2306,8 @@ static Token yylex_NORMAL() {
 
 		case ' ':
 		case '\t':
+			// Consume any run of blank space in bulk
+			bulkConsumePlainChars([](uint8_t b) { return b == ' ' || b == '\t'; });
 			continue;
 
 			// Handle unambiguous single-char tokens
@@ -1976,6 +2590,16 @@ static Token yylex_RAW() {
 	}
 
 	for (;;) {
+		// Bulk-consume chars that are copied to the macro arg verbatim; the scan stops
+		// before anything the `switch` below or `peek()` (expansions) treats specially
+		if (std::string_view run = bulkConsumePlainChars([](uint8_t b) {
+			    return b != '"' && b != '\'' && b != '#' && b != ';' && b != '/' && b != ','
+			           && b != '(' && b != ')' && b != '\\' && b != '{' && b != '\r' && b != '\n';
+		    });
+		    !run.empty()) {
+			str.append(run);
+		}
+
 		c = peek();
 
 		switch (c) {
@@ -2132,6 +2756,11 @@ static int skipPastEOL() {
 	}
 
 	for (;;) {
+		// Everything in a skipped line is discarded unseen, except for newlines (which
+		// must still be counted) and backslashes (which may hide a line continuation),
+		// so runs of anything else can be consumed in bulk
+		bulkConsumePlainChars([](uint8_t b) { return b != '\n' && b != '\r' && b != '\\'; });
+
 		if (int c = bumpChar(); c == EOF) {
 			return EOF;
 		} else if (isNewline(c)) {
@@ -2239,16 +2868,90 @@ static Token yylex_SKIP_TO_ENDR() {
 	}
 }
 
-yy::parser::symbol_type yylex() {
-	if (lexerState->atLineStart && lexerStateEOL) {
-		lexerState = lexerStateEOL;
-		lexerStateEOL = nullptr;
+// Record the token that was just lexed into the stream being recorded; if the lexer is in
+// a state the stream cannot represent, abandon the recording instead
+static void recordToken(
+    TokenStream &stream, Token const &token, bool wasDynamic, LexerMode modeBefore
+) {
+	if (lexerState->capturing || !std::holds_alternative<ViewedContent>(lexerState->content)) {
+		stream.recording = false;
+		lexerState->tokenStream = nullptr;
+		return;
 	}
-	if (lexerState->lastToken == T_(EOB) && yywrap()) {
-		return yy::parser::make_YYEOF();
+
+	auto const &view = std::get<ViewedContent>(lexerState->content);
+	// The token's end is only a safe replay boundary with no expansion still active
+	bool atBoundary = lexerState->expansions.empty();
+
+	stream.tokens.push_back({
+	    .token = token,
+	    .endOffset = atBoundary ? view.offset : SIZE_MAX,
+	    .endLineNo = lexerState->lineNo,
+	    .dynamic = wasDynamic || !atBoundary || modeBefore != LEXER_NORMAL
+	               || lexerState->mode != LEXER_NORMAL,
+	});
+
+	if (token.type == T_(EOB)) {
+		stream.complete = true;
+		stream.recording = false;
+		lexerState->tokenStream = nullptr;
+		if (stream.contentHash != 0 && !options.cacheDir.empty()) {
+			cache_StoreTokenStream(stream.contentHash, serializeTokenStream(stream));
+		}
 	}
-	if (lexerState->atLineStart) {
-		nextLine();
+}
+
+// Either replay the next recorded token, or lex one from the chars, recording it if a
+// stream is being recorded (see `TokenStream`)
+static Token lexToken() {
+	if (TokenStream *stream = lexerState->tokenStream.get();
+	    stream && lexerState->replayIndex != SIZE_MAX) {
+		auto &view = std::get<ViewedContent>(lexerState->content);
+
+		if (lexerState->replaySuspended && lexerState->mode == LEXER_NORMAL
+		    && !lexerState->capturing && lexerState->expansions.empty()
+		    && lexerState->nextToken == 0) {
+			// Try to resume the suspended replay: scan for a recorded static token
+			// boundary matching the current read cursor
+			size_t &idx = lexerState->replayIndex;
+			while (idx < stream->tokens.size()
+			       && (stream->tokens[idx].endOffset == SIZE_MAX
+			           || stream->tokens[idx].endOffset < view.offset)) {
+				++idx;
+			}
+			if (idx < stream->tokens.size() && stream->tokens[idx].endOffset == view.offset) {
+				++idx;
+				lexerState->replaySuspended = false;
+			}
+		}
+
+		if (!lexerState->replaySuspended) {
+			if (lexerState->replayIndex >= stream->tokens.size()) {
+				lexerState->replaySuspended = true; // Ran out of recorded tokens
+			} else if (TokenStream::RecordedToken const &rec =
+			               stream->tokens[lexerState->replayIndex];
+			           rec.dynamic || lexerState->mode != LEXER_NORMAL
+			           || lexerState->capturing || !lexerState->expansions.empty()) {
+				// The token must be re-lexed under the current invocation's state
+				lexerState->replaySuspended = true;
+			} else if ((rec.token.type == T_(SYMBOL) || rec.token.type == T_(LABEL)
+			            || rec.token.type == T_(QMACRO))
+			           && lexerState->expandStrings
+			           && [&rec]() {
+				              Symbol const *sym =
+				                  sym_FindExactSymbol(std::get<std::string>(rec.token.value));
+				              return sym && sym->type == SYM_EQUS;
+			              }()) {
+				// An identifier that has since been defined as `EQUS` would now expand
+				lexerState->replaySuspended = true;
+			} else {
+				++lexerState->replayIndex;
+				view.offset = rec.endOffset;
+				lexerState->lineNo = rec.endLineNo;
+				lexerState->expansionScanDistance = 0;
+				return rec.token;
+			}
+		}
 	}
 
 	static Token (* const lexerModeFuncs[NB_LEXER_MODES])() = {
@@ -2258,12 +2961,44 @@ yy::parser::symbol_type yylex() {
 	    yylex_SKIP_TO_ENDC,
 	    yylex_SKIP_TO_ENDR,
 	};
+
+	TokenStream *stream =
+	    lexerState->replayIndex == SIZE_MAX ? lexerState->tokenStream.get() : nullptr;
+	LexerMode modeBefore = lexerState->mode;
+	uint64_t nbDiagnostics = stream ? warning_GetDiagnosticsCount() : 0;
+	lexedDynamicToken = stream && !lexerState->expansions.empty();
+
 	Token token = lexerModeFuncs[lexerState->mode]();
 
 	// Captures end at their buffer's boundary no matter what
 	if (token.type == T_(YYEOF) && !lexerState->capturing) {
 		token.type = T_(EOB);
 	}
+
+	if (stream) {
+		// A token that emitted a diagnostic must be re-lexed on replay to emit it again
+		bool wasDynamic =
+		    lexedDynamicToken || warning_GetDiagnosticsCount() != nbDiagnostics;
+		recordToken(*stream, token, wasDynamic, modeBefore);
+	}
+
+	return token;
+}
+
+yy::parser::symbol_type yylex() {
+	if (lexerState->atLineStart && lexerStateEOL) {
+		lexerState = lexerStateEOL;
+		lexerStateEOL = nullptr;
+	}
+	if (lexerState->lastToken == T_(EOB) && yywrap()) {
+		return yy::parser::make_YYEOF();
+	}
+	if (lexerState->atLineStart) {
+		nextLine();
+	}
+
+	Token token = lexToken();
+	profile_Count(PROFILE_TOKENS);
 	lexerState->lastToken = token.type;
 	lexerState->atLineStart = token.type == T_(NEWLINE) || token.type == T_(EOB);
 
@@ -2288,7 +3023,10 @@ static Capture makeCapture(char const *name, F callback) {
 	// The following assumption checks that.
 	assume(lexerState->atLineStart);
 
-	assume(!lexerState->capturing && lexerState->captureBuf == nullptr);
+	assume(!lexerState->capturing && lexerState->captureSlabs == nullptr);
+	// Captures read chars directly, so a replay in progress must fall back to the chars;
+	// it resumes once the read cursor converges with a recorded token boundary again
+	lexerState->replaySuspended = true;
 	lexerState->capturing = true;
 	lexerState->captureSize = 0;
 
@@ -2300,9 +3038,9 @@ static Capture makeCapture(char const *name, F callback) {
 		auto &view = std::get<ViewedContent>(lexerState->content);
 		capture.span.ptr = view.makeSharedContentPtr();
 	} else {
-		assume(lexerState->captureBuf == nullptr);
-		lexerState->captureBuf = std::make_shared<std::vector<char>>();
-		// We'll retrieve the capture buffer when done capturing
+		assume(lexerState->captureSlabs == nullptr);
+		lexerState->captureSlabs = std::make_unique<CaptureSlabs>();
+		// We'll flatten the capture slabs when done capturing
 		assume(capture.span.ptr == nullptr);
 	}
 
@@ -2315,8 +3053,8 @@ static Capture makeCapture(char const *name, F callback) {
 			int tokenType = readIdentifier(c, false).type;
 			if (size_t endTokenLength = callback(tokenType); endTokenLength > 0) {
 				if (!capture.span.ptr) {
-					// Retrieve the capture buffer now that we're done capturing
-					capture.span.ptr = lexerState->makeSharedCaptureBufPtr();
+					// Flatten the capture slabs now that the total size is known
+					capture.span.ptr = lexerState->captureSlabs->flatten(lexerState->captureSize);
 				}
 				// Subtract the length of the ending token; we know we have read it exactly, not
 				// e.g. an interpolation or EQUS expansion, since those are disabled.
@@ -2339,7 +3077,7 @@ static Capture makeCapture(char const *name, F callback) {
 
 	lexerState->atLineStart = false; // The ending token or EOF puts us past the start of the line
 	lexerState->capturing = false;
-	lexerState->captureBuf = nullptr;
+	lexerState->captureSlabs = nullptr; // Recycles the slabs
 	return capture;
 }
 
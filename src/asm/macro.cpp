@@ -10,7 +10,7 @@
 
 #include "asm/warning.hpp"
 
-std::shared_ptr<std::string> MacroArgs::getArg(int32_t i) const {
+std::shared_ptr<std::string> MacroArgs::getArg(int32_t i) {
 	// Bracketed macro arguments adjust negative indexes such that -1 is the last argument.
 	if (i < 0) {
 		i += args.size() + 1;
@@ -18,8 +18,11 @@ std::shared_ptr<std::string> MacroArgs::getArg(int32_t i) const {
 
 	int32_t realIndex = i + shift - 1;
 
-	return realIndex < 0 || static_cast<uint32_t>(realIndex) >= args.size() ? nullptr
-	                                                                        : args[realIndex];
+	// The returned pointer aliases into `args`, whose deque storage is stable; the
+	// aliasing keeps the whole `MacroArgs` alive for as long as the argument is used
+	return realIndex < 0 || static_cast<uint32_t>(realIndex) >= args.size()
+	           ? nullptr
+	           : std::shared_ptr<std::string>(shared_from_this(), &args[realIndex]);
 }
 
 std::shared_ptr<std::string> MacroArgs::getAllArgs() const {
@@ -32,19 +35,19 @@ std::shared_ptr<std::string> MacroArgs::getAllArgs() const {
 	size_t len = 0;
 
 	for (uint32_t i = shift; i < nbArgs; ++i) {
-		len += args[i]->length() + 1; // 1 for comma
+		len += args[i].length() + 1; // 1 for comma
 	}
 
 	auto str = std::make_shared<std::string>();
 	str->reserve(len + 1); // 1 for comma
 
 	for (uint32_t i = shift; i < nbArgs; ++i) {
-		std::shared_ptr<std::string> const &arg = args[i];
+		std::string const &arg = args[i];
 
-		str->append(*arg);
+		str->append(arg);
 
 		// Commas go between args and after a last empty arg
-		if (i < nbArgs - 1 || arg->empty()) {
+		if (i < nbArgs - 1 || arg.empty()) {
 			str->push_back(','); // no space after comma
 		}
 	}
@@ -52,11 +55,11 @@ std::shared_ptr<std::string> MacroArgs::getAllArgs() const {
 	return str;
 }
 
-void MacroArgs::appendArg(std::shared_ptr<std::string> arg) {
-	if (arg->empty()) {
+void MacroArgs::appendArg(std::string &&arg) {
+	if (arg.empty()) {
 		warning(WARNING_EMPTY_MACRO_ARG, "Empty macro argument");
 	}
-	args.push_back(arg);
+	args.push_back(std::move(arg));
 }
 
 void MacroArgs::shiftArgs(int32_t count) {
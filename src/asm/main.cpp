@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <errno.h>
+#include <fstream>
 #include <inttypes.h>
 #include <memory>
 #include <stdarg.h>
@@ -17,10 +18,16 @@
 #include <utility>
 #include <vector>
 
+#ifndef _MSC_VER
+	#include <sys/wait.h>
+	#include <unistd.h>
+#endif
+
 #include "backtrace.hpp"
 #include "diagnostics.hpp"
 #include "extern/getopt.hpp"
 #include "helpers.hpp"
+#include "memstats.hpp"
 #include "parser.hpp" // Generated from parser.y
 #include "platform.hpp"
 #include "style.hpp"
@@ -29,21 +36,29 @@
 #include "verbosity.hpp"
 #include "version.hpp"
 
+#include "asm/cache.hpp"
 #include "asm/charmap.hpp"
+#include "asm/context.hpp"
 #include "asm/fstack.hpp"
+#include "asm/lexer.hpp"
 #include "asm/opt.hpp"
 #include "asm/output.hpp"
+#include "asm/profile.hpp"
+#include "asm/rpn.hpp"
 #include "asm/section.hpp"
 #include "asm/symbol.hpp"
 #include "asm/warning.hpp"
 
-Options options;
+// `options` is defined in `embed.cpp`, so `librgbasm` can omit this file's `main`
 
 static char const *dependFileName = nullptr;                                      // -M
+static size_t nbBatchJobs = 1;                                                    // -j
 static std::unordered_map<std::string, std::vector<StateFeature>> stateFileSpecs; // -s
 
+static int assembleFile(std::string const &mainFileName);
+
 // Short options
-static char const *optstring = "B:b:D:Eg:hI:M:o:P:p:Q:r:s:VvW:wX:";
+static char const *optstring = "B:b:D:Eg:hI:j:M:o:P:p:Q:r:s:VvW:wX:x";
 
 // Variables for the long-only options
 static int longOpt; // `--color` and variants of `-M`
@@ -63,6 +78,7 @@ static option const longopts[] = {
     {"gfx-chars",       required_argument, nullptr,  'g'},
     {"help",            no_argument,       nullptr,  'h'},
     {"include",         required_argument, nullptr,  'I'},
+    {"jobs",            required_argument, nullptr,  'j'},
     {"dependfile",      required_argument, nullptr,  'M'},
     {"output",          required_argument, nullptr,  'o'},
     {"preinclude",      required_argument, nullptr,  'P'},
@@ -74,7 +90,14 @@ static option const longopts[] = {
     {"verbose",         no_argument,       nullptr,  'v'},
     {"warning",         required_argument, nullptr,  'W'},
     {"max-errors",      required_argument, nullptr,  'X'},
+    {"export-filter",   no_argument,       nullptr,  'x'},
+    {"cache",           required_argument, &longOpt, 'a'},
     {"color",           required_argument, &longOpt, 'c'},
+    {"dedup-diagnostics", no_argument,     &longOpt, 'd'},
+    {"mem-stats",       no_argument,       &longOpt, 'm'},
+    {"obj-compress",    no_argument,       &longOpt, 'z'},
+    {"obj-v2",          no_argument,       &longOpt, '2'},
+    {"profile",         no_argument,       &longOpt, 'f'},
     {"MC",              no_argument,       &longOpt, 'C'},
     {"MG",              no_argument,       &longOpt, 'G'},
     {"MP",              no_argument,       &longOpt, 'P'},
@@ -87,8 +110,8 @@ static option const longopts[] = {
 static Usage usage = {
     .name = "rgbasm",
     .flags = {
-        "[-EhVvw]", "[-B depth]", "[-b chars]", "[-D name[=value]]", "[-g chars]", "[-I path]",
-        "[-M depend_file]", "[-MC]", "[-MG]", "[-MP]", "[-MT target_file]", "[-MQ target_file]",
+        "[-EhVvwx]", "[-B depth]", "[-b chars]", "[-D name[=value]]", "[-g chars]", "[-I path]",
+        "[-j jobs]", "[-M depend_file]", "[-MC]", "[-MG]", "[-MP]", "[-MT target_file]", "[-MQ target_file]",
         "[-o out_file]", "[-P include_file]", "[-p pad_value]", "[-Q precision]", "[-r depth]",
         "[-s features:state_file]", "[-W warning]", "[-X max_errors]", "<file>",
     },
@@ -121,6 +144,10 @@ static void verboseOutputConfig(int argc, char *argv[]) {
 	if (options.exportAll) {
 		fputs("\tExport all labels by default\n", stderr);
 	}
+	// -x/--export-filter
+	if (options.exportFiltered) {
+		fputs("\tOnly write exported or referenced symbols to the object file\n", stderr);
+	}
 	// -b/--binary-digits
 	if (options.binDigits[0] != '0' || options.binDigits[1] != '1') {
 		fprintf(
@@ -294,6 +321,83 @@ static std::vector<StateFeature> parseStateFeatures(char *str) {
 	return features;
 }
 
+// Assembles every file listed (one per line) in the list file, forking one child process per
+// input: each file gets a fresh assembler state without paying process startup again, and up
+// to `nbBatchJobs` files are assembled concurrently.
+static int assembleBatch(char const *listName) {
+#ifndef _MSC_VER
+	std::ifstream list(listName);
+	if (!list) {
+		fatal("Failed to open batch list \"%s\": %s", listName, strerror(errno));
+	}
+
+	std::vector<std::string> inputs;
+	for (std::string line; std::getline(list, line);) {
+		// Trim blank space on both ends, and skip blank lines and '#' comments
+		size_t begin = line.find_first_not_of(" \t");
+		if (begin == std::string::npos || line[begin] == '#') {
+			continue;
+		}
+		inputs.push_back(line.substr(begin, line.find_last_not_of(" \t\r") - begin + 1));
+	}
+	if (inputs.empty()) {
+		fatal("Batch list \"%s\" contains no input files", listName);
+	}
+
+	size_t nbFailed = 0, nbActive = 0;
+	auto waitForChild = [&nbFailed, &nbActive]() {
+		int status;
+		if (wait(&status) < 0) {
+			fatal("Failed to wait for child process: %s", strerror(errno)); // LCOV_EXCL_LINE
+		}
+		--nbActive;
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			++nbFailed;
+		}
+	};
+
+	for (std::string const &input : inputs) {
+		while (nbActive >= nbBatchJobs) {
+			waitForChild();
+		}
+
+		fflush(nullptr); // Avoid duplicating buffered output into the child
+
+		pid_t pid = fork();
+		if (pid < 0) {
+			fatal("Failed to fork: %s", strerror(errno)); // LCOV_EXCL_LINE
+		}
+		if (pid == 0) {
+			// Each child derives its object file name from its input file name
+			options.objectFileName = input;
+			if (size_t dot = options.objectFileName.find_last_of("./");
+			    dot != std::string::npos && options.objectFileName[dot] == '.') {
+				options.objectFileName.resize(dot);
+			}
+			options.objectFileName += ".o";
+			options.targetFileName = options.objectFileName;
+			verbosePrint(VERB_NOTICE, "Assembling \"%s\"\n", input.c_str()); // LCOV_EXCL_LINE
+			exit(assembleFile(input));
+		}
+		++nbActive;
+	}
+	while (nbActive > 0) {
+		waitForChild();
+	}
+
+	if (nbFailed != 0) {
+		fprintf(stderr, "Failed to assemble %zu of %zu files\n", nbFailed, inputs.size());
+		return 1;
+	}
+	return 0;
+#else
+	// LCOV_EXCL_START
+	(void)listName;
+	fatal("Batch mode is not supported on this platform");
+	// LCOV_EXCL_STOP
+#endif
+}
+
 int main(int argc, char *argv[]) {
 	// Support SOURCE_DATE_EPOCH for reproducible builds
 	// https://reproducible-builds.org/docs/source-date-epoch/
@@ -301,7 +405,7 @@ int main(int argc, char *argv[]) {
 	if (char const *sourceDateEpoch = getenv("SOURCE_DATE_EPOCH"); sourceDateEpoch) {
 		now = static_cast<time_t>(strtoul(sourceDateEpoch, nullptr, 0));
 	}
-	sym_Init(now);
+	ctx_ResetAssembly(now);
 
 	// Maximum of 100 errors only applies if rgbasm is printing errors to a terminal
 	if (isatty(STDERR_FILENO)) {
@@ -309,7 +413,18 @@ int main(int argc, char *argv[]) {
 	}
 
 	// Parse CLI options
+	std::string cacheKeyOptions; // Serialization of the options that affect object contents
 	for (int ch; (ch = musl_getopt_long_only(argc, argv, optstring, longopts, nullptr)) != -1;) {
+		// Options that only affect where output goes (or nothing at all) stay out of the
+		// cache key, so that e.g. changing '-o' does not miss the cache
+		if (ch != 'o' && ch != 'v' && ch != 'B'
+		    && !(ch == 0 && (longOpt == 'c' || longOpt == 'd' || longOpt == 'f' || longOpt == 'm'))) {
+			cacheKeyOptions += static_cast<char>(ch == 0 ? longOpt : ch);
+			if (musl_optarg) {
+				cacheKeyOptions += musl_optarg;
+			}
+			cacheKeyOptions += '\0'; // Keep adjacent options from running together
+		}
 		switch (ch) {
 		case 'B':
 			if (!trace_ParseTraceDepth(musl_optarg)) {
@@ -357,6 +472,16 @@ int main(int argc, char *argv[]) {
 			fstk_AddIncludePath(musl_optarg);
 			break;
 
+		case 'j': {
+			char *endptr;
+			nbBatchJobs = strtoul(musl_optarg, &endptr, 0);
+
+			if (musl_optarg[0] == '\0' || *endptr != '\0' || nbBatchJobs == 0) {
+				fatal("Invalid argument for option '-j'");
+			}
+			break;
+		}
+
 		case 'M':
 			if (dependFileName) {
 				warnx(
@@ -457,6 +582,7 @@ int main(int argc, char *argv[]) {
 
 		case 'w':
 			warnings.state.warningsEnabled = false;
+			warnings.flushWarningCache();
 			break;
 
 		case 'X': {
@@ -475,14 +601,42 @@ int main(int argc, char *argv[]) {
 			break;
 		}
 
+		case 'x':
+			opt_X(true);
+			break;
+
 		case 0: // Long-only options
 			switch (longOpt) {
+			case 'a':
+				options.cacheDir = musl_optarg;
+				break;
+
 			case 'c':
 				if (!style_Parse(musl_optarg)) {
 					fatal("Invalid argument for option '--color'");
 				}
 				break;
 
+			case 'd':
+				options.dedupDiagnostics = true;
+				break;
+
+			case 'm':
+				mem_EnableStats();
+				break;
+
+			case 'z':
+				options.objectCompress = true;
+				[[fallthrough]]; // Compressed section data needs the v2 container
+
+			case '2':
+				options.objectV2 = true;
+				break;
+
+			case 'f':
+				options.profile = true;
+				break;
+
 			case 'C':
 				options.missingIncludeState = GEN_CONTINUE;
 				break;
@@ -520,6 +674,16 @@ int main(int argc, char *argv[]) {
 		options.targetFileName = options.objectFileName;
 	}
 
+	if (!options.cacheDir.empty()) {
+		if (dependFileName) {
+			fatal("Option '-M' is incompatible with option '--cache'");
+		}
+		if (!stateFileSpecs.empty()) {
+			fatal("Option '-s' is incompatible with option '--cache'");
+		}
+		cache_Init(cacheKeyOptions);
+	}
+
 	verboseOutputConfig(argc, argv);
 
 	if (argc == musl_optind) {
@@ -530,6 +694,21 @@ int main(int argc, char *argv[]) {
 
 	std::string mainFileName = argv[musl_optind];
 
+	// Batch mode: `rgbasm @list` assembles every file named in the list
+	if (mainFileName.length() > 1 && mainFileName[0] == '@') {
+		if (dependFileName) {
+			fatal("Option '-M' is incompatible with batch mode");
+		}
+		if (!options.objectFileName.empty()) {
+			fatal("Option '-o' is incompatible with batch mode; object file names are derived"
+			      " from input file names");
+		}
+		if (!stateFileSpecs.empty()) {
+			fatal("Option '-s' is incompatible with batch mode");
+		}
+		return assembleBatch(mainFileName.c_str() + 1);
+	}
+
 	verbosePrint(VERB_NOTICE, "Assembling \"%s\"\n", mainFileName.c_str()); // LCOV_EXCL_LINE
 
 	if (dependFileName) {
@@ -551,17 +730,29 @@ int main(int argc, char *argv[]) {
 	}
 	options.printDep(mainFileName);
 
+	return assembleFile(mainFileName);
+}
+
+static int assembleFile(std::string const &mainFileName) {
+	// If the cache has an object whose whole input closure is unchanged, replay it
+	if (!options.cacheDir.empty() && !options.objectFileName.empty()
+	    && cache_TryReplay(mainFileName)) {
+		return 0;
+	}
+
 	charmap_New(DEFAULT_CHARMAP_NAME, nullptr);
 
 	// Init lexer and file stack, providing file info
 	fstk_Init(mainFileName);
 
 	// Perform parse (`yy::parser` is auto-generated from `parser.y`)
+	profile_BeginPhase(PROFILE_PASS);
 	if (yy::parser parser; parser.parse() != 0) {
 		if (warnings.nbErrors == 0) {
 			warnings.nbErrors = 1;
 		}
 	}
+	profile_EndPhase(PROFILE_PASS);
 
 	if (!fstk_FailedOnMissingInclude()) {
 		sect_CheckUnionClosed();
@@ -580,11 +771,26 @@ int main(int argc, char *argv[]) {
 		return 0;
 	}
 
+	profile_BeginPhase(PROFILE_OBJ_WRITE);
 	out_WriteObject();
+	profile_EndPhase(PROFILE_OBJ_WRITE);
+
+	if (!options.cacheDir.empty() && !options.objectFileName.empty()) {
+		cache_Store(mainFileName);
+	}
 
 	for (auto const &[name, features] : stateFileSpecs) {
 		out_WriteState(name, features);
 	}
 
+	profile_Report();
+	mem_ReportStats({
+	    {"Lexer buffer bytes", lexer_CountBufferedBytes()},
+	    {"Symbols",            sym_CountSymbols()       },
+	    {"Sections",           sect_CountSections()     },
+	    {"Section data bytes", sect_CountDataBytes()    },
+	    {"RPN buffer reuses",  rpn_CountBufferReuses()  },
+	});
+
 	return 0;
 }
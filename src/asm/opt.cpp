@@ -22,6 +22,7 @@ struct OptStackEntry {
 	char gfxDigits[4];
 	uint8_t fixPrecision;
 	uint8_t padByte;
+	bool exportFiltered;
 	size_t maxRecursionDepth;
 	DiagnosticsState<WarningID> warningStates;
 };
@@ -53,6 +54,10 @@ void opt_W(char const *flag) {
 	warnings.processWarningFlag(flag);
 }
 
+void opt_X(bool exportFiltered) {
+	options.exportFiltered = exportFiltered;
+}
+
 void opt_Parse(char const *s) {
 	if (s[0] == '-') {
 		++s;
@@ -147,6 +152,16 @@ void opt_Parse(char const *s) {
 		}
 		break;
 
+	case 'x':
+		if (s[1] == '\0') {
+			opt_X(true);
+		} else if ((s[1] == '0' || s[1] == '1') && s[2] == '\0') {
+			opt_X(s[1] == '1');
+		} else {
+			error("Invalid argument for option 'x'");
+		}
+		break;
+
 	default:
 		error("Unknown option '%c'", s[0]);
 		break;
@@ -159,6 +174,7 @@ void opt_Push() {
 	memcpy(entry.binDigits, options.binDigits, std::size(options.binDigits));
 	memcpy(entry.gfxDigits, options.gfxDigits, std::size(options.gfxDigits));
 	entry.padByte = options.padByte;
+	entry.exportFiltered = options.exportFiltered;
 	entry.fixPrecision = options.fixPrecision;
 	entry.maxRecursionDepth = options.maxRecursionDepth;
 	entry.warningStates = warnings.state;
@@ -180,9 +196,11 @@ void opt_Pop() {
 	opt_P(entry.padByte);
 	opt_Q(entry.fixPrecision);
 	opt_R(entry.maxRecursionDepth);
+	opt_X(entry.exportFiltered);
 
 	// `opt_W` does not apply a whole warning state; it processes one flag string
 	warnings.state = entry.warningStates;
+	warnings.flushWarningCache();
 }
 
 void opt_CheckStack() {
@@ -190,3 +208,8 @@ void opt_CheckStack() {
 		warning(WARNING_UNMATCHED_DIRECTIVE, "`PUSHO` without corresponding `POPO`");
 	}
 }
+
+// Drop any options still stacked by `PUSHO`, for a fresh assembly
+void opt_Reset() {
+	stack = {};
+}
@@ -6,17 +6,22 @@
 #include <deque>
 #include <errno.h>
 #include <inttypes.h>
+#include <map>
 #include <memory>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "helpers.hpp" // assume, Defer
 #include "linkdefs.hpp"
+#include "lz4.hpp"
 #include "platform.hpp"
+#include "util.hpp" // fnv1a64
 
 #include "asm/charmap.hpp"
 #include "asm/fstack.hpp"
@@ -40,20 +45,67 @@ static std::deque<Assertion> assertions;
 
 static std::deque<std::shared_ptr<FileStackNode>> fileStackNodes;
 
-static void putLong(uint32_t n, FILE *file) {
-	uint8_t bytes[] = {
-	    static_cast<uint8_t>(n),
-	    static_cast<uint8_t>(n >> 8),
-	    static_cast<uint8_t>(n >> 16),
-	    static_cast<uint8_t>(n >> 24),
-	};
-	fwrite(bytes, 1, sizeof(bytes), file);
+// Forget everything registered for write-out, so a fresh assembly starts from scratch
+void out_Reset() {
+	objectSymbols.clear();
+	assertions.clear();
+	fileStackNodes.clear();
 }
 
-static void putString(std::string const &s, FILE *file) {
-	fputs(s.c_str(), file);
-	putc('\0', file);
-}
+// Serializes the object file into large memory blocks, so it reaches the file through a
+// few big `fwrite`s instead of one libc call per field
+struct OutputBuffer {
+	// Once the buffer grows past this, `flushIfFull` drains it to the file
+	static constexpr size_t capacity = 1 << 20;
+
+	FILE *file;
+	std::vector<uint8_t> bytes;
+
+	explicit OutputBuffer(FILE *file_) : file(file_) { bytes.reserve(capacity); }
+
+	void putByte(uint8_t b) { bytes.push_back(b); }
+
+	void putLong(uint32_t n) {
+		uint8_t longBytes[] = {
+		    static_cast<uint8_t>(n),
+		    static_cast<uint8_t>(n >> 8),
+		    static_cast<uint8_t>(n >> 16),
+		    static_cast<uint8_t>(n >> 24),
+		};
+		putData(longBytes, sizeof(longBytes));
+	}
+
+	void putString(std::string const &s) {
+		// Like `fputs(s.c_str(), ...)`, this truncates at any embedded NUL
+		putData(s.c_str(), strlen(s.c_str()));
+		putByte('\0');
+	}
+
+	void putData(void const *data, size_t size) {
+		uint8_t const *ptr = static_cast<uint8_t const *>(data);
+		bytes.insert(bytes.end(), ptr, ptr + size);
+	}
+
+	// Overwrites a previously-written long; only usable before the buffer is flushed
+	void patchLong(size_t pos, uint32_t n) {
+		assume(pos + 4 <= bytes.size());
+		bytes[pos] = n;
+		bytes[pos + 1] = n >> 8;
+		bytes[pos + 2] = n >> 16;
+		bytes[pos + 3] = n >> 24;
+	}
+
+	void flush() {
+		fwrite(bytes.data(), 1, bytes.size(), file);
+		bytes.clear();
+	}
+
+	void flushIfFull() {
+		if (bytes.size() >= capacity) {
+			flush();
+		}
+	}
+};
 
 void out_RegisterNode(std::shared_ptr<FileStackNode> node) {
 	// If node is not already registered, register it (and parents), and give it a unique ID
@@ -63,63 +115,135 @@ void out_RegisterNode(std::shared_ptr<FileStackNode> node) {
 	}
 }
 
-static void writePatch(Patch const &patch, FILE *file) {
+// Returns the first registered node whose payload and parent chain are identical to
+// `node`'s, registering `node` as that representative if it is the first.
+static FileStackNode *canonicalizeNode(
+    std::shared_ptr<FileStackNode> const &node,
+    std::unordered_map<FileStackNode const *, FileStackNode *> &memo,
+    std::map<std::tuple<FileStackNode const *, uint32_t, uint8_t, std::string>, FileStackNode *>
+        &canonical
+) {
+	if (auto search = memo.find(node.get()); search != memo.end()) {
+		return search->second;
+	}
+
+	FileStackNode *parentCanon =
+	    node->parent ? canonicalizeNode(node->parent, memo, canonical) : nullptr;
+
+	std::string payload;
+	if (node->type != NODE_REPT) {
+		payload = node->name();
+	} else {
+		for (uint32_t iter : node->iters()) {
+			payload.append(reinterpret_cast<char const *>(&iter), sizeof(iter));
+		}
+	}
+	uint8_t typeByte = node->type | node->isQuiet << FSTACKNODE_QUIET_BIT;
+	auto [it, inserted] = canonical.try_emplace(
+	    std::tuple(parentCanon, node->lineNo, typeByte, std::move(payload)), node.get()
+	);
+	memo.emplace(node.get(), it->second);
+	return it->second;
+}
+
+// Collapses nodes with identical payloads and parent chains into a single node, remapping
+// the duplicates' IDs onto the representative's. Nested macro/`REPT` expansions register a
+// separate node per invocation, so objects can otherwise carry thousands of byte-identical
+// ones; since everything in the file references nodes by ID, merging them at write time
+// needs no reader-side support.
+static void dedupeFileStackNodes() {
+	std::unordered_map<FileStackNode const *, FileStackNode *> memo;
+	std::map<std::tuple<FileStackNode const *, uint32_t, uint8_t, std::string>, FileStackNode *>
+	    canonical;
+
+	// Iterate by increasing ID so representatives are the earliest-registered nodes
+	for (auto it = fileStackNodes.rbegin(); it != fileStackNodes.rend(); ++it) {
+		canonicalizeNode(*it, memo, canonical);
+	}
+	if (canonical.size() == fileStackNodes.size()) {
+		return;
+	}
+
+	// Keep only the representatives, renumbering them densely in their original order
+	std::deque<std::shared_ptr<FileStackNode>> merged;
+	for (auto it = fileStackNodes.rbegin(); it != fileStackNodes.rend(); ++it) {
+		if (memo[it->get()] == it->get()) {
+			(*it)->ID = merged.size();
+			merged.push_front(*it);
+		}
+	}
+	// Patches, symbols, and sections hold node pointers and read `ID` at write time, so
+	// pointing each duplicate's ID at its representative remaps every reference
+	for (std::shared_ptr<FileStackNode> const &node : fileStackNodes) {
+		node->ID = memo[node.get()]->ID;
+	}
+	fileStackNodes = std::move(merged);
+}
+
+static void writePatch(Patch const &patch, OutputBuffer &buf) {
 	assume(patch.src->ID != UINT32_MAX);
 
-	putLong(patch.src->ID, file);
-	putLong(patch.lineNo, file);
-	putLong(patch.offset, file);
-	putLong(patch.pcSection ? patch.pcSection->getID() : UINT32_MAX, file);
-	putLong(patch.pcOffset, file);
-	putc(patch.type, file);
-	putLong(patch.rpn.size(), file);
-	fwrite(patch.rpn.data(), 1, patch.rpn.size(), file);
+	buf.putLong(patch.src->ID);
+	buf.putLong(patch.lineNo);
+	buf.putLong(patch.offset);
+	buf.putLong(patch.pcSection ? patch.pcSection->getID() : UINT32_MAX);
+	buf.putLong(patch.pcOffset);
+	buf.putByte(patch.type);
+	buf.putLong(patch.rpn.size());
+	buf.putData(patch.rpn.data(), patch.rpn.size());
 }
 
-static void writeSection(Section const &sect, FILE *file) {
+static void writeSection(Section const &sect, OutputBuffer &buf) {
 	assume(sect.src->ID != UINT32_MAX);
 
-	putString(sect.name, file);
+	buf.putString(sect.name);
 
-	putLong(sect.src->ID, file);
-	putLong(sect.fileLine, file);
+	buf.putLong(sect.src->ID);
+	buf.putLong(sect.fileLine);
 
-	putLong(sect.size, file);
+	buf.putLong(sect.size);
 
 	assume((sect.type & SECTTYPE_TYPE_MASK) == sect.type);
 	bool isUnion = sect.modifier == SECTION_UNION;
 	bool isFragment = sect.modifier == SECTION_FRAGMENT;
-	putc(sect.type | isUnion << SECTTYPE_UNION_BIT | isFragment << SECTTYPE_FRAGMENT_BIT, file);
+	buf.putByte(sect.type | isUnion << SECTTYPE_UNION_BIT | isFragment << SECTTYPE_FRAGMENT_BIT);
 
-	putLong(sect.org, file);
-	putLong(sect.bank, file);
-	putc(sect.align, file);
-	putLong(sect.alignOfs, file);
+	buf.putLong(sect.org);
+	buf.putLong(sect.bank);
+	buf.putByte(sect.align);
+	buf.putLong(sect.alignOfs);
 
 	if (sectTypeHasData(sect.type)) {
-		fwrite(sect.data.data(), 1, sect.size, file);
-		putLong(sect.patches.size(), file);
-
-		for (Patch const &patch : sect.patches) {
-			writePatch(patch, file);
+		buf.putData(sect.data.data(), sect.size);
+		buf.putLong(sect.countPatches());
+
+		// Iterate in reverse to keep emitting patches newest-first, as the former
+		// per-section list did
+		std::deque<Patch> const &patchPool = sect_PatchPool();
+		for (auto span = sect.patchSpans.rbegin(); span != sect.patchSpans.rend(); ++span) {
+			for (uint32_t i = span->second; i--;) {
+				writePatch(patchPool[span->first + i], buf);
+				buf.flushIfFull();
+			}
 		}
 	}
+	buf.flushIfFull();
 }
 
-static void writeSymbol(Symbol const &sym, FILE *file) {
-	putString(sym.name, file);
+static void writeSymbol(Symbol const &sym, OutputBuffer &buf) {
+	buf.putString(sym.name);
 	if (!sym.isDefined()) {
-		putc(SYMTYPE_IMPORT, file);
+		buf.putByte(SYMTYPE_IMPORT);
 	} else {
 		assume(sym.src->ID != UINT32_MAX);
 
 		Section *symSection = sym.getSection();
 
-		putc(sym.isExported ? SYMTYPE_EXPORT : SYMTYPE_LOCAL, file);
-		putLong(sym.src->ID, file);
-		putLong(sym.fileLine, file);
-		putLong(symSection ? symSection->getID() : UINT32_MAX, file);
-		putLong(sym.getOutputValue(), file);
+		buf.putByte(sym.isExported ? SYMTYPE_EXPORT : SYMTYPE_LOCAL);
+		buf.putLong(sym.src->ID);
+		buf.putLong(sym.fileLine);
+		buf.putLong(symSection ? symSection->getID() : UINT32_MAX);
+		buf.putLong(sym.getOutputValue());
 	}
 }
 
@@ -138,12 +262,13 @@ static void writeRpn(std::vector<uint8_t> &rpnexpr, std::vector<uint8_t> const &
 	for (size_t offset = 0; offset < rpn.size();) {
 		uint8_t rpndata = rpn[offset++];
 
-		auto getSymName = [&]() {
-			std::string symName;
-			for (uint8_t c; (c = rpn[offset++]) != 0;) {
-				symName += c;
-			}
-			return symName;
+		auto getNameID = [&]() {
+			uint32_t nameID = rpn[offset];
+			nameID |= rpn[offset + 1] << 8;
+			nameID |= rpn[offset + 2] << 16;
+			nameID |= static_cast<uint32_t>(rpn[offset + 3]) << 24;
+			offset += 4;
+			return nameID;
 		};
 
 		switch (rpndata) {
@@ -160,8 +285,8 @@ static void writeRpn(std::vector<uint8_t> &rpnexpr, std::vector<uint8_t> const &
 			break;
 
 		case RPN_SYM:
-			// The symbol name is always written expanded
-			sym = sym_FindExactSymbol(getSymName());
+			// Symbol references are stored as interned name IDs (see `Expression::makeSymbol`)
+			sym = sym_FindSymbolByNameID(getNameID());
 			registerUnregisteredSymbol(*sym); // Ensure that `sym->ID` is set
 			value = sym->ID;
 
@@ -173,8 +298,7 @@ static void writeRpn(std::vector<uint8_t> &rpnexpr, std::vector<uint8_t> const &
 			break;
 
 		case RPN_BANK_SYM:
-			// The symbol name is always written expanded
-			sym = sym_FindExactSymbol(getSymName());
+			sym = sym_FindSymbolByNameID(getNameID());
 			registerUnregisteredSymbol(*sym); // Ensure that `sym->ID` is set
 			value = sym->ID;
 
@@ -263,36 +387,193 @@ void out_CreateAssert(
 	assertion.message = message;
 }
 
-static void writeAssert(Assertion const &assert, FILE *file) {
-	writePatch(assert.patch, file);
-	putString(assert.message, file);
+static void writeAssert(Assertion const &assert, OutputBuffer &buf) {
+	writePatch(assert.patch, buf);
+	buf.putString(assert.message);
 }
 
-static void writeFileStackNode(FileStackNode const &node, FILE *file) {
-	putLong(node.parent ? node.parent->ID : UINT32_MAX, file);
-	putLong(node.lineNo, file);
+static void writeFileStackNode(FileStackNode const &node, OutputBuffer &buf) {
+	buf.putLong(node.parent ? node.parent->ID : UINT32_MAX);
+	buf.putLong(node.lineNo);
 
-	putc(node.type | node.isQuiet << FSTACKNODE_QUIET_BIT, file);
+	buf.putByte(node.type | node.isQuiet << FSTACKNODE_QUIET_BIT);
 
 	if (node.type != NODE_REPT) {
-		putString(node.name(), file);
+		buf.putString(node.name());
 	} else {
 		std::vector<uint32_t> const &nodeIters = node.iters();
 
-		putLong(nodeIters.size(), file);
+		buf.putLong(nodeIters.size());
 		// Iters are stored by decreasing depth, so reverse the order for output
 		for (uint32_t i = nodeIters.size(); i--;) {
-			putLong(nodeIters[i], file);
+			buf.putLong(nodeIters[i]);
+		}
+	}
+}
+
+// Deduplicated string table for the v2 object container; names are referenced by the byte
+// offset of their characters within the table. Each name's 64-bit FNV-1a hash immediately
+// precedes its characters, so the linker's maps can insert names with precomputed hashes.
+struct StringTable {
+	std::vector<uint8_t> bytes;
+	std::unordered_map<std::string, uint32_t> offsets;
+
+	uint32_t get(std::string const &s) {
+		// Like v1's `putString`, names are truncated at any embedded NUL
+		std::string name(s.c_str());
+		if (auto search = offsets.find(name); search != offsets.end()) {
+			return search->second;
+		}
+		uint64_t hash = fnv1a64(name.data(), name.length());
+		for (int i = 0; i < 8; ++i) {
+			bytes.push_back(hash >> (i * 8));
+		}
+		uint32_t ofs = bytes.size();
+		bytes.insert(bytes.end(), name.begin(), name.end());
+		bytes.push_back('\0');
+		offsets.emplace(std::move(name), ofs);
+		return ofs;
+	}
+};
+
+static void writeSectionV2(Section const &sect, OutputBuffer &buf, StringTable &strTab) {
+	assume(sect.src->ID != UINT32_MAX);
+
+	buf.putLong(strTab.get(sect.name));
+	buf.putLong(sect.src->ID);
+	buf.putLong(sect.fileLine);
+	buf.putLong(sect.size);
+
+	// Only worth it if the LZ4 block actually came out smaller; tiny sections never do
+	std::vector<uint8_t> packed;
+	if (options.objectCompress && sectTypeHasData(sect.type) && sect.size >= 16) {
+		packed = lz4_Compress(sect.data.data(), sect.size);
+		if (packed.size() >= sect.size) {
+			packed.clear();
+		}
+	}
+	bool isCompressed = !packed.empty();
+
+	assume((sect.type & SECTTYPE_TYPE_MASK) == sect.type);
+	bool isUnion = sect.modifier == SECTION_UNION;
+	bool isFragment = sect.modifier == SECTION_FRAGMENT;
+	buf.putByte(
+	    sect.type | isUnion << SECTTYPE_UNION_BIT | isFragment << SECTTYPE_FRAGMENT_BIT
+	    | isCompressed << SECTTYPE_COMPRESSED_BIT
+	);
+
+	buf.putLong(sect.org);
+	buf.putLong(sect.bank);
+	buf.putByte(sect.align);
+	buf.putLong(sect.alignOfs);
+
+	if (sectTypeHasData(sect.type)) {
+		if (isCompressed) {
+			buf.putLong(packed.size());
+			buf.putData(packed.data(), packed.size());
+		} else {
+			buf.putData(sect.data.data(), sect.size);
+		}
+		buf.putLong(sect.countPatches());
+
+		std::deque<Patch> const &patchPool = sect_PatchPool();
+		for (auto span = sect.patchSpans.rbegin(); span != sect.patchSpans.rend(); ++span) {
+			for (uint32_t i = span->second; i--;) {
+				writePatch(patchPool[span->first + i], buf);
+			}
 		}
 	}
 }
 
+// Writes the v2 object container: a table of contents at a fixed offset gives the location
+// and length of each table, and all names live in one deduplicated string table, so readers
+// can seek straight to (and share) what they need instead of parsing sequentially.
+static void writeObjectV2(FILE *file) {
+	OutputBuffer buf{file};
+	StringTable strTab;
+
+	// `static` so `sect_ForEach` callback can see them
+	static OutputBuffer *bufPtr;
+	static StringTable *strTabPtr;
+	bufPtr = &buf;
+	strTabPtr = &strTab;
+
+	buf.putData(RGBDS_OBJECT_V2_MAGIC, literal_strlen(RGBDS_OBJECT_V2_MAGIC));
+	buf.putLong(RGBDS_OBJECT_REV);
+
+	// Table of contents: an {offset, count} pair per table, patched in as each is written.
+	// Slot 0 is the string table ({offset, size}), then nodes, symbols, sections, assertions.
+	size_t tocOfs = buf.bytes.size();
+	for (int i = 0; i < 10; ++i) {
+		buf.putLong(0);
+	}
+	auto fillTocEntry = [&buf, tocOfs](unsigned int slot, uint32_t count) {
+		buf.patchLong(tocOfs + slot * 8, buf.bytes.size());
+		buf.patchLong(tocOfs + slot * 8 + 4, count);
+	};
+
+	// Nodes are written by increasing ID, unlike v1
+	fillTocEntry(1, fileStackNodes.size());
+	for (auto it = fileStackNodes.rbegin(); it != fileStackNodes.rend(); ++it) {
+		FileStackNode const &node = **it;
+
+		buf.putLong(node.parent ? node.parent->ID : UINT32_MAX);
+		buf.putLong(node.lineNo);
+		buf.putByte(node.type | node.isQuiet << FSTACKNODE_QUIET_BIT);
+
+		if (node.type != NODE_REPT) {
+			buf.putLong(strTab.get(node.name()));
+		} else {
+			std::vector<uint32_t> const &nodeIters = node.iters();
+
+			buf.putLong(nodeIters.size());
+			// Iters are stored by decreasing depth, so reverse the order for output
+			for (uint32_t i = nodeIters.size(); i--;) {
+				buf.putLong(nodeIters[i]);
+			}
+		}
+	}
+
+	fillTocEntry(2, objectSymbols.size());
+	for (Symbol const *sym : objectSymbols) {
+		buf.putLong(strTab.get(sym->name));
+		if (!sym->isDefined()) {
+			buf.putByte(SYMTYPE_IMPORT);
+		} else {
+			assume(sym->src->ID != UINT32_MAX);
+
+			Section *symSection = sym->getSection();
+
+			buf.putByte(sym->isExported ? SYMTYPE_EXPORT : SYMTYPE_LOCAL);
+			buf.putLong(sym->src->ID);
+			buf.putLong(sym->fileLine);
+			buf.putLong(symSection ? symSection->getID() : UINT32_MAX);
+			buf.putLong(sym->getOutputValue());
+		}
+	}
+
+	fillTocEntry(3, sect_CountSections());
+	sect_ForEach([](Section &sect) { writeSectionV2(sect, *bufPtr, *strTabPtr); });
+
+	fillTocEntry(4, assertions.size());
+	for (Assertion const &assert : assertions) {
+		writePatch(assert.patch, buf);
+		buf.putLong(strTab.get(assert.message));
+	}
+
+	// The string table is written last, once all names have been interned
+	fillTocEntry(0, strTab.bytes.size());
+	buf.putData(strTab.bytes.data(), strTab.bytes.size());
+
+	buf.flush();
+}
+
 void out_WriteObject() {
 	if (options.objectFileName.empty()) {
 		return;
 	}
 
-	static FILE *file; // `static` so `sect_ForEach` callback can see it
+	FILE *file;
 	if (options.objectFileName != "-") {
 		file = fopen(options.objectFileName.c_str(), "wb");
 	} else {
@@ -309,35 +590,58 @@ void out_WriteObject() {
 	}
 	Defer closeFile{[&] { fclose(file); }};
 
-	// Also write symbols that weren't written above
-	sym_ForEach(registerUnregisteredSymbol);
+	// Also write symbols that weren't written above; under `-x` ("export filter"), symbols
+	// referenced by patches were already registered when those patches were created, so
+	// anything unexported that remains is invisible to the linker and can be omitted
+	if (options.exportFiltered) {
+		sym_ForEach([](Symbol &sym) {
+			if (sym.isExported) {
+				registerUnregisteredSymbol(sym);
+			}
+		});
+	} else {
+		sym_ForEach(registerUnregisteredSymbol);
+	}
+
+	dedupeFileStackNodes();
+
+	if (options.objectV2) {
+		writeObjectV2(file);
+		return;
+	}
+
+	static OutputBuffer buf{file}; // `static` so `sect_ForEach` callback can see it
+	Defer flushBuf{[&] { buf.flush(); }}; // Flush before `closeFile` runs
 
-	fputs(RGBDS_OBJECT_VERSION_STRING, file);
-	putLong(RGBDS_OBJECT_REV, file);
+	buf.putData(RGBDS_OBJECT_VERSION_STRING, strlen(RGBDS_OBJECT_VERSION_STRING));
+	buf.putLong(RGBDS_OBJECT_REV);
 
-	putLong(objectSymbols.size(), file);
-	putLong(sect_CountSections(), file);
+	buf.putLong(objectSymbols.size());
+	buf.putLong(sect_CountSections());
 
-	putLong(fileStackNodes.size(), file);
+	buf.putLong(fileStackNodes.size());
 	for (auto it = fileStackNodes.begin(); it != fileStackNodes.end(); ++it) {
 		FileStackNode const &node = **it;
 
-		writeFileStackNode(node, file);
+		writeFileStackNode(node, buf);
+		buf.flushIfFull();
 
 		// The list is supposed to have decrementing IDs
 		assume(it + 1 == fileStackNodes.end() || it[1]->ID == node.ID - 1);
 	}
 
 	for (Symbol const *sym : objectSymbols) {
-		writeSymbol(*sym, file);
+		writeSymbol(*sym, buf);
+		buf.flushIfFull();
 	}
 
-	sect_ForEach([](Section &sect) { writeSection(sect, file); });
+	sect_ForEach([](Section &sect) { writeSection(sect, buf); });
 
-	putLong(assertions.size(), file);
+	buf.putLong(assertions.size());
 
 	for (Assertion const &assert : assertions) {
-		writeAssert(assert, file);
+		writeAssert(assert, buf);
+		buf.flushIfFull();
 	}
 }
 
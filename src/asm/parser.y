@@ -64,10 +64,28 @@
 		} else {
 			Expression expr;
 			expr.makeSymbol(symName);
-			return numCallback(expr);
+			return numCallback(std::move(expr));
 		}
 	}
 
+	// Scratch buffers for `ds` argument lists, so each directive can reuse a previously
+	// grown vector instead of reallocating one (mirroring the RPN buffer pool)
+	static std::vector<std::vector<Expression>> dsArgsPool;
+
+	static std::vector<Expression> acquireDsArgs() {
+		if (dsArgsPool.empty()) {
+			return {};
+		}
+		std::vector<Expression> args = std::move(dsArgsPool.back());
+		dsArgsPool.pop_back();
+		return args;
+	}
+
+	static void recycleDsArgs(std::vector<Expression> &&args) {
+		args.clear();
+		dsArgsPool.push_back(std::move(args));
+	}
+
 	// The CPU encodes instructions in a logical way, so most instructions actually follow patterns.
 	// These enums thus help with bit twiddling to compute opcodes.
 	enum { REG_B, REG_C, REG_D, REG_E, REG_H, REG_L, REG_HL_IND, REG_A };
@@ -563,7 +581,7 @@ macro_args:
 	}
 	| macro_args STRING {
 		$$ = std::move($1);
-		$$->appendArg(std::make_shared<std::string>($2));
+		$$->appendArg(std::move($2));
 	}
 ;
 
@@ -1148,8 +1166,7 @@ constlist_8bit_entry:
 		sect_RelByte($1, 0);
 	}
 	| string_literal {
-		std::vector<int32_t> output = charmap_Convert($1);
-		sect_ByteString(output);
+		sect_ByteString($1);
 	}
 	| scoped_sym {
 		handleSymbolByType(
@@ -1158,10 +1175,7 @@ constlist_8bit_entry:
 			    expr.checkNBit(8);
 			    sect_RelByte(expr, 0);
 		    },
-		    [](std::string const &str) {
-			    std::vector<int32_t> output = charmap_Convert(str);
-			    sect_ByteString(output);
-		    }
+		    [](std::string const &str) { sect_ByteString(str); }
 		);
 	}
 ;
@@ -1177,8 +1191,7 @@ constlist_16bit_entry:
 		sect_RelWord($1, 0);
 	}
 	| string_literal {
-		std::vector<int32_t> output = charmap_Convert($1);
-		sect_WordString(output);
+		sect_WordString($1);
 	}
 	| scoped_sym {
 		handleSymbolByType(
@@ -1187,10 +1200,7 @@ constlist_16bit_entry:
 			    expr.checkNBit(16);
 			    sect_RelWord(expr, 0);
 		    },
-		    [](std::string const &str) {
-			    std::vector<int32_t> output = charmap_Convert(str);
-			    sect_WordString(output);
-		    }
+		    [](std::string const &str) { sect_WordString(str); }
 		);
 	}
 	| fragment_literal {
@@ -1211,17 +1221,13 @@ constlist_32bit_entry:
 		sect_RelLong($1, 0);
 	}
 	| string_literal {
-		std::vector<int32_t> output = charmap_Convert($1);
-		sect_LongString(output);
+		sect_LongString($1);
 	}
 	| scoped_sym {
 		handleSymbolByType(
 		    $1,
 		    [](Expression const &expr) { sect_RelLong(expr, 0); },
-		    [](std::string const &str) {
-			    std::vector<int32_t> output = charmap_Convert(str);
-			    sect_LongString(output);
-		    }
+		    [](std::string const &str) { sect_LongString(str); }
 		);
 	}
 ;
@@ -1267,7 +1273,7 @@ relocexpr:
 	| scoped_sym {
 		$$ = handleSymbolByType(
 		    $1,
-		    [](Expression const &expr) { return expr; },
+		    [](Expression &&expr) { return std::move(expr); },
 		    [](std::string const &str) {
 			    Expression expr;
 			    expr.makeNumber(act_StringToNum(str));
@@ -1807,6 +1813,7 @@ ds:
 	}
 	| POP_DS uconst COMMA ds_args trailing_comma {
 		sect_RelBytes($2, $4);
+		recycleDsArgs(std::move($4));
 	}
 	| POP_DS POP_ALIGN LBRACK align_spec RBRACK trailing_comma {
 		uint32_t n = sect_GetAlignBytes($4.alignment, $4.alignOfs);
@@ -1817,11 +1824,13 @@ ds:
 		uint32_t n = sect_GetAlignBytes($4.alignment, $4.alignOfs);
 		sect_RelBytes(n, $7);
 		sect_AlignPC($4.alignment, $4.alignOfs);
+		recycleDsArgs(std::move($7));
 	}
 ;
 
 ds_args:
 	reloc_8bit {
+		$$ = acquireDsArgs();
 		$$.push_back(std::move($1));
 	}
 	| ds_args COMMA reloc_8bit {
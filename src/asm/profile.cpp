@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+
+#include "asm/profile.hpp"
+
+#include <chrono>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#ifndef _MSC_VER
+	#include <sys/resource.h>
+#endif
+
+#include "style.hpp"
+
+#include "asm/main.hpp"
+
+uint64_t profileCounters[NB_PROFILE_COUNTERS];
+
+static std::chrono::steady_clock::time_point phaseStarts[NB_PROFILE_PHASES];
+static std::chrono::steady_clock::duration phaseTimes[NB_PROFILE_PHASES];
+
+void profile_Reset() {
+	for (uint64_t &counter : profileCounters) {
+		counter = 0;
+	}
+	for (std::chrono::steady_clock::duration &time : phaseTimes) {
+		time = {};
+	}
+}
+
+void profile_BeginPhase(ProfilePhase phase) {
+	if (options.profile) {
+		phaseStarts[phase] = std::chrono::steady_clock::now();
+	}
+}
+
+void profile_EndPhase(ProfilePhase phase) {
+	if (options.profile) {
+		phaseTimes[phase] += std::chrono::steady_clock::now() - phaseStarts[phase];
+	}
+}
+
+void profile_Report() {
+	if (!options.profile) {
+		return;
+	}
+
+	// LCOV_EXCL_START
+	static char const * const phaseNames[NB_PROFILE_PHASES] = {
+	    "Assembly pass",
+	    "Object write-out",
+	};
+	static char const * const counterNames[NB_PROFILE_COUNTERS] = {
+	    "Tokens parsed",
+	    "Expansions begun",
+	    "Macro invocations",
+	    "REPT/FOR blocks",
+	    "Sections created",
+	    "Patches emitted",
+	    "Symbols created",
+	};
+
+	style_Set(stderr, STYLE_MAGENTA, false);
+	for (int phase = 0; phase < NB_PROFILE_PHASES; ++phase) {
+		fprintf(
+		    stderr,
+		    "%-19s %12.3f s\n",
+		    phaseNames[phase],
+		    std::chrono::duration<double>(phaseTimes[phase]).count()
+		);
+	}
+	for (int counter = 0; counter < NB_PROFILE_COUNTERS; ++counter) {
+		fprintf(
+		    stderr, "%-19s %14" PRIu64 "\n", counterNames[counter], profileCounters[counter]
+		);
+	}
+#ifndef _MSC_VER
+	if (struct rusage usage; getrusage(RUSAGE_SELF, &usage) == 0) {
+		long maxRssKiB = usage.ru_maxrss;
+#ifdef __APPLE__
+		maxRssKiB /= 1024; // `ru_maxrss` is in bytes on macOS, KiB elsewhere
+#endif
+		fprintf(stderr, "%-19s %10ld KiB\n", "Peak memory (RSS)", maxRssKiB);
+	}
+#endif
+	style_Reset(stderr);
+	// LCOV_EXCL_STOP
+}
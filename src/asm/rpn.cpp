@@ -13,6 +13,7 @@
 #include <string_view>
 #include <utility>
 
+#include "arena.hpp"
 #include "helpers.hpp" // assume
 #include "linkdefs.hpp"
 #include "opmath.hpp"
@@ -24,11 +25,27 @@
 
 using namespace std::literals;
 
+// The parser constructs and destroys expressions at a very high rate, so their RPN buffers
+// are recycled through this pool instead of being allocated anew for each expression.
+static RecyclePool<std::vector<uint8_t>> rpnBufferPool;
+
+uint64_t rpn_CountBufferReuses() {
+	return rpnBufferPool.nbReused();
+}
+
+Expression::~Expression() {
+	if (rpn.capacity() > 0) {
+		rpn.clear();
+		rpnBufferPool.recycle(std::move(rpn));
+	}
+}
+
 void Expression::clear() {
 	data = 0;
 	isSymbol = false;
 	rpn.clear();
 	rpnPatchSize = 0;
+	hasConstAddTail = false;
 }
 
 uint8_t *Expression::reserveSpace(uint32_t size) {
@@ -37,6 +54,9 @@ uint8_t *Expression::reserveSpace(uint32_t size) {
 
 uint8_t *Expression::reserveSpace(uint32_t size, uint32_t patchSize) {
 	rpnPatchSize += patchSize;
+	if (rpn.capacity() == 0) {
+		rpn = rpnBufferPool.acquire();
+	}
 	size_t curSize = rpn.size();
 	rpn.resize(curSize + size);
 	return &rpn[curSize];
@@ -54,7 +74,8 @@ Symbol const *Expression::symbolOf() const {
 	if (!isSymbol) {
 		return nullptr;
 	}
-	return sym_FindScopedSymbol(reinterpret_cast<char const *>(&rpn[1]));
+	uint32_t nameID = rpn[1] | rpn[2] << 8 | rpn[3] << 16 | static_cast<uint32_t>(rpn[4]) << 24;
+	return sym_FindSymbolByNameID(nameID);
 }
 
 bool Expression::isDiffConstant(Symbol const *sym) const {
@@ -93,12 +114,18 @@ void Expression::makeSymbol(std::string const &symName) {
 		                           + (sym_IsPurgedScoped(symName) ? "; it was purged" : "");
 		sym = sym_Ref(symName);
 
-		size_t nameLen = sym->name.length() + 1; // Don't forget NUL!
+		// The interned name ID is stored instead of the name, both for compactness and so
+		// the writer can find the symbol again without re-hashing the name; it is resolved
+		// to the object file's symbol ID at write time (see `writeRpn`)
+		uint32_t nameID = sym->nameID;
 
 		// 1-byte opcode + 4-byte symbol ID
-		uint8_t *ptr = reserveSpace(nameLen + 1, 5);
+		uint8_t *ptr = reserveSpace(1 + 4, 5);
 		*ptr++ = RPN_SYM;
-		memcpy(ptr, sym->name.c_str(), nameLen);
+		*ptr++ = nameID & 0xFF;
+		*ptr++ = nameID >> 8;
+		*ptr++ = nameID >> 16;
+		*ptr++ = nameID >> 24;
 	} else {
 		data = static_cast<int32_t>(sym->getConstantValue());
 	}
@@ -134,12 +161,15 @@ void Expression::makeBankSymbol(std::string const &symName) {
 			           ? "`"s + symName + "`'s bank is not known; it was purged"
 			           : "`"s + symName + "`'s bank is not known";
 
-			size_t nameLen = sym->name.length() + 1; // Room for NUL!
+			uint32_t nameID = sym->nameID; // Resolved at write time, like `RPN_SYM`
 
 			// 1-byte opcode + 4-byte sect ID
-			uint8_t *ptr = reserveSpace(nameLen + 1, 5);
+			uint8_t *ptr = reserveSpace(1 + 4, 5);
 			*ptr++ = RPN_BANK_SYM;
-			memcpy(ptr, sym->name.c_str(), nameLen);
+			*ptr++ = nameID & 0xFF;
+			*ptr++ = nameID >> 8;
+			*ptr++ = nameID >> 16;
+			*ptr++ = nameID >> 24;
 		}
 	}
 }
@@ -347,6 +377,16 @@ void Expression::makeUnaryOp(RPNCommand op, Expression &&src) {
 	}
 }
 
+// Reads back the value of the `RPN_CONST <v>; RPN_ADD` tail that `hasConstAddTail` vouches for
+int32_t Expression::constAddTailValue() const {
+	assume(hasConstAddTail && rpn.size() >= 6);
+	uint8_t const *bytes = &rpn[rpn.size() - 5];
+	return static_cast<int32_t>(
+	    static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8
+	    | static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24
+	);
+}
+
 void Expression::makeBinaryOp(RPNCommand op, Expression &&src1, Expression const &src2) {
 	clear();
 	// First, check if the expressions are known
@@ -498,12 +538,35 @@ void Expression::makeBinaryOp(RPNCommand op, Expression &&src1, Expression const
 			rpnPatchSize = src1.rpnPatchSize;
 			std::swap(rpn, src1.rpn);
 			data = std::move(src1.data);
+			hasConstAddTail = src1.hasConstAddTail;
 		}
 
 		// Now, merge the right expression into the left one
 		if (src2.isKnown()) {
 			// If the right expression is constant, append a shim instead
+			// Additions and subtractions are normalized to `RPN_CONST <v>; RPN_ADD`, so
+			// constant terms in chains like `x + 1 - 2` fold into a single trailing constant
 			uint32_t rval = src2.value();
+			if (op == RPN_ADD || op == RPN_SUB) {
+				if (op == RPN_SUB) {
+					rval = -rval;
+				}
+				if (hasConstAddTail) {
+					rval += static_cast<uint32_t>(constAddTailValue());
+					if (rval == 0) {
+						// Adding zero is a no-op; drop the tail entirely
+						rpn.resize(rpn.size() - 6);
+						rpnPatchSize -= 6;
+						hasConstAddTail = false;
+						return;
+					}
+					rpn.resize(rpn.size() - 6);
+					rpnPatchSize -= 6;
+				}
+				op = RPN_ADD;
+			} else {
+				hasConstAddTail = false;
+			}
 			uint8_t bytes[] = {
 			    RPN_CONST,
 			    static_cast<uint8_t>(rval),
@@ -514,8 +577,12 @@ void Expression::makeBinaryOp(RPNCommand op, Expression &&src1, Expression const
 			uint8_t *ptr = reserveSpace(sizeof(bytes) + 1, sizeof(bytes) + 1);
 			memcpy(ptr, bytes, sizeof(bytes));
 			ptr[sizeof(bytes)] = op;
+			if (op == RPN_ADD) {
+				hasConstAddTail = true;
+			}
 		} else {
 			// Copy the right RPN and append the operator
+			hasConstAddTail = false;
 			uint32_t rightRpnSize = src2.rpn.size();
 			uint8_t *ptr = reserveSpace(rightRpnSize + 1, src2.rpnPatchSize + 1);
 			if (rightRpnSize > 0) {
@@ -530,6 +597,7 @@ void Expression::makeBinaryOp(RPNCommand op, Expression &&src1, Expression const
 void Expression::makeCheckHRAM() {
 	isSymbol = false;
 	if (!isKnown()) {
+		hasConstAddTail = false;
 		*reserveSpace(1) = RPN_HRAM;
 	} else if (int32_t val = value(); val >= 0xFF00 && val <= 0xFFFF) {
 		// That range is valid; only keep the lower byte
@@ -541,6 +609,7 @@ void Expression::makeCheckHRAM() {
 
 void Expression::makeCheckRST() {
 	if (!isKnown()) {
+		hasConstAddTail = false;
 		*reserveSpace(1) = RPN_RST;
 	} else if (int32_t val = value(); val & ~0x38) {
 		// A valid RST address must be masked with 0x38
@@ -552,6 +621,7 @@ void Expression::makeCheckBitIndex(uint8_t mask) {
 	assume((mask & 0xC0) != 0x00); // The high two bits must correspond to BIT, RES, or SET
 
 	if (!isKnown()) {
+		hasConstAddTail = false;
 		uint8_t *ptr = reserveSpace(2);
 		*ptr++ = RPN_BIT_INDEX;
 		*ptr = mask;
@@ -21,10 +21,12 @@
 #include "itertools.hpp" // InsertionOrderedMap
 #include "linkdefs.hpp"
 
+#include "asm/charmap.hpp"
 #include "asm/fstack.hpp"
 #include "asm/lexer.hpp"
 #include "asm/main.hpp"
 #include "asm/output.hpp"
+#include "asm/profile.hpp"
 #include "asm/rpn.hpp"
 #include "asm/symbol.hpp"
 #include "asm/warning.hpp"
@@ -89,6 +91,14 @@ size_t sect_CountSections() {
 	return sections.size();
 }
 
+uint64_t sect_CountDataBytes() {
+	uint64_t bytes = 0;
+	for (Section const &sect : sections) {
+		bytes += sect.data.capacity();
+	}
+	return bytes;
+}
+
 void sect_ForEach(void (*callback)(Section &)) {
 	for (Section &sect : sections) {
 		callback(sect);
@@ -322,6 +332,8 @@ static Section *createSection(
     uint16_t alignOffset,
     SectionModifier mod
 ) {
+	profile_Count(PROFILE_SECTIONS);
+
 	// Add the new section to the list
 	Section &sect = sections.add(name);
 
@@ -348,6 +360,7 @@ static Section *createSection(
 
 static Section *createSectionFragmentLiteral(Section const &parent) {
 	assume(sections.contains(parent.name));
+	profile_Count(PROFILE_SECTIONS);
 	Section &sect = sections.addAnonymous();
 
 	sect.name = parent.name;
@@ -482,6 +495,14 @@ uint32_t Section::getID() const {
 	return UINT32_MAX; // LCOV_EXCL_LINE
 }
 
+size_t Section::countPatches() const {
+	size_t nbPatches = 0;
+	for (std::pair<uint32_t, uint32_t> const &span : patchSpans) {
+		nbPatches += span.second;
+	}
+	return nbPatches;
+}
+
 bool Section::isSizeKnown() const {
 	// SECTION UNION and SECTION FRAGMENT can still grow
 	if (modifier != SECTION_NORMAL) {
@@ -601,8 +622,31 @@ std::optional<uint32_t> sect_GetOutputBank() {
 	return currentSection ? std::optional<uint32_t>(currentSection->bank) : std::nullopt;
 }
 
+// All sections' patches live in this one pool, so patch records are not allocated (nor
+// freed at exit) section by section; sections only record spans of pool indexes.
+static std::deque<Patch> patchPool;
+
+std::deque<Patch> &sect_PatchPool() {
+	return patchPool;
+}
+
 Patch *sect_AddOutputPatch() {
-	return currentSection ? &currentSection->patches.emplace_front() : nullptr;
+	if (!currentSection) {
+		return nullptr;
+	}
+
+	uint32_t idx = patchPool.size();
+	profile_Count(PROFILE_PATCHES);
+	Patch &patch = patchPool.emplace_back();
+
+	// Extend the section's last span if the patch is contiguous with it
+	if (std::vector<std::pair<uint32_t, uint32_t>> &spans = currentSection->patchSpans;
+	    !spans.empty() && spans.back().first + spans.back().second == idx) {
+		++spans.back().second;
+	} else {
+		spans.emplace_back(idx, 1);
+	}
+	return &patch;
 }
 
 // Returns how many bytes need outputting for the specified alignment and offset to succeed
@@ -694,16 +738,65 @@ static void writeByte(uint8_t byte) {
 	growSection(1);
 }
 
+// Reads up to `limit` bytes from `file` directly into the section's data buffer, a block at
+// a time, stopping early at EOF, on error, or if the section's buffer is full (the caller
+// falls back to `writeByte`, which keeps counting dropped bytes). Returns the number of
+// bytes read.
+static uint32_t writeFileBlocks(FILE *file, uint32_t limit) {
+	uint32_t total = 0;
+	while (total < limit) {
+		uint32_t index = sect_GetOutputOffset();
+		if (index >= currentSection->data.size()) {
+			break;
+		}
+		size_t want = std::min(static_cast<size_t>(limit - total),
+		                       currentSection->data.size() - index);
+		size_t n = fread(&currentSection->data[index], 1, want, file);
+		growSection(n);
+		total += n;
+		if (n < want) {
+			break;
+		}
+	}
+	return total;
+}
+
+// Reserves `n` bytes of the section's data buffer, advancing the write pointer, and
+// returns where to write them. Returns `nullptr` when the bytes would not all land inside
+// the buffer; callers must then fall back to the per-byte path, which keeps counting
+// dropped bytes past the end of an overflowing section.
+static uint8_t *reserveData(uint32_t n) {
+	uint32_t index = sect_GetOutputOffset();
+	if (n > currentSection->data.size() || index > currentSection->data.size() - n) {
+		return nullptr;
+	}
+	uint8_t *ptr = currentSection->data.data() + index;
+	growSection(n);
+	return ptr;
+}
+
 static void writeWord(uint16_t value) {
-	writeByte(value & 0xFF);
-	writeByte(value >> 8);
+	if (uint8_t *ptr = reserveData(2); ptr) {
+		ptr[0] = value & 0xFF;
+		ptr[1] = value >> 8;
+	} else {
+		writeByte(value & 0xFF);
+		writeByte(value >> 8);
+	}
 }
 
 static void writeLong(uint32_t value) {
-	writeByte(value & 0xFF);
-	writeByte(value >> 8);
-	writeByte(value >> 16);
-	writeByte(value >> 24);
+	if (uint8_t *ptr = reserveData(4); ptr) {
+		ptr[0] = value & 0xFF;
+		ptr[1] = value >> 8;
+		ptr[2] = value >> 16;
+		ptr[3] = value >> 24;
+	} else {
+		writeByte(value & 0xFF);
+		writeByte(value >> 8);
+		writeByte(value >> 16);
+		writeByte(value >> 24);
+	}
 }
 
 static void createPatch(PatchType type, Expression const &expr, uint32_t pcShift) {
@@ -770,46 +863,60 @@ void sect_ConstByte(uint8_t byte) {
 	writeByte(byte);
 }
 
-void sect_ByteString(std::vector<int32_t> const &str) {
-	if (!requireCodeSection()) {
-		return;
-	}
-
-	for (int32_t unit : str) {
-		if (!checkNBit(unit, 8, "All character units")) {
+// Streams a string's charmap units straight into the section, one mapping at a time, with a
+// scratch buffer reused across calls, so emitting a string makes no per-string allocation.
+// `width` is the unit size in bits; like the former two-pass version, at most one "All
+// character units" diagnostic is emitted per string, and all units are written regardless.
+static void writeCharmappedString(std::string const &str, uint8_t width) {
+	static std::vector<int32_t> units;
+	bool reported = false;
+
+	for (std::string_view input = str;;) {
+		units.clear();
+		if (!charmap_ConvertNext(input, &units)) {
 			break;
 		}
-	}
-
-	for (int32_t unit : str) {
-		writeByte(static_cast<uint8_t>(unit));
+		for (int32_t unit : units) {
+			if (width < 32 && !reported && !checkNBit(unit, width, "All character units")) {
+				reported = true;
+			}
+			switch (width) {
+			case 8:
+				writeByte(static_cast<uint8_t>(unit));
+				break;
+			case 16:
+				writeWord(static_cast<uint16_t>(unit));
+				break;
+			default:
+				writeLong(static_cast<uint32_t>(unit));
+				break;
+			}
+		}
 	}
 }
 
-void sect_WordString(std::vector<int32_t> const &str) {
+void sect_ByteString(std::string const &str) {
 	if (!requireCodeSection()) {
 		return;
 	}
 
-	for (int32_t unit : str) {
-		if (!checkNBit(unit, 16, "All character units")) {
-			break;
-		}
-	}
+	writeCharmappedString(str, 8);
+}
 
-	for (int32_t unit : str) {
-		writeWord(static_cast<uint16_t>(unit));
+void sect_WordString(std::string const &str) {
+	if (!requireCodeSection()) {
+		return;
 	}
+
+	writeCharmappedString(str, 16);
 }
 
-void sect_LongString(std::vector<int32_t> const &str) {
+void sect_LongString(std::string const &str) {
 	if (!requireCodeSection()) {
 		return;
 	}
 
-	for (int32_t unit : str) {
-		writeLong(static_cast<uint32_t>(unit));
-	}
+	writeCharmappedString(str, 32);
 }
 
 void sect_Skip(uint32_t skip, bool ds) {
@@ -830,8 +937,12 @@ void sect_Skip(uint32_t skip, bool ds) {
 			);
 		}
 		// We know we're in a code SECTION
-		while (skip--) {
-			writeByte(options.padByte);
+		if (uint8_t *ptr = reserveData(skip); ptr) {
+			memset(ptr, options.padByte, skip);
+		} else {
+			while (skip--) {
+				writeByte(options.padByte);
+			}
 		}
 	}
 }
@@ -854,6 +965,22 @@ void sect_RelBytes(uint32_t n, std::vector<Expression> const &exprs) {
 		return;
 	}
 
+	// Validate the space once for all `n` bytes; symbolic entries still get one patch
+	// each, with the offsets the per-byte path would have computed (PC stays at the
+	// location before the whole run, hence the `pcShift` of `n`)
+	if (uint8_t *ptr = reserveData(n); ptr) {
+		uint32_t ofs = sect_GetOutputOffset() - n;
+		for (uint32_t i = 0; i < n; ++i) {
+			if (Expression const &expr = exprs[i % exprs.size()]; !expr.isKnown()) {
+				out_CreatePatch(PATCHTYPE_BYTE, expr, ofs + i, n);
+				ptr[i] = 0;
+			} else {
+				ptr[i] = expr.value();
+			}
+		}
+		return;
+	}
+
 	for (uint32_t i = 0; i < n; ++i) {
 		if (Expression const &expr = exprs[i % exprs.size()]; !expr.isKnown()) {
 			createPatch(PATCHTYPE_BYTE, expr, i);
@@ -963,6 +1090,8 @@ bool sect_BinaryFile(std::string const &name, uint32_t startPos) {
 		}
 	}
 
+	writeFileBlocks(file, UINT32_MAX);
+	// Keep counting any bytes that did not fit in the section, one at a time
 	for (int byte; (byte = fgetc(file)) != EOF;) {
 		writeByte(byte);
 	}
@@ -1028,6 +1157,8 @@ bool sect_BinaryFileSlice(std::string const &name, uint32_t startPos, uint32_t l
 		}
 	}
 
+	length -= writeFileBlocks(file, length);
+	// Anything left over did not fit in the section or hit a premature EOF
 	while (length--) {
 		if (int byte = fgetc(file); byte != EOF) {
 			writeByte(byte);
@@ -1090,6 +1221,22 @@ void sect_CheckStack() {
 	}
 }
 
+static uint64_t nextFragmentLiteralID = 0; // See `sect_PushSectionFragmentLiteral`
+
+// Forget every section and stacked state, so a fresh assembly starts from scratch
+void sect_Reset() {
+	currentSection = nullptr;
+	sections.clear();
+	curOffset = 0;
+	sectionStack.clear();
+	currentLoadSection = nullptr;
+	currentLoadLabelScopes = {nullptr, nullptr};
+	loadOffset = 0;
+	currentUnionStack = {};
+	patchPool.clear();
+	nextFragmentLiteralID = 0;
+}
+
 void sect_EndSection() {
 	if (!currentSection) {
 		fatal("Cannot end the section outside of a `SECTION`");
@@ -1109,8 +1256,6 @@ void sect_EndSection() {
 }
 
 std::string sect_PushSectionFragmentLiteral() {
-	static uint64_t nextFragmentLiteralID = 0;
-
 	// Like `requireCodeSection` but fatal
 	if (!currentSection) {
 		fatal("Cannot output fragment literals outside of a `SECTION`");
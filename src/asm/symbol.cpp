@@ -3,6 +3,7 @@
 #include "asm/symbol.hpp"
 
 #include <algorithm>
+#include <deque>
 #include <errno.h>
 #include <inttypes.h>
 #include <memory>
@@ -10,29 +11,78 @@
 #include <stdio.h>
 #include <string.h>
 #include <string>
+#include <string_view>
 #include <time.h>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "diagnostics.hpp"
 #include "helpers.hpp" // assume
 #include "util.hpp"
 #include "version.hpp"
 
+#include "asm/cache.hpp"
 #include "asm/fstack.hpp"
 #include "asm/lexer.hpp"
 #include "asm/macro.hpp"
 #include "asm/main.hpp"
 #include "asm/output.hpp"
+#include "asm/profile.hpp"
 #include "asm/section.hpp"
 #include "asm/warning.hpp"
 
 using namespace std::literals;
 
-static std::unordered_map<std::string, Symbol> symbols;
-static std::unordered_set<std::string> purgedSymbols;
+// Every symbol name is interned once, and assigned a dense 32-bit ID in the process; the
+// symbol table is keyed by that ID, and purge tombstones are indexed by it. Repeated
+// lookups of the same name (the common case in macro-heavy code) thus hash the name only to
+// recover its ID, and never copy it. The `std::deque` guarantees stable storage, so the
+// lookup map can key views into it.
+static std::deque<std::string> symbolNames; // Indexed by name ID
+static std::unordered_map<std::string_view, uint32_t> symbolNameIDs;
+// Tombstones left by `PURGE`, indexed by name ID (`sym_InternName` keeps it sized); a flag
+// that rides along with the name's ID makes purge checks free of a second hash probe
+static std::vector<bool> purgedNames;
+
+static std::unordered_map<uint32_t, Symbol> symbols; // Keyed by name ID
+
+// Bumped whenever a symbol is purged; lets cached `Symbol *`s be validated cheaply, since
+// purging is the only way a symbol's storage can be destroyed (the map's nodes are stable)
+static uint64_t purgeCount = 0;
+
+uint64_t sym_PurgeCount() {
+	return purgeCount;
+}
+
+// Anonymous labels in definition order; `anonLabels[n]` is the symbol named "!n". Entries
+// are only appended, so backward references resolve by index without probing the map.
+static std::vector<Symbol *> anonLabels;
+
+uint32_t sym_InternName(std::string const &symName) {
+	if (auto search = symbolNameIDs.find(symName); search != symbolNameIDs.end()) {
+		return search->second;
+	}
+
+	uint32_t nameID = symbolNames.size();
+	symbolNames.push_back(symName);
+	symbolNameIDs.emplace(symbolNames.back(), nameID);
+	purgedNames.push_back(false);
+	return nameID;
+}
+
+std::string const &sym_GetInternedName(uint32_t nameID) {
+	assume(nameID < symbolNames.size());
+	return symbolNames[nameID];
+}
+
+// Returns the name's ID if it has been interned already, and `UINT32_MAX` otherwise;
+// unlike `sym_InternName`, this never extends the intern pool
+static uint32_t findNameID(std::string const &symName) {
+	auto search = symbolNameIDs.find(symName);
+	return search != symbolNameIDs.end() ? search->second : UINT32_MAX;
+}
 
 static Symbol const *globalScope = nullptr; // Current section's global label scope
 static Symbol const *localScope = nullptr;  // Current section's local label scope
@@ -47,9 +97,11 @@ static char savedTIME[256];
 static char savedDATE[256];
 static char savedTIMESTAMP_ISO8601_LOCAL[256];
 static char savedTIMESTAMP_ISO8601_UTC[256];
+static tm savedUTC;
 
 bool sym_IsPC(Symbol const *sym) {
-	return sym == PCSymbol;
+	// `PCSymbol` is instantiated lazily, so both pointers may be null
+	return sym != nullptr && sym == PCSymbol;
 }
 
 void sym_ForEach(void (*callback)(Symbol &)) {
@@ -58,6 +110,10 @@ void sym_ForEach(void (*callback)(Symbol &)) {
 	}
 }
 
+size_t sym_CountSymbols() {
+	return symbols.size();
+}
+
 static int32_t NARGCallback() {
 	if (MacroArgs const *macroArgs = fstk_GetCurrentMacroArgs(); macroArgs) {
 		return macroArgs->nbArgs();
@@ -207,12 +263,15 @@ static void assumeAlreadyExpanded(std::string const &symName) {
 
 static Symbol &createSymbol(std::string const &symName) {
 	assumeAlreadyExpanded(symName);
+	profile_Count(PROFILE_SYMBOLS);
 
 	static uint32_t nextDefIndex = 0;
 
-	Symbol &sym = symbols[symName];
+	uint32_t nameID = sym_InternName(symName);
+	Symbol &sym = symbols[nameID];
 
 	sym.name = symName;
+	sym.nameID = nameID;
 	sym.isBuiltin = false;
 	sym.isExported = false;
 	sym.isQuiet = false;
@@ -266,15 +325,186 @@ static bool isAutoScoped(std::string const &symName) {
 	return true;
 }
 
+// Qualifies a bare local label with the current global scope's name, reusing one scratch
+// buffer so hot references (e.g. `.loop` inside a macro body) do not allocate a combined
+// string on every lookup
+static std::string const &qualifyLocal(std::string const &symName) {
+	static std::string qualified;
+	qualified.assign(globalScope->name);
+	qualified += symName;
+	return qualified;
+}
+
+// Built-in symbols are registered lazily: `sym_Init` only snapshots the assembly's
+// timestamps, and a lookup that misses the symbol map consults this table, instantiating
+// the built-in on first use.
+static std::unordered_map<std::string_view, void (*)(Symbol &)> const builtinInitializers{
+    {"@",
+     [](Symbol &sym) {
+	     sym.type = SYM_LABEL;
+	     sym.data = PCCallback;
+	     PCSymbol = &sym;
+     }},
+    {"_NARG",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = NARGCallback;
+	     NARGSymbol = &sym;
+     }},
+    {".",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQUS;
+	     sym.data = globalScopeCallback;
+	     globalScopeSymbol = &sym;
+     }},
+    {"..",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQUS;
+	     sym.data = localScopeCallback;
+	     localScopeSymbol = &sym;
+     }},
+    {"_RS",
+     [](Symbol &sym) {
+	     sym.type = SYM_VAR;
+	     sym.data = 0;
+	     RSSymbol = &sym;
+     }},
+    {"__RGBDS_VERSION__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQUS;
+	     sym.data = std::make_shared<std::string>(get_package_version_string());
+     }},
+    {"__RGBDS_MAJOR__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = PACKAGE_VERSION_MAJOR;
+     }},
+    {"__RGBDS_MINOR__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = PACKAGE_VERSION_MINOR;
+     }},
+    {"__RGBDS_PATCH__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = PACKAGE_VERSION_PATCH;
+     }},
+#ifdef PACKAGE_VERSION_RC
+    {"__RGBDS_RC__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = PACKAGE_VERSION_RC;
+     }},
+#endif
+    {"__TIME__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQUS;
+	     sym.data = []() {
+		     warning(WARNING_OBSOLETE, "`__TIME__` is deprecated; use `__ISO_8601_LOCAL__`");
+		     return std::make_shared<std::string>(savedTIME);
+	     };
+     }},
+    {"__DATE__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQUS;
+	     sym.data = []() {
+		     warning(WARNING_OBSOLETE, "`__DATE__` is deprecated; use `__ISO_8601_LOCAL__`");
+		     return std::make_shared<std::string>(savedDATE);
+	     };
+     }},
+    {"__ISO_8601_LOCAL__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQUS;
+	     sym.data = std::make_shared<std::string>(savedTIMESTAMP_ISO8601_LOCAL);
+     }},
+    {"__ISO_8601_UTC__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQUS;
+	     sym.data = std::make_shared<std::string>(savedTIMESTAMP_ISO8601_UTC);
+     }},
+    {"__UTC_YEAR__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = savedUTC.tm_year + 1900;
+     }},
+    {"__UTC_MONTH__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = savedUTC.tm_mon + 1;
+     }},
+    {"__UTC_DAY__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = savedUTC.tm_mday;
+     }},
+    {"__UTC_HOUR__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = savedUTC.tm_hour;
+     }},
+    {"__UTC_MINUTE__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = savedUTC.tm_min;
+     }},
+    {"__UTC_SECOND__",
+     [](Symbol &sym) {
+	     sym.type = SYM_EQU;
+	     sym.data = savedUTC.tm_sec;
+     }},
+};
+
+static Symbol *instantiateBuiltin(std::string const &symName) {
+	auto search = builtinInitializers.find(std::string_view(symName));
+	if (search == builtinInitializers.end()) {
+		return nullptr;
+	}
+
+	Symbol &sym = createSymbol(symName);
+	// No matter when it is instantiated, a built-in belongs to no input file
+	sym.src = nullptr;
+	sym.fileLine = 0;
+	sym.isBuiltin = true;
+	search->second(sym);
+	// Timestamp built-ins embed this assembly's wall-clock time, which no input file
+	// reflects, so an object that used one must not enter the object cache
+	if (symName.starts_with("__UTC_") || symName.starts_with("__ISO_8601_")
+	    || symName == "__TIME__" || symName == "__DATE__") {
+		cache_MarkTimestampUse();
+	}
+	return &sym;
+}
+
 Symbol *sym_FindExactSymbol(std::string const &symName) {
 	assumeAlreadyExpanded(symName);
 
-	auto search = symbols.find(symName);
+	// Anonymous labels that already exist are resolved by index, skipping the name hash;
+	// forward references (not yet appended) still go through the map below
+	if (symName.starts_with('!')) {
+		if (uint32_t id = strtoul(symName.c_str() + 1, nullptr, 10);
+		    id < anonLabels.size() && anonLabels[id]) {
+			return anonLabels[id];
+		}
+	}
+
+	uint32_t nameID = findNameID(symName);
+	if (nameID == UINT32_MAX) {
+		// A name that was never even interned can still denote a built-in
+		return instantiateBuiltin(symName);
+	}
+	if (auto search = symbols.find(nameID); search != symbols.end()) {
+		return &search->second;
+	}
+	return instantiateBuiltin(symName);
+}
+
+Symbol *sym_FindSymbolByNameID(uint32_t nameID) {
+	auto search = symbols.find(nameID);
 	return search != symbols.end() ? &search->second : nullptr;
 }
 
 Symbol *sym_FindScopedSymbol(std::string const &symName) {
-	return sym_FindExactSymbol(isAutoScoped(symName) ? globalScope->name + symName : symName);
+	return sym_FindExactSymbol(isAutoScoped(symName) ? qualifyLocal(symName) : symName);
 }
 
 Symbol *sym_FindScopedValidSymbol(std::string const &symName) {
@@ -301,6 +531,9 @@ Symbol *sym_FindScopedValidSymbol(std::string const &symName) {
 }
 
 Symbol const *sym_GetPC() {
+	if (!PCSymbol) {
+		instantiateBuiltin("@"s);
+	}
 	return PCSymbol;
 }
 
@@ -330,28 +563,39 @@ void sym_Purge(std::string const &symName) {
 		if (sym == localScope) {
 			localScope = nullptr;
 		}
-		purgedSymbols.emplace(sym->name);
-		symbols.erase(sym->name);
+		purgedNames[sym->nameID] = true;
+		++purgeCount;
+		symbols.erase(sym->nameID);
 	}
 }
 
 bool sym_IsPurgedExact(std::string const &symName) {
 	assumeAlreadyExpanded(symName);
 
-	return purgedSymbols.find(symName) != purgedSymbols.end();
+	uint32_t nameID = findNameID(symName);
+	return nameID != UINT32_MAX && purgedNames[nameID];
 }
 
 bool sym_IsPurgedScoped(std::string const &symName) {
-	return sym_IsPurgedExact(isAutoScoped(symName) ? globalScope->name + symName : symName);
+	return sym_IsPurgedExact(isAutoScoped(symName) ? qualifyLocal(symName) : symName);
+}
+
+static Symbol &getRSSymbol() {
+	// `RB`/`RW`/`RL`/`RSSET` reach `_RS` without a name lookup, so instantiate it on demand
+	if (!RSSymbol) {
+		instantiateBuiltin("_RS"s);
+	}
+	return *RSSymbol;
 }
 
 int32_t sym_GetRSValue() {
-	return RSSymbol->getOutputValue();
+	return getRSSymbol().getOutputValue();
 }
 
 void sym_SetRSValue(int32_t value) {
-	updateSymbolFilename(*RSSymbol);
-	RSSymbol->data = value;
+	Symbol &sym = getRSSymbol();
+	updateSymbolFilename(sym);
+	sym.data = value;
 }
 
 uint32_t Symbol::getConstantValue() const {
@@ -392,7 +636,7 @@ static Symbol *createNonrelocSymbol(std::string const &symName, bool numeric) {
 
 	if (!sym) {
 		sym = &createSymbol(symName);
-		purgedSymbols.erase(sym->name);
+		purgedNames[sym->nameID] = false;
 	} else if (sym->isDefined()) {
 		alreadyDefinedError(*sym, nullptr);
 		return nullptr; // Don't allow overriding the symbol, that'd be bad!
@@ -534,7 +778,7 @@ Symbol *sym_AddLocalLabel(std::string const &symName) {
 	// The symbol name should be local, qualified or not
 	assume(symName.find('.') != std::string::npos);
 
-	Symbol *sym = addLabel(isAutoScoped(symName) ? globalScope->name + symName : symName);
+	Symbol *sym = addLabel(isAutoScoped(symName) ? qualifyLocal(symName) : symName);
 
 	if (sym) {
 		localScope = sym;
@@ -570,7 +814,9 @@ Symbol *sym_AddAnonLabel() {
 
 	std::string anon = sym_MakeAnonLabelName(0, true); // The direction is important!
 	++anonLabelID;
-	return addLabel(anon);
+	Symbol *sym = addLabel(anon);
+	anonLabels.push_back(sym); // Even if `nullptr`, to keep indices aligned with the IDs
+	return sym;
 }
 
 std::string sym_MakeAnonLabelName(uint32_t ofs, bool neg) {
@@ -604,7 +850,9 @@ std::string sym_MakeAnonLabelName(uint32_t ofs, bool neg) {
 		}
 	}
 
-	return "!"s + std::to_string(id);
+	char name[12]; // '!' plus up to 10 decimal digits
+	snprintf(name, sizeof(name), "!%" PRIu32, id);
+	return name;
 }
 
 void sym_Export(std::string const &symName) {
@@ -654,47 +902,35 @@ Symbol *sym_Ref(std::string const &symName) {
 	Symbol *sym = sym_FindScopedSymbol(symName);
 
 	if (!sym) {
-		sym = &createSymbol(isAutoScoped(symName) ? globalScope->name + symName : symName);
+		sym = &createSymbol(isAutoScoped(symName) ? qualifyLocal(symName) : symName);
 		sym->type = SYM_REF;
 	}
 
 	return sym;
 }
 
-// Define the built-in symbols
-void sym_Init(time_t now) {
-	PCSymbol = &createSymbol("@"s);
-	PCSymbol->type = SYM_LABEL;
-	PCSymbol->data = PCCallback;
-	PCSymbol->isBuiltin = true;
-
-	NARGSymbol = &createSymbol("_NARG"s);
-	NARGSymbol->type = SYM_EQU;
-	NARGSymbol->data = NARGCallback;
-	NARGSymbol->isBuiltin = true;
-
-	globalScopeSymbol = &createSymbol("."s);
-	globalScopeSymbol->type = SYM_EQUS;
-	globalScopeSymbol->data = globalScopeCallback;
-	globalScopeSymbol->isBuiltin = true;
-
-	localScopeSymbol = &createSymbol(".."s);
-	localScopeSymbol->type = SYM_EQUS;
-	localScopeSymbol->data = localScopeCallback;
-	localScopeSymbol->isBuiltin = true;
-
-	RSSymbol = sym_AddVar("_RS"s, 0);
-	RSSymbol->isBuiltin = true;
-
-	sym_AddString("__RGBDS_VERSION__"s, std::make_shared<std::string>(get_package_version_string()))
-	    ->isBuiltin = true;
-	sym_AddEqu("__RGBDS_MAJOR__"s, PACKAGE_VERSION_MAJOR)->isBuiltin = true;
-	sym_AddEqu("__RGBDS_MINOR__"s, PACKAGE_VERSION_MINOR)->isBuiltin = true;
-	sym_AddEqu("__RGBDS_PATCH__"s, PACKAGE_VERSION_PATCH)->isBuiltin = true;
-#ifdef PACKAGE_VERSION_RC
-	sym_AddEqu("__RGBDS_RC__"s, PACKAGE_VERSION_RC)->isBuiltin = true;
-#endif
+// Forget every symbol, so a fresh assembly can start from a pristine table; the built-ins
+// are re-instantiated lazily on lookup, but `sym_Init` must still run to refresh the
+// timestamps they capture
+void sym_Reset() {
+	symbols.clear();
+	symbolNameIDs.clear();
+	symbolNames.clear();
+	purgeCount = 0;
+	anonLabels.clear();
+	purgedNames.clear();
+	globalScope = nullptr;
+	localScope = nullptr;
+	PCSymbol = nullptr;
+	NARGSymbol = nullptr;
+	globalScopeSymbol = nullptr;
+	localScopeSymbol = nullptr;
+	RSSymbol = nullptr;
+}
 
+// Snapshot the timestamps captured by the `__TIME__`-style built-ins; the symbols
+// themselves are instantiated on first lookup (see `builtinInitializers`)
+void sym_Init(time_t now) {
 	// LCOV_EXCL_START
 	if (now == static_cast<time_t>(-1)) {
 		warnx("Failed to determine current time: %s", strerror(errno));
@@ -723,33 +959,5 @@ void sym_Init(time_t now) {
 	    time_utc
 	);
 
-	Symbol *timeSymbol = &createSymbol("__TIME__"s);
-	timeSymbol->type = SYM_EQUS;
-	timeSymbol->data = []() {
-		warning(WARNING_OBSOLETE, "`__TIME__` is deprecated; use `__ISO_8601_LOCAL__`");
-		return std::make_shared<std::string>(savedTIME);
-	};
-	timeSymbol->isBuiltin = true;
-
-	Symbol *dateSymbol = &createSymbol("__DATE__"s);
-	dateSymbol->type = SYM_EQUS;
-	dateSymbol->data = []() {
-		warning(WARNING_OBSOLETE, "`__DATE__` is deprecated; use `__ISO_8601_LOCAL__`");
-		return std::make_shared<std::string>(savedDATE);
-	};
-	dateSymbol->isBuiltin = true;
-
-	sym_AddString(
-	    "__ISO_8601_LOCAL__"s, std::make_shared<std::string>(savedTIMESTAMP_ISO8601_LOCAL)
-	)
-	    ->isBuiltin = true;
-	sym_AddString("__ISO_8601_UTC__"s, std::make_shared<std::string>(savedTIMESTAMP_ISO8601_UTC))
-	    ->isBuiltin = true;
-
-	sym_AddEqu("__UTC_YEAR__"s, time_utc->tm_year + 1900)->isBuiltin = true;
-	sym_AddEqu("__UTC_MONTH__"s, time_utc->tm_mon + 1)->isBuiltin = true;
-	sym_AddEqu("__UTC_DAY__"s, time_utc->tm_mday)->isBuiltin = true;
-	sym_AddEqu("__UTC_HOUR__"s, time_utc->tm_hour)->isBuiltin = true;
-	sym_AddEqu("__UTC_MINUTE__"s, time_utc->tm_min)->isBuiltin = true;
-	sym_AddEqu("__UTC_SECOND__"s, time_utc->tm_sec)->isBuiltin = true;
+	savedUTC = *time_utc;
 }
@@ -4,10 +4,18 @@
 
 #include <functional>
 #include <inttypes.h>
+#include <map>
+#include <memory>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
+#include "backtrace.hpp"
 #include "diagnostics.hpp"
 #include "style.hpp"
 
@@ -61,6 +69,116 @@ Diagnostics<WarningLevel, WarningID> warnings = {
 };
 // clang-format on
 
+// Total number of diagnostics (errors and printed warnings) emitted so far; this lets
+// callers check whether some operation emitted any, e.g. so it can be repeated verbatim
+static uint64_t nbDiagnostics = 0;
+
+uint64_t warning_GetDiagnosticsCount() {
+	return nbDiagnostics;
+}
+
+// With `--dedup-diagnostics`, only the first few diagnostics from the same location are
+// printed; further repeats are counted here, and summarized at the end of assembly.
+// Warnings are keyed by their ID, errors by their (statically-allocated) format string;
+// the location is the nearest named context plus the line number within it, so that every
+// iteration of a loop (and every invocation of the same macro) counts as a repeat.
+static constexpr uint64_t nbRepeatsPrinted = 3;
+template<typename K>
+using RepeatMap = std::map<std::tuple<K, std::string, uint32_t>, uint64_t>;
+static RepeatMap<WarningID> repeatedWarnings;
+static RepeatMap<char const *> repeatedErrors;
+
+template<typename K>
+static bool suppressRepeated(RepeatMap<K> &repeats, K key) {
+	if (!options.dedupDiagnostics) {
+		return false;
+	}
+	std::shared_ptr<FileStackNode> node = fstk_GetFileStack();
+	if (!node) {
+		return false; // LCOV_EXCL_LINE
+	}
+
+	// REPT nodes take their name from their parent, and their iteration counts change
+	// every iteration, so climb to the nearest named node
+	FileStackNode const *named = node.get();
+	while (named->type == NODE_REPT) {
+		assume(named->parent); // The top-level context cannot be a REPT
+		named = named->parent.get();
+	}
+
+	uint64_t &count = repeats[{key, named->name(), lexer_GetLineNo()}];
+	if (count != UINT64_MAX) {
+		++count;
+	}
+	if (count <= nbRepeatsPrinted) {
+		return false;
+	}
+	// A suppressed diagnostic still counts as emitted (e.g. for token replay)
+	++nbDiagnostics;
+	return true;
+}
+
+static void printRepeatLocation(std::string const &context, uint32_t lineNo) {
+	std::vector<std::pair<std::string, uint32_t>> location{
+	    {context, lineNo}
+	};
+	trace_PrintBacktrace(
+	    location,
+	    [](std::pair<std::string, uint32_t> const &loc) { return loc.first.c_str(); },
+	    [](std::pair<std::string, uint32_t> const &loc) { return loc.second; }
+	);
+}
+
+void warning_PrintRepeatSummary() {
+	for (auto const &[key, count] : repeatedWarnings) {
+		if (count <= nbRepeatsPrinted) {
+			continue;
+		}
+		auto const &[id, context, lineNo] = key;
+		bool isError = warnings.getWarningBehavior(id) == WarningBehavior::ERROR;
+		StyleColor color = isError ? STYLE_RED : STYLE_YELLOW;
+		uint64_t extra = count - nbRepeatsPrinted;
+		{
+			StyleSink sink(stderr);
+			sink.set(color, true);
+			sink.printf("%s: ", isError ? "error" : "warning");
+			sink.reset();
+			sink.printf("Warning repeated %" PRIu64 " more time%s", extra, extra == 1 ? "" : "s");
+			sink.set(color, true);
+			sink.printf(isError ? " [-Werror=%s]" : " [-W%s]", warnings.warningFlags[id].name);
+			sink.append('\n');
+		}
+		printRepeatLocation(context, lineNo);
+	}
+	for (auto const &[key, count] : repeatedErrors) {
+		if (count <= nbRepeatsPrinted) {
+			continue;
+		}
+		auto const &[fmt, context, lineNo] = key;
+		uint64_t extra = count - nbRepeatsPrinted;
+		{
+			StyleSink sink(stderr);
+			sink.set(STYLE_RED, true);
+			sink.append("error: ");
+			sink.reset();
+			sink.printf("Error repeated %" PRIu64 " more time%s", extra, extra == 1 ? "" : "s");
+			sink.append('\n');
+		}
+		printRepeatLocation(context, lineNo);
+	}
+	repeatedWarnings.clear();
+	repeatedErrors.clear();
+}
+
+// Reset the diagnostic counters, so a fresh assembly starts with a clean slate; the warning
+// flags set on the command line are configuration, and stay
+void warning_Reset() {
+	nbDiagnostics = 0;
+	repeatedWarnings.clear();
+	repeatedErrors.clear();
+	warnings.nbErrors = 0;
+}
+
 static void printDiag(
     char const *fmt,
     va_list args,
@@ -69,16 +187,19 @@ static void printDiag(
     char const *flagfmt,
     char const *flag
 ) {
-	style_Set(stderr, color, true);
-	fprintf(stderr, "%s: ", type);
-	style_Reset(stderr);
-	vfprintf(stderr, fmt, args);
+	++nbDiagnostics;
+	StyleSink sink(stderr);
+	sink.set(color, true);
+	sink.printf("%s: ", type);
+	sink.reset();
+	sink.vprintf(fmt, args);
 	if (flagfmt) {
-		style_Set(stderr, color, true);
-		putc(' ', stderr);
-		fprintf(stderr, flagfmt, flag);
+		sink.set(color, true);
+		sink.append(' ');
+		sink.printf(flagfmt, flag);
 	}
-	putc('\n', stderr);
+	sink.append('\n');
+	sink.flush();
 
 	fstk_TraceCurrent();
 }
@@ -102,6 +223,11 @@ static void incrementErrors() {
 }
 
 void error(char const *fmt, ...) {
+	if (suppressRepeated(repeatedErrors, fmt)) {
+		incrementErrors(); // Suppressed errors still count toward the total
+		return;
+	}
+
 	va_list args;
 
 	va_start(args, fmt);
@@ -112,6 +238,7 @@ void error(char const *fmt, ...) {
 }
 
 void errorNoTrace(std::function<void()> callback) {
+	++nbDiagnostics;
 	style_Set(stderr, STYLE_RED, true);
 	fputs("error: ", stderr);
 	style_Reset(stderr);
@@ -132,6 +259,7 @@ void fatal(char const *fmt, ...) {
 }
 
 void requireZeroErrors() {
+	warning_PrintRepeatSummary();
 	if (warnings.nbErrors != 0) {
 		style_Set(stderr, STYLE_RED, true);
 		fprintf(
@@ -146,23 +274,51 @@ void requireZeroErrors() {
 }
 
 void warning(WarningID id, char const *fmt, ...) {
+	// Check this first, so that disabled warnings cost nothing beyond this cached load;
+	// no formatting or backtrace work happens for them
+	WarningBehavior behavior = warnings.getWarningBehavior(id);
+	if (behavior == WarningBehavior::DISABLED) {
+		return;
+	}
+	if (suppressRepeated(repeatedWarnings, id)) {
+		return;
+	}
+
 	char const *flag = warnings.warningFlags[id].name;
 	va_list args;
 
 	va_start(args, fmt);
-
-	switch (warnings.getWarningBehavior(id)) {
-	case WarningBehavior::DISABLED:
-		break;
-
-	case WarningBehavior::ENABLED:
+	if (behavior == WarningBehavior::ENABLED) {
 		printDiag(fmt, args, "warning", STYLE_YELLOW, "[-W%s]", flag);
-		break;
-
-	case WarningBehavior::ERROR:
+	} else {
 		printDiag(fmt, args, "error", STYLE_RED, "[-Werror=%s]", flag);
-		break;
 	}
-
 	va_end(args);
 }
+
+void warning(WarningID id, std::function<void()> callback) {
+	// The callback is only invoked once the warning is known to be visible, so callers
+	// can defer formatting its message until then
+	WarningBehavior behavior = warnings.getWarningBehavior(id);
+	if (behavior == WarningBehavior::DISABLED) {
+		return;
+	}
+	if (suppressRepeated(repeatedWarnings, id)) {
+		return;
+	}
+
+	char const *flag = warnings.warningFlags[id].name;
+	bool isError = behavior == WarningBehavior::ERROR;
+	StyleColor color = isError ? STYLE_RED : STYLE_YELLOW;
+
+	++nbDiagnostics;
+	style_Set(stderr, color, true);
+	fprintf(stderr, "%s: ", isError ? "error" : "warning");
+	style_Reset(stderr);
+	callback();
+	style_Set(stderr, color, true);
+	fprintf(stderr, isError ? " [-Werror=%s]" : " [-W%s]", flag);
+	putc('\n', stderr);
+
+	fstk_TraceCurrent();
+}
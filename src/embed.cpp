@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: MIT
+
+#include "embed.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifndef _MSC_VER
+	#include <errno.h>
+	#include <sys/wait.h>
+	#include <unistd.h>
+#endif
+
+void rgbds_free(void *buffer) {
+	free(buffer);
+}
+
+int embed_RunWorker(std::function<void()> const &childFn, unsigned char **out, size_t *outSize) {
+	*out = nullptr;
+	*outSize = 0;
+
+#ifndef _MSC_VER
+	int pipeFDs[2];
+	if (pipe(pipeFDs) != 0) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to create pipe: %s\n", strerror(errno));
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	fflush(nullptr); // Avoid duplicating buffered output into the worker
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to fork: %s\n", strerror(errno));
+		close(pipeFDs[0]);
+		close(pipeFDs[1]);
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	if (pid == 0) {
+		// The output goes to the pipe; a `fatal` error only exits this worker
+		close(pipeFDs[0]);
+		if (dup2(pipeFDs[1], STDOUT_FILENO) < 0) {
+			exit(1); // LCOV_EXCL_LINE
+		}
+		close(pipeFDs[1]);
+		childFn();
+		exit(0); // Flushes the output through stdio
+	}
+	close(pipeFDs[1]);
+
+	std::vector<unsigned char> bytes;
+	bool readFailed = false;
+	for (unsigned char chunk[65536];;) {
+		ssize_t n = read(pipeFDs[0], chunk, sizeof(chunk));
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue; // LCOV_EXCL_LINE
+			}
+			// LCOV_EXCL_START
+			fprintf(stderr, "Failed to read from worker: %s\n", strerror(errno));
+			readFailed = true;
+			break;
+			// LCOV_EXCL_STOP
+		}
+		if (n == 0) {
+			break;
+		}
+		bytes.insert(bytes.end(), chunk, chunk + n);
+	}
+	close(pipeFDs[0]);
+
+	int status;
+	if (waitpid(pid, &status, 0) < 0) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to wait for worker: %s\n", strerror(errno));
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	if (!WIFEXITED(status)) {
+		return -1; // LCOV_EXCL_LINE
+	}
+	if (int code = WEXITSTATUS(status); code != 0 || readFailed) {
+		return code != 0 ? code : -1;
+	}
+
+	// The buffer is returned to (possibly C) callers, who release it with `rgbds_free`
+	unsigned char *buf = static_cast<unsigned char *>(malloc(bytes.empty() ? 1 : bytes.size()));
+	if (!buf) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to allocate %zu bytes for worker output\n", bytes.size());
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	memcpy(buf, bytes.data(), bytes.size());
+	*out = buf;
+	*outSize = bytes.size();
+	return 0;
+#else
+	// LCOV_EXCL_START
+	(void)childFn;
+	fprintf(stderr, "The embedding API is not supported on this platform\n");
+	return -1;
+	// LCOV_EXCL_STOP
+#endif
+}
@@ -12,6 +12,10 @@
 #include <string.h>
 #include <vector>
 
+#ifndef _MSC_VER
+	#include <sys/mman.h>
+#endif
+
 #include "diagnostics.hpp"
 #include "helpers.hpp"
 #include "platform.hpp"
@@ -74,6 +78,17 @@ static ssize_t writeBytes(int fd, uint8_t *buf, size_t len) {
 	return total;
 }
 
+// Adds a buffer's bytes to the running global checksum. The plain widening reduction is
+// recognized by compilers, which lower it to SIMD block sums with a final horizontal add;
+// the checksum is taken mod 65536, so the truncation on return is harmless.
+static uint16_t sumBytes(uint16_t sum, uint8_t const *bytes, size_t len) {
+	uint64_t total = 0;
+	for (size_t i = 0; i < len; ++i) {
+		total += bytes[i];
+	}
+	return sum + total;
+}
+
 static void overwriteByte(uint8_t *rom0, uint16_t addr, uint8_t fixedByte, char const *areaName) {
 	uint8_t origByte = rom0[addr];
 
@@ -107,11 +122,35 @@ static void
 		assume(fileSize == 0);
 	}
 
-	uint8_t rom0[BANK_SIZE];
-	ssize_t rom0Len = readBytes(input, rom0, sizeof(rom0));
+	uint8_t rom0Buf[BANK_SIZE];
+	uint8_t *rom0 = rom0Buf;
+	ssize_t rom0Len;
 	// Also used as how many bytes to write back when fixing in-place
 	ssize_t headerSize = (options.cartridgeType & 0xFF00) == TPP1 ? 0x154 : 0x150;
 
+#ifndef _MSC_VER
+	// When fixing a regular file in-place (and not padding it, which changes its size), map it
+	// into memory instead of reading it: the header fields and checksums are patched directly in
+	// the shared mapping, so only the dirtied pages get written back, and the global checksum
+	// reads the ROM without copying it. If the mapping fails, fall back to regular I/O.
+	void *mapping = MAP_FAILED;
+	if (input == output && options.padValue == UNSPECIFIED) {
+		mapping = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, input, 0);
+	}
+	Defer unmap{[&] {
+		if (mapping != MAP_FAILED) {
+			munmap(mapping, fileSize);
+		}
+	}};
+	if (mapping != MAP_FAILED) {
+		rom0 = static_cast<uint8_t *>(mapping);
+		rom0Len = fileSize < BANK_SIZE ? fileSize : BANK_SIZE;
+	} else
+#endif
+	{
+		rom0Len = readBytes(input, rom0, sizeof(rom0Buf));
+	}
+
 	if (rom0Len == -1) {
 		// LCOV_EXCL_START
 		error("Failed to read \"%s\"'s header: %s", name, strerror(errno));
@@ -242,6 +281,14 @@ static void
 	size_t totalRomxLen = 0;   // *Actual* size of ROMX data
 	uint8_t bank[BANK_SIZE];   // Temp buffer used to store a whole bank's worth of data
 
+	// When writing to a separate output, the ROM body only needs to be buffered if the header
+	// depends on it (the global checksum) or if its total size must be known up front (padding
+	// and the ROM size byte). Otherwise, the body can be forwarded as-is after the patched
+	// header, without accumulating it in memory.
+	bool const passthrough = input != output
+	                         && !(options.fixSpec & (FIX_GLOBAL_SUM | TRASH_GLOBAL_SUM))
+	                         && options.padValue == UNSPECIFIED;
+
 	// Handle ROMX
 	if (input == output) {
 		if (fileSize >= 0x10000 * BANK_SIZE) {
@@ -253,14 +300,14 @@ static void
 		// Compute number of banks and ROMX len from file size
 		nbBanks = (fileSize + (BANK_SIZE - 1)) / BANK_SIZE; // ceil(fileSize / BANK_SIZE)
 		totalRomxLen = fileSize >= BANK_SIZE ? fileSize - BANK_SIZE : 0;
-	} else if (rom0Len == BANK_SIZE) {
+	} else if (rom0Len == BANK_SIZE && !passthrough) {
 		// Copy ROMX when reading a pipe, and we're not at EOF yet
 		for (;;) {
 			romx.resize(nbBanks * BANK_SIZE);
 			ssize_t bankLen = readBytes(input, &romx[(nbBanks - 1) * BANK_SIZE], BANK_SIZE);
 
 			// Update bank count, ONLY IF at least one byte was read
-			if (bankLen) {
+			if (bankLen > 0) {
 				// We're going to read another bank, check that it won't be too much
 				static_assert(
 				    0x10000 * BANK_SIZE <= SSIZE_MAX, "Max input file size too large for OS"
@@ -271,10 +318,9 @@ static void
 				}
 				++nbBanks;
 
-				// Update global checksum, too
-				for (uint16_t i = 0; i < bankLen; ++i) {
-					globalSum += romx[totalRomxLen + i];
-				}
+				// Update global checksum, too; this sums each bank as it is read, so the image
+				// is only streamed through once
+				globalSum = sumBytes(globalSum, &romx[totalRomxLen], bankLen);
 				totalRomxLen += bankLen;
 			}
 			// Stop when an incomplete bank has been read
@@ -292,16 +338,16 @@ static void
 	if (options.padValue != UNSPECIFIED) {
 		// We want at least 2 banks
 		if (nbBanks == 1) {
-			if (rom0Len != sizeof(rom0)) {
-				memset(&rom0[rom0Len], options.padValue, sizeof(rom0) - rom0Len);
+			if (rom0Len != sizeof(rom0Buf)) {
+				memset(&rom0[rom0Len], options.padValue, sizeof(rom0Buf) - rom0Len);
 				// The global checksum hasn't taken ROM0 into consideration yet!
 				// ROM0 was padded, so treat it as entirely written: update its size
 				// Update how many bytes were read in total, too
-				rom0Len = sizeof(rom0);
+				rom0Len = sizeof(rom0Buf);
 			}
 			nbBanks = 2;
 		} else {
-			assume(rom0Len == sizeof(rom0));
+			assume(rom0Len == sizeof(rom0Buf));
 		}
 		assume(nbBanks >= 2);
 		// Alter number of banks to reflect required value
@@ -332,22 +378,29 @@ static void
 	if (options.fixSpec & (FIX_GLOBAL_SUM | TRASH_GLOBAL_SUM)) {
 		// Computation of the global checksum does not include the checksum bytes
 		assume(rom0Len >= 0x14E);
-		for (uint16_t i = 0; i < 0x14E; ++i) {
-			globalSum += rom0[i];
-		}
-		for (uint16_t i = 0x150; i < rom0Len; ++i) {
-			globalSum += rom0[i];
-		}
+		globalSum = sumBytes(globalSum, rom0, 0x14E);
+		globalSum = sumBytes(globalSum, &rom0[0x150], rom0Len - 0x150);
 		// Pipes have already read ROMX and updated globalSum, but not regular files
 		if (input == output) {
-			for (;;) {
-				ssize_t bankLen = readBytes(input, bank, sizeof(bank));
-
-				for (uint16_t i = 0; i < bankLen; ++i) {
-					globalSum += bank[i];
+#ifndef _MSC_VER
+			if (mapping != MAP_FAILED) {
+				// Sum ROMX straight from the mapping, without copying it
+				if (fileSize > BANK_SIZE) {
+					uint8_t const *bytes = static_cast<uint8_t const *>(mapping);
+					globalSum = sumBytes(globalSum, &bytes[BANK_SIZE], fileSize - BANK_SIZE);
 				}
-				if (bankLen != sizeof(bank)) {
-					break;
+			} else
+#endif
+			{
+				for (;;) {
+					ssize_t bankLen = readBytes(input, bank, sizeof(bank));
+
+					if (bankLen > 0) {
+						globalSum = sumBytes(globalSum, bank, bankLen);
+					}
+					if (bankLen != sizeof(bank)) {
+						break;
+					}
 				}
 			}
 		}
@@ -363,6 +416,14 @@ static void
 		overwriteBytes(rom0, 0x14E, bytes, sizeof(bytes), "global checksum");
 	}
 
+#ifndef _MSC_VER
+	if (mapping != MAP_FAILED) {
+		// The header fields and checksums were patched directly in the mapping, and no padding
+		// was requested, so there is nothing left to write back.
+		return;
+	}
+#endif
+
 	ssize_t writeLen;
 
 	// In case the output depends on the input, reset to the beginning of the file, and only
@@ -422,6 +483,51 @@ static void
 		}
 	}
 
+	// Forward the rest of the body, which was deliberately not buffered
+	if (passthrough && rom0Len == BANK_SIZE) {
+#ifdef __linux__
+		// Forward from pipe to pipe (e.g. in a FIFO-based pipeline) without a round trip
+		// through user space; `splice` refuses outright if neither end is a pipe, in which
+		// case the regular read/write loop below takes over
+		for (;;) {
+			ssize_t ret = splice(input, nullptr, output, nullptr, 1 << 20, 0);
+			if (ret == 0) { // EOF
+				return;
+			}
+			if (ret == -1) {
+				if (errno == EINVAL || errno == ENOSYS) {
+					break; // Not spliceable, fall back
+				}
+				if (errno != EINTR) {
+					// LCOV_EXCL_START
+					error("Failed to forward \"%s\"'s ROMX: %s", name, strerror(errno));
+					return;
+					// LCOV_EXCL_STOP
+				}
+			}
+		}
+#endif
+		for (;;) {
+			ssize_t bankLen = readBytes(input, bank, sizeof(bank));
+
+			if (bankLen == -1) {
+				// LCOV_EXCL_START
+				error("Failed to read \"%s\"'s ROMX: %s", name, strerror(errno));
+				return;
+				// LCOV_EXCL_STOP
+			}
+			if (bankLen > 0 && writeBytes(output, bank, bankLen) != bankLen) {
+				// LCOV_EXCL_START
+				error("Failed to write \"%s\"'s ROMX: %s", name, strerror(errno));
+				return;
+				// LCOV_EXCL_STOP
+			}
+			if (bankLen != sizeof(bank)) {
+				break;
+			}
+		}
+	}
+
 	// Output padding
 	if (options.padValue != UNSPECIFIED) {
 		if (input == output) {
@@ -453,10 +559,210 @@ static void
 	}
 }
 
+// Checks a ROM against what the requested fixes would have written, without modifying it: the
+// header fields in a single read, plus a streaming pass for the global checksum if requested.
+// Each mismatch is reported as an error.
+static void verifyFile(int input, char const *name, off_t fileSize) {
+	uint8_t rom0[BANK_SIZE];
+	ssize_t rom0Len = readBytes(input, rom0, sizeof(rom0));
+	ssize_t headerSize = (options.cartridgeType & 0xFF00) == TPP1 ? 0x154 : 0x150;
+
+	if (rom0Len == -1) {
+		// LCOV_EXCL_START
+		error("Failed to read \"%s\"'s header: %s", name, strerror(errno));
+		return;
+		// LCOV_EXCL_STOP
+	} else if (rom0Len < headerSize) {
+		error(
+		    "\"%s\" too short, expected at least %jd ($%jx) bytes, got only %jd",
+		    name,
+		    static_cast<intmax_t>(headerSize),
+		    static_cast<intmax_t>(headerSize),
+		    static_cast<intmax_t>(rom0Len)
+		);
+		return;
+	}
+
+	auto expectByte = [&rom0, name](uint16_t addr, uint8_t expected, char const *areaName) {
+		if (rom0[addr] != expected) {
+			error(
+			    "\"%s\": %s is 0x%02X, expected 0x%02X", name, areaName, rom0[addr], expected
+			);
+		}
+	};
+	auto expectBytes =
+	    [&rom0, name](uint16_t startAddr, uint8_t const *expected, uint8_t size, char const *areaName) {
+		    if (memcmp(&rom0[startAddr], expected, size) != 0) {
+			    error("\"%s\": %s does not match", name, areaName);
+		    }
+	    };
+
+	if (options.fixSpec & (FIX_LOGO | TRASH_LOGO)) {
+		expectBytes(
+		    0x0104,
+		    options.logo,
+		    sizeof(options.logo),
+		    options.logoFilename ? "logo" : "Nintendo logo"
+		);
+	}
+
+	if (options.title) {
+		expectBytes(
+		    0x134, reinterpret_cast<uint8_t const *>(options.title), options.titleLen, "title"
+		);
+	}
+
+	if (options.gameID) {
+		expectBytes(
+		    0x13F,
+		    reinterpret_cast<uint8_t const *>(options.gameID),
+		    options.gameIDLen,
+		    "manufacturer code"
+		);
+	}
+
+	if (options.model != DMG) {
+		expectByte(0x143, options.model == BOTH ? 0x80 : 0xC0, "CGB flag");
+	}
+
+	if (options.newLicensee) {
+		expectBytes(
+		    0x144,
+		    reinterpret_cast<uint8_t const *>(options.newLicensee),
+		    options.newLicenseeLen,
+		    "new licensee code"
+		);
+	}
+
+	if (options.sgb) {
+		expectByte(0x146, 0x03, "SGB flag");
+	}
+
+	if (options.cartridgeType < MBC_NONE) {
+		uint8_t byte = options.cartridgeType;
+		if ((options.cartridgeType & 0xFF00) == TPP1) {
+			byte = 0xBC;
+		}
+		expectByte(0x147, byte, "cartridge type");
+	}
+
+	if ((options.cartridgeType & 0xFF00) == TPP1) {
+		uint8_t const tpp1Code[2] = {0xC1, 0x65};
+
+		expectBytes(0x149, tpp1Code, sizeof(tpp1Code), "TPP1 identification code");
+		expectBytes(0x150, options.tpp1Rev, sizeof(options.tpp1Rev), "TPP1 revision number");
+		if (options.ramSize != UNSPECIFIED) {
+			expectByte(0x152, options.ramSize, "RAM size");
+		}
+		expectByte(0x153, options.cartridgeType & 0xFF, "TPP1 feature flags");
+	} else {
+		if (options.ramSize != UNSPECIFIED) {
+			expectByte(0x149, options.ramSize, "RAM size");
+		}
+		if (!options.japanese) {
+			expectByte(0x14A, 0x01, "destination code");
+		}
+	}
+
+	if (options.oldLicensee != UNSPECIFIED) {
+		expectByte(0x14B, options.oldLicensee, "old licensee code");
+	}
+
+	if (options.romVersion != UNSPECIFIED) {
+		expectByte(0x14C, options.romVersion, "mask ROM version number");
+	}
+
+	if (options.fixSpec & (FIX_HEADER_SUM | TRASH_HEADER_SUM)) {
+		uint8_t sum = 0;
+
+		for (uint16_t i = 0x134; i < 0x14D; ++i) {
+			sum -= rom0[i] + 1;
+		}
+
+		expectByte(0x14D, options.fixSpec & TRASH_HEADER_SUM ? ~sum : sum, "header checksum");
+	}
+
+	// The total length is only known up front for regular files; pipes must be streamed to the
+	// end to learn it, which the global checksum pass does anyway
+	off_t totalLen = fileSize != 0 ? fileSize : rom0Len;
+	bool needTotalLen = options.padValue != UNSPECIFIED && fileSize == 0;
+
+	if (options.fixSpec & (FIX_GLOBAL_SUM | TRASH_GLOBAL_SUM) || needTotalLen) {
+		assume(rom0Len >= 0x14E);
+		uint16_t globalSum = 0;
+		globalSum = sumBytes(globalSum, rom0, 0x14E);
+		globalSum = sumBytes(globalSum, &rom0[0x150], rom0Len - 0x150);
+
+		uint8_t bank[BANK_SIZE];
+		for (;;) {
+			ssize_t bankLen = readBytes(input, bank, sizeof(bank));
+
+			if (bankLen > 0) {
+				globalSum = sumBytes(globalSum, bank, bankLen);
+				if (fileSize == 0) {
+					totalLen += bankLen;
+				}
+			}
+			if (bankLen != sizeof(bank)) {
+				break;
+			}
+		}
+
+		if (options.fixSpec & (FIX_GLOBAL_SUM | TRASH_GLOBAL_SUM)) {
+			if (options.fixSpec & TRASH_GLOBAL_SUM) {
+				globalSum = ~globalSum;
+			}
+			uint16_t stored = rom0[0x14E] << 8 | rom0[0x14F];
+			if (stored != globalSum) {
+				error(
+				    "\"%s\": global checksum is 0x%04X, expected 0x%04X", name, stored, globalSum
+				);
+			}
+		}
+	}
+
+	if (options.padValue != UNSPECIFIED) {
+		uint32_t nbBanks = (totalLen + (BANK_SIZE - 1)) / BANK_SIZE; // ceil(totalLen / BANK_SIZE)
+		if (nbBanks < 2 || (nbBanks & (nbBanks - 1)) != 0
+		    || totalLen != static_cast<off_t>(nbBanks) * BANK_SIZE) {
+			error(
+			    "\"%s\" is %jd ($%jx) bytes, which is not padded to a valid size",
+			    name,
+			    static_cast<intmax_t>(totalLen),
+			    static_cast<intmax_t>(totalLen)
+			);
+		} else {
+			expectByte(0x148, ctz(nbBanks / 2), "ROM size");
+		}
+	}
+}
+
 bool fix_ProcessFile(char const *name, char const *outputName) {
-	warnings.nbErrors = 0;
+	threadNbErrors() = 0;
 
 	bool inputStdin = !strcmp(name, "-");
+
+	if (options.verify) {
+		// Verification never writes, so the input is only ever opened for reading
+		if (inputStdin) {
+			name = "<stdin>";
+			(void)setmode(STDIN_FILENO, O_BINARY);
+			verifyFile(STDIN_FILENO, name, 0);
+		} else if (int input = open(name, O_RDONLY | O_BINARY); input == -1) {
+			error("Failed to open \"%s\" for reading: %s", name, strerror(errno));
+		} else {
+			Defer closeInput{[&] { close(input); }};
+			struct stat stat;
+			// Pipes report a size of 0, and are streamed to their end instead
+			off_t fileSize = 0;
+			if (fstat(input, &stat) == 0 && S_ISREG(stat.st_mode) && stat.st_size > 0) {
+				fileSize = stat.st_size;
+			}
+			verifyFile(input, name, fileSize);
+		}
+		return checkErrors(name);
+	}
+
 	if (inputStdin && !outputName) {
 		outputName = "-";
 	}
@@ -9,10 +9,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <vector>
 
 #include "diagnostics.hpp"
 #include "extern/getopt.hpp"
 #include "helpers.hpp"
+#include "memstats.hpp"
+#include "parallel.hpp"
 #include "platform.hpp"
 #include "style.hpp"
 #include "usage.hpp"
@@ -28,7 +32,7 @@ Options options;
 static char const *optstring = "Ccf:hi:jk:L:l:m:n:Oo:p:r:st:VvW:w";
 
 // Variables for the long-only options
-static int longOpt; // `--color`
+static int longOpt; // `--color`, `--verify`
 
 // Equivalent long options
 // Please keep in the same order as short opts.
@@ -59,6 +63,8 @@ static option const longopts[] = {
     {"validate",         no_argument,       nullptr,  'v'},
     {"warning",          required_argument, nullptr,  'W'},
     {"color",            required_argument, &longOpt, 'c'},
+    {"mem-stats",        no_argument,       &longOpt, 'm'},
+    {"verify",           no_argument,       &longOpt, 'v'},
     {nullptr,            no_argument,       nullptr,  0  },
 };
 
@@ -322,11 +328,16 @@ int main(int argc, char *argv[]) {
 
 		case 'w':
 			warnings.state.warningsEnabled = false;
+			warnings.flushWarningCache();
 			break;
 
 		case 0: // Long-only options
 			if (longOpt == 'c' && !style_Parse(musl_optarg)) {
 				fatal("Invalid argument for option '--color'");
+			} else if (longOpt == 'm') {
+				mem_EnableStats();
+			} else if (longOpt == 'v') {
+				options.verify = true;
 			}
 			break;
 
@@ -394,10 +405,55 @@ int main(int argc, char *argv[]) {
 		usage.printAndExit("If '-o' is set then only a single input file may be specified");
 	}
 
+	if (options.verify && outputFilename) {
+		usage.printAndExit("'--verify' never writes, so it is incompatible with '-o'");
+	}
+
 	bool failed = warnings.nbErrors > 0;
-	do {
-		failed |= fix_ProcessFile(*argv, outputFilename);
-	} while (*++argv);
+
+	size_t nbFiles = 0;
+	bool anyStdio = false;
+	for (char *const *arg = argv; *arg; ++arg) {
+		++nbFiles;
+		anyStdio |= !strcmp(*arg, "-");
+	}
+
+#ifndef _MSC_VER
+	// Each file's work (header patch plus global checksum over the whole image) is independent,
+	// so fix multiple named files concurrently. Each job buffers its diagnostics and they are
+	// printed in argument order afterwards; stdin/stdout jobs stay sequential, as they share
+	// their streams.
+	if (nbFiles > 1 && !anyStdio) {
+		// The warning behavior cache is built lazily; warm it up before it can be raced on
+		warnings.getWarningBehavior(WARNING_MBC);
+
+		std::vector<std::string> diagnostics(nbFiles);
+		std::vector<uint8_t> fileFailed(nbFiles, 0);
+		forEachParallel(nbFiles, 1, [&](size_t i) {
+			char *buf = nullptr;
+			size_t bufLen = 0;
+			FILE *output = open_memstream(&buf, &bufLen);
+			uint64_t nbErrors = 0;
+			setThreadDiagnostics(output, &nbErrors);
+			fileFailed[i] = fix_ProcessFile(argv[i], nullptr);
+			setThreadDiagnostics(nullptr, nullptr);
+			fclose(output);
+			diagnostics[i].assign(buf, bufLen);
+			free(buf);
+		});
+		for (size_t i = 0; i < nbFiles; ++i) {
+			fwrite(diagnostics[i].data(), 1, diagnostics[i].size(), stderr);
+			failed |= fileFailed[i] != 0;
+		}
+	} else
+#endif
+	{
+		do {
+			failed |= fix_ProcessFile(*argv, outputFilename);
+		} while (*++argv);
+	}
+
+	mem_ReportStats();
 
 	return failed;
 }
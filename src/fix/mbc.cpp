@@ -2,11 +2,11 @@
 
 #include "fix/mbc.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unordered_map>
-#include <utility>
 
 #include "helpers.hpp"  // unreachable_
 #include "platform.hpp" // strcasecmp
@@ -14,54 +14,76 @@
 
 #include "fix/warning.hpp"
 
-// Associate every MBC type with its name and whether it has RAM
-static std::unordered_map<MbcType, std::pair<char const *, bool>> mbcData{
-    {ROM,                                   {"ROM", false}                           },
-    {ROM_RAM,                               {"ROM+RAM", true}                        },
-    {ROM_RAM_BATTERY,                       {"ROM+RAM+BATTERY", true}                },
-    {MBC1,                                  {"MBC1", false}                          },
-    {MBC1_RAM,                              {"MBC1+RAM", true}                       },
-    {MBC1_RAM_BATTERY,                      {"MBC1+RAM+BATTERY", true}               },
+// Associate every MBC type with its name and whether it has RAM; sorted by ID for binary search
+struct MbcData {
+	MbcType type;
+	char const *name;
+	bool hasRam;
+};
+static constexpr MbcData mbcData[] = {
+    {ROM,                                   "ROM",                             false},
+    {MBC1,                                  "MBC1",                            false},
+    {MBC1_RAM,                              "MBC1+RAM",                        true },
+    {MBC1_RAM_BATTERY,                      "MBC1+RAM+BATTERY",                true },
     // MBC2 technically has RAM, but is not marked as such
-    {MBC2,                                  {"MBC2", false}                          },
-    {MBC2_BATTERY,                          {"MBC2+BATTERY", false}                  },
-    {MMM01,                                 {"MMM01", false}                         },
-    {MMM01_RAM,                             {"MMM01+RAM", true}                      },
-    {MMM01_RAM_BATTERY,                     {"MMM01+RAM+BATTERY", true}              },
-    {MBC3,                                  {"MBC3", false}                          },
-    {MBC3_TIMER_BATTERY,                    {"MBC3+TIMER+BATTERY", false}            },
-    {MBC3_TIMER_RAM_BATTERY,                {"MBC3+TIMER+RAM+BATTERY", true}         },
-    {MBC3_RAM,                              {"MBC3+RAM", true}                       },
-    {MBC3_RAM_BATTERY,                      {"MBC3+RAM+BATTERY", true}               },
-    {MBC5,                                  {"MBC5", false}                          },
-    {MBC5_RAM,                              {"MBC5+RAM", true}                       },
-    {MBC5_RAM_BATTERY,                      {"MBC5+RAM+BATTERY", true}               },
-    {MBC5_RUMBLE,                           {"MBC5+RUMBLE", false}                   },
-    {MBC5_RUMBLE_RAM,                       {"MBC5+RUMBLE+RAM", true}                },
-    {MBC5_RUMBLE_RAM_BATTERY,               {"MBC5+RUMBLE+RAM+BATTERY", true}        },
+    {MBC2,                                  "MBC2",                            false},
+    {MBC2_BATTERY,                          "MBC2+BATTERY",                    false},
+    {ROM_RAM,                               "ROM+RAM",                         true },
+    {ROM_RAM_BATTERY,                       "ROM+RAM+BATTERY",                 true },
+    {MMM01,                                 "MMM01",                           false},
+    {MMM01_RAM,                             "MMM01+RAM",                       true },
+    {MMM01_RAM_BATTERY,                     "MMM01+RAM+BATTERY",               true },
+    {MBC3_TIMER_BATTERY,                    "MBC3+TIMER+BATTERY",              false},
+    {MBC3_TIMER_RAM_BATTERY,                "MBC3+TIMER+RAM+BATTERY",          true },
+    {MBC3,                                  "MBC3",                            false},
+    {MBC3_RAM,                              "MBC3+RAM",                        true },
+    {MBC3_RAM_BATTERY,                      "MBC3+RAM+BATTERY",                true },
+    {MBC5,                                  "MBC5",                            false},
+    {MBC5_RAM,                              "MBC5+RAM",                        true },
+    {MBC5_RAM_BATTERY,                      "MBC5+RAM+BATTERY",                true },
+    {MBC5_RUMBLE,                           "MBC5+RUMBLE",                     false},
+    {MBC5_RUMBLE_RAM,                       "MBC5+RUMBLE+RAM",                 true },
+    {MBC5_RUMBLE_RAM_BATTERY,               "MBC5+RUMBLE+RAM+BATTERY",         true },
     // MBC6 "Net de Get - Minigame @ 100" has RAM size 3 (32 KiB)
-    {MBC6,                                  {"MBC6", true}                           },
-    {MBC7_SENSOR_RUMBLE_RAM_BATTERY,        {"MBC7+SENSOR+RUMBLE+RAM+BATTERY", true} },
-    {POCKET_CAMERA,                         {"POCKET CAMERA", true}                  },
+    {MBC6,                                  "MBC6",                            true },
+    {MBC7_SENSOR_RUMBLE_RAM_BATTERY,        "MBC7+SENSOR+RUMBLE+RAM+BATTERY",  true },
+    {POCKET_CAMERA,                         "POCKET CAMERA",                   true },
     // Bandai TAMA5 "Game de Hakken!! Tamagotchi - Osutchi to Mesutchi" has RAM size 0
-    {BANDAI_TAMA5,                          {"BANDAI TAMA5", false}                  },
-    {HUC3,                                  {"HUC3", true}                           },
-    {HUC1_RAM_BATTERY,                      {"HUC1+RAM+BATTERY", true}               },
+    {BANDAI_TAMA5,                          "BANDAI TAMA5",                    false},
+    {HUC3,                                  "HUC3",                            true },
+    {HUC1_RAM_BATTERY,                      "HUC1+RAM+BATTERY",                true },
     // TPP1 may or may not have RAM, don't use these flags for it
-    {TPP1,                                  {"TPP1", false}                          },
-    {TPP1_RUMBLE,                           {"TPP1+RUMBLE", false}                   },
-    {TPP1_MULTIRUMBLE_RUMBLE,               {"TPP1+MULTIRUMBLE", false}              },
-    {TPP1_TIMER,                            {"TPP1+TIMER", false}                    },
-    {TPP1_TIMER_RUMBLE,                     {"TPP1+TIMER+RUMBLE", false}             },
-    {TPP1_TIMER_MULTIRUMBLE_RUMBLE,         {"TPP1+TIMER+MULTIRUMBLE", false}        },
-    {TPP1_BATTERY,                          {"TPP1+BATTERY", false}                  },
-    {TPP1_BATTERY_RUMBLE,                   {"TPP1+BATTERY+RUMBLE", false}           },
-    {TPP1_BATTERY_MULTIRUMBLE_RUMBLE,       {"TPP1+BATTERY+MULTIRUMBLE", false}      },
-    {TPP1_BATTERY_TIMER,                    {"TPP1+BATTERY+TIMER", false}            },
-    {TPP1_BATTERY_TIMER_RUMBLE,             {"TPP1+BATTERY+TIMER+RUMBLE", false}     },
-    {TPP1_BATTERY_TIMER_MULTIRUMBLE_RUMBLE, {"TPP1+BATTERY+TIMER+MULTIRUMBLE", false}},
+    {TPP1,                                  "TPP1",                            false},
+    {TPP1_RUMBLE,                           "TPP1+RUMBLE",                     false},
+    {TPP1_MULTIRUMBLE_RUMBLE,               "TPP1+MULTIRUMBLE",                false},
+    {TPP1_TIMER,                            "TPP1+TIMER",                      false},
+    {TPP1_TIMER_RUMBLE,                     "TPP1+TIMER+RUMBLE",               false},
+    {TPP1_TIMER_MULTIRUMBLE_RUMBLE,         "TPP1+TIMER+MULTIRUMBLE",          false},
+    {TPP1_BATTERY,                          "TPP1+BATTERY",                    false},
+    {TPP1_BATTERY_RUMBLE,                   "TPP1+BATTERY+RUMBLE",             false},
+    {TPP1_BATTERY_MULTIRUMBLE_RUMBLE,       "TPP1+BATTERY+MULTIRUMBLE",        false},
+    {TPP1_BATTERY_TIMER,                    "TPP1+BATTERY+TIMER",              false},
+    {TPP1_BATTERY_TIMER_RUMBLE,             "TPP1+BATTERY+TIMER+RUMBLE",       false},
+    {TPP1_BATTERY_TIMER_MULTIRUMBLE_RUMBLE, "TPP1+BATTERY+TIMER+MULTIRUMBLE",  false},
 };
 
+static constexpr bool isSortedByType() {
+	for (size_t i = 1; i < std::size(mbcData); ++i) {
+		if (mbcData[i - 1].type >= mbcData[i].type) {
+			return false;
+		}
+	}
+	return true;
+}
+static_assert(isSortedByType(), "MBC data must be sorted by type ID");
+
+static MbcData const *findMbcData(MbcType type) {
+	auto search = std::lower_bound(RANGE(mbcData), type, [](MbcData const &data, MbcType value) {
+		return data.type < value;
+	});
+	return search != std::end(mbcData) && search->type == type ? search : nullptr;
+}
+
 static char const *acceptedMBCNames =
     "Accepted MBC names:\n"
     "\tROM ($00) [aka ROM_ONLY]\n"
@@ -87,13 +109,13 @@ static char const *acceptedMBCNames =
     "\tTPP1_1.0+BATTERY+TIMER+MULTIRUMBLE"; // No trailing newline
 
 char const *mbc_Name(MbcType type) {
-	auto search = mbcData.find(type);
-	return search != mbcData.end() ? search->second.first : "(unknown)";
+	MbcData const *data = findMbcData(type);
+	return data ? data->name : "(unknown)";
 }
 
 bool mbc_HasRAM(MbcType type) {
-	auto search = mbcData.find(type);
-	return search != mbcData.end() && search->second.second;
+	MbcData const *data = findMbcData(type);
+	return data && data->hasRam;
 }
 
 static void skipBlankSpace(char const *&ptr) {
@@ -117,16 +139,68 @@ static char normalizeMBCChar(char c) {
 	return c;
 }
 
-static bool readMBCSlice(char const *&name, char const *expected) {
-	while (*expected) {
-		// If `name` is too short, the character will be '\0' and this will return `false`
-		if (normalizeMBCChar(*name++) != *expected++) {
+// Tries to match `expected` at `ptr`, advancing it past the match on success, and leaving it
+// untouched on failure. The comparison is case-insensitive and treats underscores as spaces;
+// an asterisk in `expected` matches any (possibly empty) run of blank space and underscores.
+static bool matchMBCToken(char const *&ptr, char const *expected) {
+	char const *name = ptr;
+	for (; *expected; ++expected) {
+		if (*expected == '*') {
+			skipMBCSpace(name);
+		} else if (normalizeMBCChar(*name++) != *expected) {
+			// If `name` is too short, the character will be '\0' and this will not match
 			return false;
 		}
 	}
+	ptr = name;
 	return true;
 }
 
+// The recognized MBC names; the first match wins, so names sharing a prefix are ordered
+// longest first
+static constexpr struct {
+	char const *pattern;
+	uint16_t mbc;
+} mbcNames[] = {
+    {"ROM*ONLY",      ROM                           },
+    {"ROM",           ROM                           },
+    {"MBC1",          MBC1                          },
+    {"MBC2",          MBC2                          },
+    {"MBC3",          MBC3                          },
+    {"MBC5",          MBC5                          },
+    {"MBC6",          MBC6                          },
+    {"MBC7",          MBC7_SENSOR_RUMBLE_RAM_BATTERY},
+    {"MMM01",         MMM01                         },
+    {"POCKET CAMERA", POCKET_CAMERA                 },
+    {"BANDAI TAMA5",  BANDAI_TAMA5                  },
+    {"TAMA5",         BANDAI_TAMA5                  },
+    {"TPP1",          TPP1                          },
+    {"HUC1",          HUC1_RAM_BATTERY              },
+    {"HUC3",          HUC3                          },
+};
+
+// "Additional feature" flags, which refine the base MBC type once parsing is done
+// clang-format off: vertically align values
+static constexpr uint8_t RAM         = 1 << 7;
+static constexpr uint8_t BATTERY     = 1 << 6;
+static constexpr uint8_t TIMER       = 1 << 5;
+static constexpr uint8_t RUMBLE      = 1 << 4;
+static constexpr uint8_t SENSOR      = 1 << 3;
+static constexpr uint8_t MULTIRUMBLE = 1 << 2;
+// clang-format on
+
+static constexpr struct {
+	char const *pattern;
+	uint8_t flag;
+} mbcFeatures[] = {
+    {"BATTERY",     BATTERY    },
+    {"MULTIRUMBLE", MULTIRUMBLE},
+    {"RAM",         RAM        },
+    {"RUMBLE",      RUMBLE     },
+    {"SENSOR",      SENSOR     },
+    {"TIMER",       TIMER      },
+};
+
 [[noreturn]]
 static void fatalUnknownMBC(char const *fullName) {
 	fatal("Unknown MBC \"%s\"\n%s", fullName, acceptedMBCNames);
@@ -166,159 +240,53 @@ MbcType mbc_ParseName(char const *name, uint8_t &tpp1Major, uint8_t &tpp1Minor)
 	}
 
 	// Begin by reading the MBC type:
-	uint16_t mbc;
+	uint16_t mbc = UNSPECIFIED;
 	char const *ptr = name;
 
 	skipBlankSpace(ptr); // Trim off leading blank space
 
-#define tryReadSlice(expected) \
-	do { \
-		if (!readMBCSlice(ptr, expected)) { \
-			fatalUnknownMBC(fullName); \
-		} \
-	} while (0)
-
-	switch (*ptr++) {
-	case 'R': // ROM / ROM_ONLY
-	case 'r':
-		tryReadSlice("OM");
-		// Handle optional " ONLY"
-		skipMBCSpace(ptr);
-		if (*ptr == 'O' || *ptr == 'o') {
-			++ptr;
-			tryReadSlice("NLY");
-		}
-		mbc = ROM;
-		break;
-
-	case 'M': // MBC{1, 2, 3, 5, 6, 7} / MMM01
-	case 'm':
-		switch (*ptr++) {
-		case 'B':
-		case 'b':
-			switch (*ptr++) {
-			case 'C':
-			case 'c':
-				break;
-			default:
-				fatalUnknownMBC(fullName);
-			}
-			switch (*ptr++) {
-			case '1':
-				mbc = MBC1;
-				break;
-			case '2':
-				mbc = MBC2;
-				break;
-			case '3':
-				mbc = MBC3;
-				break;
-			case '5':
-				mbc = MBC5;
-				break;
-			case '6':
-				mbc = MBC6;
-				break;
-			case '7':
-				mbc = MBC7_SENSOR_RUMBLE_RAM_BATTERY;
-				break;
-			default:
-				fatalUnknownMBC(fullName);
-			}
+	for (auto const &candidate : mbcNames) {
+		if (matchMBCToken(ptr, candidate.pattern)) {
+			mbc = candidate.mbc;
 			break;
-		case 'M':
-		case 'm':
-			tryReadSlice("M01");
-			mbc = MMM01;
-			break;
-		default:
-			fatalUnknownMBC(fullName);
 		}
-		break;
-
-	case 'P': // POCKET_CAMERA
-	case 'p':
-		tryReadSlice("OCKET CAMERA");
-		mbc = POCKET_CAMERA;
-		break;
+	}
+	if (mbc == UNSPECIFIED) {
+		fatalUnknownMBC(fullName);
+	}
 
-	case 'B': // BANDAI_TAMA5
-	case 'b':
-		tryReadSlice("ANDAI TAMA5");
-		mbc = BANDAI_TAMA5;
-		break;
+	if (mbc == TPP1) {
+		// Parse version
+		skipMBCSpace(ptr);
+		// Major
+		char *endptr;
+		unsigned long val = strtoul(ptr, &endptr, 10);
 
-	case 'T': // TAMA5 / TPP1
-	case 't':
-		switch (*ptr++) {
-		case 'A':
-			tryReadSlice("MA5");
-			mbc = BANDAI_TAMA5;
-			break;
-		case 'P': {
-			tryReadSlice("P1");
-			// Parse version
-			skipMBCSpace(ptr);
-			// Major
-			char *endptr;
-			unsigned long val = strtoul(ptr, &endptr, 10);
-
-			if (endptr == ptr) {
-				fatal("Failed to parse TPP1 major revision number");
-			}
-			ptr = endptr;
-			if (val != 1) {
-				fatal("RGBFIX only supports TPP1 version 1.0");
-			}
-			tpp1Major = val;
-			tryReadSlice(".");
-			// Minor
-			val = strtoul(ptr, &endptr, 10);
-			if (endptr == ptr) {
-				fatal("Failed to parse TPP1 minor revision number");
-			}
-			ptr = endptr;
-			if (val > 0xFF) {
-				fatal("TPP1 minor revision number must be 8-bit");
-			}
-			tpp1Minor = val;
-			mbc = TPP1;
-			break;
+		if (endptr == ptr) {
+			fatal("Failed to parse TPP1 major revision number");
 		}
-		default:
-			fatalUnknownMBC(fullName);
+		ptr = endptr;
+		if (val != 1) {
+			fatal("RGBFIX only supports TPP1 version 1.0");
 		}
-		break;
-
-	case 'H': // HuC{1, 3}
-	case 'h':
-		tryReadSlice("UC");
-		switch (*ptr++) {
-		case '1':
-			mbc = HUC1_RAM_BATTERY;
-			break;
-		case '3':
-			mbc = HUC3;
-			break;
-		default:
+		tpp1Major = val;
+		if (!matchMBCToken(ptr, ".")) {
 			fatalUnknownMBC(fullName);
 		}
-		break;
-
-	default:
-		fatalUnknownMBC(fullName);
+		// Minor
+		val = strtoul(ptr, &endptr, 10);
+		if (endptr == ptr) {
+			fatal("Failed to parse TPP1 minor revision number");
+		}
+		ptr = endptr;
+		if (val > 0xFF) {
+			fatal("TPP1 minor revision number must be 8-bit");
+		}
+		tpp1Minor = val;
 	}
 
 	// Read "additional features"
 	uint8_t features = 0;
-	// clang-format off: vertically align values
-	static constexpr uint8_t RAM         = 1 << 7;
-	static constexpr uint8_t BATTERY     = 1 << 6;
-	static constexpr uint8_t TIMER       = 1 << 5;
-	static constexpr uint8_t RUMBLE      = 1 << 4;
-	static constexpr uint8_t SENSOR      = 1 << 3;
-	static constexpr uint8_t MULTIRUMBLE = 1 << 2;
-	// clang-format on
 
 	for (;;) {
 		skipBlankSpace(ptr); // Trim off trailing blank space
@@ -334,54 +302,18 @@ MbcType mbc_ParseName(char const *name, uint8_t &tpp1Major, uint8_t &tpp1Minor)
 		}
 		skipMBCSpace(ptr);
 
-		switch (*ptr++) {
-		case 'B': // BATTERY
-		case 'b':
-			tryReadSlice("ATTERY");
-			features |= BATTERY;
-			break;
-
-		case 'M':
-		case 'm':
-			tryReadSlice("ULTIRUMBLE");
-			features |= MULTIRUMBLE;
-			break;
-
-		case 'R': // RAM or RUMBLE
-		case 'r':
-			switch (*ptr++) {
-			case 'U':
-			case 'u':
-				tryReadSlice("MBLE");
-				features |= RUMBLE;
+		uint8_t flag = 0;
+		for (auto const &feature : mbcFeatures) {
+			if (matchMBCToken(ptr, feature.pattern)) {
+				flag = feature.flag;
 				break;
-			case 'A':
-			case 'a':
-				tryReadSlice("M");
-				features |= RAM;
-				break;
-			default:
-				fatalUnknownMBC(fullName);
 			}
-			break;
-
-		case 'S': // SENSOR
-		case 's':
-			tryReadSlice("ENSOR");
-			features |= SENSOR;
-			break;
-
-		case 'T': // TIMER
-		case 't':
-			tryReadSlice("IMER");
-			features |= TIMER;
-			break;
-
-		default:
+		}
+		if (!flag) {
 			fatalUnknownMBC(fullName);
 		}
+		features |= flag;
 	}
-#undef tryReadSlice
 
 	switch (mbc) {
 	case ROM:
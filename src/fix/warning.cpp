@@ -11,6 +11,8 @@
 #include "diagnostics.hpp"
 #include "style.hpp"
 
+#include "fix/main.hpp"
+
 // clang-format off: nested initializers
 Diagnostics<WarningLevel, WarningID> warnings = {
     .metaWarnings = {
@@ -30,79 +32,102 @@ Diagnostics<WarningLevel, WarningID> warnings = {
 };
 // clang-format on
 
+// Worker threads fixing files in parallel buffer their diagnostics and count their errors
+// separately from the global state, so per-file output stays ordered
+static thread_local FILE *threadOutput = nullptr;
+static thread_local uint64_t *threadErrors = nullptr;
+
+void setThreadDiagnostics(FILE *output, uint64_t *nbErrors) {
+	threadOutput = output;
+	threadErrors = nbErrors;
+}
+
+static FILE *diagnosticsOutput() {
+	return threadOutput ? threadOutput : stderr;
+}
+
+uint64_t &threadNbErrors() {
+	return threadErrors ? *threadErrors : warnings.nbErrors;
+}
+
 uint32_t checkErrors(char const *filename) {
-	if (warnings.nbErrors > 0) {
-		style_Set(stderr, STYLE_RED, true);
+	uint64_t nbErrors = threadNbErrors();
+	if (nbErrors > 0) {
+		FILE *out = diagnosticsOutput();
+		style_Set(out, STYLE_RED, true);
 		fprintf(
-		    stderr,
-		    "Fixing \"%s\" failed with %" PRIu64 " error%s\n",
+		    out,
+			    "%s \"%s\" failed with %" PRIu64 " error%s\n",
+		    options.verify ? "Verifying" : "Fixing",
 		    filename,
-		    warnings.nbErrors,
-		    warnings.nbErrors == 1 ? "" : "s"
+		    nbErrors,
+		    nbErrors == 1 ? "" : "s"
 		);
-		style_Reset(stderr);
+		style_Reset(out);
 	}
-	return warnings.nbErrors;
+	return nbErrors;
 }
 
 void error(char const *fmt, ...) {
 	va_list ap;
-	style_Set(stderr, STYLE_RED, true);
-	fputs("error: ", stderr);
-	style_Reset(stderr);
+	StyleSink sink(diagnosticsOutput());
+	sink.set(STYLE_RED, true);
+	sink.append("error: ");
+	sink.reset();
 	va_start(ap, fmt);
-	vfprintf(stderr, fmt, ap);
+	sink.vprintf(fmt, ap);
 	va_end(ap);
-	putc('\n', stderr);
+	sink.append('\n');
+	sink.flush();
 
-	warnings.incrementErrors();
+	if (uint64_t &nbErrors = threadNbErrors(); nbErrors != UINT64_MAX) {
+		++nbErrors;
+	}
 }
 
 void fatal(char const *fmt, ...) {
 	va_list ap;
-	style_Set(stderr, STYLE_RED, true);
-	fputs("FATAL: ", stderr);
-	style_Reset(stderr);
+	StyleSink sink(stderr);
+	sink.set(STYLE_RED, true);
+	sink.append("FATAL: ");
+	sink.reset();
 	va_start(ap, fmt);
-	vfprintf(stderr, fmt, ap);
+	sink.vprintf(fmt, ap);
 	va_end(ap);
-	putc('\n', stderr);
+	sink.append('\n');
+	sink.flush();
 
 	exit(1);
 }
 
 void warning(WarningID id, char const *fmt, ...) {
+	// Check this first, so that disabled warnings cost nothing beyond this cached load;
+	// no formatting work happens for them
+	WarningBehavior behavior = warnings.getWarningBehavior(id);
+	if (behavior == WarningBehavior::DISABLED) {
+		return;
+	}
+
 	char const *flag = warnings.warningFlags[id].name;
+	bool isError = behavior == WarningBehavior::ERROR;
+	StyleColor color = isError ? STYLE_RED : STYLE_YELLOW;
 	va_list ap;
 
-	switch (warnings.getWarningBehavior(id)) {
-	case WarningBehavior::DISABLED:
-		break;
-
-	case WarningBehavior::ENABLED:
-		style_Set(stderr, STYLE_YELLOW, true);
-		fputs("warning: ", stderr);
-		style_Reset(stderr);
-		va_start(ap, fmt);
-		vfprintf(stderr, fmt, ap);
-		va_end(ap);
-		style_Set(stderr, STYLE_YELLOW, true);
-		fprintf(stderr, " [-W%s]\n", flag);
-		style_Reset(stderr);
-		break;
-
-	case WarningBehavior::ERROR:
-		style_Set(stderr, STYLE_RED, true);
-		fputs("error: ", stderr);
-		style_Reset(stderr);
-		va_start(ap, fmt);
-		vfprintf(stderr, fmt, ap);
-		va_end(ap);
-		style_Set(stderr, STYLE_RED, true);
-		fprintf(stderr, " [-Werror=%s]\n", flag);
-		style_Reset(stderr);
-
-		warnings.incrementErrors();
-		break;
+	StyleSink sink(diagnosticsOutput());
+	sink.set(color, true);
+	sink.printf("%s: ", isError ? "error" : "warning");
+	sink.reset();
+	va_start(ap, fmt);
+	sink.vprintf(fmt, ap);
+	va_end(ap);
+	sink.set(color, true);
+	sink.printf(isError ? " [-Werror=%s]\n" : " [-W%s]\n", flag);
+	sink.reset();
+	sink.flush();
+
+	if (isError) {
+		if (uint64_t &nbErrors = threadNbErrors(); nbErrors != UINT64_MAX) {
+			++nbErrors;
+		}
 	}
 }
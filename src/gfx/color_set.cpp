@@ -46,23 +46,20 @@ ColorSet::ComparisonResult ColorSet::compare(ColorSet const &other) const {
 	assume(std::is_sorted(RANGE(_colorIndices)));
 	assume(std::is_sorted(RANGE(other._colorIndices)));
 
-	auto ours = _colorIndices.begin(), theirs = other._colorIndices.begin();
-	bool weBigger = true, theyBigger = true;
+	// Identical sets are by far the most common case, and decide in a single word comparison
+	if (word() == other.word()) {
+		return THEY_BIGGER;
+	}
 
-	while (ours != end() && theirs != other.end()) {
-		if (*ours == *theirs) {
-			++ours;
-			++theirs;
-		} else if (*ours < *theirs) {
-			++ours;
-			theyBigger = false;
-		} else { // *ours > *theirs
-			++theirs;
-			weBigger = false;
-		}
+	// The sets differ, so at most one of them can contain the other; each `contains` is a
+	// single-word test, so this beats merging the two sorted arrays element-wise
+	bool weBigger = true, theyBigger = true;
+	for (uint16_t color : other) {
+		weBigger &= contains(color);
+	}
+	for (uint16_t color : *this) {
+		theyBigger &= other.contains(color);
 	}
-	weBigger &= theirs == other.end();
-	theyBigger &= ours == end();
 
 	return theyBigger ? THEY_BIGGER : (weBigger ? WE_BIGGER : NEITHER);
 }
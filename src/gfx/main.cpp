@@ -3,22 +3,26 @@
 #include "gfx/main.hpp"
 
 #include <algorithm>
+#include <condition_variable>
 #include <ctype.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <ios>
+#include <mutex>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include "diagnostics.hpp"
 #include "extern/getopt.hpp"
 #include "file.hpp"
 #include "helpers.hpp"
+#include "memstats.hpp"
 #include "platform.hpp"
 #include "style.hpp"
 #include "usage.hpp"
@@ -38,6 +42,7 @@ Options options;
 
 static struct LocalOptions {
 	char const *externalPalSpec;
+	char const *batchManifest;
 	bool autoAttrmap;
 	bool autoTilemap;
 	bool autoPalettes;
@@ -50,7 +55,7 @@ static struct LocalOptions {
 static char const *optstring = "-Aa:B:b:Cc:d:hi:L:l:mN:n:Oo:Pp:Qq:r:s:Tt:U:uVvW:wXx:YZ";
 
 // Variables for the long-only options
-static int longOpt; // `--color`
+static int longOpt; // `--color`, `--batch`, `--shared-tileset`, `--container`
 
 // Equivalent long options
 // Please keep in the same order as short opts.
@@ -94,6 +99,10 @@ static option const longopts[] = {
     {"mirror-y",         no_argument,       nullptr,  'Y'},
     {"columns",          no_argument,       nullptr,  'Z'},
     {"color",            required_argument, &longOpt, 'c'},
+    {"batch",            required_argument, &longOpt, 'b'},
+    {"mem-stats",        no_argument,       &longOpt, 'm'},
+    {"shared-tileset",   required_argument, &longOpt, 's'},
+    {"container",        required_argument, &longOpt, 'C'},
     {nullptr,            no_argument,       nullptr,  0  },
 };
 
@@ -559,6 +568,7 @@ static char *parseArgv(int argc, char *argv[]) {
 
 		case 'w':
 			warnings.state.warningsEnabled = false;
+			warnings.flushWarningCache();
 			break;
 
 		case 'x':
@@ -585,6 +595,20 @@ static char *parseArgv(int argc, char *argv[]) {
 		case 0: // Long-only options
 			if (longOpt == 'c' && !style_Parse(musl_optarg)) {
 				fatal("Invalid argument for option '--color'");
+			} else if (longOpt == 'b') {
+				localOptions.batchManifest = musl_optarg;
+			} else if (longOpt == 'm') {
+				mem_EnableStats();
+			} else if (longOpt == 's') {
+				if (!options.sharedTileset.empty()) {
+					warnx("Overriding shared tileset file \"%s\"", options.sharedTileset.c_str());
+				}
+				options.sharedTileset = musl_optarg;
+			} else if (longOpt == 'C') {
+				if (!options.container.empty()) {
+					warnx("Overriding container file \"%s\"", options.container.c_str());
+				}
+				options.container = musl_optarg;
 			}
 			break;
 
@@ -726,6 +750,10 @@ static void verboseOutputConfig() {
 	printPath("Input image", options.input);
 	// -i/--input-tileset
 	printPath("Input tileset", options.inputTileset);
+	// --shared-tileset
+	printPath("Shared tileset", options.sharedTileset);
+	// --container
+	printPath("Output container", options.container);
 	// -o/--output
 	printPath("Output tile data", options.output);
 	// -t/--tilemap or -T/--auto-tilemap
@@ -769,7 +797,12 @@ static void replaceExtension(std::string &path, char const *extension) {
 	path.append(extension);
 }
 
-int main(int argc, char *argv[]) {
+// The at-files' arg pools must outlive parsing: `localOptions` keeps pointers into them
+// (e.g. the deferred external palette spec) until the conversion actually runs.
+static std::vector<std::vector<char>> argPools;
+
+// Parses a whole arg vector, including any at-files it refers to.
+static void parseAllArgv(int argc, char *argv[]) {
 	struct AtFileStackEntry {
 		int parentInd;            // Saved offset into parent argv
 		std::vector<char *> argv; // This context's arg pointer vec
@@ -782,7 +815,6 @@ int main(int argc, char *argv[]) {
 	// Parse CLI options
 	int curArgc = argc;
 	char **curArgv = argv;
-	std::vector<std::vector<char>> argPools;
 	for (;;) {
 		char *atFileName = parseArgv(curArgc, curArgv);
 		if (atFileName) {
@@ -834,7 +866,11 @@ int main(int argc, char *argv[]) {
 			curArgv = vec.data();
 		}
 	}
+}
 
+// Runs one conversion with the current `options`, also performing the checks and path
+// defaulting that must wait until option parsing is over.
+static void executeConversion() {
 	if (options.nbColorsPerPal == 0) {
 		options.nbColorsPerPal = 1u << options.bitDepth;
 	} else if (options.nbColorsPerPal > 1u << options.bitDepth) {
@@ -846,6 +882,17 @@ int main(int argc, char *argv[]) {
 		);
 	}
 
+	// The shared tileset takes the input tileset's place during deduplication, so specifying
+	// both would be ambiguous.
+	if (!options.sharedTileset.empty() && !options.inputTileset.empty()) {
+		error("Options '--shared-tileset' and '-i' are incompatible");
+	}
+
+	// The container gathers conversion outputs, which reverse mode does not produce.
+	if (!options.container.empty() && localOptions.reverse) {
+		error("Option '--container' is incompatible with reverse mode ('-r')");
+	}
+
 	auto autoOutPath = [](bool autoOptEnabled, std::string &path, char const *extension) {
 		if (!autoOptEnabled) {
 			return;
@@ -888,6 +935,158 @@ int main(int argc, char *argv[]) {
 	}
 
 	requireZeroErrors();
+}
+
+// Reads a batch manifest; each non-blank, non-comment line lists one conversion's
+// arguments, using the same syntax as an at-file line.
+static std::vector<std::vector<std::string>> readManifest(std::string const &path) {
+	File file;
+	if (!file.open(path, std::ios_base::in)) {
+		fatal("Error reading batch manifest \"%s\": %s", file.c_str(path), strerror(errno));
+	}
+
+	std::vector<std::vector<std::string>> jobs;
+	for (;;) {
+		int c = file->sbumpc();
+
+		// First, discard any leading blank space
+		while (isBlankSpace(c)) {
+			c = file->sbumpc();
+		}
+
+		// If it's a comment, discard everything until EOL
+		if (c == '#') {
+			c = file->sbumpc();
+			while (c != EOF && !isNewline(c)) {
+				c = file->sbumpc();
+			}
+		}
+
+		if (c == EOF) {
+			return jobs;
+		} else if (isNewline(c)) {
+			continue; // Start processing the next line
+		}
+
+		std::vector<std::string> &job = jobs.emplace_back();
+		do {
+			std::string &arg = job.emplace_back();
+
+			// Read one argument (until the next whitespace char).
+			// We know there is one because we already have its first character in `c`.
+			for (; c != EOF && !isWhitespace(c); c = file->sbumpc()) {
+				arg.push_back(c);
+			}
+
+			// Discard blank space until the next argument (candidate)
+			while (isBlankSpace(c)) {
+				c = file->sbumpc();
+			}
+		} while (c != EOF && !isNewline(c)); // End if we reached EOL
+	}
+}
+
+// Runs every conversion listed in the manifest within this one process, which amortizes
+// process startup across the whole batch; the command line's own options serve as each
+// job's defaults.
+static void runBatch(char *argv0) {
+	if (!options.input.empty()) {
+		fatal("Option '--batch' is incompatible with an input image on the command line");
+	}
+
+	std::vector<std::vector<std::string>> jobs = readManifest(localOptions.batchManifest);
+
+	// A conversion is CPU-bound once its input bytes are cached, so a reader thread warms
+	// the page cache for upcoming jobs' files while the current job converts; on slow
+	// (e.g. network) storage, that overlaps nearly all of the read latency with compute.
+	// Conversions themselves still run one at a time, since they all share the global
+	// options and warning state. The look-ahead is bounded, so at most `prefetchWindow`
+	// jobs' files are pulled into the cache ahead of their use.
+	constexpr size_t prefetchWindow = 4;
+	std::mutex prefetchMutex;
+	std::condition_variable prefetchWake;
+	size_t nbJobsDone = 0;
+	bool abandonPrefetch = false;
+
+	// The reader works on its own copies of the paths, so it never touches a line the main
+	// loop may be parsing. Any argument that does not look like an option is a candidate;
+	// reading a file that turns out to be an about-to-be-overwritten output is harmless.
+	std::vector<std::vector<std::string>> prefetchPaths(jobs.size());
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		for (std::string const &arg : jobs[i]) {
+			if (!arg.empty() && arg[0] != '-') {
+				prefetchPaths[i].push_back(arg);
+			}
+		}
+	}
+	std::thread prefetcher([&] {
+		char buf[65536];
+		for (size_t i = 0; i < prefetchPaths.size(); ++i) {
+			{
+				std::unique_lock lock(prefetchMutex);
+				prefetchWake.wait(lock, [&] {
+					return abandonPrefetch || i < nbJobsDone + prefetchWindow;
+				});
+				if (abandonPrefetch) {
+					return;
+				}
+			}
+			for (std::string const &path : prefetchPaths[i]) {
+				if (FILE *file = fopen(path.c_str(), "rb"); file) {
+					while (fread(buf, 1, sizeof(buf), file) == sizeof(buf)) {}
+					fclose(file);
+				}
+			}
+		}
+	});
+	Defer stopPrefetcher{[&] {
+		{
+			std::lock_guard lock(prefetchMutex);
+			abandonPrefetch = true;
+		}
+		prefetchWake.notify_one();
+		prefetcher.join();
+	}};
+
+	Options const baseOptions = options;
+	LocalOptions const baseLocal = localOptions;
+	auto const baseWarnings = warnings;
+
+	for (std::vector<std::string> &job : jobs) {
+		options = baseOptions;
+		localOptions = baseLocal;
+		warnings = baseWarnings;
+
+		std::vector<char *> jobArgv;
+		jobArgv.reserve(job.size() + 2);
+		jobArgv.push_back(argv0); // Option parsing skips `argv[0]`
+		for (std::string &arg : job) {
+			jobArgv.push_back(arg.data());
+		}
+		jobArgv.push_back(nullptr);
+
+		musl_optind = 0; // Fully reset the option parser for the new arg vector
+		parseAllArgv(jobArgv.size() - 1, jobArgv.data());
+		executeConversion();
+
+		{
+			std::lock_guard lock(prefetchMutex);
+			++nbJobsDone;
+		}
+		prefetchWake.notify_one();
+	}
+}
+
+int main(int argc, char *argv[]) {
+	parseAllArgv(argc, argv);
+
+	if (localOptions.batchManifest) {
+		runBatch(argv[0]);
+	} else {
+		executeConversion();
+	}
+
+	mem_ReportStats();
 	return 0;
 }
 
@@ -910,6 +1109,22 @@ uint8_t Palette::indexOf(uint16_t color) const {
 	           : std::find(begin(), colors.end(), color) - begin() + options.hasTransparentPixels;
 }
 
+void Palette::indicesOf(uint16_t const *rowColors, uint8_t *indices) const {
+	uint8_t const firstSlot = options.hasTransparentPixels;
+	for (size_t i = 0; i < 8; ++i) {
+		uint16_t color = rowColors[i];
+		// The index is how many slots fail to match before the first one that does, which
+		// mirrors the `std::find` in `indexOf` without its early exit
+		uint8_t index = firstSlot;
+		bool missing = true;
+		for (uint8_t slot = firstSlot; slot < colors.size(); ++slot) {
+			missing = missing && color != colors[slot];
+			index += missing;
+		}
+		indices[i] = color == Rgba::transparent ? 0 : index;
+	}
+}
+
 auto Palette::begin() -> decltype(colors)::iterator {
 	// Skip the first slot if reserved for transparency
 	return colors.begin() + options.hasTransparentPixels;
@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "helpers.hpp"
+#include "parallel.hpp"
 #include "style.hpp"
 #include "verbosity.hpp"
 
@@ -216,8 +217,8 @@ public:
 			// How many of our color sets does this color also belong to?
 			uint32_t multiplicity =
 			    std::count_if(RANGE(*this), [this, &color](ColorSetAttrs const &attrs) {
-				    ColorSet const &pal = (*_colorSets)[attrs.colorSetIndex];
-				    return std::find(RANGE(pal), color) != pal.end();
+				    // Single-word membership test; this is the hottest loop in packing
+				    return (*_colorSets)[attrs.colorSetIndex].contains(color);
 			    });
 			// We increase the denominator by 1 here; the reference code does this,
 			// but the paper does not. Not adding 1 makes a multiplicity of 0 cause a division by 0
@@ -328,8 +329,12 @@ static void decant(std::vector<AssignedSets> &assignments, std::vector<ColorSet>
 			// Build up the "component"...
 			for (; ++iter != processed.end(); ++attrs) {
 				// If at least one color matches, add it
+				// (Probe the ≤4-color set against the hash set, not the other way around)
 				if (ColorSet const &colorSet = colorSets[attrs->colorSetIndex];
-				    std::find_first_of(RANGE(colors), RANGE(colorSet)) != colors.end()) {
+				    std::any_of(
+				        RANGE(colorSet),
+				        [&colors](uint16_t color) { return colors.contains(color); }
+				    )) {
 					colors.insert(RANGE(colorSet));
 					members.push_back(iter - processed.begin());
 					*iter = true; // Mark that color set as processed
@@ -386,6 +391,9 @@ std::pair<std::vector<size_t>, size_t> overloadAndRemove(std::vector<ColorSet> c
 
 	// Begin with no pages
 	std::vector<AssignedSets> assignments;
+	// Relative size of the current color set on each page; hoisted out of the loop so its
+	// allocation is reused across iterations
+	std::vector<uint32_t> relSizes;
 
 	// Begin with all color sets queued up for insertion
 	for (std::queue<ColorSetAttrs> queue(std::deque<ColorSetAttrs>(RANGE(sortedColorSetIDs)));
@@ -400,13 +408,21 @@ std::pair<std::vector<size_t>, size_t> overloadAndRemove(std::vector<ColorSet> c
 		// its actual size; so only overwrite the "not found" index on meeting that criterion
 		uint32_t bestRelSize = colorSet.size() * AssignedSets::scaleFactor;
 
+		// Scoring each candidate palette is read-only and independent, so it can spread over
+		// the thread pool once enough palettes have accumulated; picking the winner stays a
+		// sequential reduction below, so the heuristic's decisions are deterministic
+		relSizes.resize(assignments.size());
+		forEachParallel(assignments.size(), 2048, [&](size_t i) {
+			relSizes[i] = attrs.isBannedFrom(i) ? UINT32_MAX : assignments[i].relSizeOf(colorSet);
+		});
+
 		for (size_t i = 0; i < assignments.size(); ++i) {
 			// Skip the page if this one is banned from it
 			if (attrs.isBannedFrom(i)) {
 				continue;
 			}
 
-			uint32_t relSize = assignments[i].relSizeOf(colorSet);
+			uint32_t relSize = relSizes[i];
 			verbosePrint(
 			    VERB_TRACE,
 			    "  Relative size to palette %zu (of %zu): %" PRIu32 " (size = %zu)\n",
@@ -15,6 +15,9 @@
 #include <string.h>
 #include <string>
 #include <string_view>
+#include <sys/stat.h>
+#include <time.h>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -22,6 +25,7 @@
 #include "helpers.hpp"
 #include "platform.hpp"
 #include "util.hpp" // UpperMap, isDigit
+#include "verbosity.hpp"
 
 #include "gfx/main.hpp"
 #include "gfx/png.hpp"
@@ -194,31 +198,41 @@ static T readLE(U const *bytes) {
 	return val;
 }
 
-// Appends the first line read from `file` to the end of the provided `buffer`.
-// Returns true if a line was read.
-[[gnu::warn_unused_result]]
-static bool readLine(std::filebuf &file, std::string &buffer) {
-	assume(buffer.empty());
+// Reads the rest of `file` into a single buffer, so that lines can be tokenized in place
+// instead of being accumulated character by character
+static std::string slurpFile(std::filebuf &file) {
+	std::string contents;
+	char buf[65536];
 	for (;;) {
-		int c = file.sbumpc();
-		if (c == std::filebuf::traits_type::eof()) {
-			return !buffer.empty();
-		}
-		if (c == '\n') {
-			// Discard a trailing CRLF
-			if (!buffer.empty() && buffer.back() == '\r') {
-				buffer.pop_back();
-			}
-			return true;
+		size_t nbRead = file.sgetn(buf, sizeof(buf));
+		contents.append(buf, nbRead);
+		if (nbRead < sizeof(buf)) {
+			break;
 		}
+	}
+	return contents;
+}
 
-		buffer.push_back(c);
+// Extracts the first line of `rest` into `line` (without its newline, nor a trailing CR),
+// consuming it from `rest`. Returns true if a line was read.
+[[gnu::warn_unused_result]]
+static bool readLine(std::string_view &rest, std::string_view &line) {
+	if (rest.empty()) {
+		return false;
 	}
+	size_t end = rest.find('\n');
+	line = rest.substr(0, end);
+	rest.remove_prefix(end == rest.npos ? rest.length() : end + 1);
+	// Discard a trailing CRLF
+	if (line.ends_with('\r')) {
+		line.remove_suffix(1);
+	}
+	return true;
 }
 
-#define requireLine(kind, filename, file, buffer) \
+#define requireLine(kind, filename, rest, line) \
 	do { \
-		if (!readLine(file, buffer)) { \
+		if (!readLine(rest, line)) { \
 			error(kind " palette file \"%s\" is shorter than expected", filename); \
 			return; \
 		} \
@@ -237,9 +251,12 @@ static void warnExtraColors(
 	);
 }
 
+// `"%.*s"` arguments for printing a string_view, which lacks a terminator
+#define STR_FMT(str) static_cast<int>((str).length()), (str).data()
+
 // Parses the initial part of a string_view, advancing the "read index" as it does
 template<typename U> // Should be uint*_t
-static std::optional<U> parseDec(std::string const &str, size_t &n) {
+static std::optional<U> parseDec(std::string_view str, size_t &n) {
 	uintmax_t value = 0;
 	auto result = std::from_chars(str.data() + n, str.data() + str.length(), value);
 	if (static_cast<bool>(result.ec)) {
@@ -249,30 +266,30 @@ static std::optional<U> parseDec(std::string const &str, size_t &n) {
 	return std::optional<U>{value};
 }
 
-static std::optional<Rgba> parseColor(std::string const &str, size_t &n, uint16_t i) {
+static std::optional<Rgba> parseColor(std::string_view str, size_t &n, uint16_t i) {
 	std::optional<uint8_t> r = parseDec<uint8_t>(str, n);
 	if (!r) {
-		error("Failed to parse color #%d (\"%s\"): invalid red component", i + 1, str.c_str());
+		error("Failed to parse color #%d (\"%.*s\"): invalid red component", i + 1, STR_FMT(str));
 		return std::nullopt;
 	}
 	skipBlankSpace(str, n);
 	if (n == str.length()) {
-		error("Failed to parse color #%d (\"%s\"): missing green component", i + 1, str.c_str());
+		error("Failed to parse color #%d (\"%.*s\"): missing green component", i + 1, STR_FMT(str));
 		return std::nullopt;
 	}
 	std::optional<uint8_t> g = parseDec<uint8_t>(str, n);
 	if (!g) {
-		error("Failed to parse color #%d (\"%s\"): invalid green component", i + 1, str.c_str());
+		error("Failed to parse color #%d (\"%.*s\"): invalid green component", i + 1, STR_FMT(str));
 		return std::nullopt;
 	}
 	skipBlankSpace(str, n);
 	if (n == str.length()) {
-		error("Failed to parse color #%d (\"%s\"): missing blue component", i + 1, str.c_str());
+		error("Failed to parse color #%d (\"%.*s\"): missing blue component", i + 1, STR_FMT(str));
 		return std::nullopt;
 	}
 	std::optional<uint8_t> b = parseDec<uint8_t>(str, n);
 	if (!b) {
-		error("Failed to parse color #%d (\"%s\"): invalid blue component", i + 1, str.c_str());
+		error("Failed to parse color #%d (\"%.*s\"): invalid blue component", i + 1, STR_FMT(str));
 		return std::nullopt;
 	}
 
@@ -282,25 +299,24 @@ static std::optional<Rgba> parseColor(std::string const &str, size_t &n, uint16_
 static void parsePSPFile(char const *filename, std::filebuf &file) {
 	// https://www.selapa.net/swatches/colors/fileformats.php#psp_pal
 
-	std::string line;
-	if (!readLine(file, line) || line != "JASC-PAL") {
+	std::string const contents = slurpFile(file);
+	std::string_view rest = contents, line;
+	if (!readLine(rest, line) || line != "JASC-PAL") {
 		error("File \"%s\" is not a valid PSP palette file", filename);
 		return;
 	}
 
-	line.clear();
-	requireLine("PSP", filename, file, line);
+	requireLine("PSP", filename, rest, line);
 	if (line != "0100") {
-		error("Unsupported PSP palette file version \"%s\"", line.c_str());
+		error("Unsupported PSP palette file version \"%.*s\"", STR_FMT(line));
 		return;
 	}
 
-	line.clear();
-	requireLine("PSP", filename, file, line);
+	requireLine("PSP", filename, rest, line);
 	size_t n = 0;
 	std::optional<uint16_t> nbColors = parseDec<uint16_t>(line, n);
 	if (!nbColors || n != line.length()) {
-		error("Invalid \"number of colors\" line in PSP file (\"%s\")", line.c_str());
+		error("Invalid \"number of colors\" line in PSP file (\"%.*s\")", STR_FMT(line));
 		return;
 	}
 
@@ -312,8 +328,7 @@ static void parsePSPFile(char const *filename, std::filebuf &file) {
 	options.palSpec.clear();
 
 	for (uint16_t i = 0; i < *nbColors; ++i) {
-		line.clear();
-		requireLine("PSP", filename, file, line);
+		requireLine("PSP", filename, rest, line);
 
 		n = 0;
 		std::optional<Rgba> color = parseColor(line, n, i + 1);
@@ -322,9 +337,9 @@ static void parsePSPFile(char const *filename, std::filebuf &file) {
 		}
 		if (n != line.length()) {
 			error(
-			    "Failed to parse color #%d (\"%s\"): trailing characters after blue component",
+			    "Failed to parse color #%d (\"%.*s\"): trailing characters after blue component",
 			    i + 1,
-			    line.c_str()
+			    STR_FMT(line)
 			);
 			return;
 		}
@@ -339,8 +354,9 @@ static void parsePSPFile(char const *filename, std::filebuf &file) {
 static void parseGPLFile(char const *filename, std::filebuf &file) {
 	// https://gitlab.gnome.org/GNOME/gimp/-/blob/gimp-2-10/app/core/gimppalette-load.c#L39
 
-	std::string line;
-	if (!readLine(file, line) || !line.starts_with("GIMP Palette")) {
+	std::string const contents = slurpFile(file);
+	std::string_view rest = contents, line;
+	if (!readLine(rest, line) || !line.starts_with("GIMP Palette")) {
 		error("File \"%s\" is not a valid GPL palette file", filename);
 		return;
 	}
@@ -349,8 +365,7 @@ static void parseGPLFile(char const *filename, std::filebuf &file) {
 	uint16_t const maxNbColors = options.maxNbColors();
 
 	for (;;) {
-		line.clear();
-		if (!readLine(file, line)) {
+		if (!readLine(rest, line)) {
 			break;
 		}
 		if (line.starts_with("Name:") || line.starts_with("Columns:")) {
@@ -392,9 +407,10 @@ static void parseHEXFile(char const *filename, std::filebuf &file) {
 	uint16_t nbColors = 0;
 	uint16_t const maxNbColors = options.maxNbColors();
 
+	std::string const contents = slurpFile(file);
+	std::string_view rest = contents, line;
 	for (;;) {
-		std::string line;
-		if (!readLine(file, line)) {
+		if (!readLine(rest, line)) {
 			break;
 		}
 		// Ignore empty lines.
@@ -402,11 +418,11 @@ static void parseHEXFile(char const *filename, std::filebuf &file) {
 			continue;
 		}
 
-		if (line.length() != 6 || line.find_first_not_of(hexDigits) != std::string::npos) {
+		if (line.length() != 6 || line.find_first_not_of(hexDigits) != std::string_view::npos) {
 			error(
-			    "Failed to parse color #%d (\"%s\"): invalid \"rrggbb\" line",
+			    "Failed to parse color #%d (\"%.*s\"): invalid \"rrggbb\" line",
 			    nbColors + 1,
-			    line.c_str()
+			    STR_FMT(line)
 			);
 			return;
 		}
@@ -672,6 +688,33 @@ void parseExternalPalSpec(char const *arg) {
 		return;
 	}
 
+	// Palette files tend to be consulted over and over by later conversions in the same
+	// process (typically via `--batch`), so remember what each one parsed to. The mtime and
+	// size catch files modified in between, and the color counts affect how files are
+	// interpreted, so all of them are part of the key.
+	struct CachedPalSpec {
+		time_t mtime;
+		off_t size;
+		uint8_t nbColorsPerPal;
+		uint16_t nbPalettes;
+		std::vector<std::array<std::optional<Rgba>, 4>> palSpec;
+	};
+	static std::unordered_map<std::string, CachedPalSpec> palSpecCache;
+
+	struct stat statBuf;
+	bool canCache = stat(path, &statBuf) == 0;
+	if (canCache) {
+		if (auto cached = palSpecCache.find(arg);
+		    cached != palSpecCache.end() && cached->second.mtime == statBuf.st_mtime
+		    && cached->second.size == statBuf.st_size
+		    && cached->second.nbColorsPerPal == options.nbColorsPerPal
+		    && cached->second.nbPalettes == options.nbPalettes) {
+			verbosePrint(VERB_DEBUG, "Reusing already-parsed palette file \"%s\"\n", path);
+			options.palSpec = cached->second.palSpec;
+			return;
+		}
+	}
+
 	std::filebuf file;
 	// Some parsers read the file in text mode, others in binary mode
 	if (!file.open(path, search->second.second ? std::ios::in | std::ios::binary : std::ios::in)) {
@@ -679,7 +722,22 @@ void parseExternalPalSpec(char const *arg) {
 		return;
 	}
 
+	uint64_t const nbErrorsBefore = warnings.nbErrors;
 	search->second.first(path, file);
+
+	// Only cache specs that parsed cleanly; erroring ones should re-diagnose every time
+	if (canCache && warnings.nbErrors == nbErrorsBefore) {
+		palSpecCache.insert_or_assign(
+		    arg,
+		    CachedPalSpec{
+		        statBuf.st_mtime,
+		        statBuf.st_size,
+		        options.nbColorsPerPal,
+		        options.nbPalettes,
+		        options.palSpec,
+		    }
+		);
+	}
 }
 
 void parseDmgPalSpec(char const * const rawArg) {
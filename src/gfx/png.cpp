@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "diagnostics.hpp"
+#include "file.hpp"
 #include "helpers.hpp"
 #include "style.hpp"
 #include "verbosity.hpp"
@@ -22,50 +23,85 @@
 #include "gfx/rgba.hpp"
 #include "gfx/warning.hpp"
 
-struct Input {
+struct PngInput {
 	char const *filename;
-	std::streambuf &file;
+	std::streambuf *file = nullptr; // Streaming input (standard input, palette spec files)
+	MappedFile mapped;              // Keeps the contents alive while decoding otherwise
+	FileCursor cursor;
+
+	PngInput(char const *filename_, std::streambuf &file_) : filename(filename_), file(&file_) {}
+	explicit PngInput(std::string const &path) : filename(path.c_str()) {
+		if (!mapped.open(path)) {
+			fatal("Failed to open input image (\"%s\"): %s", filename, strerror(errno));
+		}
+		mapped.adviseSequential();
+		cursor = FileCursor(mapped);
+	}
 
-	Input(char const *filename_, std::streambuf &file_) : filename(filename_), file(file_) {}
+	// Reads up to `length` bytes, returning how many were read
+	size_t read(void *dest, size_t length) {
+		if (file) {
+			return file->sgetn(static_cast<char *>(dest), length);
+		}
+		size_t nbBytes = length < cursor.remaining() ? length : cursor.remaining();
+		(void)cursor.getData(dest, nbBytes); // Cannot fail, the length was just clamped
+		return nbBytes;
+	}
+
+	// How many bytes have been read so far
+	size_t tell() const {
+		return file ? static_cast<size_t>(file->pubseekoff(0, std::ios_base::cur))
+		            : cursor.tell();
+	}
 };
 
 [[noreturn]]
 static void handleError(png_structp png, char const *msg) {
-	Input const &input = *reinterpret_cast<Input *>(png_get_error_ptr(png));
+	PngInput const &input = *reinterpret_cast<PngInput *>(png_get_error_ptr(png));
 
 	fatal("Error reading PNG image (\"%s\"): %s", input.filename, msg);
 }
 
 static void handleWarning(png_structp png, char const *msg) {
-	Input const &input = *reinterpret_cast<Input *>(png_get_error_ptr(png));
+	PngInput const &input = *reinterpret_cast<PngInput *>(png_get_error_ptr(png));
 
 	warnx("In PNG image (\"%s\"): %s", input.filename, msg);
 }
 
 static void readData(png_structp png, png_bytep data, size_t length) {
-	Input &input = *reinterpret_cast<Input *>(png_get_io_ptr(png));
-	std::streamsize expectedLen = length;
-	std::streamsize nbBytesRead = input.file.sgetn(reinterpret_cast<char *>(data), expectedLen);
+	PngInput &input = *reinterpret_cast<PngInput *>(png_get_io_ptr(png));
+	size_t nbBytesRead = input.read(data, length);
 
-	if (nbBytesRead != expectedLen) {
+	if (nbBytesRead != length) {
 		fatal(
-		    "Error reading PNG image (\"%s\"): file too short (expected at least %zd more "
+		    "Error reading PNG image (\"%s\"): file too short (expected at least %zu more "
 		    "bytes after reading %zu)",
 		    input.filename,
 		    length - nbBytesRead,
-		    static_cast<size_t>(input.file.pubseekoff(0, std::ios_base::cur))
+		    input.tell()
 		);
 	}
 }
 
-Png::Png(char const *filename, std::streambuf &file) {
-	Input input(filename, file);
+static PngInput makeInput(std::string const &path) {
+	if (path != "-") {
+		return PngInput(path);
+	}
+	(void)setmode(STDIN_FILENO, O_BINARY);
+	return PngInput("<stdin>", *std::cin.rdbuf());
+}
+
+Png::Png(char const *filename, std::streambuf &file)
+    : Png(PngInput(filename, file), 0, UINT32_MAX, nullptr) {}
 
+Png::Png(std::string const &path, uint32_t firstRow, uint32_t lastRow, RowCallback rowCallback)
+    : Png(makeInput(path), firstRow, lastRow, std::move(rowCallback)) {}
+
+Png::Png(PngInput &&input, uint32_t firstRow, uint32_t lastRow, RowCallback rowCallback) {
 	verbosePrint(VERB_NOTICE, "Reading PNG file \"%s\"\n", input.filename);
 
 	std::array<unsigned char, 8> pngHeader;
-	if (input.file.sgetn(reinterpret_cast<char *>(pngHeader.data()), pngHeader.size())
-	        != static_cast<std::streamsize>(pngHeader.size()) // Not enough bytes?
+	if (input.read(pngHeader.data(), pngHeader.size()) != pngHeader.size() // Not enough bytes?
 	    || png_sig_cmp(pngHeader.data(), 0, pngHeader.size()) != 0) {
 		fatal("File \"%s\" is not a valid PNG image", input.filename); // LCOV_EXCL_LINE
 	}
@@ -207,23 +243,61 @@ Png::Png(char const *filename, std::streambuf &file) {
 	assume(png_get_color_type(png, info) == PNG_COLOR_TYPE_RGBA);
 	assume(png_get_bit_depth(png, info) == 8);
 
-	// Now that metadata has been read, we can read the image data
-	std::vector<png_byte> image(width * height * 4);
-	std::vector<png_bytep> rowPtrs(height);
-	for (uint32_t y = 0; y < height; ++y) {
-		rowPtrs[y] = image.data() + y * width * 4;
+	if (lastRow > height) {
+		lastRow = height;
+	}
+	if (firstRow > lastRow) {
+		firstRow = lastRow;
 	}
-	png_read_image(png, rowPtrs.data());
 
-	// We don't care about chunks after the image data (comments, etc.)
-	png_read_end(png, nullptr);
+	// Now that metadata has been read, we can read the image data
+	if (interlaceType == PNG_INTERLACE_NONE) {
+		// Rows before the requested range still have to be decompressed, since each row's
+		// filter depends on the previous one, but a null destination skips the transformations
+		// and the conversion below
+		for (uint32_t y = 0; y < firstRow; ++y) {
+			png_read_row(png, nullptr, nullptr);
+		}
+		// Decode one row at a time and convert it into `pixels` right away, so only a single
+		// row of RGBA8888 bytes is ever buffered on top of the `Rgba` image
+		std::vector<png_byte> row(static_cast<size_t>(width) * 4);
+		for (uint32_t y = firstRow; y < lastRow; ++y) {
+			png_read_row(png, row.data(), nullptr);
+			for (uint32_t x = 0; x < width; ++x) {
+				uint32_t off = x * 4;
+				pixels[y * width + x] = Rgba(row[off], row[off + 1], row[off + 2], row[off + 3]);
+			}
+			if (rowCallback) {
+				rowCallback(&pixels[y * width], width, y);
+			}
+		}
+		if (lastRow < height) {
+			// Rows past the range are not even decompressed; tearing down the read struct
+			// without reading the rest of the stream is fine, nothing else will read from it
+			return;
+		}
+	} else {
+		// Adam7 passes each touch rows all over the image, so interlaced PNGs have to be
+		// decoded into a full-size buffer first
+		std::vector<png_byte> image(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+		std::vector<png_bytep> rowPtrs(height);
+		for (uint32_t y = 0; y < height; ++y) {
+			rowPtrs[y] = image.data() + static_cast<size_t>(y) * width * 4;
+		}
+		png_read_image(png, rowPtrs.data());
 
-	// Finally, process the image data from RGBA8888 bytes into `Rgba` colors
-	for (uint32_t y = 0; y < height; ++y) {
-		for (uint32_t x = 0; x < width; ++x) {
-			uint32_t idx = y * width + x;
-			uint32_t off = idx * 4;
-			pixels[idx] = Rgba(image[off], image[off + 1], image[off + 2], image[off + 3]);
+		for (uint32_t y = 0; y < height; ++y) {
+			for (uint32_t x = 0; x < width; ++x) {
+				size_t idx = static_cast<size_t>(y) * width + x;
+				size_t off = idx * 4;
+				pixels[idx] = Rgba(image[off], image[off + 1], image[off + 2], image[off + 3]);
+			}
+			if (rowCallback && y >= firstRow && y < lastRow) {
+				rowCallback(&pixels[static_cast<size_t>(y) * width], width, y);
+			}
 		}
 	}
+
+	// We don't care about chunks after the image data (comments, etc.)
+	png_read_end(png, nullptr);
 }
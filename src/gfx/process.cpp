@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <array>
+#include <bitset>
 #include <errno.h>
 #include <inttypes.h>
 #include <ios>
@@ -14,6 +15,7 @@
 #include <string.h>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -27,6 +29,7 @@
 
 #include "gfx/color_set.hpp"
 #include "gfx/main.hpp"
+#include "parallel.hpp"
 #include "gfx/pal_packing.hpp"
 #include "gfx/pal_sorting.hpp"
 #include "gfx/png.hpp"
@@ -121,12 +124,56 @@ struct Image {
 	}
 
 	explicit Image(std::string const &path) {
-		File input;
-		if (input.open(path, std::ios_base::in | std::ios_base::binary) == nullptr) {
-			fatal("Failed to open input image (\"%s\"): %s", input.c_str(path), strerror(errno));
-		}
+		// One bit per CGB color: colors already reported as ambiguously transparent, and colors
+		// already reported as fused. Unlike hash sets keyed on the full RGBA values, these never
+		// allocate; the cost is that colors landing in an already-reported slot are not reported
+		// a second time.
+		std::bitset<NB_COLOR_SLOTS> ambiguous, fused;
+
+		// Validate and register each pixel as its row is decoded, while it is still cache-hot;
+		// this avoids a separate full pass over the image. With `-L`, rows outside the slice are
+		// never decoded, but the slice's rows are decoded whole, so colors to its left and right
+		// still register.
+		Png::RowCallback validateRow = [&](Rgba const *row, uint32_t width, uint32_t y) {
+			for (uint32_t x = 0; x < width; ++x) {
+				if (Rgba const &color = row[x]; color.isTransparent() == color.isOpaque()) {
+					// Report ambiguously transparent or opaque colors
+					if (uint16_t cgb = color.cgbColor(); !ambiguous[cgb]) {
+						error(
+						    "Color #%08x is neither transparent (alpha < %u) nor opaque (alpha >= "
+						    "%u) [first seen at x: %" PRIu32 ", y: %" PRIu32 "]",
+						    color.toCSS(),
+						    Rgba::transparency_threshold,
+						    Rgba::opacity_threshold,
+						    x,
+						    y
+						);
+						ambiguous.set(cgb); // Do not report this color again
+					}
+				} else if (Rgba const *other = colors.registerColor(color); other) {
+					// Report fused colors that reduce to the same RGB555 value
+					if (uint16_t cgb = color.cgbColor(); !fused[cgb]) {
+						warnx(
+						    "Fusing colors #%08x and #%08x into Game Boy color $%04x [first seen "
+						    "at x: %" PRIu32 ", y: %" PRIu32 "]",
+						    color.toCSS(),
+						    other->toCSS(),
+						    cgb,
+						    x,
+						    y
+						);
+						fused.set(cgb); // Do not report this fusion again
+					}
+				}
+			}
+		};
 
-		png = Png(input.c_str(path), *input);
+		// Decoding can stop at the bottom edge of the input slice, and rows above its top edge
+		// are decompressed but not stored; a slice out of a large "atlas" image thus only pays
+		// for the rows it covers
+		png = options.inputSlice.specified()
+		          ? Png(path, options.inputSlice.top, options.inputSlice.bottom(), validateRow)
+		          : Png(path, 0, UINT32_MAX, validateRow);
 
 		// Validate input slice
 		if (options.inputSlice.width == 0 && png.width % 8 != 0) {
@@ -159,53 +206,6 @@ struct Image {
 			}
 			giveUp();
 		}
-
-		// Holds colors whose alpha value is ambiguous to avoid erroring about them twice.
-		std::unordered_set<uint32_t> ambiguous;
-		// Holds fused color pairs to avoid warning about them twice.
-		// We don't need to worry about transitivity, as ImagePalette slots are immutable once
-		// assigned, and conflicts always occur between that and another color.
-		// For the same reason, we don't need to worry about order, either.
-		auto hashPair = [](std::pair<uint32_t, uint32_t> const &pair) {
-			return pair.first * 31 + pair.second;
-		};
-		std::unordered_set<std::pair<uint32_t, uint32_t>, decltype(hashPair)> fusions;
-
-		// Register colors from `png` into `colors`
-		for (uint32_t y = 0; y < png.height; ++y) {
-			for (uint32_t x = 0; x < png.width; ++x) {
-				if (Rgba const &color = pixel(x, y); color.isTransparent() == color.isOpaque()) {
-					// Report ambiguously transparent or opaque colors
-					if (uint32_t css = color.toCSS(); ambiguous.find(css) == ambiguous.end()) {
-						error(
-						    "Color #%08x is neither transparent (alpha < %u) nor opaque (alpha >= "
-						    "%u) [first seen at x: %" PRIu32 ", y: %" PRIu32 "]",
-						    css,
-						    Rgba::transparency_threshold,
-						    Rgba::opacity_threshold,
-						    x,
-						    y
-						);
-						ambiguous.insert(css); // Do not report this color again
-					}
-				} else if (Rgba const *other = colors.registerColor(color); other) {
-					// Report fused colors that reduce to the same RGB555 value
-					if (std::pair fused{color.toCSS(), other->toCSS()};
-					    fusions.find(fused) == fusions.end()) {
-						warnx(
-						    "Fusing colors #%08x and #%08x into Game Boy color $%04x [first seen "
-						    "at x: %" PRIu32 ", y: %" PRIu32 "]",
-						    fused.first,
-						    fused.second,
-						    color.cgbColor(),
-						    x,
-						    y
-						);
-						fusions.insert(fused); // Do not report this fusion again
-					}
-				}
-			}
-		}
 	}
 
 	class TilesVisitor {
@@ -229,6 +229,8 @@ struct Image {
 			Rgba pixel(uint32_t xOfs, uint32_t yOfs) const {
 				return _image.pixel(x + xOfs, y + yOfs);
 			}
+			// A tile row is contiguous in the image, so row-sized kernels can run on it directly
+			Rgba const *row(uint32_t yOfs) const { return &_image.pixel(x, y + yOfs); }
 		};
 
 	private:
@@ -294,23 +296,59 @@ public:
 	RawTile &newTile() { return _tiles.emplace_back(); }
 };
 
-struct AttrmapEntry {
-	// This field can either be a color set ID, or `transparent` to indicate that the
-	// corresponding tile is fully transparent. If you are looking to get the palette ID for this
+// Per-tile attributes, stored as one dense array per field ("structure of arrays"): each pass
+// below streams only the field(s) it needs, and the output loops, which compose one byte per
+// tile from byte-sized fields, vectorize
+struct Attrmap {
+	// Each element can either be a color set ID, or `transparent` to indicate that the
+	// corresponding tile is fully transparent. If you are looking to get the palette ID for an
 	// attrmap entry while correctly handling the above, use `getPalID`.
-	size_t colorSetID; // Only this field is used when outputting "unoptimized" data
-	uint8_t tileID;    // This is the ID as it will be output to the tilemap
-	bool bank;
-	bool yFlip;
-	bool xFlip;
+	std::vector<size_t> colorSetIDs; // Only this field is used when outputting "unoptimized" data
+	// The remaining fields are only filled in by `dedupTiles`, which sizes their arrays
+	std::vector<uint8_t> tileIDs; // These are the IDs as they will be output to the tilemap
+	std::vector<uint8_t> banks;
+	std::vector<uint8_t> yFlips;
+	std::vector<uint8_t> xFlips;
 
 	static constexpr size_t transparent = static_cast<size_t>(-1);
 	static constexpr size_t background = static_cast<size_t>(-2);
 
-	bool isBackgroundTile() const { return colorSetID == background; }
-	size_t getPalID(std::vector<size_t> const &mappings) const {
-		return mappings[isBackgroundTile() || colorSetID == transparent ? 0 : colorSetID];
+	size_t size() const { return colorSetIDs.size(); }
+	bool isBackgroundTile(size_t i) const { return colorSetIDs[i] == background; }
+	size_t getPalID(std::vector<size_t> const &mappings, size_t i) const {
+		size_t colorSetID = colorSetIDs[i];
+		return mappings[isBackgroundTile(i) || colorSetID == transparent ? 0 : colorSetID];
+	}
+};
+
+// A tile's distinct colors, collected into a fixed inline array so color collection never hits
+// the heap; an 8x8 tile bounds this at 64. Unlike `ColorSet`, this must be able to hold more
+// than 4 colors, since over-colorful tiles are only diagnosed after collection (with the exact
+// count). Kept sorted by the insertion, like `ColorSet::add`.
+struct TileColors {
+	std::array<uint16_t, 64> colors;
+	uint8_t nbColors = 0;
+
+	void add(uint16_t color) {
+		size_t i = 0;
+		while (i < nbColors && colors[i] < color) {
+			++i;
+		}
+		if (i < nbColors && colors[i] == color) {
+			return; // Already known
+		}
+		for (size_t j = nbColors; j > i; --j) {
+			colors[j] = colors[j - 1];
+		}
+		colors[i] = color;
+		++nbColors;
 	}
+
+	size_t size() const { return nbColors; }
+	bool empty() const { return nbColors == 0; }
+
+	auto begin() const { return colors.begin(); }
+	auto end() const { return colors.begin() + nbColors; }
 };
 
 static void generatePalSpec(Image const &image) {
@@ -444,6 +482,63 @@ static std::pair<std::vector<size_t>, std::vector<Palette>>
 	return {mappings, palettes};
 }
 
+// When `--container` is active, fully-serialized artifacts are gathered here instead of each
+// getting its own file; `writeContainer` then flushes them all in one go.
+static std::vector<std::pair<char const *, std::vector<uint8_t>>> containerSections;
+
+// Writes one fully-serialized artifact, either to its own file in a single call, or into the
+// pending container if one was requested.
+static void writeArtifact(char const *tag, std::string const &path, std::vector<uint8_t> &&data) {
+	if (!options.container.empty()) {
+		containerSections.emplace_back(tag, std::move(data));
+		return;
+	}
+
+	File output;
+	if (!output.open(path, std::ios_base::out | std::ios_base::binary)) {
+		// LCOV_EXCL_START
+		fatal("Failed to create \"%s\": %s", output.c_str(path), strerror(errno));
+		// LCOV_EXCL_STOP
+	}
+	output->sputn(reinterpret_cast<char const *>(data.data()), data.size());
+}
+
+// Flushes all gathered artifacts to the container file: an 8-byte magic number, then one section
+// per artifact (its 4-byte tag, the payload's length as a little-endian 32-bit number, then the
+// payload itself, which is identical to what the artifact's own file would contain), in the order
+// the artifacts were generated.
+static void writeContainer() {
+	assume(!options.container.empty());
+
+	size_t size = 8;
+	for (auto const &[tag, payload] : containerSections) {
+		size += 8 + payload.size();
+	}
+	std::vector<uint8_t> data;
+	data.reserve(size);
+
+	static char const magic[8] = {'R', 'G', 'B', 'G', 'F', 'X', '0', '\0'};
+	data.insert(data.end(), magic, magic + sizeof(magic));
+	for (auto const &[tag, payload] : containerSections) {
+		data.insert(data.end(), tag, tag + 4);
+		uint32_t const length = payload.size();
+		data.push_back(length & 0xFF);
+		data.push_back(length >> 8 & 0xFF);
+		data.push_back(length >> 16 & 0xFF);
+		data.push_back(length >> 24);
+		data.insert(data.end(), RANGE(payload));
+	}
+	containerSections.clear();
+
+	File output;
+	if (!output.open(options.container, std::ios_base::out | std::ios_base::binary)) {
+		// LCOV_EXCL_START
+		fatal("Failed to create \"%s\": %s", output.c_str(options.container), strerror(errno));
+		// LCOV_EXCL_STOP
+	}
+	output->sputn(reinterpret_cast<char const *>(data.data()), data.size());
+}
+
 static void outputPalettes(std::vector<Palette> const &palettes) {
 	// LCOV_EXCL_START
 	if (checkVerbosity(VERB_INFO)) {
@@ -470,32 +565,17 @@ static void outputPalettes(std::vector<Palette> const &palettes) {
 	}
 
 	if (!options.palettes.empty()) {
-		File output;
-		if (!output.open(options.palettes, std::ios_base::out | std::ios_base::binary)) {
-			// LCOV_EXCL_START
-			fatal("Failed to create \"%s\": %s", output.c_str(options.palettes), strerror(errno));
-			// LCOV_EXCL_STOP
-		}
-
+		std::vector<uint8_t> data;
+		data.reserve(palettes.size() * options.nbColorsPerPal * 2);
 		for (Palette const &palette : palettes) {
 			for (uint8_t i = 0; i < options.nbColorsPerPal; ++i) {
 				// Will output `UINT16_MAX` for unused slots
 				uint16_t color = palette.colors[i];
-				output->sputc(color & 0xFF);
-				output->sputc(color >> 8);
+				data.push_back(color & 0xFF);
+				data.push_back(color >> 8);
 			}
 		}
-	}
-}
-
-static void hashBitplanes(uint16_t bitplanes, uint16_t &hash) {
-	hash ^= bitplanes;
-	if (options.allowMirroringX) {
-		// Count the line itself as mirrored, which ensures the same hash as the tile's horizontal
-		// flip; vertical mirroring is already taken care of because the symmetric line will be
-		// XOR'd the same way. (This can trivially create some collisions, but real-world tile data
-		// generally doesn't trigger them.)
-		hash ^= flipTable[bitplanes >> 8] << 8 | flipTable[bitplanes & 0xFF];
+		writeArtifact("PALS", options.palettes, std::move(data));
 	}
 }
 
@@ -505,10 +585,35 @@ class TileData {
 	// 1bpp. This massively simplifies internal processing, since bit depth is always identical
 	// outside of I/O / serialization boundaries.
 	std::array<uint8_t, 16> _data;
-	// The hash is a bit lax: it's the XOR of all lines, and every other nibble is identical
-	// if horizontal mirroring is in effect. It should still be a reasonable tie-breaker in
-	// non-pathological cases.
-	uint16_t _hash;
+	// The minimum of the tile's FNV-1a hash and those of its allowed flips, so a tile and
+	// its mirrored variants land in the same bucket; collisions fall back to the exact
+	// comparison in `tryMatching`.
+	uint64_t _hash;
+
+	void computeHash() {
+		// The flipped variants' bytes are derived from the plane representation: horizontal
+		// flips reverse each bitplane byte's bits, and vertical flips read the bitplane
+		// pairs backwards.
+		uint64_t exact = 0xCBF29CE484222325, hFlip = exact, vFlip = exact, vhFlip = exact;
+		for (size_t i = 0; i < _data.size(); ++i) {
+			uint8_t byte = _data[i], mirrored = _data[(15 - i) ^ 1];
+			exact = (exact ^ byte) * 0x100000001B3;
+			hFlip = (hFlip ^ flipTable[byte]) * 0x100000001B3;
+			vFlip = (vFlip ^ mirrored) * 0x100000001B3;
+			vhFlip = (vhFlip ^ flipTable[mirrored]) * 0x100000001B3;
+		}
+		_hash = exact;
+		if (options.allowMirroringX) {
+			_hash = std::min(_hash, hFlip);
+		}
+		if (options.allowMirroringY) {
+			_hash = std::min(_hash, vFlip);
+			if (options.allowMirroringX) {
+				_hash = std::min(_hash, vhFlip);
+			}
+		}
+	}
+
 public:
 	// This is an index within the "global" pool; no bank info is encoded here
 	// It's marked as `mutable` so that it can be modified even on a `const` object;
@@ -518,10 +623,17 @@ public:
 
 	static uint16_t
 	    rowBitplanes(Image::TilesVisitor::Tile const &tile, Palette const &palette, uint32_t y) {
+		// Convert and palette-match the whole row at once; both kernels are branchless so
+		// the compiler can vectorize them
+		std::array<uint16_t, 8> colors;
+		Rgba::cgbColorRow(tile.row(y), colors.data(), colors.size());
+		std::array<uint8_t, 8> indices;
+		palette.indicesOf(colors.data(), indices.data());
+
 		uint16_t row = 0;
 		for (uint32_t x = 0; x < 8; ++x) {
 			row <<= 1;
-			uint8_t index = palette.indexOf(tile.pixel(x, y).cgbColor());
+			uint8_t index = indices[x];
 			assume(index < palette.size()); // The color should be in the palette
 			if (index & 1) {
 				row |= 1;
@@ -533,26 +645,21 @@ public:
 		return row;
 	}
 
-	TileData(std::array<uint8_t, 16> &&raw) : _data(raw), _hash(0) {
-		for (uint8_t y = 0; y < 8; ++y) {
-			uint16_t bitplanes = _data[y * 2] | _data[y * 2 + 1] << 8;
-			hashBitplanes(bitplanes, _hash);
-		}
-	}
+	TileData(std::array<uint8_t, 16> &&raw) : _data(raw) { computeHash(); }
 
-	TileData(Image::TilesVisitor::Tile const &tile, Palette const &palette) : _hash(0) {
+	TileData(Image::TilesVisitor::Tile const &tile, Palette const &palette) {
 		size_t writeIndex = 0;
 		for (uint32_t y = 0; y < 8; ++y) {
 			uint16_t bitplanes = rowBitplanes(tile, palette, y);
-			hashBitplanes(bitplanes, _hash);
 
 			_data[writeIndex++] = bitplanes & 0xFF;
 			_data[writeIndex++] = bitplanes >> 8;
 		}
+		computeHash();
 	}
 
 	std::array<uint8_t, 16> const &data() const { return _data; }
-	uint16_t hash() const { return _hash; }
+	uint64_t hash() const { return _hash; }
 
 	enum MatchType {
 		NOPE,
@@ -621,17 +728,10 @@ struct std::hash<TileData> {
 
 static void outputUnoptimizedTileData(
     Image const &image,
-    std::vector<AttrmapEntry> const &attrmap,
+    Attrmap const &attrmap,
     std::vector<Palette> const &palettes,
     std::vector<size_t> const &mappings
 ) {
-	File output;
-	if (!output.open(options.output, std::ios_base::out | std::ios_base::binary)) {
-		// LCOV_EXCL_START
-		fatal("Failed to create \"%s\": %s", output.c_str(options.output), strerror(errno));
-		// LCOV_EXCL_STOP
-	}
-
 	uint16_t widthTiles = options.inputSlice.width ? options.inputSlice.width : image.png.width / 8;
 	uint16_t heightTiles =
 	    options.inputSlice.height ? options.inputSlice.height : image.png.height / 8;
@@ -639,15 +739,18 @@ static void outputUnoptimizedTileData(
 	uint64_t nbKeptTiles = nbTiles > options.trim ? nbTiles - options.trim : 0;
 	uint64_t tileIdx = 0;
 
-	for (auto const &[tile, attr] : zip(image.visitAsTiles(), attrmap)) {
+	std::vector<uint8_t> data;
+	data.reserve(nbKeptTiles * options.bitDepth * 8);
+
+	for (auto tile : image.visitAsTiles()) {
 		// Do not emit fully-background tiles.
-		if (attr.isBackgroundTile()) {
+		if (attrmap.isBackgroundTile(tileIdx)) {
 			++tileIdx;
 			continue;
 		}
 
 		// If the tile is fully transparent, this defaults to palette 0.
-		Palette const &palette = palettes[attr.getPalID(mappings)];
+		Palette const &palette = palettes[attrmap.getPalID(mappings, tileIdx)];
 
 		bool empty = true;
 		for (uint32_t y = 0; y < 8; ++y) {
@@ -656,9 +759,9 @@ static void outputUnoptimizedTileData(
 				empty = false;
 			}
 			if (tileIdx < nbKeptTiles) {
-				output->sputc(bitplanes & 0xFF);
+				data.push_back(bitplanes & 0xFF);
 				if (options.bitDepth == 2) {
-					output->sputc(bitplanes >> 8);
+					data.push_back(bitplanes >> 8);
 				}
 			}
 		}
@@ -672,57 +775,66 @@ static void outputUnoptimizedTileData(
 		++tileIdx;
 	}
 	assume(nbKeptTiles <= tileIdx && tileIdx <= nbTiles);
+
+	writeArtifact("TILE", options.output, std::move(data));
 }
 
-static void outputUnoptimizedMaps(
-    std::vector<AttrmapEntry> const &attrmap, std::vector<size_t> const &mappings
-) {
-	std::optional<File> tilemapOutput, attrmapOutput, palmapOutput;
-	auto autoOpenPath = [](std::string const &path, std::optional<File> &file) {
+static void outputUnoptimizedMaps(Attrmap const &attrmap, std::vector<size_t> const &mappings) {
+	std::optional<std::vector<uint8_t>> tilemapData, attrmapData, palmapData;
+	auto autoReserve = [&attrmap](std::string const &path, std::optional<std::vector<uint8_t>> &data
+	                   ) {
 		if (!path.empty()) {
-			file.emplace();
-			if (!file->open(path, std::ios_base::out | std::ios_base::binary)) {
-				// LCOV_EXCL_START
-				fatal("Failed to create \"%s\": %s", file->c_str(options.tilemap), strerror(errno));
-				// LCOV_EXCL_STOP
-			}
+			data.emplace();
+			data->reserve(attrmap.size());
 		}
 	};
-	autoOpenPath(options.tilemap, tilemapOutput);
-	autoOpenPath(options.attrmap, attrmapOutput);
-	autoOpenPath(options.palmap, palmapOutput);
+	autoReserve(options.tilemap, tilemapData);
+	autoReserve(options.attrmap, attrmapData);
+	autoReserve(options.palmap, palmapData);
 
 	uint8_t tileID = 0;
 	uint8_t bank = 0;
-	for (AttrmapEntry const &attr : attrmap) {
+	for (size_t i = 0; i < attrmap.size(); ++i) {
 		if (tileID == options.maxNbTiles[bank]) {
 			assume(bank == 0);
 			bank = 1;
 			tileID = 0;
 		}
 
-		if (tilemapOutput.has_value()) {
-			(*tilemapOutput)
-			    ->sputc((attr.isBackgroundTile() ? 0 : tileID) + options.baseTileIDs[bank]);
+		bool isBackgroundTile = attrmap.isBackgroundTile(i);
+		if (tilemapData.has_value()) {
+			tilemapData->push_back((isBackgroundTile ? 0 : tileID) + options.baseTileIDs[bank]);
 		}
-		uint8_t palID = attr.getPalID(mappings) + options.basePalID;
-		if (attrmapOutput.has_value()) {
-			(*attrmapOutput)->sputc((palID & 0b111) | bank << 3); // The other flags are all 0
+		uint8_t palID = attrmap.getPalID(mappings, i) + options.basePalID;
+		if (attrmapData.has_value()) {
+			attrmapData->push_back((palID & 0b111) | bank << 3); // The other flags are all 0
 		}
-		if (palmapOutput.has_value()) {
-			(*palmapOutput)->sputc(palID);
+		if (palmapData.has_value()) {
+			palmapData->push_back(palID);
 		}
 
 		// Background tiles are skipped in the tile data, so they should be skipped in the maps too.
-		if (!attr.isBackgroundTile()) {
+		if (!isBackgroundTile) {
 			++tileID;
 		}
 	}
+
+	if (tilemapData.has_value()) {
+		writeArtifact("TMAP", options.tilemap, std::move(*tilemapData));
+	}
+	if (attrmapData.has_value()) {
+		writeArtifact("AMAP", options.attrmap, std::move(*attrmapData));
+	}
+	if (palmapData.has_value()) {
+		writeArtifact("PMAP", options.palmap, std::move(*palmapData));
+	}
 }
 
 struct UniqueTiles {
 	std::unordered_set<TileData> tileset;
 	std::vector<TileData const *> tiles;
+	// Tiles preloaded from the input/shared tileset; they occupy IDs 0 through `nbPreloaded - 1`
+	size_t nbPreloaded = 0;
 
 	UniqueTiles() = default;
 	// Copies are likely to break pointers, so we really don't want those.
@@ -754,7 +866,7 @@ struct UniqueTiles {
 // twice)
 static UniqueTiles dedupTiles(
     Image const &image,
-    std::vector<AttrmapEntry> &attrmap,
+    Attrmap &attrmap,
     std::vector<Palette> const &palettes,
     std::vector<size_t> const &mappings
 ) {
@@ -763,143 +875,185 @@ static UniqueTiles dedupTiles(
 	// by caching the full tile data anyway, so we might as well.)
 	UniqueTiles tiles;
 
-	if (!options.inputTileset.empty()) {
+	// A shared tileset is read just like an input tileset, except that it is allowed not to
+	// exist yet (the first conversion creates it).
+	std::string const &tilesetPath =
+	    !options.inputTileset.empty() ? options.inputTileset : options.sharedTileset;
+	if (!tilesetPath.empty()) {
 		File inputTileset;
-		if (!inputTileset.open(options.inputTileset, std::ios::in | std::ios::binary)) {
-			fatal("Failed to open \"%s\": %s", options.inputTileset.c_str(), strerror(errno));
-		}
-
-		std::array<uint8_t, 16> tile;
-		size_t const tileSize = options.bitDepth * 8;
-		for (;;) {
-			// It's okay to cast between character types.
-			size_t len = inputTileset->sgetn(reinterpret_cast<char *>(tile.data()), tileSize);
-			if (len == 0) { // EOF!
-				break;
-			} else if (len != tileSize) {
-				fatal(
-				    "\"%s\" does not contain a multiple of %zu bytes; is it actually tile data?",
-				    options.inputTileset.c_str(),
-				    tileSize
+		if (!inputTileset.open(tilesetPath, std::ios::in | std::ios::binary)) {
+			if (options.inputTileset.empty() && errno == ENOENT) {
+				verbosePrint(
+				    VERB_NOTICE,
+				    "Shared tileset \"%s\" does not exist yet, starting it empty\n",
+				    tilesetPath.c_str()
 				);
-			} else if (len == 8) {
-				// Expand the tile data to 2bpp.
-				for (size_t i = 8; i--;) {
-					tile[i * 2 + 1] = 0;
-					tile[i * 2] = tile[i];
-				}
+			} else {
+				fatal("Failed to open \"%s\": %s", tilesetPath.c_str(), strerror(errno));
 			}
+		} else {
+			std::array<uint8_t, 16> tile;
+			size_t const tileSize = options.bitDepth * 8;
+			for (;;) {
+				// It's okay to cast between character types.
+				size_t len = inputTileset->sgetn(reinterpret_cast<char *>(tile.data()), tileSize);
+				if (len == 0) { // EOF!
+					break;
+				} else if (len != tileSize) {
+					fatal(
+					    "\"%s\" does not contain a multiple of %zu bytes; is it actually tile data?",
+					    tilesetPath.c_str(),
+					    tileSize
+					);
+				} else if (len == 8) {
+					// Expand the tile data to 2bpp.
+					for (size_t i = 8; i--;) {
+						tile[i * 2 + 1] = 0;
+						tile[i * 2] = tile[i];
+					}
+				}
 
-			auto [tileID, matchType] = tiles.addTile(std::move(tile));
-
-			if (matchType != TileData::NOPE) {
-				error(
-				    "The input tileset's tile #%hu was deduplicated; please check that your "
-				    "deduplication flags ('-u', '-m') are consistent with what was used to "
-				    "generate the input tileset",
-				    tileID
-				);
+				auto [tileID, matchType] = tiles.addTile(std::move(tile));
+
+				if (matchType != TileData::NOPE) {
+					error(
+					    "The %s tileset's tile #%hu was deduplicated; please check that your "
+					    "deduplication flags ('-u', '-m') are consistent with what was used to "
+					    "generate the %s tileset",
+					    options.inputTileset.empty() ? "shared" : "input",
+					    tileID,
+					    options.inputTileset.empty() ? "shared" : "input"
+					);
+				}
 			}
 		}
+		tiles.nbPreloaded = tiles.size();
+	}
+
+	// Encode tiles to 2bpp in parallel; registering them must stay sequential so tile IDs
+	// are deterministic.
+	std::vector<Image::TilesVisitor::Tile> tileList;
+	for (auto tile : image.visitAsTiles()) {
+		tileList.push_back(tile);
 	}
+	std::vector<std::optional<TileData>> tileData(tileList.size());
+	forEachParallel(tileList.size(), 512, [&](size_t tileIdx) {
+		if (!attrmap.isBackgroundTile(tileIdx)) {
+			tileData[tileIdx].emplace(
+			    tileList[tileIdx], palettes[mappings[attrmap.colorSetIDs[tileIdx]]]
+			);
+		}
+	});
+
+	// Background tiles keep the zeroes these fields are initialized with
+	attrmap.tileIDs.assign(tileList.size(), 0);
+	attrmap.banks.assign(tileList.size(), 0);
+	attrmap.yFlips.assign(tileList.size(), 0);
+	attrmap.xFlips.assign(tileList.size(), 0);
 
 	bool inputWithoutOutput = !options.inputTileset.empty() && options.output.empty();
-	for (auto const &[tile, attr] : zip(image.visitAsTiles(), attrmap)) {
-		if (attr.isBackgroundTile()) {
-			attr.xFlip = false;
-			attr.yFlip = false;
-			attr.bank = 0;
-			attr.tileID = 0;
-		} else {
-			auto [tileID, matchType] = tiles.addTile({tile, palettes[mappings[attr.colorSetID]]});
-
-			if (inputWithoutOutput && matchType == TileData::NOPE) {
-				error(
-				    "Tile at (%" PRIu32 ", %" PRIu32
-				    ") is not within the input tileset, and '-o' was not given!",
-				    tile.x,
-				    tile.y
-				);
-			}
+	for (size_t tileIdx = 0; tileIdx < tileList.size(); ++tileIdx) {
+		if (attrmap.isBackgroundTile(tileIdx)) {
+			continue;
+		}
+		auto [tileID, matchType] = tiles.addTile(std::move(*tileData[tileIdx]));
 
-			attr.xFlip = matchType == TileData::HFLIP || matchType == TileData::VHFLIP;
-			attr.yFlip = matchType == TileData::VFLIP || matchType == TileData::VHFLIP;
-			attr.bank = tileID >= options.maxNbTiles[0];
-			attr.tileID = (attr.bank ? tileID - options.maxNbTiles[0] : tileID)
-			              + options.baseTileIDs[attr.bank];
+		if (inputWithoutOutput && matchType == TileData::NOPE) {
+			error(
+			    "Tile at (%" PRIu32 ", %" PRIu32
+			    ") is not within the input tileset, and '-o' was not given!",
+			    tileList[tileIdx].x,
+			    tileList[tileIdx].y
+			);
 		}
+
+		bool bank = tileID >= options.maxNbTiles[0];
+		attrmap.xFlips[tileIdx] = matchType == TileData::HFLIP || matchType == TileData::VHFLIP;
+		attrmap.yFlips[tileIdx] = matchType == TileData::VFLIP || matchType == TileData::VHFLIP;
+		attrmap.banks[tileIdx] = bank;
+		attrmap.tileIDs[tileIdx] =
+		    (bank ? tileID - options.maxNbTiles[0] : tileID) + options.baseTileIDs[bank];
 	}
 
 	// Copy elision should prevent the contained `unordered_set` from being re-constructed
 	return tiles;
 }
 
-static void outputTileData(UniqueTiles const &tiles) {
-	File output;
-	if (!output.open(options.output, std::ios_base::out | std::ios_base::binary)) {
-		// LCOV_EXCL_START
-		fatal("Failed to create \"%s\": %s", output.c_str(options.output), strerror(errno));
-		// LCOV_EXCL_STOP
-	}
-
-	uint16_t tileID = 0;
-	for (auto iter = tiles.begin(), end = tiles.end() - options.trim; iter != end; ++iter) {
+// Serializes a range of tiles at the active bit depth, appending to the buffer
+template<typename Iter>
+static void serializeTiles(std::vector<uint8_t> &data, Iter iter, Iter end) {
+	data.reserve(data.size() + (end - iter) * options.bitDepth * 8);
+	for (; iter != end; ++iter) {
 		TileData const *tile = *iter;
-		assume(tile->tileID == tileID);
-		++tileID;
 		if (options.bitDepth == 2) {
-			output->sputn(reinterpret_cast<char const *>(tile->data().data()), 16);
+			data.insert(data.end(), RANGE(tile->data()));
 		} else {
 			assume(options.bitDepth == 1);
 			for (size_t y = 0; y < 8; ++y) {
-				output->sputc(tile->data()[y * 2]);
+				data.push_back(tile->data()[y * 2]);
 			}
 		}
 	}
 }
 
-static void outputTilemap(std::vector<AttrmapEntry> const &attrmap) {
-	File output;
-	if (!output.open(options.tilemap, std::ios_base::out | std::ios_base::binary)) {
-		// LCOV_EXCL_START
-		fatal("Failed to create \"%s\": %s", output.c_str(options.tilemap), strerror(errno));
-		// LCOV_EXCL_STOP
+static void outputTileData(UniqueTiles const &tiles) {
+	uint16_t tileID = 0;
+	for (auto iter = tiles.begin(), end = tiles.end() - options.trim; iter != end; ++iter) {
+		assume((*iter)->tileID == tileID);
+		++tileID;
 	}
 
-	for (AttrmapEntry const &entry : attrmap) {
-		output->sputc(entry.tileID); // The tile ID has already been converted
-	}
+	std::vector<uint8_t> data;
+	serializeTiles(data, tiles.begin(), tiles.end() - options.trim);
+	writeArtifact("TILE", options.output, std::move(data));
 }
 
-static void
-    outputAttrmap(std::vector<AttrmapEntry> const &attrmap, std::vector<size_t> const &mappings) {
+// Appends the tiles that were not already in the shared tileset to its file, so that later
+// conversions can deduplicate against them; `-x` does not apply to the shared tileset.
+static void outputSharedTileset(UniqueTiles const &tiles) {
 	File output;
-	if (!output.open(options.attrmap, std::ios_base::out | std::ios_base::binary)) {
+	if (!output.open(
+	        options.sharedTileset, std::ios_base::out | std::ios_base::app | std::ios_base::binary
+	    )) {
 		// LCOV_EXCL_START
-		fatal("Failed to create \"%s\": %s", output.c_str(options.attrmap), strerror(errno));
+		fatal("Failed to open \"%s\": %s", output.c_str(options.sharedTileset), strerror(errno));
 		// LCOV_EXCL_STOP
 	}
 
-	for (AttrmapEntry const &entry : attrmap) {
-		uint8_t attr = entry.xFlip << 5 | entry.yFlip << 6;
-		attr |= entry.bank << 3;
-		attr |= (entry.getPalID(mappings) + options.basePalID) & 0b111;
-		output->sputc(attr);
-	}
+	// Unlike the other artifacts, this one is an append to a file shared between conversions, so
+	// it never goes into the container; it does still get written in a single call.
+	std::vector<uint8_t> data;
+	serializeTiles(data, tiles.begin() + tiles.nbPreloaded, tiles.end());
+	output->sputn(reinterpret_cast<char const *>(data.data()), data.size());
 }
 
-static void
-    outputPalmap(std::vector<AttrmapEntry> const &attrmap, std::vector<size_t> const &mappings) {
-	File output;
-	if (!output.open(options.palmap, std::ios_base::out | std::ios_base::binary)) {
-		// LCOV_EXCL_START
-		fatal("Failed to create \"%s\": %s", output.c_str(options.palmap), strerror(errno));
-		// LCOV_EXCL_STOP
+// One dense byte per tile; the output palette IDs are the only per-tile value that needs an
+// indirection (through `mappings`), so they are resolved in their own pass
+static std::vector<uint8_t> resolvePalIDs(Attrmap const &attrmap, std::vector<size_t> const &mappings) {
+	std::vector<uint8_t> palIDs(attrmap.size());
+	for (size_t i = 0; i < attrmap.size(); ++i) {
+		palIDs[i] = attrmap.getPalID(mappings, i) + options.basePalID;
 	}
+	return palIDs;
+}
 
-	for (AttrmapEntry const &entry : attrmap) {
-		output->sputc(entry.getPalID(mappings) + options.basePalID);
+static void outputTilemap(Attrmap const &attrmap) {
+	// The tile IDs have already been converted, so the tilemap is that array verbatim
+	writeArtifact("TMAP", options.tilemap, std::vector<uint8_t>(attrmap.tileIDs));
+}
+
+static void outputAttrmap(Attrmap const &attrmap, std::vector<size_t> const &mappings) {
+	// Composing each byte from the per-field arrays streams five dense bytes per tile
+	std::vector<uint8_t> data = resolvePalIDs(attrmap, mappings);
+	for (size_t i = 0; i < attrmap.size(); ++i) {
+		data[i] = attrmap.xFlips[i] << 5 | attrmap.yFlips[i] << 6 | attrmap.banks[i] << 3
+		          | (data[i] & 0b111);
 	}
+	writeArtifact("AMAP", options.attrmap, std::move(data));
+}
+
+static void outputPalmap(Attrmap const &attrmap, std::vector<size_t> const &mappings) {
+	writeArtifact("PMAP", options.palmap, resolvePalIDs(attrmap, mappings));
 }
 
 void processPalettes() {
@@ -910,61 +1064,53 @@ void processPalettes() {
 	std::tie(std::ignore, palettes) = makePalsAsSpecified(colorSets);
 
 	outputPalettes(palettes);
-}
-
-void process() {
-	verbosePrint(VERB_CONFIG, "Using libpng %s\n", png_get_libpng_ver(nullptr));
 
-	verbosePrint(VERB_NOTICE, "Reading tiles...\n");
-	Image image(options.input); // This also sets `hasTransparentPixels` as a side effect
-
-	// LCOV_EXCL_START
-	if (checkVerbosity(VERB_INFO)) {
-		style_Set(stderr, STYLE_MAGENTA, false);
-		fputs("Image colors: [ ", stderr);
-		for (std::optional<Rgba> const &slot : image.colors) {
-			if (!slot.has_value()) {
-				continue;
-			}
-			fprintf(stderr, "#%08x, ", slot->toCSS());
-		}
-		fputs("]\n", stderr);
-		style_Reset(stderr);
+	if (!options.container.empty()) {
+		verbosePrint(VERB_NOTICE, "Writing the container file...\n");
+		writeContainer();
 	}
-	// LCOV_EXCL_STOP
+}
 
-	if (options.palSpecType == Options::DMG) {
-		if (options.hasTransparentPixels) {
-			fatal(
-			    "Image contains transparent pixels, not compatible with a DMG palette specification"
-			);
-		}
-		if (!image.isSuitableForGrayscale()) {
-			fatal("Image contains too many or non-gray colors, not compatible with a DMG palette "
-			      "specification");
-		}
+// Iterates through the image's tiles, collecting their color sets and performing the per-tile
+// validation; fills in one attrmap entry per tile with the color set IDs.
+static void generateColorSets(Image const &image, std::vector<ColorSet> &colorSets, Attrmap &attrmap) {
+	std::vector<Image::TilesVisitor::Tile> tiles;
+	for (auto tile : image.visitAsTiles()) {
+		tiles.push_back(tile);
 	}
 
-	// Now, iterate through the tiles, generating color sets as we go
-	// We do this unconditionally because this performs the image validation (which we want to
-	// perform even if no output is requested), and because it's necessary to generate any
-	// output (with the exception of an un-duplicated tilemap, but that's an acceptable loss.)
-	std::vector<ColorSet> colorSets;
-	std::vector<AttrmapEntry> attrmap{};
-
-	for (auto tile : image.visitAsTiles()) {
-		AttrmapEntry &attrs = attrmap.emplace_back();
+	// Collect each tile's unique colors in parallel; tiles are independent for this stage.
+	// Stored in fixed inline arrays (an 8x8 tile has at most 64 distinct colors), kept sorted
+	// by the insertion, so no per-tile heap allocation is ever performed.
+	std::vector<TileColors> tileColorLists(tiles.size());
+	forEachParallel(tiles.size(), 512, [&](size_t tileIdx) {
+		Image::TilesVisitor::Tile const &tile = tiles[tileIdx];
 
 		// Count the unique non-transparent colors for packing
-		std::unordered_set<uint16_t> tileColors;
+		TileColors &tileColors = tileColorLists[tileIdx];
 		for (uint32_t y = 0; y < 8; ++y) {
-			for (uint32_t x = 0; x < 8; ++x) {
-				if (Rgba color = tile.pixel(x, y);
-				    !color.isTransparent() || !options.hasTransparentPixels) {
-					tileColors.insert(color.cgbColor());
+			std::array<uint16_t, 8> rowColors;
+			Rgba::cgbColorRow(tile.row(y), rowColors.data(), rowColors.size());
+			for (uint16_t color : rowColors) {
+				// Only transparent pixels convert to `Rgba::transparent`
+				if (color != Rgba::transparent || !options.hasTransparentPixels) {
+					tileColors.add(color);
 				}
 			}
 		}
+	});
+
+	// Merging into color sets is order-dependent (sets can override one another), so this
+	// stage stays sequential, and also performs the per-tile diagnostics in tile order.
+	// Tiles vastly outnumber distinct color sets, and most repeat an exact set that was already
+	// resolved; remember what ID each exact set got, so the subset/superset scan below only
+	// runs once per distinct set. (The 64-bit word view of a set makes a cheap key.)
+	std::unordered_map<uint64_t, size_t> knownColorSets;
+	attrmap.colorSetIDs.reserve(tiles.size());
+	for (size_t tileIdx = 0; tileIdx < tiles.size(); ++tileIdx) {
+		Image::TilesVisitor::Tile const &tile = tiles[tileIdx];
+		TileColors const &tileColors = tileColorLists[tileIdx];
+		size_t &colorSetID = attrmap.colorSetIDs.emplace_back();
 
 		if (tileColors.size() > options.maxOpaqueColors()) {
 			fatal(
@@ -979,7 +1125,7 @@ void process() {
 		if (tileColors.empty()) {
 			// "Empty" color sets screw with the packing process, so discard those
 			assume(!isBgColorTransparent());
-			attrs.colorSetID = AttrmapEntry::transparent;
+			colorSetID = Attrmap::transparent;
 			continue;
 		}
 
@@ -992,7 +1138,7 @@ void process() {
 		    && std::find(RANGE(tileColors), options.bgColor->cgbColor()) != tileColors.end()) {
 			if (tileColors.size() == 1) {
 				// The tile contains just the background color, skip it.
-				attrs.colorSetID = AttrmapEntry::background;
+				colorSetID = Attrmap::background;
 				continue;
 			}
 			fatal(
@@ -1003,6 +1149,13 @@ void process() {
 			);
 		}
 
+		// If this exact color set was seen before, reuse the ID it resolved to
+		// (Overriding a set with a superset does not change its ID, so cached IDs stay valid)
+		if (auto cached = knownColorSets.find(colorSet.word()); cached != knownColorSets.end()) {
+			colorSetID = cached->second;
+			continue;
+		}
+
 		// Insert the color set, making sure to avoid overlaps
 		for (size_t n = 0; n < colorSets.size(); ++n) {
 			switch (colorSet.compare(colorSets[n])) {
@@ -1014,7 +1167,8 @@ void process() {
 
 			case ColorSet::THEY_BIGGER:
 				// Do nothing, they already contain us
-				attrs.colorSetID = n;
+				colorSetID = n;
+				knownColorSets.emplace(colorSet.word(), n);
 				goto continue_visiting_tiles; // Can't `continue` from within a nested loop
 
 			case ColorSet::NEITHER:
@@ -1022,44 +1176,113 @@ void process() {
 			}
 		}
 
-		attrs.colorSetID = colorSets.size();
-		if (colorSets.size() == AttrmapEntry::background) { // Check for overflow
+		colorSetID = colorSets.size();
+		if (colorSets.size() == Attrmap::background) { // Check for overflow
 			fatal(
 			    "Reached %zu color sets... sorry, this image is too much for me to handle :(",
-			    AttrmapEntry::transparent
+			    Attrmap::transparent
 			);
 		}
+		knownColorSets.emplace(colorSet.word(), colorSetID);
 		colorSets.push_back(colorSet);
 continue_visiting_tiles:;
 	}
+}
+
+void process() {
+	verbosePrint(VERB_CONFIG, "Using libpng %s\n", png_get_libpng_ver(nullptr));
+
+	verbosePrint(VERB_NOTICE, "Reading tiles...\n");
+	Image image(options.input); // This also sets `hasTransparentPixels` as a side effect
 
-	verbosePrint(
-	    VERB_INFO,
-	    "Image contains %zu color set%s\n",
-	    colorSets.size(),
-	    colorSets.size() != 1 ? "s" : ""
-	);
 	// LCOV_EXCL_START
 	if (checkVerbosity(VERB_INFO)) {
 		style_Set(stderr, STYLE_MAGENTA, false);
-		for (ColorSet const &colorSet : colorSets) {
-			fputs("[ ", stderr);
-			for (uint16_t color : colorSet) {
-				fprintf(stderr, "$%04x, ", color);
+		fputs("Image colors: [ ", stderr);
+		for (std::optional<Rgba> const &slot : image.colors) {
+			if (!slot.has_value()) {
+				continue;
 			}
-			fputs("]\n", stderr);
+			fprintf(stderr, "#%08x, ", slot->toCSS());
 		}
+		fputs("]\n", stderr);
 		style_Reset(stderr);
 	}
 	// LCOV_EXCL_STOP
 
-	if (options.palSpecType == Options::EMBEDDED) {
-		generatePalSpec(image);
+	if (options.palSpecType == Options::DMG) {
+		if (options.hasTransparentPixels) {
+			fatal(
+			    "Image contains transparent pixels, not compatible with a DMG palette specification"
+			);
+		}
+		if (!image.isSuitableForGrayscale()) {
+			fatal("Image contains too many or non-gray colors, not compatible with a DMG palette "
+			      "specification");
+		}
+	}
+
+	std::vector<ColorSet> colorSets;
+	Attrmap attrmap{};
+	std::vector<size_t> mappings;
+	std::vector<Palette> palettes;
+
+	// When every color is known to reduce to one of the four grayscale bins (a DMG palette spec
+	// asserts this, and plain grayscale images are detected), all tiles map to the same single
+	// palette, with each pixel going straight to its shade's slot; color set construction and
+	// palette packing can be skipped entirely. (The skipped per-tile validation cannot fail
+	// either: no tile can exceed the image's own color count, and transparency is excluded.)
+	if (!options.hasTransparentPixels && !options.bgColor.has_value()
+	    && (options.palSpecType == Options::DMG
+	        || (options.palSpecType == Options::NO_SPEC && image.png.palette.empty()
+	            && image.isSuitableForGrayscale()))) {
+		verbosePrint(VERB_NOTICE, "Using the grayscale fast path...\n");
+
+		uint32_t const nbTilesW =
+		    options.inputSlice.width ? options.inputSlice.width : image.png.width / 8;
+		uint32_t const nbTilesH =
+		    options.inputSlice.height ? options.inputSlice.height : image.png.height / 8;
+		// `resize` value-initializes the new entries, so they all use color set ID 0...
+		attrmap.colorSetIDs.resize(static_cast<size_t>(nbTilesW) * nbTilesH);
+		// ...which maps to the single palette.
+		mappings.push_back(0);
+		palettes.resize(1);
+		sortGrayscale(palettes, image.colors.raw());
+	} else {
+		// Iterate through the tiles, generating color sets as we go
+		// We do this even when no output is requested, because this also performs the image
+		// validation, and because it's necessary to generate any output (with the exception of
+		// an un-duplicated tilemap, but that's an acceptable loss.)
+		generateColorSets(image, colorSets, attrmap);
+
+		verbosePrint(
+		    VERB_INFO,
+		    "Image contains %zu color set%s\n",
+		    colorSets.size(),
+		    colorSets.size() != 1 ? "s" : ""
+		);
+		// LCOV_EXCL_START
+		if (checkVerbosity(VERB_INFO)) {
+			style_Set(stderr, STYLE_MAGENTA, false);
+			for (ColorSet const &colorSet : colorSets) {
+				fputs("[ ", stderr);
+				for (uint16_t color : colorSet) {
+					fprintf(stderr, "$%04x, ", color);
+				}
+				fputs("]\n", stderr);
+			}
+			style_Reset(stderr);
+		}
+		// LCOV_EXCL_STOP
+
+		if (options.palSpecType == Options::EMBEDDED) {
+			generatePalSpec(image);
+		}
+		std::tie(mappings, palettes) =
+		    options.palSpecType == Options::NO_SPEC || options.palSpecType == Options::DMG
+		        ? generatePalettes(colorSets, image)
+		        : makePalsAsSpecified(colorSets);
 	}
-	auto [mappings, palettes] =
-	    options.palSpecType == Options::NO_SPEC || options.palSpecType == Options::DMG
-	        ? generatePalettes(colorSets, image)
-	        : makePalsAsSpecified(colorSets);
 	outputPalettes(palettes);
 
 	// If deduplication is not happening, we just need to output the tile data and/or maps as-is
@@ -1081,6 +1304,9 @@ continue_visiting_tiles:;
 		if (!options.inputTileset.empty()) {
 			fatal("Input tilesets are not supported without '-u'");
 		}
+		if (!options.sharedTileset.empty()) {
+			fatal("Shared tilesets are not supported without '-u'");
+		}
 
 		if (!options.output.empty()) {
 			verbosePrint(VERB_NOTICE, "Generating unoptimized tile data...\n");
@@ -1113,6 +1339,15 @@ continue_visiting_tiles:;
 			outputTileData(tiles);
 		}
 
+		if (!options.sharedTileset.empty() && tiles.size() > tiles.nbPreloaded) {
+			verbosePrint(
+			    VERB_NOTICE,
+			    "Appending %zu new tiles to the shared tileset...\n",
+			    tiles.size() - tiles.nbPreloaded
+			);
+			outputSharedTileset(tiles);
+		}
+
 		if (!options.tilemap.empty()) {
 			verbosePrint(VERB_NOTICE, "Generating optimized tilemap...\n");
 			outputTilemap(attrmap);
@@ -1128,4 +1363,9 @@ continue_visiting_tiles:;
 			outputPalmap(attrmap, mappings);
 		}
 	}
+
+	if (!options.container.empty()) {
+		verbosePrint(VERB_NOTICE, "Writing the container file...\n");
+		writeContainer();
+	}
 }
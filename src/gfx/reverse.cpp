@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -24,6 +25,7 @@
 #include "verbosity.hpp"
 
 #include "gfx/main.hpp"
+#include "parallel.hpp"
 #include "gfx/rgba.hpp"
 #include "gfx/warning.hpp"
 
@@ -493,19 +495,20 @@ void reverse() {
 	// N bits/pixel * 8 pixels/tile row / 8 bits/byte = N bytes/tile row
 	uint8_t const bytesPerTileRow = pngColorType == PNG_COLOR_TYPE_RGB_ALPHA ? 32 : pngDepth;
 	size_t const bytesPerRow = width * bytesPerTileRow;
-	std::vector<uint8_t> tileRow(8 * bytesPerRow, 0xFF); // Data for 8 rows of pixels
-	uint8_t * const rowPtrs[8] = {
-	    &tileRow.data()[0 * bytesPerRow],
-	    &tileRow.data()[1 * bytesPerRow],
-	    &tileRow.data()[2 * bytesPerRow],
-	    &tileRow.data()[3 * bytesPerRow],
-	    &tileRow.data()[4 * bytesPerRow],
-	    &tileRow.data()[5 * bytesPerRow],
-	    &tileRow.data()[6 * bytesPerRow],
-	    &tileRow.data()[7 * bytesPerRow],
-	};
-
-	for (size_t ty = 0; ty < height; ++ty) {
+	size_t const bytesPerStrip = 8 * bytesPerRow; // Data for 8 rows of pixels
+
+	// Reconstructs one row of tiles into the 8-pixel-row strip at `strip`
+	auto renderStrip = [&](size_t ty, uint8_t *strip) {
+		uint8_t * const rowPtrs[8] = {
+		    &strip[0 * bytesPerRow],
+		    &strip[1 * bytesPerRow],
+		    &strip[2 * bytesPerRow],
+		    &strip[3 * bytesPerRow],
+		    &strip[4 * bytesPerRow],
+		    &strip[5 * bytesPerRow],
+		    &strip[6 * bytesPerRow],
+		    &strip[7 * bytesPerRow],
+		};
 		for (size_t tx = 0; tx < width; ++tx) {
 			size_t index = options.columnMajor ? ty + tx * height : ty * width + tx;
 			// By default, a tile is unflipped, in bank 0, and uses palette #0
@@ -567,11 +570,37 @@ void reverse() {
 				}
 			}
 		}
-		// We never modify the pointers, and neither should libpng, despite the overly lax function
-		// signature.
-		// (AIUI, casting away const-ness is okay as long as you don't actually modify the
-		// pointed-to data)
-		png_write_rows(png, const_cast<png_bytepp>(rowPtrs), 8);
+	};
+
+	// Reconstruct tile rows in parallel, one band of strips at a time, feeding each band to
+	// libpng in order (PNG encoding itself is inherently sequential); the band keeps memory
+	// usage bounded no matter how tall the image is.
+	size_t const bandHeight =
+	    std::min<size_t>(height, std::thread::hardware_concurrency() < 2 ? 1 : 128);
+	std::vector<uint8_t> band(bandHeight * bytesPerStrip, 0xFF);
+	for (size_t bandStart = 0; bandStart < height; bandStart += bandHeight) {
+		size_t const bandRows = std::min(bandHeight, height - bandStart);
+		forEachParallel(bandRows, 8, [&](size_t i) {
+			renderStrip(bandStart + i, &band.data()[i * bytesPerStrip]);
+		});
+		for (size_t i = 0; i < bandRows; ++i) {
+			uint8_t *strip = &band.data()[i * bytesPerStrip];
+			uint8_t * const rowPtrs[8] = {
+			    &strip[0 * bytesPerRow],
+			    &strip[1 * bytesPerRow],
+			    &strip[2 * bytesPerRow],
+			    &strip[3 * bytesPerRow],
+			    &strip[4 * bytesPerRow],
+			    &strip[5 * bytesPerRow],
+			    &strip[6 * bytesPerRow],
+			    &strip[7 * bytesPerRow],
+			};
+			// We never modify the pointers, and neither should libpng, despite the overly lax
+			// function signature.
+			// (AIUI, casting away const-ness is okay as long as you don't actually modify the
+			// pointed-to data)
+			png_write_rows(png, const_cast<png_bytepp>(rowPtrs), 8);
+		}
 	}
 
 	// Finalize the write
@@ -57,6 +57,22 @@ uint16_t Rgba::cgbColor() const {
 	return r | g << 5 | b << 10;
 }
 
+void Rgba::cgbColorRow(Rgba const *pixels, uint16_t *colors, size_t count) {
+	if (options.useColorCurve) {
+		// The curve path is dominated by `pow`, so there is nothing to vectorize here
+		for (size_t i = 0; i < count; ++i) {
+			colors[i] = pixels[i].cgbColor();
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		Rgba const &pixel = pixels[i];
+		uint16_t color = pixel.red >> 3 | (pixel.green >> 3) << 5 | (pixel.blue >> 3) << 10;
+		colors[i] = pixel.isTransparent() ? transparent : color;
+	}
+}
+
 uint8_t Rgba::grayIndex() const {
 	assume(isGray());
 	// 2bpp shades are inverted from RGB PNG; %00 = white, %11 = black
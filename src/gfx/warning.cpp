@@ -48,13 +48,15 @@ void requireZeroErrors() {
 
 void error(char const *fmt, ...) {
 	va_list ap;
-	style_Set(stderr, STYLE_RED, true);
-	fputs("error: ", stderr);
-	style_Reset(stderr);
+	StyleSink sink(stderr);
+	sink.set(STYLE_RED, true);
+	sink.append("error: ");
+	sink.reset();
 	va_start(ap, fmt);
-	vfprintf(stderr, fmt, ap);
+	sink.vprintf(fmt, ap);
 	va_end(ap);
-	putc('\n', stderr);
+	sink.append('\n');
+	sink.flush();
 
 	warnings.incrementErrors();
 }
@@ -62,50 +64,46 @@ void error(char const *fmt, ...) {
 [[noreturn]]
 void fatal(char const *fmt, ...) {
 	va_list ap;
-	style_Set(stderr, STYLE_RED, true);
-	fputs("FATAL: ", stderr);
-	style_Reset(stderr);
+	StyleSink sink(stderr);
+	sink.set(STYLE_RED, true);
+	sink.append("FATAL: ");
+	sink.reset();
 	va_start(ap, fmt);
-	vfprintf(stderr, fmt, ap);
+	sink.vprintf(fmt, ap);
 	va_end(ap);
-	putc('\n', stderr);
+	sink.append('\n');
+	sink.flush();
 
 	warnings.incrementErrors();
 	giveUp();
 }
 
 void warning(WarningID id, char const *fmt, ...) {
+	// Check this first, so that disabled warnings cost nothing beyond this cached load;
+	// no formatting work happens for them
+	WarningBehavior behavior = warnings.getWarningBehavior(id);
+	if (behavior == WarningBehavior::DISABLED) {
+		return;
+	}
+
 	char const *flag = warnings.warningFlags[id].name;
+	bool isError = behavior == WarningBehavior::ERROR;
+	StyleColor color = isError ? STYLE_RED : STYLE_YELLOW;
 	va_list ap;
 
-	switch (warnings.getWarningBehavior(id)) {
-	case WarningBehavior::DISABLED:
-		break;
-
-	case WarningBehavior::ENABLED:
-		style_Set(stderr, STYLE_YELLOW, true);
-		fputs("warning: ", stderr);
-		style_Reset(stderr);
-		va_start(ap, fmt);
-		vfprintf(stderr, fmt, ap);
-		va_end(ap);
-		style_Set(stderr, STYLE_YELLOW, true);
-		fprintf(stderr, " [-W%s]\n", flag);
-		style_Reset(stderr);
-		break;
-
-	case WarningBehavior::ERROR:
-		style_Set(stderr, STYLE_RED, true);
-		fputs("error: ", stderr);
-		style_Reset(stderr);
-		va_start(ap, fmt);
-		vfprintf(stderr, fmt, ap);
-		va_end(ap);
-		style_Set(stderr, STYLE_RED, true);
-		fprintf(stderr, " [-Werror=%s]\n", flag);
-		style_Reset(stderr);
+	StyleSink sink(stderr);
+	sink.set(color, true);
+	sink.printf("%s: ", isError ? "error" : "warning");
+	sink.reset();
+	va_start(ap, fmt);
+	sink.vprintf(fmt, ap);
+	va_end(ap);
+	sink.set(color, true);
+	sink.printf(isError ? " [-Werror=%s]\n" : " [-W%s]\n", flag);
+	sink.reset();
+	sink.flush();
 
+	if (isError) {
 		warnings.incrementErrors();
-		break;
 	}
 }
@@ -2,6 +2,7 @@
 
 #include "link/assign.hpp"
 
+#include <algorithm>
 #include <deque>
 #include <inttypes.h>
 #include <optional>
@@ -17,8 +18,10 @@
 #include "linkdefs.hpp"
 #include "verbosity.hpp"
 
+#include "link/cache.hpp"
 #include "link/main.hpp"
 #include "link/output.hpp"
+#include "link/pool.hpp"
 #include "link/section.hpp"
 #include "link/symbol.hpp"
 #include "link/warning.hpp"
@@ -31,20 +34,88 @@ struct MemoryLocation {
 struct FreeSpace {
 	uint16_t address;
 	uint16_t size;
+
+	// Returns the first address at or after this block's start which satisfies the given
+	// alignment constraint; it may lie past the end of the block, or past $FFFF
+	uint32_t firstAlignedAddr(uint16_t alignMask, uint16_t alignOfs) const {
+		uint32_t addr = address;
+		if (uint32_t misalign = (addr - alignOfs) & alignMask; misalign) {
+			addr += alignMask + 1 - misalign;
+		}
+		return addr;
+	}
+};
+
+struct BankFreeSpace {
+	std::deque<FreeSpace> spaces;
+	// Size of the largest block in `spaces`, cached so that banks which cannot possibly fit
+	// a section are skipped without walking their fragment list
+	uint16_t maxFree;
+
+	void recomputeMaxFree() {
+		maxFree = 0;
+		for (FreeSpace const &space : spaces) {
+			if (space.size > maxFree) {
+				maxFree = space.size;
+			}
+		}
+	}
 };
 
 // Table of free space for each bank
-static std::vector<std::deque<FreeSpace>> memory[SECTTYPE_INVALID];
+static std::vector<BankFreeSpace> memory[SECTTYPE_INVALID];
+
+// Precomputed bank visit order for a scrambled region (`-S`): the scrambled range in descending
+// order, then any banks past it in ascending order. Each floating section starts searching at the
+// rotating cursor's bank and walks the rest of the order, so the sequence of banks probed is the
+// same as advancing one bank at a time, but exhausted banks are skipped in constant time.
+struct ScrambleOrder {
+	std::vector<uint32_t> banks;
+	size_t scrambleLen = 0; // Length of the descending (rotating) prefix of `banks`
+	size_t cursor = 0;      // Index into that prefix at which the next section starts searching
+};
+
+static ScrambleOrder scrambleOrder[SECTTYPE_INVALID];
+
+// Precompute the bank orders for whichever regions are being scrambled
+static void initScrambleOrder() {
+	auto init = [](SectionType type, uint32_t scrambleBanks) {
+		if (!scrambleBanks) {
+			return;
+		}
+		SectionTypeInfo const &typeInfo = sectionTypeInfo[type];
+		ScrambleOrder &order = scrambleOrder[type];
+		for (uint32_t bank = std::min(scrambleBanks, typeInfo.lastBank);; --bank) {
+			order.banks.push_back(bank);
+			if (bank == typeInfo.firstBank) {
+				break;
+			}
+		}
+		order.scrambleLen = order.banks.size();
+		for (uint32_t bank = scrambleBanks + 1; bank <= typeInfo.lastBank; ++bank) {
+			order.banks.push_back(bank);
+		}
+	};
+	init(SECTTYPE_ROMX, options.scrambleROMX);
+	init(SECTTYPE_WRAMX, options.scrambleWRAMX);
+	init(SECTTYPE_SRAM, options.scrambleSRAM);
+	// SRAM's rotation has always started at bank 0 before wrapping around to the top bank;
+	// keep that so scrambled layouts stay reproducible across versions
+	if (ScrambleOrder &order = scrambleOrder[SECTTYPE_SRAM]; order.scrambleLen != 0) {
+		order.cursor = order.scrambleLen - 1;
+	}
+}
 
 // Init the free space-modelling structs
 static void initFreeSpace() {
 	for (SectionType type : EnumSeq(SECTTYPE_INVALID)) {
 		memory[type].resize(sectTypeBanks(type));
-		for (std::deque<FreeSpace> &bankMem : memory[type]) {
-			bankMem.push_back({
+		for (BankFreeSpace &bankMem : memory[type]) {
+			bankMem.spaces.push_back({
 			    .address = sectionTypeInfo[type].startAddr,
 			    .size = sectionTypeInfo[type].size,
 			});
+			bankMem.maxFree = sectionTypeInfo[type].size;
 		}
 	}
 }
@@ -53,7 +124,7 @@ static void initFreeSpace() {
 static void assignSection(Section &section, MemoryLocation const &location) {
 	// Propagate the assigned location to all UNIONs/FRAGMENTs
 	// so `jr` patches in them will have the correct offset
-	for (Section *next = &section; next != nullptr; next = next->nextu.get()) {
+	for (Section *next = &section; next != nullptr; next = next->nextu) {
 		next->org = location.address;
 		next->bank = location.bank;
 	}
@@ -83,30 +154,15 @@ static bool isLocationSuitable(
 }
 
 static MemoryLocation getStartLocation(Section const &section) {
-	static uint16_t curScrambleROM = 0;
-	static uint8_t curScrambleWRAM = 0;
-	static int8_t curScrambleSRAM = 0;
-
 	MemoryLocation location;
 
 	// Determine which bank we should start searching in
 	if (section.isBankFixed) {
 		location.bank = section.bank;
-	} else if (options.scrambleROMX && section.type == SECTTYPE_ROMX) {
-		if (curScrambleROM < 1) {
-			curScrambleROM = options.scrambleROMX;
-		}
-		location.bank = curScrambleROM--;
-	} else if (options.scrambleWRAMX && section.type == SECTTYPE_WRAMX) {
-		if (curScrambleWRAM < 1) {
-			curScrambleWRAM = options.scrambleWRAMX;
-		}
-		location.bank = curScrambleWRAM--;
-	} else if (options.scrambleSRAM && section.type == SECTTYPE_SRAM) {
-		if (curScrambleSRAM < 0) {
-			curScrambleSRAM = options.scrambleSRAM;
-		}
-		location.bank = curScrambleSRAM--;
+	} else if (ScrambleOrder &order = scrambleOrder[section.type]; order.scrambleLen != 0) {
+		// Rotate through the scrambled range so consecutive sections start in different banks
+		location.bank = order.banks[order.cursor];
+		order.cursor = (order.cursor + 1) % order.scrambleLen;
 	} else {
 		location.bank = sectionTypeInfo[section.type].firstBank;
 	}
@@ -114,97 +170,157 @@ static MemoryLocation getStartLocation(Section const &section) {
 	return location;
 }
 
+// Scans one bank's free blocks for a suitable location for the given section, returning the
+// matching free space index into `memory[section->type][location.bank]`, or `std::nullopt`.
+static std::optional<size_t> getPlacementInBank(Section const &section, MemoryLocation &location) {
+	std::deque<FreeSpace> &spaces =
+	    memory[section.type][location.bank - sectionTypeInfo[section.type].firstBank].spaces;
+
+	// Process free blocks in that bank; they are sorted by ascending address, and each
+	// block's single candidate address is computed in closed form, so this does not probe
+	// alignment boundaries one by one
+	for (size_t spaceIdx = 0; spaceIdx < spaces.size(); ++spaceIdx) {
+		FreeSpace const &space = spaces[spaceIdx];
+
+		if (section.isAddressFixed) {
+			if (section.org < space.address) {
+				break; // Later blocks start even higher; try again in next bank
+			}
+			location.address = section.org;
+		} else if (section.isAlignFixed) {
+			// The first address in the block with the right alignment; if the section does
+			// not fit there, it cannot fit later in the block either
+			uint32_t address = space.firstAlignedAddr(section.alignMask, section.alignOfs);
+			if (address > UINT16_MAX) {
+				break; // Aligning up can only go higher in later blocks
+			}
+			location.address = address;
+		} else {
+			// Any location is fine, so, the block's start
+			location.address = space.address;
+		}
+
+		// If that location is OK, return it
+		if (isLocationSuitable(section, space, location)) {
+			return spaceIdx;
+		}
+	}
+
+	return std::nullopt;
+}
+
+// Returns whether a bank even has a free block large enough for the section; this check is what
+// keeps mostly-full multi-bank ROMs from being rescanned in vain for every floating section
+static bool bankMayFit(Section const &section, uint32_t bank) {
+	return section.size
+	       <= memory[section.type][bank - sectionTypeInfo[section.type].firstBank].maxFree;
+}
+
 // Returns a suitable free space index into `memory[section->type]` at which to place the given
 // section, or `std::nullopt` if none was found.
 static std::optional<size_t> getPlacement(Section const &section, MemoryLocation &location) {
 	SectionTypeInfo const &typeInfo = sectionTypeInfo[section.type];
 
-	// Switch to the beginning of the next bank
-	std::deque<FreeSpace> &bankMem = memory[section.type][location.bank - typeInfo.firstBank];
-	size_t spaceIdx = 0;
+	if (section.isBankFixed) {
+		return bankMayFit(section, location.bank) ? getPlacementInBank(section, location)
+		                                          : std::nullopt;
+	}
 
-	if (spaceIdx < bankMem.size()) {
-		location.address = bankMem[spaceIdx].address;
+	if (ScrambleOrder const &order = scrambleOrder[section.type]; order.scrambleLen != 0) {
+		// Walk the precomputed order from the starting bank onward: the rest of the scrambled
+		// range in descending order, then the banks past it in ascending order. Banks too full
+		// for the section are rejected by their cached `maxFree` without scanning their blocks.
+		for (size_t idx = order.banks[0] - location.bank; idx < order.banks.size(); ++idx) {
+			location.bank = order.banks[idx];
+			if (!bankMayFit(section, location.bank)) {
+				continue;
+			}
+			if (std::optional<size_t> spaceIdx = getPlacementInBank(section, location); spaceIdx) {
+				return spaceIdx;
+			}
+		}
+		return std::nullopt;
 	}
 
-	// Process locations in that bank
-	while (spaceIdx < bankMem.size()) {
-		// If that location is OK, return it
-		if (isLocationSuitable(section, bankMem[spaceIdx], location)) {
+	// Not scrambled: try each bank from the starting one upward
+	for (uint32_t bank = location.bank; bank <= typeInfo.lastBank; ++bank) {
+		location.bank = bank;
+		if (!bankMayFit(section, bank)) {
+			continue;
+		}
+		if (std::optional<size_t> spaceIdx = getPlacementInBank(section, location); spaceIdx) {
 			return spaceIdx;
 		}
+	}
+	return std::nullopt;
+}
 
-		// Go to the next *possible* location
-		if (section.isAddressFixed) {
-			// If the address is fixed, there can be only one candidate block per bank;
-			// if we already reached it, give up.
-			if (location.address < section.org) {
-				location.address = section.org;
-			} else {
-				break; // Try again in next bank
+// Returns the suitable free space index into `memory[section->type]` which leaves the fewest
+// bytes of its free block unused, and the matching location, or `std::nullopt` if the section
+// fits nowhere. Unlike `getPlacement`, this considers every bank, so scrambling's choice of a
+// starting bank does not influence the result.
+static std::optional<size_t> getBestPlacement(Section const &section, MemoryLocation &location) {
+	SectionTypeInfo const &typeInfo = sectionTypeInfo[section.type];
+	uint32_t firstBank = section.isBankFixed ? section.bank : typeInfo.firstBank;
+	uint32_t lastBank = section.isBankFixed ? section.bank : typeInfo.lastBank;
+	std::optional<size_t> bestIdx;
+	uint16_t bestLeftover = UINT16_MAX;
+
+	for (uint32_t bank = firstBank; bank <= lastBank; ++bank) {
+		BankFreeSpace &bankMem = memory[section.type][bank - typeInfo.firstBank];
+
+		if (section.size > bankMem.maxFree) {
+			continue;
+		}
+		for (size_t spaceIdx = 0; spaceIdx < bankMem.spaces.size(); ++spaceIdx) {
+			FreeSpace const &space = bankMem.spaces[spaceIdx];
+			uint32_t address = space.address;
+
+			if (section.isAddressFixed) {
+				if (section.org < space.address) {
+					continue;
+				}
+				address = section.org;
+			} else if (section.isAlignFixed) {
+				address = space.firstAlignedAddr(section.alignMask, section.alignOfs);
+			}
+			if (address + section.size > static_cast<uint32_t>(space.address) + space.size) {
+				continue;
+			}
+			// A leading alignment gap stays available to other sections, so only the bytes
+			// left between the section's end and the block's end count against this block
+			if (uint16_t leftover =
+			        static_cast<uint16_t>(space.address + space.size - (address + section.size));
+			    leftover < bestLeftover) {
+				bestLeftover = leftover;
+				bestIdx = spaceIdx;
+				location.address = address;
+				location.bank = bank;
 			}
-		} else if (section.isAlignFixed) {
-			// Move to next aligned location
-			// Move back to alignment boundary
-			location.address -= section.alignOfs;
-			// Ensure we're there (e.g. on first check)
-			location.address &= ~section.alignMask;
-			// Go to next align boundary and add offset
-			location.address += section.alignMask + 1 + section.alignOfs;
-		} else if (++spaceIdx < bankMem.size()) {
-			// Any location is fine, so, next free block
-			location.address = bankMem[spaceIdx].address;
 		}
+	}
+	return bestIdx;
+}
 
-		// If that location is past the current block's end,
-		// go forwards until that is no longer the case.
-		while (spaceIdx < bankMem.size()
-		       && location.address >= bankMem[spaceIdx].address + bankMem[spaceIdx].size) {
-			++spaceIdx;
-		}
+// Returns the free space index at which the location the previous link gave this section
+// is still available (`--placement-cache`), or `std::nullopt` to fall back to a search.
+static std::optional<size_t> getCachedPlacement(Section const &section, MemoryLocation &location) {
+	SectionTypeInfo const &typeInfo = sectionTypeInfo[section.type];
 
-		// Try again with the new location/free space combo
+	if (!cache_GetPlacement(section, location.bank, location.address)) {
+		return std::nullopt;
+	}
+	if (location.bank < typeInfo.firstBank || location.bank > typeInfo.lastBank) {
+		return std::nullopt; // The cache was written for a different memory layout
 	}
 
-	// Try again in the next bank, if one is available.
-	// Try scrambled banks in descending order until no bank in the scrambled range is
-	// available. Otherwise, try in ascending order.
-	if (section.isBankFixed) {
-		return std::nullopt;
-	} else if (options.scrambleROMX && section.type == SECTTYPE_ROMX
-	           && location.bank <= options.scrambleROMX) {
-		if (location.bank > typeInfo.firstBank) {
-			--location.bank;
-		} else if (options.scrambleROMX < typeInfo.lastBank) {
-			location.bank = options.scrambleROMX + 1;
-		} else {
-			return std::nullopt;
-		}
-	} else if (options.scrambleWRAMX && section.type == SECTTYPE_WRAMX
-	           && location.bank <= options.scrambleWRAMX) {
-		if (location.bank > typeInfo.firstBank) {
-			--location.bank;
-		} else if (options.scrambleWRAMX < typeInfo.lastBank) {
-			location.bank = options.scrambleWRAMX + 1;
-		} else {
-			return std::nullopt;
-		}
-	} else if (options.scrambleSRAM && section.type == SECTTYPE_SRAM
-	           && location.bank <= options.scrambleSRAM) {
-		if (location.bank > typeInfo.firstBank) {
-			--location.bank;
-		} else if (options.scrambleSRAM < typeInfo.lastBank) {
-			location.bank = options.scrambleSRAM + 1;
-		} else {
-			return std::nullopt;
+	std::deque<FreeSpace> &spaces = memory[section.type][location.bank - typeInfo.firstBank].spaces;
+	for (size_t spaceIdx = 0; spaceIdx < spaces.size(); ++spaceIdx) {
+		if (isLocationSuitable(section, spaces[spaceIdx], location)) {
+			return spaceIdx;
 		}
-	} else if (location.bank < typeInfo.lastBank) {
-		++location.bank;
-	} else {
-		return std::nullopt;
 	}
-
-	return getPlacement(section, location); // Tail recursion
+	return std::nullopt;
 }
 
 static std::string getSectionDescription(Section const &section) {
@@ -254,9 +370,46 @@ static std::string getSectionDescription(Section const &section) {
 	return where;
 }
 
-// Places a section in a suitable location, or error out if it fails to.
+// Reports why `section` could not be placed, and aborts the link. Assignment runs on the
+// worker pool, so this must only be called from the submitting thread, once the workers are
+// done; `exit`ing a worker while its siblings still mutate the free-space pools would not
+// be safe.
+[[noreturn]]
+static void reportUnplaceableSection(Section &section) {
+	if (!section.isBankFixed || !section.isAddressFixed) {
+		// If a section failed to go to several places, nothing we can report
+		fatal(
+		    "Unable to place \"%s\" (%s section) %s",
+		    section.name.c_str(),
+		    sectionTypeInfo[section.type].name.c_str(),
+		    getSectionDescription(section).c_str()
+		);
+	} else if (section.org + section.size > sectTypeEndAddr(section.type) + 1) {
+		// If the section just can't fit the bank, report that
+		fatal(
+		    "Unable to place \"%s\" (%s section) %s: section runs past end of region ($%04x > "
+		    "$%04x)",
+		    section.name.c_str(),
+		    sectionTypeInfo[section.type].name.c_str(),
+		    getSectionDescription(section).c_str(),
+		    section.org + section.size,
+		    sectTypeEndAddr(section.type) + 1
+		);
+	} else {
+		// Otherwise there is overlap with another section
+		fatal(
+		    "Unable to place \"%s\" (%s section) %s: section overlaps with \"%s\"",
+		    section.name.c_str(),
+		    sectionTypeInfo[section.type].name.c_str(),
+		    getSectionDescription(section).c_str(),
+		    out_OverlappingSection(section)->name.c_str()
+		);
+	}
+}
+
+// Places a section in a suitable location, returning whether it found one.
 // Due to the implemented algorithm, this should be called with sections of decreasing size!
-static void placeSection(Section &section) {
+static bool placeSection(Section &section) {
 	// Specially handle 0-byte SECTIONs, as they can't overlap anything
 	if (section.size == 0) {
 		// Unless the SECTION's address was fixed, the starting address
@@ -267,16 +420,24 @@ static void placeSection(Section &section) {
 		    .bank = section.isBankFixed ? section.bank : sectionTypeInfo[section.type].firstBank,
 		};
 		assignSection(section, location);
-		return;
+		return true;
 	}
 
-	// Place section using first-fit decreasing algorithm
+	// Reuse the previous link's placement if it is still valid, otherwise place the section
+	// using the first-fit decreasing algorithm
 	// https://en.wikipedia.org/wiki/Bin_packing_problem#First-fit_algorithm
-	MemoryLocation location = getStartLocation(section);
-	if (std::optional<size_t> spaceIdx = getPlacement(section, location); spaceIdx) {
-		std::deque<FreeSpace> &bankMem =
+	MemoryLocation location;
+	std::optional<size_t> spaceIdx = getCachedPlacement(section, location);
+	if (!spaceIdx) {
+		location = getStartLocation(section);
+		spaceIdx =
+		    options.bestFit ? getBestPlacement(section, location) : getPlacement(section, location);
+	}
+	if (spaceIdx) {
+		BankFreeSpace &bankMem =
 		    memory[section.type][location.bank - sectionTypeInfo[section.type].firstBank];
-		FreeSpace &freeSpace = bankMem[*spaceIdx];
+		std::deque<FreeSpace> &spaces = bankMem.spaces;
+		FreeSpace &freeSpace = spaces[*spaceIdx];
 
 		assignSection(section, location);
 
@@ -286,17 +447,17 @@ static void placeSection(Section &section) {
 		bool noRightSpace = freeSpace.address + freeSpace.size == sectionEnd;
 		if (noLeftSpace && noRightSpace) {
 			// The free space is entirely deleted
-			bankMem.erase(bankMem.begin() + *spaceIdx);
+			spaces.erase(spaces.begin() + *spaceIdx);
 		} else if (!noLeftSpace && !noRightSpace) {
 			// The free space is split in two
 			// Append the new space after the original one
 			uint16_t size = static_cast<uint16_t>(freeSpace.address + freeSpace.size - sectionEnd);
-			bankMem.insert(bankMem.begin() + *spaceIdx + 1, {.address = sectionEnd, .size = size});
-			// **`freeSpace` cannot be reused from this point on, because `bankMem.insert`
+			spaces.insert(spaces.begin() + *spaceIdx + 1, {.address = sectionEnd, .size = size});
+			// **`freeSpace` cannot be reused from this point on, because `spaces.insert`
 			// invalidates all references to itself!**
 
 			// Resize the original space (address is unmodified)
-			bankMem[*spaceIdx].size = section.org - bankMem[*spaceIdx].address;
+			spaces[*spaceIdx].size = section.org - spaces[*spaceIdx].address;
 		} else {
 			// The amount of free spaces doesn't change: resize!
 			freeSpace.size -= section.size;
@@ -305,41 +466,16 @@ static void placeSection(Section &section) {
 				freeSpace.address += section.size;
 			}
 		}
-		return;
+		bankMem.recomputeMaxFree();
+		return true;
 	}
 
-	if (!section.isBankFixed || !section.isAddressFixed) {
-		// If a section failed to go to several places, nothing we can report
-		fatal(
-		    "Unable to place \"%s\" (%s section) %s",
-		    section.name.c_str(),
-		    sectionTypeInfo[section.type].name.c_str(),
-		    getSectionDescription(section).c_str()
-		);
-	} else if (section.org + section.size > sectTypeEndAddr(section.type) + 1) {
-		// If the section just can't fit the bank, report that
-		fatal(
-		    "Unable to place \"%s\" (%s section) %s: section runs past end of region ($%04x > "
-		    "$%04x)",
-		    section.name.c_str(),
-		    sectionTypeInfo[section.type].name.c_str(),
-		    getSectionDescription(section).c_str(),
-		    section.org + section.size,
-		    sectTypeEndAddr(section.type) + 1
-		);
-	} else {
-		// Otherwise there is overlap with another section
-		fatal(
-		    "Unable to place \"%s\" (%s section) %s: section overlaps with \"%s\"",
-		    section.name.c_str(),
-		    sectionTypeInfo[section.type].name.c_str(),
-		    getSectionDescription(section).c_str(),
-		    out_OverlappingSection(section)->name.c_str()
-		);
-	}
+	return false;
 }
 
-static std::deque<Section *> unassignedSections[1 << 3];
+// Unassigned sections, partitioned by region so each can be assigned independently
+static std::deque<Section *> unassignedSections[SECTTYPE_INVALID][1 << 3];
+static uint64_t nbSectionsToAssign;
 // clang-format off: vertically align values
 static constexpr uint8_t BANK_CONSTRAINED  = 1 << 2;
 static constexpr uint8_t ORG_CONSTRAINED   = 1 << 1;
@@ -371,7 +507,7 @@ static void categorizeSection(Section &section) {
 		constraints |= ALIGN_CONSTRAINED;
 	}
 
-	std::deque<Section *> &sections = unassignedSections[constraints];
+	std::deque<Section *> &sections = unassignedSections[section.type][constraints];
 
 	// Insert section while keeping the list sorted by decreasing size
 	auto pos = sections.begin();
@@ -381,6 +517,29 @@ static void categorizeSection(Section &section) {
 	sections.insert(pos, &section);
 }
 
+// The first section each region failed to place, if any; written by that region's worker
+// and reported by the submitting thread after the barrier, so the diagnostics (and the
+// `exit`) happen with all workers parked
+static Section *unplaceableSections[SECTTYPE_INVALID];
+
+// Assigns one region's sections, in decreasing constraint order
+static void assignRegionSections(SectionType type) {
+	for (uint8_t constraints = std::size(unassignedSections[type]); constraints--;) {
+		if (!constraintNames[constraints]) {
+			assume(unassignedSections[type][constraints].empty());
+		}
+
+		for (Section *section : unassignedSections[type][constraints]) {
+			if (!placeSection(*section)) {
+				// The link is aborting; later sections would only pile further diagnostics
+				// onto a layout that is already dead
+				unplaceableSections[type] = section;
+				return;
+			}
+		}
+	}
+}
+
 static std::vector<Section const *> checkOverlayCompat() {
 	std::vector<Section const *> unfixedSections;
 
@@ -388,17 +547,18 @@ static std::vector<Section const *> checkOverlayCompat() {
 		return unfixedSections;
 	}
 
-	for (uint8_t constraints = std::size(unassignedSections); constraints--;) {
-		if (((constraints & BANK_CONSTRAINED) && (constraints & ORG_CONSTRAINED))
-		    || unassignedSections[constraints].empty()) {
+	for (uint8_t constraints = std::size(unassignedSections[0]); constraints--;) {
+		if ((constraints & BANK_CONSTRAINED) && (constraints & ORG_CONSTRAINED)) {
 			continue;
 		}
 
-		for (Section *section : unassignedSections[constraints]) {
-			unfixedSections.push_back(section);
+		for (SectionType type : EnumSeq(SECTTYPE_INVALID)) {
+			for (Section *section : unassignedSections[type][constraints]) {
+				unfixedSections.push_back(section);
 
-			if (unfixedSections.size() == 10) {
-				return unfixedSections;
+				if (unfixedSections.size() == 10) {
+					return unfixedSections;
+				}
 			}
 		}
 	}
@@ -406,20 +566,8 @@ static std::vector<Section const *> checkOverlayCompat() {
 	return unfixedSections;
 }
 
-void assign_AssignSections() {
-	verbosePrint(VERB_NOTICE, "Beginning assignment...\n");
-
-	// Initialize assignment
-	initFreeSpace();
-
-	// Generate linked lists of sections to assign
-	static uint64_t nbSectionsToAssign = 0; // `static` so `sect_ForEach` callback can see it
-	sect_ForEach([](Section &section) {
-		categorizeSection(section);
-		++nbSectionsToAssign;
-	});
-
-	// Overlaying requires only fully-constrained sections
+// Overlaying requires only fully-constrained sections
+static void requireOverlayCompat() {
 	if (std::vector<Section const *> unfixedSections = checkOverlayCompat();
 	    !unfixedSections.empty()) {
 		size_t nbUnfixedSections = unfixedSections.size();
@@ -441,24 +589,59 @@ void assign_AssignSections() {
 		    unfixedList.c_str()
 		);
 	}
+}
 
-	// Assign sections in decreasing constraint order
-	for (uint8_t constraints = std::size(unassignedSections); constraints--;) {
-		if (char const *constraintName = constraintNames[constraints]; constraintName) {
-			verbosePrint(VERB_INFO, "Assigning %sconstrained sections...\n", constraintName);
-		} else {
-			assume(unassignedSections[constraints].empty());
+// The free-space pools, and everything else `placeSection` touches, are independent
+// between regions, so all regions are assigned concurrently; within each region,
+// sections are still placed in decreasing constraint order, then decreasing size, so
+// every region's layout is the same as with a sequential assignment.
+static void assignAllRegions() {
+	pool_ForEach(SECTTYPE_INVALID, [](size_t type) {
+		verbosePrint(VERB_INFO, "Assigning %s sections...\n", sectionTypeInfo[type].name.c_str());
+		assignRegionSections(static_cast<SectionType>(type));
+	});
+
+	for (SectionType type : EnumSeq(SECTTYPE_INVALID)) {
+		if (unplaceableSections[type]) {
+			reportUnplaceableSection(*unplaceableSections[type]);
 		}
+	}
+}
+
+void assign_AssignSections() {
+	verbosePrint(VERB_NOTICE, "Beginning assignment...\n");
 
-		for (Section *section : unassignedSections[constraints]) {
-			placeSection(*section);
+	// Initialize assignment
+	initFreeSpace();
+	initScrambleOrder();
 
-			// If all sections were fully constrained, we have nothing left to do
-			if (!--nbSectionsToAssign) {
-				return;
-			}
+	// Generate linked lists of sections to assign
+	nbSectionsToAssign = 0;
+	sect_ForEach([](Section &section) {
+		categorizeSection(section);
+		++nbSectionsToAssign;
+	});
+
+	requireOverlayCompat();
+	assignAllRegions();
+}
+
+void assign_AssignExtraSections(size_t firstSectIdx) {
+	verbosePrint(VERB_NOTICE, "Assigning profile sections...\n");
+
+	// The free space left by the shared assignment, and the scramble rotation, carry over;
+	// only the profile's own sections are categorized and placed
+	for (auto &regionLists : unassignedSections) {
+		for (std::deque<Section *> &list : regionLists) {
+			list.clear();
 		}
 	}
+	nbSectionsToAssign = 0;
+	for (size_t i = firstSectIdx, nbSections = sect_CountSections(); i < nbSections; ++i) {
+		categorizeSection(sect_GetNthSection(i));
+		++nbSectionsToAssign;
+	}
 
-	assume(nbSectionsToAssign == 0);
+	requireOverlayCompat();
+	assignAllRegions();
 }
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: MIT
+
+#include "link/cache.hpp"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+#include "helpers.hpp" // Defer
+#include "linkdefs.hpp"
+#include "verbosity.hpp"
+
+#include "link/main.hpp"
+#include "link/section.hpp"
+#include "link/warning.hpp"
+
+struct CachedPlacement {
+	// The constraints the section had when the cache was written; its location is only
+	// reused if they still match, so a stale entry merely degrades to a normal placement
+	SectionType type;
+	uint16_t size;
+	bool isAddressFixed;
+	uint16_t org;
+	bool isBankFixed;
+	uint32_t bank;
+	bool isAlignFixed;
+	uint16_t alignMask;
+	uint16_t alignOfs;
+	// Where the previous link placed the section
+	uint32_t placedBank;
+	uint16_t placedOrg;
+};
+
+static std::unordered_map<std::string, CachedPlacement> cachedPlacements;
+
+static constexpr uint8_t ADDRESS_FIXED = 1 << 0;
+static constexpr uint8_t BANK_FIXED = 1 << 1;
+static constexpr uint8_t ALIGN_FIXED = 1 << 2;
+
+// FNV-1a over every option that can influence placement; cached locations are only valid
+// for the configuration that produced them
+static uint64_t optionsKey() {
+	uint16_t config[] = {
+	    options.isDmgMode,
+	    options.is32kMode,
+	    options.isWRAM0Mode,
+	    options.bestFit,
+	    options.gcSections,
+	    options.scrambleROMX,
+	    options.scrambleWRAMX,
+	    options.scrambleSRAM,
+	};
+	uint64_t hash = 0xCBF29CE484222325;
+	for (uint16_t value : config) {
+		hash = (hash ^ value) * 0x100000001B3;
+	}
+	return hash;
+}
+
+static char const cacheHeader[] = "; rgblink placement cache\n";
+
+void cache_ReadPlacements() {
+	FILE *file = fopen(options.placementCacheName, "r");
+	if (!file) {
+		// A missing cache is not an error; this is how the first link of a project goes
+		verbosePrint(
+		    VERB_NOTICE, "No placement cache at %s, placing from scratch\n",
+		    options.placementCacheName
+		);
+		return;
+	}
+	Defer closeFile{[&] { fclose(file); }};
+
+	char line[4096];
+	if (!fgets(line, sizeof(line), file) || strcmp(line, cacheHeader) != 0) {
+		warnx("Ignoring placement cache \"%s\": bad header", options.placementCacheName);
+		return;
+	}
+	if (uint64_t key; !fgets(line, sizeof(line), file)
+	                  || sscanf(line, "%" SCNx64, &key) != 1 || key != optionsKey()) {
+		verbosePrint(
+		    VERB_NOTICE, "Ignoring placement cache %s: options changed\n",
+		    options.placementCacheName
+		);
+		return;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		unsigned int type, size, flags, org, bank, alignMask, alignOfs, placedBank, placedOrg;
+		int nameOfs;
+		if (sscanf(
+		        line, "%x %x %x %x %x %x %x %x %x %n", &type, &size, &flags, &org, &bank,
+		        &alignMask, &alignOfs, &placedBank, &placedOrg, &nameOfs
+		    ) != 9
+		    || type >= SECTTYPE_INVALID) {
+			warnx("Ignoring placement cache \"%s\": bad entry", options.placementCacheName);
+			cachedPlacements.clear();
+			return;
+		}
+
+		char const *name = line + nameOfs;
+		size_t nameLen = strlen(name);
+		if (nameLen && name[nameLen - 1] == '\n') {
+			--nameLen;
+		}
+		cachedPlacements.emplace(
+		    std::string(name, nameLen),
+		    CachedPlacement{
+		        .type = static_cast<SectionType>(type),
+		        .size = static_cast<uint16_t>(size),
+		        .isAddressFixed = (flags & ADDRESS_FIXED) != 0,
+		        .org = static_cast<uint16_t>(org),
+		        .isBankFixed = (flags & BANK_FIXED) != 0,
+		        .bank = bank,
+		        .isAlignFixed = (flags & ALIGN_FIXED) != 0,
+		        .alignMask = static_cast<uint16_t>(alignMask),
+		        .alignOfs = static_cast<uint16_t>(alignOfs),
+		        .placedBank = placedBank,
+		        .placedOrg = static_cast<uint16_t>(placedOrg),
+		    }
+		);
+	}
+
+	verbosePrint(
+	    VERB_INFO, "Read %zu cached placements from %s\n", cachedPlacements.size(),
+	    options.placementCacheName
+	);
+}
+
+bool cache_GetPlacement(Section const &section, uint32_t &bank, uint16_t &org) {
+	auto search = cachedPlacements.find(section.name);
+	if (search == cachedPlacements.end()) {
+		return false;
+	}
+
+	CachedPlacement const &cached = search->second;
+	if (cached.type != section.type || cached.size != section.size
+	    || cached.isAddressFixed != section.isAddressFixed
+	    || (section.isAddressFixed && cached.org != section.org)
+	    || cached.isBankFixed != section.isBankFixed
+	    || (section.isBankFixed && cached.bank != section.bank)
+	    || cached.isAlignFixed != section.isAlignFixed
+	    || (section.isAlignFixed
+	        && (cached.alignMask != section.alignMask || cached.alignOfs != section.alignOfs))) {
+		return false;
+	}
+
+	bank = cached.placedBank;
+	org = cached.placedOrg;
+	return true;
+}
+
+static FILE *cacheFile; // `static` so the `sect_ForEach` callback below can reach it
+
+void cache_WritePlacements() {
+	cacheFile = fopen(options.placementCacheName, "w");
+	if (!cacheFile) {
+		warnx(
+		    "Failed to write placement cache \"%s\": %s", options.placementCacheName,
+		    strerror(errno)
+		);
+		return;
+	}
+
+	fputs(cacheHeader, cacheFile);
+	fprintf(cacheFile, "%016" PRIx64 "\n", optionsKey());
+	sect_ForEach([](Section &section) {
+		// The entry format keeps the name last, up to the end of the line, so names
+		// containing newlines cannot round-trip; such sections just get placed normally
+		if (section.name.find('\n') != std::string::npos
+		    || section.name.find('\r') != std::string::npos) {
+			return;
+		}
+
+		// Assignment only overwrote `org` and `bank` where they were not fixed, so the
+		// section still carries its original constraints alongside its placement
+		uint8_t flags = (section.isAddressFixed ? ADDRESS_FIXED : 0)
+		                | (section.isBankFixed ? BANK_FIXED : 0)
+		                | (section.isAlignFixed ? ALIGN_FIXED : 0);
+		fprintf(
+		    cacheFile, "%x %x %x %x %x %x %x %x %x %s\n", section.type, section.size, flags,
+		    section.isAddressFixed ? section.org : 0, section.isBankFixed ? section.bank : 0,
+		    section.isAlignFixed ? section.alignMask : 0,
+		    section.isAlignFixed ? section.alignOfs : 0, section.bank, section.org,
+		    section.name.c_str()
+		);
+	});
+	fclose(cacheFile);
+}
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MIT
+
+#include "embed.hpp"
+
+#include <stdint.h>
+
+#include "linkdefs.hpp"
+
+#include "link/assign.hpp"
+#include "link/main.hpp"
+#include "link/object.hpp"
+#include "link/output.hpp"
+#include "link/patch.hpp"
+#include "link/section.hpp"
+#include "link/warning.hpp"
+
+// Defined here rather than in `main.cpp` so `librgblink`, which omits the CLI entry point,
+// still links
+Options options;
+
+int rgblink_link(
+    RGBDSObjectBuffer const *objects, size_t nbObjects, unsigned char **rom, size_t *romSize
+) {
+	return embed_RunWorker(
+	    [&] {
+		    // Patch the size array the same way `main` does when `-t`/`-w`/`-d` are not passed
+		    if (!options.is32kMode) {
+			    sectionTypeInfo[SECTTYPE_ROM0].size = 0x4000;
+		    }
+		    if (!options.isWRAM0Mode) {
+			    sectionTypeInfo[SECTTYPE_WRAM0].size = 0x1000;
+		    }
+		    if (options.isDmgMode) {
+			    sectionTypeInfo[SECTTYPE_VRAM].lastBank = 0;
+		    }
+
+		    options.outputFileName = "-"; // The worker's stdout is the capture pipe
+
+		    // Read all object files first (same file ID numbering as `obj_ReadFiles`),
+		    obj_Setup(nbObjects);
+		    for (size_t i = 0; i < nbObjects; ++i) {
+			    obj_ReadBuffer(
+			        objects[i].name,
+			        objects[i].data,
+			        objects[i].size,
+			        static_cast<unsigned int>(nbObjects - 1 - i)
+			    );
+		    }
+
+		    // then process them,
+		    sect_DoSanityChecks();
+		    requireZeroErrors();
+		    assign_AssignSections();
+		    patch_CheckAssertions();
+
+		    // and finally output the result.
+		    patch_ApplyPatches();
+		    requireZeroErrors();
+		    out_WriteFiles();
+	    },
+	    rom,
+	    romSize
+	);
+}
@@ -11,6 +11,7 @@
 #include "helpers.hpp"
 #include "linkdefs.hpp"
 
+#include "link/plan.hpp"
 #include "link/section.hpp"
 #include "link/warning.hpp"
 
@@ -31,6 +32,7 @@ static void setActiveTypeAndIdx(SectionType type, uint32_t idx) {
 }
 
 void layout_SetFloatingSectionType(SectionType type) {
+	plan_RecordCommand('F', type);
 	if (sectTypeBanks(type) == 1) {
 		// There is only a single bank anyway, so just set the index to 0.
 		setActiveTypeAndIdx(type, 0);
@@ -46,6 +48,7 @@ void layout_SetFloatingSectionType(SectionType type) {
 }
 
 void layout_SetSectionType(SectionType type) {
+	plan_RecordCommand('T', type);
 	if (sectTypeBanks(type) != 1) {
 		scriptError("A bank number must be specified for %s", sectionTypeInfo[type].name.c_str());
 		// Keep going with a default value for the bank index.
@@ -55,6 +58,8 @@ void layout_SetSectionType(SectionType type) {
 }
 
 void layout_SetSectionType(SectionType type, uint32_t bank) {
+	plan_RecordCommand('B', type, bank);
+
 	SectionTypeInfo const &typeInfo = sectionTypeInfo[type];
 
 	if (bank < typeInfo.firstBank) {
@@ -78,6 +83,7 @@ void layout_SetSectionType(SectionType type, uint32_t bank) {
 }
 
 void layout_SetAddr(uint32_t addr) {
+	plan_RecordCommand('O', addr);
 	if (activeType == SECTTYPE_INVALID) {
 		scriptError("Cannot set the current address: no memory region is active");
 		return;
@@ -107,6 +113,7 @@ void layout_SetAddr(uint32_t addr) {
 }
 
 void layout_MakeAddrFloating() {
+	plan_RecordCommand('f');
 	if (activeType == SECTTYPE_INVALID) {
 		scriptError("Cannot make the current address floating: no memory region is active");
 		return;
@@ -118,6 +125,7 @@ void layout_MakeAddrFloating() {
 }
 
 void layout_AlignTo(uint32_t alignment, uint32_t alignOfs) {
+	plan_RecordCommand('A', alignment, alignOfs);
 	if (activeType == SECTTYPE_INVALID) {
 		scriptError("Cannot align: no memory region is active");
 		return;
@@ -188,6 +196,7 @@ void layout_AlignTo(uint32_t alignment, uint32_t alignOfs) {
 }
 
 void layout_Pad(uint32_t length) {
+	plan_RecordCommand('P', length);
 	if (activeType == SECTTYPE_INVALID) {
 		scriptError("Cannot increase the current address: no memory region is active");
 		return;
@@ -215,6 +224,7 @@ void layout_Pad(uint32_t length) {
 }
 
 void layout_PlaceSection(std::string const &name, bool isOptional) {
+	plan_RecordPlace(name, isOptional);
 	if (activeType == SECTTYPE_INVALID) {
 		scriptError("No memory region has been specified to place section \"%s\" in", name.c_str());
 		return;
@@ -250,7 +260,7 @@ void layout_PlaceSection(std::string const &name, bool isOptional) {
 		} else {
 			// SDCC areas don't have a type assigned yet, so the linker script is used to give them
 			// one.
-			for (Section *fragment = section; fragment; fragment = fragment->nextu.get()) {
+			for (Section *fragment = section; fragment; fragment = fragment->nextu) {
 				fragment->type = activeType;
 			}
 		}
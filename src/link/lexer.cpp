@@ -3,8 +3,6 @@
 #include "link/lexer.hpp"
 
 #include <errno.h>
-#include <fstream>
-#include <ios>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -17,16 +15,56 @@
 #include "linkdefs.hpp"
 #include "util.hpp"
 
+#include "link/plan.hpp"
 #include "link/warning.hpp"
 // Include this last so it gets all type & constant definitions
 #include "script.hpp" // For token definitions, generated from script.y
 
 struct LexerStackEntry {
-	std::filebuf file;
+	// The script is read into memory in one go and tokenized in place, instead of pulling
+	// one character at a time through a stream
+	std::vector<char> contents;
+	size_t offset;
 	std::string path;
 	uint32_t lineNo;
 
-	explicit LexerStackEntry(std::string &&path_) : file(), path(path_), lineNo(1) {}
+	explicit LexerStackEntry(std::string &&path_) : contents(), offset(0), path(path_), lineNo(1) {}
+
+	// Slurps the whole file; returns whether it could be opened
+	bool open() {
+		FILE *file = fopen(path.c_str(), "r");
+		if (!file) {
+			return false;
+		}
+		for (char chunk[65536];;) {
+			size_t n = fread(chunk, 1, sizeof(chunk), file);
+			contents.insert(contents.end(), chunk, chunk + n);
+			if (n < sizeof(chunk)) {
+				break;
+			}
+		}
+		bool ok = !ferror(file);
+		fclose(file);
+		return ok;
+	}
+
+	// These mimic `std::filebuf`'s reading interface over the in-memory contents
+	int sgetc() const {
+		return offset < contents.size() ? static_cast<uint8_t>(contents[offset]) : EOF;
+	}
+	int sbumpc() {
+		int c = sgetc();
+		if (c != EOF) {
+			++offset;
+		}
+		return c;
+	}
+	int snextc() {
+		if (offset < contents.size()) {
+			++offset;
+		}
+		return sgetc();
+	}
 };
 
 static std::vector<LexerStackEntry> lexerStack;
@@ -45,7 +83,7 @@ void lexer_IncludeFile(std::string &&path) {
 	LexerStackEntry &newContext = lexerStack.emplace_back(std::move(path));
 	LexerStackEntry &prevContext = lexerStack[lexerStack.size() - 2];
 
-	if (!newContext.file.open(newContext.path, std::ios_base::in)) {
+	if (!newContext.open()) {
 		// `.pop_back()` will invalidate `newContext`, which is why `path` must be moved first.
 		std::string badPath = std::move(newContext.path);
 		lexerStack.pop_back();
@@ -53,6 +91,8 @@ void lexer_IncludeFile(std::string &&path) {
 		scriptError(
 		    "Failed to open included linker script \"%s\": %s", badPath.c_str(), strerror(errno)
 		);
+	} else {
+		plan_RecordFile(newContext.path);
 	}
 
 	// `.pop_back()` cannot invalidate an unpopped reference, so `prevContext`
@@ -89,7 +129,7 @@ static std::string readKeyword(int c) {
 	LexerStackEntry &context = lexerStack.back();
 	std::string keyword;
 	keyword.push_back(c);
-	for (c = context.file.sgetc(); isAlphanumeric(c); c = context.file.snextc()) {
+	for (c = context.sgetc(); isAlphanumeric(c); c = context.snextc()) {
 		keyword.push_back(c);
 	}
 	return keyword;
@@ -98,11 +138,11 @@ static std::string readKeyword(int c) {
 static yy::parser::symbol_type parseDecNumber(int c) {
 	LexerStackEntry &context = lexerStack.back();
 	uint32_t number = c - '0';
-	for (c = context.file.sgetc(); isDigit(c) || c == '_'; c = context.file.sgetc()) {
+	for (c = context.sgetc(); isDigit(c) || c == '_'; c = context.sgetc()) {
 		if (c != '_') {
 			number = number * 10 + (c - '0');
 		}
-		context.file.sbumpc();
+		context.sbumpc();
 	}
 	return yy::parser::make_number(number);
 }
@@ -113,38 +153,38 @@ static bool isBinDigit(int c) {
 
 static yy::parser::symbol_type parseBinNumber(char const *prefix) {
 	LexerStackEntry &context = lexerStack.back();
-	int c = context.file.sgetc();
+	int c = context.sgetc();
 	if (!isBinDigit(c)) {
 		scriptError("No binary digits found after %s", prefix);
 		return yy::parser::make_number(0);
 	}
 
 	uint32_t number = c - '0';
-	context.file.sbumpc();
-	for (c = context.file.sgetc(); isBinDigit(c) || c == '_'; c = context.file.sgetc()) {
+	context.sbumpc();
+	for (c = context.sgetc(); isBinDigit(c) || c == '_'; c = context.sgetc()) {
 		if (c != '_') {
 			number = number * 2 + (c - '0');
 		}
-		context.file.sbumpc();
+		context.sbumpc();
 	}
 	return yy::parser::make_number(number);
 }
 
 static yy::parser::symbol_type parseOctNumber(char const *prefix) {
 	LexerStackEntry &context = lexerStack.back();
-	int c = context.file.sgetc();
+	int c = context.sgetc();
 	if (!isOctDigit(c)) {
 		scriptError("No octal digits found after %s", prefix);
 		return yy::parser::make_number(0);
 	}
 
 	uint32_t number = c - '0';
-	context.file.sbumpc();
-	for (c = context.file.sgetc(); isOctDigit(c) || c == '_'; c = context.file.sgetc()) {
+	context.sbumpc();
+	for (c = context.sgetc(); isOctDigit(c) || c == '_'; c = context.sgetc()) {
 		if (c != '_') {
 			number = number * 8 + (c - '0');
 		}
-		context.file.sbumpc();
+		context.sbumpc();
 	}
 	return yy::parser::make_number(number);
 }
@@ -163,19 +203,19 @@ static uint8_t parseHexDigit(int c) {
 
 static yy::parser::symbol_type parseHexNumber(char const *prefix) {
 	LexerStackEntry &context = lexerStack.back();
-	int c = context.file.sgetc();
+	int c = context.sgetc();
 	if (!isHexDigit(c)) {
 		scriptError("No hexadecimal digits found after %s", prefix);
 		return yy::parser::make_number(0);
 	}
 
 	uint32_t number = parseHexDigit(c);
-	context.file.sbumpc();
-	for (c = context.file.sgetc(); isHexDigit(c) || c == '_'; c = context.file.sgetc()) {
+	context.sbumpc();
+	for (c = context.sgetc(); isHexDigit(c) || c == '_'; c = context.sgetc()) {
 		if (c != '_') {
 			number = number * 16 + parseHexDigit(c);
 		}
-		context.file.sbumpc();
+		context.sbumpc();
 	}
 	return yy::parser::make_number(number);
 }
@@ -183,24 +223,24 @@ static yy::parser::symbol_type parseHexNumber(char const *prefix) {
 static yy::parser::symbol_type parseNumber(int c) {
 	LexerStackEntry &context = lexerStack.back();
 	if (c == '0') {
-		switch (context.file.sgetc()) {
+		switch (context.sgetc()) {
 		case 'x':
-			context.file.sbumpc();
+			context.sbumpc();
 			return parseHexNumber("\"0x\"");
 		case 'X':
-			context.file.sbumpc();
+			context.sbumpc();
 			return parseHexNumber("\"0X\"");
 		case 'o':
-			context.file.sbumpc();
+			context.sbumpc();
 			return parseOctNumber("\"0o\"");
 		case 'O':
-			context.file.sbumpc();
+			context.sbumpc();
 			return parseOctNumber("\"0O\"");
 		case 'b':
-			context.file.sbumpc();
+			context.sbumpc();
 			return parseBinNumber("\"0b\"");
 		case 'B':
-			context.file.sbumpc();
+			context.sbumpc();
 			return parseBinNumber("\"0B");
 		}
 	}
@@ -209,16 +249,16 @@ static yy::parser::symbol_type parseNumber(int c) {
 
 static yy::parser::symbol_type parseString() {
 	LexerStackEntry &context = lexerStack.back();
-	int c = context.file.sgetc();
+	int c = context.sgetc();
 	std::string str;
-	for (; c != '"'; c = context.file.sgetc()) {
+	for (; c != '"'; c = context.sgetc()) {
 		if (c == EOF || isNewline(c)) {
 			scriptError("Unterminated string");
 			break;
 		}
-		context.file.sbumpc();
+		context.sbumpc();
 		if (c == '\\') {
-			c = context.file.sgetc();
+			c = context.sgetc();
 			if (c == EOF || isNewline(c)) {
 				scriptError("Unterminated string");
 				break;
@@ -233,28 +273,28 @@ static yy::parser::symbol_type parseString() {
 			} else if (c != '\\' && c != '"' && c != '\'') {
 				scriptError("Cannot escape character %s", printChar(c));
 			}
-			context.file.sbumpc();
+			context.sbumpc();
 		}
 		str.push_back(c);
 	}
 	if (c == '"') {
-		context.file.sbumpc();
+		context.sbumpc();
 	}
 	return yy::parser::make_string(std::move(str));
 }
 
 yy::parser::symbol_type yylex() {
 	LexerStackEntry &context = lexerStack.back();
-	int c = context.file.sbumpc();
+	int c = context.sbumpc();
 
 	// First, skip leading blank space.
 	while (isBlankSpace(c)) {
-		c = context.file.sbumpc();
+		c = context.sbumpc();
 	}
 	// Then, skip a comment if applicable.
 	if (c == ';') {
 		while (c != EOF && !isNewline(c)) {
-			c = context.file.sbumpc();
+			c = context.sbumpc();
 		}
 	}
 
@@ -265,8 +305,8 @@ yy::parser::symbol_type yylex() {
 		return yy::parser::make_COMMA();
 	} else if (isNewline(c)) {
 		// Handle CRLF.
-		if (c == '\r' && context.file.sgetc() == '\n') {
-			context.file.sbumpc();
+		if (c == '\r' && context.sgetc() == '\n') {
+			context.sbumpc();
 		}
 		return yy::parser::make_newline();
 	} else if (c == '"') {
@@ -313,11 +353,11 @@ yy::parser::symbol_type yylex() {
 	} else {
 		scriptError("Unexpected character %s", printChar(c));
 		// Keep reading characters until the EOL, to avoid reporting too many errors.
-		for (c = context.file.sgetc(); !isNewline(c); c = context.file.sgetc()) {
+		for (c = context.sgetc(); !isNewline(c); c = context.sgetc()) {
 			if (c == EOF) {
 				break;
 			}
-			context.file.sbumpc();
+			context.sbumpc();
 		}
 		return yylex();
 	}
@@ -326,10 +366,11 @@ yy::parser::symbol_type yylex() {
 
 bool lexer_Init(char const *linkerScriptName) {
 	if (LexerStackEntry &newContext = lexerStack.emplace_back(std::string(linkerScriptName));
-	    !newContext.file.open(newContext.path, std::ios_base::in)) {
+	    !newContext.open()) {
 		error("Failed to open linker script \"%s\"", linkerScriptName);
 		lexerStack.clear();
 		return false;
 	}
+	plan_RecordFile(lexerStack.back().path);
 	return true;
 }
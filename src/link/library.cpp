@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: MIT
+
+#include "link/library.hpp"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "helpers.hpp" // literal_strlen
+#include "platform.hpp"
+#include "verbosity.hpp"
+
+#include "link/object.hpp"
+#include "link/symbol.hpp"
+#include "link/warning.hpp"
+
+// Library archives (.lib, as created by `sdar`) are `!<arch>` ar files whose members are
+// SDCC objects. Members are only parsed as objects on demand: registration scans each
+// member's 'S' lines to map every defined symbol to the member defining it, and
+// `lib_ResolveSymbols` then loads just the members that resolve otherwise-undefined
+// imports, iterating since a loaded member may import symbols of its own.
+
+static char const arMagic[] = "!<arch>\n";
+
+struct ArchiveMember {
+	std::string name;
+	uint8_t const *data; // Points into the owning archive's image
+	size_t size;
+	bool loaded = false;
+};
+
+struct Archive {
+	char const *fileName;
+	std::vector<char> image; // Keeps the members (and the indexed names) alive
+	std::vector<ArchiveMember> members;
+};
+
+static std::vector<Archive> archives;
+
+struct MemberRef {
+	size_t archiveID;
+	size_t memberID;
+};
+// Which member defines each symbol; the first definition wins, like `sdld` searching
+// archives in command-line order
+static std::unordered_map<std::string_view, MemberRef> memberIndex;
+
+bool lib_IsArchive(uint8_t const *data, size_t size) {
+	return size >= sizeof(arMagic) - 1 && memcmp(data, arMagic, sizeof(arMagic) - 1) == 0;
+}
+
+// Records which symbols a member defines, by scanning its text for `S <name> Def...` lines
+// the way the SDCC reader would tokenize them (but without mutating the shared image, since
+// the member may still get parsed for real later)
+static void indexMember(size_t archiveID, size_t memberID) {
+	static char const *delim = " \f\n\r\t\v"; // Whitespace according to the C and POSIX locales
+	ArchiveMember const &member = archives[archiveID].members[memberID];
+	std::string_view text(reinterpret_cast<char const *>(member.data), member.size);
+
+	for (size_t pos = 0; pos < text.size();) {
+		size_t eol = text.find('\n', pos);
+		std::string_view line = text.substr(pos, eol == text.npos ? text.npos : eol - pos);
+		pos = eol == text.npos ? text.size() : eol + 1;
+
+		if (line.empty() || line[0] != 'S') {
+			continue;
+		}
+		size_t nameStart = line.find_first_not_of(delim, 1);
+		if (nameStart == 1 || nameStart == line.npos) { // 'S' must be the whole first token
+			continue;
+		}
+		size_t nameEnd = line.find_first_of(delim, nameStart);
+		size_t valueStart = line.find_first_not_of(delim, nameEnd);
+		// Expected format: /[DR]ef[0-9A-F]+/i; only definitions are indexed
+		if (valueStart == line.npos
+		    || strncasecmp(&line[valueStart], "Def", literal_strlen("Def")) != 0) {
+			continue;
+		}
+		memberIndex.try_emplace(
+		    line.substr(nameStart, nameEnd - nameStart), MemberRef{archiveID, memberID}
+		);
+	}
+}
+
+// Parses a decimal field of an archive member header (digits padded with trailing spaces)
+static size_t parseArField(Archive const &archive, char const *field, size_t width) {
+	size_t value = 0;
+	size_t i = 0;
+	for (; i < width && field[i] >= '0' && field[i] <= '9'; ++i) {
+		value = value * 10 + (field[i] - '0');
+	}
+	for (; i < width; ++i) {
+		if (field[i] != ' ') {
+			fatal("%s: Malformed archive member header", archive.fileName);
+		}
+	}
+	return value;
+}
+
+void lib_RegisterArchive(char const *fileName) {
+	Archive &archive = archives.emplace_back();
+	archive.fileName = fileName;
+
+	FILE *file = fopen(fileName, "rb");
+	if (!file) {
+		// LCOV_EXCL_START
+		fatal("Failed to open file \"%s\": %s", fileName, strerror(errno));
+		// LCOV_EXCL_STOP
+	}
+	Defer closeFile{[&] { fclose(file); }};
+	for (uint8_t chunk[65536];;) {
+		size_t n = fread(chunk, 1, sizeof(chunk), file);
+		archive.image.insert(archive.image.end(), chunk, chunk + n);
+		if (n < sizeof(chunk)) {
+			break;
+		}
+	}
+	if (!lib_IsArchive(reinterpret_cast<uint8_t const *>(archive.image.data()), archive.image.size())) {
+		fatal("%s: Not a library archive", fileName);
+	}
+
+	std::string_view longNames; // The `//` member, holding names too long for the header
+	for (size_t offset = literal_strlen(arMagic); offset < archive.image.size();) {
+		// Each member is a 60-byte header (name, metadata, and size, all in text form),
+		// then the data, padded to an even offset
+		if (offset + 60 > archive.image.size()) {
+			fatal("%s: Truncated archive member header", fileName);
+		}
+		char const *header = &archive.image[offset];
+		if (header[58] != '`' || header[59] != '\n') {
+			fatal("%s: Malformed archive member header", fileName);
+		}
+		size_t size = parseArField(archive, &header[48], 10);
+		offset += 60;
+		if (offset + size > archive.image.size()) {
+			fatal("%s: Truncated archive member", fileName);
+		}
+		std::string_view name(header, 16);
+		name = name.substr(0, name.find_last_not_of(' ') + 1);
+
+		if (name == "//") {
+			// The long name table; `/<offset>` member names point into it
+			longNames = std::string_view(&archive.image[offset], size);
+		} else if (name != "/" && name != "/SYM64/") {
+			// (`/` is the `ranlib` symbol index; it is not always present nor up to date,
+			// so the members' own symbol lines are indexed instead)
+			if (name.length() > 1 && name[0] == '/') {
+				size_t nameOfs = parseArField(archive, &name[1], name.length() - 1);
+				if (nameOfs >= longNames.length()) {
+					fatal("%s: Invalid long member name offset %zu", fileName, nameOfs);
+				}
+				name = longNames.substr(nameOfs);
+				name = name.substr(0, name.find_first_of("/\n"));
+			} else if (name.length() > 1 && name.back() == '/') {
+				name.remove_suffix(1); // Regular names are `/`-terminated
+			}
+			archive.members.push_back({
+			    .name = std::string(name),
+			    .data = reinterpret_cast<uint8_t const *>(&archive.image[offset]),
+			    .size = size,
+			});
+			// Members that are not SDCC objects (the first byte of those is their integer
+			// format, 'X', 'D', or 'Q') define no symbols this can see, and are never loaded
+			if (size > 0 && strchr("XDQ;", archive.image[offset])) {
+				indexMember(archives.size() - 1, archive.members.size() - 1);
+			}
+		}
+		offset += size + (size & 1); // Members are padded to even offsets
+	}
+	verbosePrint(
+	    VERB_INFO,
+	    "Indexed library \"%s\": %zu members, %zu symbols total\n",
+	    fileName,
+	    archive.members.size(),
+	    memberIndex.size()
+	);
+}
+
+void lib_ResolveSymbols() {
+	if (archives.empty()) {
+		return;
+	}
+	// Loading a member appends its own imports to the list being walked, so this loop runs
+	// until a fixpoint where every import is either defined or in no archive
+	for (size_t i = 0; i < sym_CountImports(); ++i) {
+		Symbol const &import = sym_GetNthImport(i);
+		if (sym_GetSymbol(import.name)) {
+			continue; // Defined by a regular object or an already-loaded member
+		}
+		auto search = memberIndex.find(std::string_view(import.name));
+		if (search == memberIndex.end()) {
+			continue; // Still undefined; reported when the referencing patch is applied
+		}
+		auto [archiveID, memberID] = search->second;
+		ArchiveMember &member = archives[archiveID].members[memberID];
+		if (member.loaded) {
+			continue;
+		}
+		member.loaded = true;
+
+		std::string name(archives[archiveID].fileName);
+		name.append("(").append(member.name).append(")");
+		verbosePrint(VERB_NOTICE, "Loading library member \"%s\"\n", name.c_str());
+		obj_ReadLibraryMember(name.c_str(), member.data, member.size);
+	}
+}
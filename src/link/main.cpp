@@ -2,6 +2,7 @@
 
 #include "link/main.hpp"
 
+#include <errno.h>
 #include <inttypes.h>
 #include <limits.h>
 #include <stdarg.h>
@@ -9,12 +10,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef _MSC_VER
+	#include <sys/wait.h>
+	#include <unistd.h>
+#endif
 #include <utility>
+#include <vector>
 
 #include "backtrace.hpp"
 #include "diagnostics.hpp"
 #include "extern/getopt.hpp"
 #include "linkdefs.hpp"
+#include "memstats.hpp"
 #include "script.hpp" // Generated from script.y
 #include "style.hpp"
 #include "usage.hpp"
@@ -23,19 +30,33 @@
 #include "version.hpp"
 
 #include "link/assign.hpp"
+#include "link/cache.hpp"
 #include "link/lexer.hpp"
 #include "link/object.hpp"
 #include "link/output.hpp"
 #include "link/patch.hpp"
+#include "link/plan.hpp"
+#include "link/pool.hpp"
 #include "link/section.hpp"
+#include "link/symbol.hpp"
 #include "link/warning.hpp"
 
-Options options;
+// `options` is defined in `embed.cpp`, so `librgblink` can omit this file's `main`
 
 static char const *linkerScriptName = nullptr; // -l
 
+// One output profile (`--profile`): the shared objects' placement is reused, the profile's
+// own objects are overlaid on top, and the result is written to the profile's outputs
+struct OutputProfile {
+	char const *outputFileName = nullptr; // o=
+	char const *mapFileName = nullptr;    // m=
+	char const *symFileName = nullptr;    // n=
+	std::vector<char const *> objectFileNames;
+};
+static std::vector<OutputProfile> profiles;
+
 // Short options
-static char const *optstring = "B:dhl:m:Mn:O:o:p:S:tVvW:wx";
+static char const *optstring = "B:bdghl:m:Mn:O:o:p:S:tVvW:wx";
 
 // Variables for the long-only options
 static int longOpt; // `--color`
@@ -49,7 +70,9 @@ static int longOpt; // `--color`
 // over short opt matching.
 static option const longopts[] = {
     {"backtrace",     required_argument, nullptr,  'B'},
+    {"best-fit",      no_argument,       nullptr,  'b'},
     {"dmg",           no_argument,       nullptr,  'd'},
+    {"gc-sections",   no_argument,       nullptr,  'g'},
     {"help",          no_argument,       nullptr,  'h'},
     {"linkerscript",  required_argument, nullptr,  'l'},
     {"map",           required_argument, nullptr,  'm'},
@@ -65,7 +88,14 @@ static option const longopts[] = {
     {"warning",       required_argument, nullptr,  'W'},
     {"wramx",         no_argument,       nullptr,  'w'},
     {"nopad",         no_argument,       nullptr,  'x'},
-    {"color",         required_argument, &longOpt, 'c'},
+    {"color",           required_argument, &longOpt, 'c'},
+    {"dedup-diagnostics", no_argument,     &longOpt, 'e'},
+    {"layout-plan",     required_argument, &longOpt, 'Y'},
+    {"map-format",      required_argument, &longOpt, 'f'},
+    {"mem-stats",       no_argument,       &longOpt, 'm'},
+    {"placement-cache", required_argument, &longOpt, 'P'},
+    {"profile",         required_argument, &longOpt, 'r'},
+    {"threads",         required_argument, &longOpt, 'j'},
     {nullptr,         no_argument,       nullptr,  0  },
 };
 
@@ -73,10 +103,12 @@ static option const longopts[] = {
 static Usage usage = {
     .name = "rgblink",
     .flags = {
-        "[-dhMtVvwx]", "[-B depth]", "[-l script]", "[-m map_file]", "[-n sym_file]",
+        "[-bdghMtVvwx]", "[-B depth]", "[-l script]", "[-m map_file]", "[-n sym_file]",
         "[-O overlay_file]", "[-o out_file]", "[-p pad_value]", "[-S spec]", "<file> ...",
     },
     .options = {
+        {{"-b", "--best-fit"}, {"pack floating sections with best-fit instead of first-fit"}},
+        {{"-g", "--gc-sections"}, {"prune sections not reachable from a fixed-address section"}},
         {{"-l", "--linkerscript <path>"}, {"set the input linker script"}},
         {{"-m", "--map <path>"}, {"set the output map file"}},
         {{"-n", "--sym <path>"}, {"set the output symbol list file"}},
@@ -106,6 +138,14 @@ static void verboseOutputConfig(int argc, char *argv[]) {
 	if (options.isDmgMode) {
 		fputs("\tDMG mode prohibits non-DMG section types\n", stderr);
 	}
+	// -b/--best-fit
+	if (options.bestFit) {
+		fputs("\tBest-fit placement of floating sections\n", stderr);
+	}
+	// -g/--gc-sections
+	if (options.gcSections) {
+		fputs("\tPruning of unreferenced sections\n", stderr);
+	}
 	// -t/--tiny
 	if (options.is32kMode) {
 		fputs("\tROM0 covers the full 32 KiB of ROM\n", stderr);
@@ -168,12 +208,20 @@ static void verboseOutputConfig(int argc, char *argv[]) {
 	printPath("Output ROM file", options.outputFileName);
 	// -m/--map
 	printPath("Output map file", options.mapFileName);
+	// --map-format
+	if (options.mapFileName && options.binaryMapFormat) {
+		fputs("\tBinary map file format\n", stderr);
+	}
 	// -M/--no-sym-in-map
 	if (options.mapFileName && options.noSymInMap) {
 		fputs("\tNo symbols in map file\n", stderr);
 	}
 	// -n/--sym
 	printPath("Output sym file", options.symFileName);
+	// --placement-cache
+	printPath("Placement cache file", options.placementCacheName);
+	// --layout-plan
+	printPath("Layout plan file", options.layoutPlanName);
 	fputs("Ready.\n", stderr);
 
 	style_Reset(stderr);
@@ -294,6 +342,128 @@ static void parseScrambleSpec(char *spec) {
 	}
 }
 
+// The argument to `--profile` is a comma-separated list: `o=`, `m=`, and `n=` items name
+// the profile's output ROM, map, and sym files, and every other item is an object file to
+// link into this profile on top of the shared objects.
+static void parseProfileSpec(char *spec) {
+	OutputProfile &profile = profiles.emplace_back();
+
+	while (*spec) {
+		char *item = spec + skipBlankSpace(spec);
+		size_t itemLen = strcspn(item, ",");
+		spec = item + itemLen;
+		if (*spec == ',') {
+			++spec;
+		}
+		// Trim trailing blank space, then terminate the item.
+		while (itemLen > 0 && (item[itemLen - 1] == ' ' || item[itemLen - 1] == '\t')) {
+			--itemLen;
+		}
+		item[itemLen] = '\0';
+
+		if (itemLen == 0) {
+			continue; // Allow a trailing (or doubled) comma
+		}
+		if (itemLen >= 2 && item[1] == '=') {
+			char const *path = item + 2;
+			char const **dest;
+			switch (item[0]) {
+			case 'o':
+				dest = &profile.outputFileName;
+				break;
+			case 'm':
+				dest = &profile.mapFileName;
+				break;
+			case 'n':
+				dest = &profile.symFileName;
+				break;
+			default:
+				fatal("Unknown output \"%c=\" in spec for option '--profile'", item[0]);
+			}
+			if (*path == '\0') {
+				fatal("Empty \"%c=\" path in spec for option '--profile'", item[0]);
+			}
+			if (*dest) {
+				warnx("Overriding \"%c=\" path in spec for option '--profile'", item[0]);
+			}
+			*dest = path;
+		} else {
+			profile.objectFileNames.push_back(item);
+		}
+	}
+
+	if (!profile.outputFileName && !profile.mapFileName && !profile.symFileName) {
+		fatal(
+		    "Spec for option '--profile' must name at least one output (\"o=\", \"m=\", or"
+		    " \"n=\")"
+		);
+	}
+}
+
+#ifndef _MSC_VER
+// Links one profile on top of the inherited shared link: its objects are read and placed in
+// the free space left over, only they get sanity-checked, assigned, and patched, and the
+// combined result is written to the profile's outputs.
+[[noreturn]]
+static void linkProfile(OutputProfile const &profile) {
+	options.outputFileName = profile.outputFileName;
+	options.mapFileName = profile.mapFileName;
+	options.symFileName = profile.symFileName;
+
+	if (!profile.objectFileNames.empty()) {
+		size_t firstSectIdx = sect_CountSections();
+		obj_ReadExtraFiles(profile.objectFileNames);
+		sect_DoSanityChecks(firstSectIdx);
+		requireZeroErrors();
+		assign_AssignExtraSections(firstSectIdx);
+	}
+	// Patches (and assertions) may reference the profile's symbols even from shared
+	// sections, so all of the patching happens here rather than in the shared link
+	patch_CheckAssertions();
+	patch_ApplyPatches();
+	requireZeroErrors();
+	out_WriteFiles();
+	exit(0);
+}
+#endif
+
+// Writes every profile's outputs, forking one child per profile so each inherits the shared
+// objects' placement and patch results without redoing them, and so one profile's sections
+// and symbols never leak into another's.
+static void linkProfiles() {
+#ifndef _MSC_VER
+	sect_SealSharedSections();
+
+	size_t nbFailed = 0;
+	for (OutputProfile const &profile : profiles) {
+		fflush(nullptr); // Avoid duplicating buffered output into the child
+
+		pid_t pid = fork();
+		if (pid < 0) {
+			fatal("Failed to fork: %s", strerror(errno)); // LCOV_EXCL_LINE
+		}
+		if (pid == 0) {
+			linkProfile(profile);
+		}
+
+		int status;
+		if (waitpid(pid, &status, 0) < 0) {
+			fatal("Failed to wait for child process: %s", strerror(errno)); // LCOV_EXCL_LINE
+		}
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			++nbFailed;
+		}
+	}
+	if (nbFailed != 0) {
+		fatal("Failed to link %zu of %zu profiles", nbFailed, profiles.size());
+	}
+#else
+	// LCOV_EXCL_START
+	fatal("Option '--profile' is not supported on this platform");
+	// LCOV_EXCL_STOP
+#endif
+}
+
 int main(int argc, char *argv[]) {
 	// Parse CLI options
 	for (int ch; (ch = musl_getopt_long_only(argc, argv, optstring, longopts, nullptr)) != -1;) {
@@ -304,11 +474,19 @@ int main(int argc, char *argv[]) {
 			}
 			break;
 
+		case 'b':
+			options.bestFit = true;
+			break;
+
 		case 'd':
 			options.isDmgMode = true;
 			options.isWRAM0Mode = true;
 			break;
 
+		case 'g':
+			options.gcSections = true;
+			break;
+
 			// LCOV_EXCL_START
 		case 'h':
 			usage.printAndExit(0);
@@ -404,6 +582,44 @@ int main(int argc, char *argv[]) {
 		case 0: // Long-only options
 			if (longOpt == 'c' && !style_Parse(musl_optarg)) {
 				fatal("Invalid argument for option '--color'");
+			} else if (longOpt == 'e') {
+				options.dedupDiagnostics = true;
+			} else if (longOpt == 'f') {
+				if (!strcmp(musl_optarg, "text")) {
+					options.binaryMapFormat = false;
+				} else if (!strcmp(musl_optarg, "binary")) {
+					options.binaryMapFormat = true;
+				} else {
+					fatal(
+					    "Invalid argument for option '--map-format' (expected \"text\" or"
+					    " \"binary\")"
+					);
+				}
+			} else if (longOpt == 'm') {
+				mem_EnableStats();
+			} else if (longOpt == 'P') {
+				if (options.placementCacheName) {
+					warnx("Overriding placement cache file \"%s\"", options.placementCacheName);
+				}
+				options.placementCacheName = musl_optarg;
+			} else if (longOpt == 'r') {
+				parseProfileSpec(musl_optarg);
+			} else if (longOpt == 'j') {
+				char *endptr;
+				unsigned long value = strtoul(musl_optarg, &endptr, 0);
+
+				if (musl_optarg[0] == '\0' || *endptr != '\0') {
+					fatal("Invalid argument for option '--threads'");
+				}
+				if (value == 0) {
+					fatal("Argument for option '--threads' must be at least 1");
+				}
+				pool_SetNbThreads(value);
+			} else if (longOpt == 'Y') {
+				if (options.layoutPlanName) {
+					warnx("Overriding layout plan file \"%s\"", options.layoutPlanName);
+				}
+				options.layoutPlanName = musl_optarg;
 			}
 			break;
 
@@ -418,6 +634,18 @@ int main(int argc, char *argv[]) {
 		usage.printAndExit("No input file specified (pass \"-\" to read from standard input)");
 	}
 
+	if (options.layoutPlanName && !linkerScriptName) {
+		fatal("Option '--layout-plan' requires a linker script ('-l')");
+	}
+
+	if (!profiles.empty()
+	    && (options.outputFileName || options.mapFileName || options.symFileName)) {
+		fatal(
+		    "Options '-o', '-m', and '-n' are incompatible with '--profile'; name each"
+		    " profile's outputs in its spec"
+		);
+	}
+
 	// Patch the size array depending on command-line options
 	if (!options.is32kMode) {
 		sectionTypeInfo[SECTTYPE_ROM0].size = 0x4000;
@@ -433,33 +661,63 @@ int main(int argc, char *argv[]) {
 
 	// Read all object files first,
 	obj_Setup(argc - musl_optind);
-	for (int i = musl_optind; i < argc; ++i) {
-		obj_ReadFile(argv[i], argc - i - 1);
-	}
+	obj_ReadFiles(std::vector<char const *>(&argv[musl_optind], &argv[argc]));
 
 	// apply the linker script's modifications,
 	if (linkerScriptName) {
-		verbosePrint(VERB_NOTICE, "Reading linker script...\n");
+		// A valid layout plan replays the script's layout commands without parsing it
+		bool replayed = options.layoutPlanName && plan_TryReplay(linkerScriptName);
+		if (!replayed) {
+			verbosePrint(VERB_NOTICE, "Reading linker script...\n");
 
-		if (lexer_Init(linkerScriptName)) {
-			yy::parser parser;
-			// We don't care about the return value, as any error increments the global error count,
-			// which is what `main` checks.
-			(void)parser.parse();
+			if (options.layoutPlanName) {
+				plan_StartRecording();
+			}
+			if (lexer_Init(linkerScriptName)) {
+				yy::parser parser;
+				// We don't care about the return value, as any error increments the global error
+				// count, which is what `main` checks.
+				(void)parser.parse();
+			}
 		}
 
 		// If the linker script produced any errors, some sections may be in an invalid state
 		requireZeroErrors();
+		if (!replayed && options.layoutPlanName) {
+			plan_Write();
+		}
 	}
 
 	// then process them,
 	sect_DoSanityChecks();
 	requireZeroErrors();
+	if (options.gcSections) {
+		patch_PruneSections();
+	}
+	if (options.placementCacheName) {
+		cache_ReadPlacements();
+	}
 	assign_AssignSections();
-	patch_CheckAssertions();
+	if (options.placementCacheName) {
+		cache_WritePlacements();
+	}
 
-	// and finally output the result.
-	patch_ApplyPatches();
-	requireZeroErrors();
-	out_WriteFiles();
+	// and finally patch and output the result; with profiles, both happen per profile, since
+	// even shared sections' patches and assertions may reference a profile's symbols
+	if (profiles.empty()) {
+		patch_CheckAssertions();
+		patch_ApplyPatches();
+		requireZeroErrors();
+		out_WriteFiles();
+	} else {
+		linkProfiles();
+	}
+
+	mem_ReportStats({
+	    {"Sections",           sect_CountSections()       },
+	    {"Symbols",            sym_CountSymbols()         },
+	    {"Patches",            sect_CountPatches()        },
+	    {"Section data bytes", sect_CountDataBytes()      },
+	    {"RPN buffer reuses",  obj_CountRPNBufferReuses()},
+	});
 }
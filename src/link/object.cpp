@@ -7,23 +7,35 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <setjmp.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "arena.hpp"
+#include "file.hpp"
 #include "helpers.hpp"
 #include "linkdefs.hpp"
+#include "lz4.hpp"
 #include "platform.hpp"
+#include "util.hpp" // fnv1a64
 #include "verbosity.hpp"
 #include "version.hpp"
 
 #include "link/fstack.hpp"
+#include "link/library.hpp"
+#include "link/main.hpp"
 #include "link/patch.hpp"
+#include "link/pool.hpp"
 #include "link/sdas_obj.hpp"
 #include "link/section.hpp"
 #include "link/symbol.hpp"
@@ -32,82 +44,226 @@
 static std::deque<std::vector<Symbol>> symbolLists;
 static std::vector<std::vector<FileStackNode>> nodes;
 
-// Helper functions for reading object files
+// Intern pool for RPN payloads, hashed and compared by content (FNV-1a); patches from any
+// object file that carry byte-identical expressions share one copy
+struct RPNPayloadHash {
+	size_t operator()(std::shared_ptr<RPNPayload const> const &payload) const {
+		uint64_t hash = 0xCBF29CE484222325;
+		for (uint32_t i = 0; i < payload->size; ++i) {
+			hash = (hash ^ payload->bytes[i]) * 0x100000001B3;
+		}
+		return hash;
+	}
+};
+struct RPNPayloadEq {
+	bool operator()(
+	    std::shared_ptr<RPNPayload const> const &lhs, std::shared_ptr<RPNPayload const> const &rhs
+	) const {
+		return lhs->size == rhs->size && memcmp(lhs->bytes, rhs->bytes, lhs->size) == 0;
+	}
+};
+static std::unordered_set<std::shared_ptr<RPNPayload const>, RPNPayloadHash, RPNPayloadEq> rpnPool;
+// Staging buffers for RPN payloads; duplicates dropped by interning are recycled into the
+// next patch read instead of being freed
+static RecyclePool<std::vector<uint8_t>> rpnBufferPool;
+static std::mutex rpnPoolMutex; // Object files are parsed concurrently; guards both pools
+
+std::vector<uint8_t> obj_AcquireRPNBuffer() {
+	std::lock_guard lock(rpnPoolMutex);
+	return rpnBufferPool.acquire();
+}
+
+uint64_t obj_CountRPNBufferReuses() {
+	std::lock_guard lock(rpnPoolMutex);
+	return rpnBufferPool.nbReused();
+}
+
+std::shared_ptr<RPNPayload const> obj_InternRPN(std::vector<uint8_t> &&rpnExpression) {
+	std::lock_guard lock(rpnPoolMutex);
+	auto storage = std::make_shared<std::vector<uint8_t>>(std::move(rpnExpression));
+	auto entry = std::make_shared<RPNPayload const>(RPNPayload{
+	    .owner = storage,
+	    .bytes = storage->data(),
+	    .size = static_cast<uint32_t>(storage->size()),
+	});
+	auto [it, inserted] = rpnPool.insert(entry);
+	if (!inserted) {
+		// The duplicate's buffer can serve a later `obj_AcquireRPNBuffer`
+		storage->clear();
+		rpnBufferPool.recycle(std::move(*storage));
+	}
+	return *it;
+}
 
-// For internal use only by `tryReadLong` and `tryGetc`!
-#define tryRead(func, type, errval, vartype, var, file, ...) \
-	do { \
-		FILE *tmpFile = file; \
-		type tmpVal = func(tmpFile); \
-		if (tmpVal == (errval)) { \
-			fatal(__VA_ARGS__, feof(tmpFile) ? "Unexpected end of file" : strerror(errno)); \
-		} \
-		var = static_cast<vartype>(tmpVal); \
-	} while (0)
-
-// Reads an unsigned long (32-bit) value from a file, or `INT64_MAX` on failure.
-static int64_t readLong(FILE *file) {
-	uint32_t value = 0;
-
-	// Read the little-endian value byte by byte
-	for (uint8_t shift = 0; shift < sizeof(value) * CHAR_BIT; shift += 8) {
-		int byte = getc(file);
-
-		if (byte == EOF) {
-			return INT64_MAX;
-		}
-		// This must be casted to `unsigned`, not `uint8_t`. Rationale:
-		// the type of the shift is the type of `byte` after undergoing
-		// integer promotion, which would be `int` if this was casted to
-		// `uint8_t`, because int is large enough to hold a byte. This
-		// however causes values larger than 127 to be too large when
-		// shifted, potentially triggering undefined behavior.
-		value |= static_cast<unsigned int>(byte) << shift;
-	}
-	return value;
+std::shared_ptr<RPNPayload const>
+    obj_AdoptRPN(uint8_t const *data, uint32_t size, std::shared_ptr<void> owner) {
+	std::lock_guard lock(rpnPoolMutex);
+	auto entry = std::make_shared<RPNPayload const>(RPNPayload{
+	    .owner = std::move(owner),
+	    .bytes = data,
+	    .size = size,
+	});
+	// A duplicate simply drops the borrowed view, releasing nothing
+	return *rpnPool.insert(entry).first;
 }
 
-// Helper macro to read a long from a file to a var, or error out if it fails to.
-#define tryReadLong(var, file, ...) \
-	tryRead(readLong, int64_t, INT64_MAX, long, var, file, __VA_ARGS__)
-
-// Helper macro to read a byte from a file to a var, or error out if it fails to.
-#define tryGetc(type, var, file, ...) tryRead(getc, int, EOF, type, var, file, __VA_ARGS__)
-
-// Helper macro to read a '\0'-terminated string from a file, or error out if it fails to.
-#define tryReadString(var, file, ...) \
-	do { \
-		FILE *tmpFile = file; \
-		std::string &tmpVal = var; \
-		for (int tmpByte; (tmpByte = getc(tmpFile)) != '\0';) { \
-			if (tmpByte == EOF) { \
-				fatal(__VA_ARGS__, feof(tmpFile) ? "Unexpected end of file" : strerror(errno)); \
-			} else { \
-				tmpVal.push_back(tmpByte); \
-			} \
-		} \
-	} while (0)
+struct ObjFileBuf;
+
+// The v2 string table, validated once so names can be referenced by offset afterwards.
+struct ObjStringTable {
+	char const *strings;
+	uint32_t size;
+	char const *fileName;
+
+	ObjStringTable(ObjFileBuf const &file, uint32_t ofs, uint32_t size_);
+
+	char const *get(uint32_t ofs) const {
+		if (ofs >= size) {
+			fatal("%s: Name offset %" PRIu32 " is outside the string table", fileName, ofs);
+		}
+		return &strings[ofs];
+	}
+
+	// Each name's precomputed 64-bit hash immediately precedes its characters
+	uint64_t getHash(uint32_t ofs) const {
+		if (ofs < 8 || ofs >= size) {
+			fatal("%s: Name offset %" PRIu32 " has no hash in the string table", fileName, ofs);
+		}
+		uint64_t hash = 0;
+		for (int i = 0; i < 8; ++i) {
+			hash |= static_cast<uint64_t>(static_cast<uint8_t>(strings[ofs - 8 + i])) << (i * 8);
+		}
+		return hash;
+	}
+};
+
+// Symbol records that the v2 reader skipped over: most local symbols are never referenced by
+// any patch, so only their export level is parsed up front, and a record is only re-read from
+// the (kept-alive) file image if a patch turns out to need the symbol.
+struct LazySymbolTable {
+	std::shared_ptr<void> owner; // Keeps the object file image alive
+	uint8_t const *image;
+	ObjStringTable strTab;
+	std::vector<FileStackNode> *fileNodes;
+	std::vector<Symbol> *fileSymbols = nullptr;   // Set at registration time
+	std::vector<Section> *fileSections = nullptr; // Set at registration time
+	// File offset of each deferred symbol record; `UINT32_MAX` if read eagerly or materialized
+	std::vector<uint32_t> recordOfs;
+};
+
+// Per-file staging area: object files are parsed into these (possibly concurrently), then
+// registered into the global tables in command-line order so results are deterministic.
+struct StagedObjFile {
+	char const *fileName;
+	unsigned int fileID;
+	// SDCC objects and stdin are handled sequentially by `obj_ReadFile` at merge time
+	bool deferred = false;
+	std::vector<Symbol> symbols;
+	std::vector<Section> sections;
+	std::vector<Assertion> assertions;
+	std::optional<LazySymbolTable> lazySymbols;
+};
+
+// Registered files' deferred symbol records, looked up by their symbol lists' addresses
+// (which is how patches refer to the file they came from)
+static std::unordered_map<std::vector<Symbol> const *, LazySymbolTable> lazySymbolTables;
+
+// Helper functions for reading object files
+
+// Cursor over an in-memory object file — memory-mapped when possible, otherwise slurped into
+// memory up front — so records are decoded with pointer arithmetic and per-record bounds
+// checks instead of per-byte stdio calls.
+struct ObjFileBuf {
+	MappedFile file; // Keeps a mapping alive (unused when the file was slurped)
+	std::shared_ptr<std::vector<uint8_t>> buf; // Fallback storage for non-mappable inputs
+	FileCursor cursor;
+	char const *fileName;
+
+	[[noreturn]] void truncated() const {
+		fatal("%s: Unexpected end of file", fileName);
+	}
+
+	uint8_t const *data() const { return cursor.data(); }
+	size_t size() const { return cursor.size(); }
+
+	// Shares ownership of the backing image, so adopted views outlive this buffer;
+	// null for externally-owned buffers (`obj_ReadBuffer`), whose caller keeps them alive
+	std::shared_ptr<void> owner() const {
+		return buf ? std::shared_ptr<void>(buf) : std::shared_ptr<void>(file.share());
+	}
+
+	// Returns a pointer to the next `nbBytes` bytes and skips past them, without copying
+	uint8_t const *getView(size_t nbBytes) {
+		uint8_t const *view = &cursor.data()[cursor.tell()];
+		if (!cursor.seek(cursor.tell() + nbBytes)) {
+			truncated();
+		}
+		return view;
+	}
+
+	void seek(uint32_t ofs) {
+		if (!cursor.seek(ofs)) {
+			truncated();
+		}
+	}
+
+	uint8_t getByte() {
+		std::optional<uint8_t> value = cursor.getByte();
+		if (!value) {
+			truncated();
+		}
+		return *value;
+	}
+
+	uint32_t getLong() {
+		std::optional<uint32_t> value = cursor.getLong();
+		if (!value) {
+			truncated();
+		}
+		return *value;
+	}
+
+	void getData(void *dest, size_t size) {
+		if (!cursor.getData(dest, size)) {
+			truncated();
+		}
+	}
+
+	void getString(std::string &dest) {
+		if (!cursor.getString(dest)) {
+			truncated();
+		}
+	}
+};
+
+// Slurps the whole of `file` into `obj.buf`.
+static void slurpFile(ObjFileBuf &obj, FILE *file) {
+	obj.buf = std::make_shared<std::vector<uint8_t>>();
+	for (uint8_t chunk[65536];;) {
+		size_t n = fread(chunk, 1, sizeof(chunk), file);
+		obj.buf->insert(obj.buf->end(), chunk, chunk + n);
+		if (n < sizeof(chunk)) {
+			break;
+		}
+	}
+	if (ferror(file)) {
+		fatal("%s: Failed to read file: %s", obj.fileName, strerror(errno));
+	}
+	obj.cursor = FileCursor(obj.buf->data(), obj.buf->size());
+}
 
 // Functions to parse object files
 
 // Reads a file stack node from a file.
-static void readFileStackNode(
-    FILE *file, std::vector<FileStackNode> &fileNodes, uint32_t nodeID, char const *fileName
-) {
+static void
+    readFileStackNode(ObjFileBuf &obj, std::vector<FileStackNode> &fileNodes, uint32_t nodeID) {
 	FileStackNode &node = fileNodes[nodeID];
 
-	uint32_t parentID;
-	tryReadLong(
-	    parentID, file, "%s: Cannot read node #%" PRIu32 "'s parent ID: %s", fileName, nodeID
-	);
+	uint32_t parentID = obj.getLong();
 	node.parent = parentID != UINT32_MAX ? &fileNodes[parentID] : nullptr;
+	node.lineNo = obj.getLong();
 
-	tryReadLong(
-	    node.lineNo, file, "%s: Cannot read node #%" PRIu32 "'s line number: %s", fileName, nodeID
-	);
-
-	uint8_t type;
-	tryGetc(uint8_t, type, file, "%s: Cannot read node #%" PRIu32 "'s type: %s", fileName, nodeID);
+	uint8_t type = obj.getByte();
 	node.type = static_cast<FileStackNodeType>(type & ~(1 << FSTACKNODE_QUIET_BIT));
 	node.isQuiet = (type & (1 << FSTACKNODE_QUIET_BIT)) != 0;
 
@@ -115,31 +271,19 @@ static void readFileStackNode(
 	case NODE_FILE:
 	case NODE_MACRO:
 		node.data = "";
-		tryReadString(
-		    node.name(), file, "%s: Cannot read node #%" PRIu32 "'s file name: %s", fileName, nodeID
-		);
+		obj.getString(node.name());
 		break;
 
 	case NODE_REPT: {
-		uint32_t depth;
-		tryReadLong(
-		    depth, file, "%s: Cannot read node #%" PRIu32 "'s REPT depth: %s", fileName, nodeID
-		);
+		uint32_t depth = obj.getLong();
 		node.data = std::vector<uint32_t>(depth);
 		for (uint32_t i = 0; i < depth; ++i) {
-			tryReadLong(
-			    node.iters()[i],
-			    file,
-			    "%s: Cannot read node #%" PRIu32 "'s iter #%" PRIu32 ": %s",
-			    fileName,
-			    nodeID,
-			    i
-			);
+			node.iters()[i] = obj.getLong();
 		}
 		if (!node.parent) {
 			fatal(
 			    "%s: Invalid object file: root node (#%" PRIu32 ") may not be REPT",
-			    fileName,
+			    obj.fileName,
 			    nodeID
 			);
 		}
@@ -148,37 +292,20 @@ static void readFileStackNode(
 }
 
 // Reads a symbol from a file.
-static void readSymbol(
-    FILE *file, Symbol &symbol, char const *fileName, std::vector<FileStackNode> const &fileNodes
-) {
-	tryReadString(symbol.name, file, "%s: Cannot read symbol name: %s", fileName);
-	tryGetc(
-	    ExportLevel,
-	    symbol.type,
-	    file,
-	    "%s: Cannot read `%s`'s type: %s",
-	    fileName,
-	    symbol.name.c_str()
-	);
+static void
+    readSymbol(ObjFileBuf &obj, Symbol &symbol, std::vector<FileStackNode> const &fileNodes) {
+	obj.getString(symbol.name);
+	symbol.nameHash = fnv1a64(symbol.name.data(), symbol.name.length());
+	symbol.type = static_cast<ExportLevel>(obj.getByte());
 	// If the symbol is defined in this file, read its definition
 	if (symbol.type != SYMTYPE_IMPORT) {
-		uint32_t nodeID;
-		tryReadLong(
-		    nodeID, file, "%s: Cannot read `%s`'s node ID: %s", fileName, symbol.name.c_str()
-		);
+		uint32_t nodeID = obj.getLong();
+		if (nodeID >= fileNodes.size()) {
+			fatal("%s: Invalid node ID for `%s`", obj.fileName, symbol.name.c_str());
+		}
 		symbol.src = &fileNodes[nodeID];
-		tryReadLong(
-		    symbol.lineNo,
-		    file,
-		    "%s: Cannot read `%s`'s line number: %s",
-		    fileName,
-		    symbol.name.c_str()
-		);
-		int32_t sectionID, value;
-		tryReadLong(
-		    sectionID, file, "%s: Cannot read `%s`'s section ID: %s", fileName, symbol.name.c_str()
-		);
-		tryReadLong(value, file, "%s: Cannot read `%s`'s value: %s", fileName, symbol.name.c_str());
+		symbol.lineNo = obj.getLong();
+		int32_t sectionID = obj.getLong(), value = obj.getLong();
 		if (sectionID == -1) {
 			symbol.data = value;
 		} else {
@@ -195,128 +322,133 @@ static void readSymbol(
 }
 
 // Reads a patch from a file.
-static void readPatch(
-    FILE *file,
-    Patch &patch,
-    char const *fileName,
-    std::string const &sectName,
-    uint32_t patchID,
-    std::vector<FileStackNode> const &fileNodes
-) {
-	uint32_t nodeID;
-	tryReadLong(
-	    nodeID,
-	    file,
-	    "%s: Cannot read \"%s\"'s patch #%" PRIu32 "'s node ID: %s",
-	    fileName,
-	    sectName.c_str(),
-	    patchID
-	);
+static void readPatch(ObjFileBuf &file, Patch &patch, std::vector<FileStackNode> const &fileNodes) {
+	uint32_t nodeID = file.getLong();
+	if (nodeID >= fileNodes.size()) {
+		fatal("%s: Invalid node ID %" PRIu32 " in patch", file.fileName, nodeID);
+	}
 	patch.src = &fileNodes[nodeID];
+	patch.lineNo = file.getLong();
+	patch.offset = file.getLong();
+	patch.pcSectionID = file.getLong();
+	patch.pcOffset = file.getLong();
+	patch.type = static_cast<PatchType>(file.getByte());
+
+	uint32_t rpnSize = file.getLong();
+	// Adopt the serialized blob in place instead of copying it out of the image
+	patch.rpnExpression = obj_AdoptRPN(file.getView(rpnSize), rpnSize, file.owner());
+}
 
-	tryReadLong(
-	    patch.lineNo,
-	    file,
-	    "%s: Cannot read \"%s\"'s patch #%" PRIu32 "'s line number: %s",
-	    fileName,
-	    sectName.c_str(),
-	    patchID
-	);
-	tryReadLong(
-	    patch.offset,
-	    file,
-	    "%s: Cannot read \"%s\"'s patch #%" PRIu32 "'s offset: %s",
-	    fileName,
-	    sectName.c_str(),
-	    patchID
-	);
-	tryReadLong(
-	    patch.pcSectionID,
-	    file,
-	    "%s: Cannot read \"%s\"'s patch #%" PRIu32 "'s PC offset: %s",
-	    fileName,
-	    sectName.c_str(),
-	    patchID
-	);
-	tryReadLong(
-	    patch.pcOffset,
-	    file,
-	    "%s: Cannot read \"%s\"'s patch #%" PRIu32 "'s PC offset: %s",
-	    fileName,
-	    sectName.c_str(),
-	    patchID
-	);
+// Sets a patch's `pcSection` from its `pcSectionID`.
+static void linkPatchToPCSect(Patch &patch, std::vector<Section> const &fileSections) {
+	patch.pcSection =
+	    patch.pcSectionID != UINT32_MAX ? &fileSections[patch.pcSectionID] : nullptr;
+}
 
-	PatchType type;
-	tryGetc(
-	    PatchType,
-	    type,
-	    file,
-	    "%s: Cannot read \"%s\"'s patch #%" PRIu32 "'s type: %s",
-	    fileName,
-	    sectName.c_str(),
-	    patchID
-	);
-	patch.type = type;
-
-	uint32_t rpnSize;
-	tryReadLong(
-	    rpnSize,
-	    file,
-	    "%s: Cannot read \"%s\"'s patch #%" PRIu32 "'s RPN size: %s",
-	    fileName,
-	    sectName.c_str(),
-	    patchID
-	);
+// Reads a section from a file.
+static void
+    readSection(ObjFileBuf &obj, Section &section, std::vector<FileStackNode> const &fileNodes) {
+	obj.getString(section.name);
+	uint32_t nodeID = obj.getLong();
+	if (nodeID >= fileNodes.size()) {
+		fatal("%s: Invalid node ID for \"%s\"", obj.fileName, section.name.c_str());
+	}
+	section.src = &fileNodes[nodeID];
+	section.lineNo = obj.getLong();
+	int32_t tmp = obj.getLong();
+	if (tmp < 0 || tmp > UINT16_MAX) {
+		fatal("\"%s\"'s section size ($%" PRIx32 ") is invalid", section.name.c_str(), tmp);
+	}
+	section.size = tmp;
+	section.offset = 0;
+	uint8_t byte = obj.getByte();
+	if (uint8_t type = byte & SECTTYPE_TYPE_MASK; type >= SECTTYPE_INVALID) {
+		fatal("\"%s\" has unknown section type 0x%02x", section.name.c_str(), type);
+	} else {
+		section.type = SectionType(type);
+	}
+	if (byte & (1 << SECTTYPE_UNION_BIT)) {
+		section.modifier = SECTION_UNION;
+	} else if (byte & (1 << SECTTYPE_FRAGMENT_BIT)) {
+		section.modifier = SECTION_FRAGMENT;
+	} else {
+		section.modifier = SECTION_NORMAL;
+	}
+	tmp = obj.getLong();
+	section.isAddressFixed = tmp >= 0;
+	if (tmp > UINT16_MAX) {
+		error("\"%s\"'s org is too large ($%" PRIx32 ")", section.name.c_str(), tmp);
+		tmp = UINT16_MAX;
+	}
+	section.org = tmp;
+	tmp = obj.getLong();
+	section.isBankFixed = tmp >= 0;
+	section.bank = tmp;
+	byte = obj.getByte();
+	if (byte > 16) {
+		byte = 16;
+	}
+	section.isAlignFixed = byte != 0;
+	section.alignMask = (1 << byte) - 1;
+	tmp = obj.getLong();
+	if (tmp > UINT16_MAX) {
+		error("\"%s\"'s alignment offset is too large ($%" PRIx32 ")", section.name.c_str(), tmp);
+		tmp = UINT16_MAX;
+	}
+	section.alignOfs = tmp;
 
-	patch.rpnExpression.resize(rpnSize);
-	if (fread(patch.rpnExpression.data(), 1, rpnSize, file) != rpnSize) {
-		fatal(
-		    "%s: Cannot read \"%s\"'s patch #%" PRIu32 "'s RPN expression: %s",
-		    fileName,
-		    sectName.c_str(),
-		    patchID,
-		    feof(file) ? "Unexpected end of file" : strerror(errno)
-		);
+	if (sectTypeHasData(section.type)) {
+		if (section.size) {
+			section.data.resize(section.size);
+			obj.getData(section.data.data(), section.size);
+		}
+
+		uint32_t nbPatches = obj.getLong();
+
+		section.patches.resize(nbPatches);
+		for (uint32_t i = 0; i < nbPatches; ++i) {
+			readPatch(obj, section.patches[i], fileNodes);
+		}
 	}
 }
 
-// Sets a patch's `pcSection` from its `pcSectionID`.
-static void
-    linkPatchToPCSect(Patch &patch, std::vector<std::unique_ptr<Section>> const &fileSections) {
-	patch.pcSection =
-	    patch.pcSectionID != UINT32_MAX ? fileSections[patch.pcSectionID].get() : nullptr;
+ObjStringTable::ObjStringTable(ObjFileBuf const &file, uint32_t ofs, uint32_t size_)
+    : size(size_) {
+	fileName = file.fileName;
+	if (ofs > file.size() || size > file.size() - ofs) {
+		fatal("%s: String table extends past the end of the file", fileName);
+	}
+	if (size != 0 && file.data()[ofs + size - 1] != '\0') {
+		fatal("%s: String table is not NUL-terminated", fileName);
+	}
+	strings = reinterpret_cast<char const *>(file.data()) + ofs;
 }
 
-// Reads a section from a file.
-static void readSection(
-    FILE *file, Section &section, char const *fileName, std::vector<FileStackNode> const &fileNodes
+// Reads a section from a v2 object file.
+static void readSectionV2(
+    ObjFileBuf &file,
+    Section &section,
+    ObjStringTable const &strTab,
+    std::vector<FileStackNode> const &fileNodes
 ) {
-	int32_t tmp;
-	uint8_t byte;
+	char const *fileName = file.fileName;
 
-	tryReadString(section.name, file, "%s: Cannot read section name: %s", fileName);
-	uint32_t nodeID;
-	tryReadLong(
-	    nodeID, file, "%s: Cannot read \"%s\"'s node ID: %s", fileName, section.name.c_str()
-	);
+	section.name = strTab.get(file.getLong());
+	uint32_t nodeID = file.getLong();
+	if (nodeID >= fileNodes.size()) {
+		fatal("%s: Invalid node ID %" PRIu32 " for \"%s\"", fileName, nodeID, section.name.c_str());
+	}
 	section.src = &fileNodes[nodeID];
-	tryReadLong(
-	    section.lineNo,
-	    file,
-	    "%s: Cannot read \"%s\"'s line number: %s",
-	    fileName,
-	    section.name.c_str()
-	);
-	tryReadLong(tmp, file, "%s: Cannot read \"%s\"'s' size: %s", fileName, section.name.c_str());
+	section.lineNo = file.getLong();
+
+	int32_t tmp = file.getLong();
 	if (tmp < 0 || tmp > UINT16_MAX) {
 		fatal("\"%s\"'s section size ($%" PRIx32 ") is invalid", section.name.c_str(), tmp);
 	}
 	section.size = tmp;
 	section.offset = 0;
-	tryGetc(
-	    uint8_t, byte, file, "%s: Cannot read \"%s\"'s type: %s", fileName, section.name.c_str()
-	);
+
+	uint8_t byte = file.getByte();
 	if (uint8_t type = byte & SECTTYPE_TYPE_MASK; type >= SECTTYPE_INVALID) {
 		fatal("\"%s\" has unknown section type 0x%02x", section.name.c_str(), type);
 	} else {
@@ -329,32 +461,28 @@ static void readSection(
 	} else {
 		section.modifier = SECTION_NORMAL;
 	}
-	tryReadLong(tmp, file, "%s: Cannot read \"%s\"'s org: %s", fileName, section.name.c_str());
+	bool isCompressed = byte & (1 << SECTTYPE_COMPRESSED_BIT);
+
+	tmp = file.getLong();
 	section.isAddressFixed = tmp >= 0;
 	if (tmp > UINT16_MAX) {
 		error("\"%s\"'s org is too large ($%" PRIx32 ")", section.name.c_str(), tmp);
 		tmp = UINT16_MAX;
 	}
 	section.org = tmp;
-	tryReadLong(tmp, file, "%s: Cannot read \"%s\"'s bank: %s", fileName, section.name.c_str());
+
+	tmp = file.getLong();
 	section.isBankFixed = tmp >= 0;
 	section.bank = tmp;
-	tryGetc(
-	    uint8_t,
-	    byte,
-	    file,
-	    "%s: Cannot read \"%s\"'s alignment: %s",
-	    fileName,
-	    section.name.c_str()
-	);
+
+	byte = file.getByte();
 	if (byte > 16) {
 		byte = 16;
 	}
 	section.isAlignFixed = byte != 0;
 	section.alignMask = (1 << byte) - 1;
-	tryReadLong(
-	    tmp, file, "%s: Cannot read \"%s\"'s alignment offset: %s", fileName, section.name.c_str()
-	);
+
+	tmp = file.getLong();
 	if (tmp > UINT16_MAX) {
 		error("\"%s\"'s alignment offset is too large ($%" PRIx32 ")", section.name.c_str(), tmp);
 		tmp = UINT16_MAX;
@@ -362,30 +490,24 @@ static void readSection(
 	section.alignOfs = tmp;
 
 	if (sectTypeHasData(section.type)) {
-		if (section.size) {
+		if (isCompressed) {
+			uint32_t packedSize = file.getLong();
+			uint8_t const *packed = file.getView(packedSize);
 			section.data.resize(section.size);
-			if (fread(section.data.data(), 1, section.size, file) != section.size) {
+			if (!lz4_Decompress(packed, packedSize, section.data.data(), section.size)) {
 				fatal(
-				    "%s: Cannot read \"%s\"'s data: %s",
-				    fileName,
-				    section.name.c_str(),
-				    feof(file) ? "Unexpected end of file" : strerror(errno)
+				    "%s: Invalid compressed data for \"%s\"", file.fileName, section.name.c_str()
 				);
 			}
+		} else if (section.size) {
+			section.data.resize(section.size);
+			file.getData(section.data.data(), section.size);
 		}
 
-		uint32_t nbPatches;
-		tryReadLong(
-		    nbPatches,
-		    file,
-		    "%s: Cannot read \"%s\"'s number of patches: %s",
-		    fileName,
-		    section.name.c_str()
-		);
-
+		uint32_t nbPatches = file.getLong();
 		section.patches.resize(nbPatches);
 		for (uint32_t i = 0; i < nbPatches; ++i) {
-			readPatch(file, section.patches[i], fileName, section.name, i, fileNodes);
+			readPatch(file, section.patches[i], fileNodes);
 		}
 	}
 }
@@ -410,76 +532,275 @@ static void linkSymToSect(Symbol &symbol, Section &section) {
 }
 
 // Reads an assertion from a file.
-static void readAssertion(
-    FILE *file,
-    Assertion &assert,
-    char const *fileName,
-    uint32_t assertID,
-    std::vector<FileStackNode> const &fileNodes
-) {
-	std::string assertName("Assertion #");
+static void
+    readAssertion(ObjFileBuf &obj, Assertion &assert, std::vector<FileStackNode> const &fileNodes) {
+	readPatch(obj, assert.patch, fileNodes);
+	obj.getString(assert.message);
+}
+
+// Links a file's sections and symbols together once all of them have been read.
+static void
+    linkFileContents(std::vector<Symbol> &fileSymbols, std::vector<Section> &fileSections) {
+	size_t nbSymbols = fileSymbols.size();
+	size_t nbSections = fileSections.size();
 
-	assertName += std::to_string(assertID);
-	readPatch(file, assert.patch, fileName, assertName, 0, fileNodes);
-	tryReadString(assert.message, file, "%s: Cannot read assertion's message: %s", fileName);
+	// Give patches' PC section pointers to their sections
+	for (uint32_t i = 0; i < nbSections; ++i) {
+		if (sectTypeHasData(fileSections[i].type)) {
+			for (Patch &patch : fileSections[i].patches) {
+				linkPatchToPCSect(patch, fileSections);
+			}
+		}
+	}
+
+	// Give symbols' section pointers to their sections
+	for (uint32_t i = 0; i < nbSymbols; ++i) {
+		if (std::holds_alternative<Label>(fileSymbols[i].data)) {
+			Label &label = std::get<Label>(fileSymbols[i].data);
+			label.section = &fileSections[label.sectionID];
+			// Give the section a pointer to the symbol as well
+			linkSymToSect(fileSymbols[i], *label.section);
+		}
+	}
+
+	for (uint32_t i = 0; i < nbSections; ++i) {
+		sect_AddSection(fileSections[i]);
+	}
+
+	// Fix symbols' section pointers to component sections
+	// This has to run **after** all the `sect_AddSection()` calls,
+	// so that `sect_GetSection()` will work
+	for (uint32_t i = 0; i < nbSymbols; ++i) {
+		if (std::holds_alternative<Label>(fileSymbols[i].data)) {
+			Label &label = std::get<Label>(fileSymbols[i].data);
+			Section *section = label.section;
+			if (section->modifier != SECTION_NORMAL) {
+				// Associate the symbol with the main section, not the "component" one
+				label.section = sect_GetSection(section->name);
+			}
+			if (section->modifier == SECTION_FRAGMENT) {
+				// Add the fragment's offset to the symbol's
+				// (`section->offset` is computed by `sect_AddSection`)
+				label.offset += section->offset;
+			}
+		}
+	}
 }
 
-void obj_ReadFile(char const *fileName, unsigned int fileID) {
-	FILE *file;
-	if (strcmp(fileName, "-")) {
-		file = fopen(fileName, "rb");
+// Parses a symbol record that the v2 reader skipped over, and registers the symbol; the
+// record's own bounds were already checked when it was skipped.
+static void materializeSymbol(LazySymbolTable &table, uint32_t index) {
+	uint8_t const *record = &table.image[table.recordOfs[index]];
+	table.recordOfs[index] = UINT32_MAX;
+	auto getLong = [&record]() {
+		uint32_t value = record[0] | record[1] << 8 | static_cast<uint32_t>(record[2]) << 16
+		                 | static_cast<uint32_t>(record[3]) << 24;
+		record += 4;
+		return value;
+	};
+
+	Symbol &symbol = (*table.fileSymbols)[index];
+	uint32_t nameOfs = getLong();
+	symbol.name = table.strTab.get(nameOfs);
+	symbol.nameHash = table.strTab.getHash(nameOfs);
+	symbol.type = static_cast<ExportLevel>(*record++);
+	uint32_t nodeID = getLong();
+	if (nodeID >= table.fileNodes->size()) {
+		fatal("%s: Invalid node ID for `%s`", table.strTab.fileName, symbol.name.c_str());
+	}
+	symbol.src = &(*table.fileNodes)[nodeID];
+	symbol.lineNo = getLong();
+	int32_t sectionID = getLong(), value = getLong();
+	if (sectionID == -1) {
+		symbol.data = value;
 	} else {
-		fileName = "<stdin>";
-		(void)setmode(STDIN_FILENO, O_BINARY);
-		file = stdin;
+		if (static_cast<uint32_t>(sectionID) >= table.fileSections->size()) {
+			fatal(
+			    "%s: Invalid section ID for `%s`", table.strTab.fileName, symbol.name.c_str()
+			);
+		}
+		Section *section = &(*table.fileSections)[sectionID];
+		Label label = {.sectionID = sectionID, .offset = value, .section = section};
+		// Mirror `linkFileContents`'s fix-ups, which ran before this record was needed
+		if (section->modifier != SECTION_NORMAL) {
+			// Associate the symbol with the main section, not the "component" one
+			label.section = sect_GetSection(section->name);
+		}
+		if (section->modifier == SECTION_FRAGMENT) {
+			label.offset += section->offset;
+		}
+		symbol.data = label;
+	}
+	sym_AddSymbol(symbol);
+}
+
+void obj_MaterializeSymbol(std::vector<Symbol> const &fileSymbols, uint32_t index) {
+	auto search = lazySymbolTables.find(&fileSymbols);
+	if (search == lazySymbolTables.end() || search->second.recordOfs[index] == UINT32_MAX) {
+		return;
 	}
-	if (!file) {
-		fatal("Failed to open file \"%s\": %s", fileName, strerror(errno));
+	materializeSymbol(search->second, index);
+}
+
+void obj_MaterializeAllSymbols() {
+	for (auto &it : lazySymbolTables) {
+		LazySymbolTable &table = it.second;
+		for (uint32_t i = 0; i < table.recordOfs.size(); ++i) {
+			if (table.recordOfs[i] != UINT32_MAX) {
+				materializeSymbol(table, i);
+			}
+		}
 	}
-	Defer closeFile{[&] { fclose(file); }};
+}
 
-	// First, check if the object is a RGBDS object or a SDCC one. If the first byte is 'R',
-	// we'll assume it's a RGBDS object file, and otherwise, that it's a SDCC object file.
-	int c = getc(file);
+bool obj_HasDeferredSymbols() {
+	return !lazySymbolTables.empty();
+}
 
-	ungetc(c, file); // Guaranteed to work
-	switch (c) {
-	case EOF:
-		fatal("File \"%s\" is empty!", fileName);
+// Reads a v2 object file, whose table of contents locates each table within the file.
+// `obj`'s cursor is positioned right after the magic bytes; absolute offsets in the table of
+// contents are valid since the cursor covers the whole file.
+static void readObjectV2File(ObjFileBuf &obj, StagedObjFile &staged) {
+	char const *fileName = staged.fileName;
+	unsigned int fileID = staged.fileID;
 
-	case 'R':
-		break;
+	verbosePrint(VERB_NOTICE, "Reading v2 object file %s\n", fileName);
 
-	default:
-		// This is (probably) a SDCC object file, defer the rest of detection to it.
-		// Since SDCC does not provide line info, everything will be reported as coming from the
-		// object file. It's better than nothing.
-		nodes[fileID].push_back({
-		    .type = NODE_FILE,
-		    .data = std::variant<std::monostate, std::vector<uint32_t>, std::string>(fileName),
-		    .isQuiet = false,
-		    .parent = nullptr,
-		    .lineNo = 0,
-		});
-
-		std::vector<Symbol> &fileSymbols = symbolLists.emplace_front();
-
-		sdobj_ReadFile(nodes[fileID].back(), file, fileSymbols);
-		return;
+	uint32_t revNum = obj.getLong();
+	if (revNum != RGBDS_OBJECT_REV) {
+		fatal(
+		    "%s: Unsupported object file for rgblink %s; try rebuilding \"%s\"%s"
+		    " (expected revision %d, got %d)",
+		    fileName,
+		    get_package_version_string(),
+		    fileName,
+		    revNum > RGBDS_OBJECT_REV ? " or updating rgblink" : "",
+		    RGBDS_OBJECT_REV,
+		    revNum
+		);
 	}
 
-	// Begin by reading the magic bytes
-	int matchedElems;
+	// Table of contents: {offset, count} per table; slot 0 is the string table ({offset, size})
+	uint32_t strTabOfs = obj.getLong(), strTabSize = obj.getLong();
+	uint32_t nodesOfs = obj.getLong(), nbNodes = obj.getLong();
+	uint32_t symbolsOfs = obj.getLong(), nbSymbols = obj.getLong();
+	uint32_t sectionsOfs = obj.getLong(), nbSections = obj.getLong();
+	uint32_t assertsOfs = obj.getLong(), nbAsserts = obj.getLong();
+
+	ObjStringTable strTab(obj, strTabOfs, strTabSize);
 
-	if (fscanf(file, RGBDS_OBJECT_VERSION_STRING "%n", &matchedElems) == 1
-	    && matchedElems != literal_strlen(RGBDS_OBJECT_VERSION_STRING)) {
-		fatal("%s: Not a RGBDS object file", fileName);
+	nodes[fileID].resize(nbNodes);
+	std::vector<FileStackNode> &fileNodes = nodes[fileID];
+	verbosePrint(VERB_INFO, "Reading %" PRIu32 " nodes...\n", nbNodes);
+	obj.seek(nodesOfs);
+	for (uint32_t i = 0; i < nbNodes; ++i) {
+		FileStackNode &node = fileNodes[i];
+
+		uint32_t parentID = obj.getLong();
+		if (parentID != UINT32_MAX && parentID >= nbNodes) {
+			fatal("%s: Invalid parent ID for node #%" PRIu32, fileName, i);
+		}
+		node.parent = parentID != UINT32_MAX ? &fileNodes[parentID] : nullptr;
+		node.lineNo = obj.getLong();
+
+		uint8_t type = obj.getByte();
+		node.type = static_cast<FileStackNodeType>(type & ~(1 << FSTACKNODE_QUIET_BIT));
+		node.isQuiet = (type & (1 << FSTACKNODE_QUIET_BIT)) != 0;
+
+		if (node.type != NODE_REPT) {
+			node.data = std::string(strTab.get(obj.getLong()));
+		} else {
+			uint32_t depth = obj.getLong();
+			node.data = std::vector<uint32_t>(depth);
+			for (uint32_t j = 0; j < depth; ++j) {
+				node.iters()[j] = obj.getLong();
+			}
+			if (!node.parent) {
+				fatal(
+				    "%s: Invalid object file: root node (#%" PRIu32 ") may not be REPT", fileName, i
+				);
+			}
+		}
 	}
 
+	staged.symbols.resize(nbSymbols);
+	// The ".sym" and map writers walk every label, so deferring local records only pays off
+	// when neither output was requested
+	bool deferLocals = !options.symFileName && !options.mapFileName;
+	if (deferLocals) {
+		staged.lazySymbols = LazySymbolTable{
+		    .owner = obj.owner(),
+		    .image = obj.data(),
+		    .strTab = strTab,
+		    .fileNodes = &fileNodes,
+		    .recordOfs = std::vector<uint32_t>(nbSymbols, UINT32_MAX),
+		};
+	}
+	verbosePrint(VERB_INFO, "Reading %" PRIu32 " symbols...\n", nbSymbols);
+	obj.seek(symbolsOfs);
+	for (uint32_t i = 0; i < nbSymbols; ++i) {
+		Symbol &symbol = staged.symbols[i];
+
+		uint32_t recordOfs = obj.cursor.tell();
+		uint32_t nameOfs = obj.getLong();
+		symbol.type = static_cast<ExportLevel>(obj.getByte());
+		if (symbol.type == SYMTYPE_LOCAL && deferLocals) {
+			// Skip the rest of the record (node ID, line, section ID, and value); it will be
+			// materialized from `recordOfs` if a patch turns out to reference this symbol
+			obj.getView(4 * sizeof(uint32_t));
+			staged.lazySymbols->recordOfs[i] = recordOfs;
+			continue;
+		}
+		symbol.name = strTab.get(nameOfs);
+		symbol.nameHash = strTab.getHash(nameOfs);
+		if (symbol.type != SYMTYPE_IMPORT) {
+			uint32_t nodeID = obj.getLong();
+			if (nodeID >= nbNodes) {
+				fatal("%s: Invalid node ID for `%s`", fileName, symbol.name.c_str());
+			}
+			symbol.src = &fileNodes[nodeID];
+			symbol.lineNo = obj.getLong();
+			int32_t sectionID = obj.getLong(), value = obj.getLong();
+			if (sectionID == -1) {
+				symbol.data = value;
+			} else {
+				symbol.data = Label{
+				    .sectionID = sectionID,
+				    .offset = value,
+				    // Set the `.section` later based on the `.sectionID`
+				    .section = nullptr,
+				};
+			}
+		} else {
+			symbol.data = -1;
+		}
+	}
+
+	staged.sections.resize(nbSections);
+	verbosePrint(VERB_INFO, "Reading %" PRIu32 " sections...\n", nbSections);
+	obj.seek(sectionsOfs);
+	for (uint32_t i = 0; i < nbSections; ++i) {
+		readSectionV2(obj, staged.sections[i], strTab, fileNodes);
+	}
+
+	staged.assertions.resize(nbAsserts);
+	verbosePrint(VERB_INFO, "Reading %" PRIu32 " assertions...\n", nbAsserts);
+	obj.seek(assertsOfs);
+	for (uint32_t i = 0; i < nbAsserts; ++i) {
+		Assertion &assertion = staged.assertions[i];
+
+		readPatch(obj, assertion.patch, fileNodes);
+		assertion.message = strTab.get(obj.getLong());
+	}
+}
+
+// Reads a v1 object file's contents into `staged`; `obj`'s cursor is positioned right after
+// the magic bytes, and the v1 format is a plain byte stream from there on.
+static void readObjectFile(ObjFileBuf &obj, StagedObjFile &staged) {
+	char const *fileName = staged.fileName;
 	verbosePrint(VERB_NOTICE, "Reading object file %s\n", fileName);
 
-	uint32_t revNum;
-	tryReadLong(revNum, file, "%s: Cannot read revision number: %s", fileName);
+	uint32_t revNum = obj.getLong();
 	if (revNum != RGBDS_OBJECT_REV) {
 		fatal(
 		    "%s: Unsupported object file for rgblink %s; try rebuilding \"%s\"%s"
@@ -493,103 +814,327 @@ void obj_ReadFile(char const *fileName, unsigned int fileID) {
 		);
 	}
 
-	uint32_t nbSymbols;
-	tryReadLong(nbSymbols, file, "%s: Cannot read number of symbols: %s", fileName);
-
-	uint32_t nbSections;
-	tryReadLong(nbSections, file, "%s: Cannot read number of sections: %s", fileName);
+	uint32_t nbSymbols = obj.getLong();
+	uint32_t nbSections = obj.getLong();
 
-	uint32_t nbNodes;
-	tryReadLong(nbNodes, file, "%s: Cannot read number of nodes: %s", fileName);
-	nodes[fileID].resize(nbNodes);
+	uint32_t nbNodes = obj.getLong();
+	nodes[staged.fileID].resize(nbNodes);
 	verbosePrint(VERB_INFO, "Reading %u nodes...\n", nbNodes);
 	for (uint32_t i = nbNodes; i--;) {
-		readFileStackNode(file, nodes[fileID], i, fileName);
+		readFileStackNode(obj, nodes[staged.fileID], i);
 	}
 
-	// This file's symbols, kept to link sections to them
-	std::vector<Symbol> &fileSymbols = symbolLists.emplace_front(nbSymbols);
-	std::vector<uint32_t> nbSymPerSect(nbSections, 0);
-
+	staged.symbols.resize(nbSymbols);
 	verbosePrint(VERB_INFO, "Reading %" PRIu32 " symbols...\n", nbSymbols);
 	for (uint32_t i = 0; i < nbSymbols; ++i) {
-		// Read symbol
-		Symbol &symbol = fileSymbols[i];
+		readSymbol(obj, staged.symbols[i], nodes[staged.fileID]);
+	}
+
+	staged.sections.resize(nbSections);
+	verbosePrint(VERB_INFO, "Reading %" PRIu32 " sections...\n", nbSections);
+	for (uint32_t i = 0; i < nbSections; ++i) {
+		readSection(obj, staged.sections[i], nodes[staged.fileID]);
+	}
+
+	uint32_t nbAsserts = obj.getLong();
+	verbosePrint(VERB_INFO, "Reading %" PRIu32 " assertions...\n", nbAsserts);
+	staged.assertions.resize(nbAsserts);
+	for (uint32_t i = 0; i < nbAsserts; ++i) {
+		readAssertion(obj, staged.assertions[i], nodes[staged.fileID]);
+	}
+}
+
+// Parses a SDCC object file via stdio, deferring the rest of detection to its own reader.
+// Since SDCC does not provide line info, everything will be reported as coming from the
+// object file. It's better than nothing.
+static void readSdccFile(FILE *file, char const *fileName, unsigned int fileID) {
+	nodes[fileID].push_back({
+	    .type = NODE_FILE,
+	    .data = std::variant<std::monostate, std::vector<uint32_t>, std::string>(fileName),
+	    .isQuiet = false,
+	    .parent = nullptr,
+	    .lineNo = 0,
+	});
+
+	std::vector<Symbol> &fileSymbols = symbolLists.emplace_front();
+
+	sdobj_ReadFile(nodes[fileID].back(), file, fileSymbols);
+}
+
+// Decodes a RGBDS object file already in memory, dispatching on its magic bytes.
+static void parseObjBuf(ObjFileBuf &obj, StagedObjFile &staged) {
+	static_assert(
+	    literal_strlen(RGBDS_OBJECT_VERSION_STRING) == literal_strlen(RGBDS_OBJECT_V2_MAGIC)
+	);
+	char magic[literal_strlen(RGBDS_OBJECT_VERSION_STRING)];
+
+	if (!obj.cursor.getData(magic, sizeof(magic))) {
+		fatal("%s: Not a RGBDS object file", obj.fileName);
+	}
+	if (memcmp(magic, RGBDS_OBJECT_V2_MAGIC, sizeof(magic)) == 0) {
+		readObjectV2File(obj, staged);
+	} else if (memcmp(magic, RGBDS_OBJECT_VERSION_STRING, sizeof(magic)) == 0) {
+		readObjectFile(obj, staged);
+	} else {
+		fatal("%s: Not a RGBDS object file", obj.fileName);
+	}
+}
+
+// Parses `staged`'s file into its staging structures. Returns false if the file was not
+// staged: either it was handled (and registered) entirely, or, if `deferSpecial` is set,
+// it needs `obj_ReadFile`'s sequential handling (SDCC objects and stdin).
+static bool parseFile(StagedObjFile &staged, bool deferSpecial) {
+	char const *fileName = staged.fileName;
+	unsigned int fileID = staged.fileID;
+
+	ObjFileBuf obj{.file = {}, .buf = {}, .cursor = {}, .fileName = fileName};
+
+	if (strcmp(fileName, "-") != 0 && obj.file.open(fileName)) {
+		// Regular file: decode it straight from the mapping (or the read buffer)
+		obj.file.adviseSequential();
+		obj.cursor = FileCursor(obj.file);
+
+		// If the first byte is 'R', we'll assume it's a RGBDS object file,
+		// and otherwise, that it's a SDCC object file
+		if (obj.size() == 0) {
+			fatal("File \"%s\" is empty!", fileName);
+		}
+		if (obj.data()[0] != 'R') {
+			if (deferSpecial) {
+				// SDCC objects and archives register as they parse, so they are read at merge time
+				staged.deferred = true;
+				return false;
+			}
+			if (lib_IsArchive(obj.data(), obj.size())) {
+				// Library archives only register their index; members are loaded on demand
+				// once every regular object's imports are known (`lib_ResolveSymbols`)
+				lib_RegisterArchive(fileName);
+				return false;
+			}
+			// The SDCC reader consumes a `FILE *`, so reopen the file through stdio
+			FILE *file = fopen(fileName, "rb");
+			if (!file) {
+				fatal("Failed to open file \"%s\": %s", fileName, strerror(errno)); // LCOV_EXCL_LINE
+			}
+			Defer closeFile{[&] { fclose(file); }};
+			readSdccFile(file, fileName, fileID);
+			return false;
+		}
+	} else {
+		// stdin, and non-regular files passed by path, are streamed through stdio
+		FILE *file;
+		if (strcmp(fileName, "-") != 0) {
+			file = fopen(fileName, "rb");
+		} else if (deferSpecial) {
+			// stdin cannot be reopened, so it is read where registration is known to be safe
+			staged.deferred = true;
+			return false;
+		} else {
+			fileName = "<stdin>";
+			staged.fileName = fileName;
+			obj.fileName = fileName;
+			(void)setmode(STDIN_FILENO, O_BINARY);
+			file = stdin;
+		}
+		if (!file) {
+			fatal("Failed to open file \"%s\": %s", fileName, strerror(errno));
+		}
+		Defer closeFile{[&] { fclose(file); }};
+
+		// First, check if the object is a RGBDS object or a SDCC one. If the first byte is 'R',
+		// we'll assume it's a RGBDS object file, and otherwise, that it's a SDCC object file.
+		int c = getc(file);
+
+		ungetc(c, file); // Guaranteed to work
+		switch (c) {
+		case EOF:
+			fatal("File \"%s\" is empty!", fileName);
+
+		case 'R':
+			break;
+
+		case '!':
+			// Archives need random access for their member index, which a pipe cannot provide
+			fatal("File \"%s\": library archives cannot be read from standard input", fileName);
 
-		readSymbol(file, symbol, fileName, nodes[fileID]);
+		default:
+			if (deferSpecial) {
+				// SDCC objects register as they parse, so they are read at merge time
+				staged.deferred = true;
+				return false;
+			}
+
+			readSdccFile(file, fileName, fileID);
+			return false;
+		}
+
+		slurpFile(obj, file);
+	}
+
+	parseObjBuf(obj, staged);
+	return true;
+}
+
+// Registers a staged file's contents into the global tables.
+static void registerStagedFile(StagedObjFile &staged) {
+	// This file's symbols and sections, kept to link each other together; both blocks are
+	// referenced by address from now on, so they move into permanent storage first
+	std::vector<Symbol> &fileSymbols = symbolLists.emplace_front(std::move(staged.symbols));
+	std::vector<Section> &fileSections = sect_AdoptPool(std::move(staged.sections));
+	std::vector<uint32_t> nbSymPerSect(fileSections.size(), 0);
+
+	LazySymbolTable const *lazySymbols = nullptr;
+	if (staged.lazySymbols) {
+		staged.lazySymbols->fileSymbols = &fileSymbols;
+		staged.lazySymbols->fileSections = &fileSections;
+		lazySymbols =
+		    &lazySymbolTables.emplace(&fileSymbols, std::move(*staged.lazySymbols)).first->second;
+	}
 
+	for (size_t i = 0; i < fileSymbols.size(); ++i) {
+		Symbol &symbol = fileSymbols[i];
+		// Deferred records are registered if and when they are materialized
+		if (lazySymbols && lazySymbols->recordOfs[i] != UINT32_MAX) {
+			continue;
+		}
 		sym_AddSymbol(symbol);
 		if (std::holds_alternative<Label>(symbol.data)) {
 			++nbSymPerSect[std::get<Label>(symbol.data).sectionID];
 		}
 	}
 
-	// This file's sections, stored in a table to link symbols to them
-	std::vector<std::unique_ptr<Section>> fileSections(nbSections);
-
-	verbosePrint(VERB_INFO, "Reading %" PRIu32 " sections...\n", nbSections);
-	for (uint32_t i = 0; i < nbSections; ++i) {
-		// Read section
-		fileSections[i] = std::make_unique<Section>();
-		fileSections[i]->nextu = nullptr;
-		readSection(file, *fileSections[i], fileName, nodes[fileID]);
-		fileSections[i]->fileSymbols = &fileSymbols;
-		fileSections[i]->symbols.reserve(nbSymPerSect[i]);
+	for (size_t i = 0; i < fileSections.size(); ++i) {
+		fileSections[i].fileSymbols = &fileSymbols;
+		fileSections[i].symbols.reserve(nbSymPerSect[i]);
 	}
 
-	uint32_t nbAsserts;
-	tryReadLong(nbAsserts, file, "%s: Cannot read number of assertions: %s", fileName);
-	verbosePrint(VERB_INFO, "Reading %" PRIu32 " assertions...\n", nbAsserts);
-	for (uint32_t i = 0; i < nbAsserts; ++i) {
-		Assertion &assertion = patch_AddAssertion();
-
-		readAssertion(file, assertion, fileName, i, nodes[fileID]);
+	for (Assertion &assertion : staged.assertions) {
 		linkPatchToPCSect(assertion.patch, fileSections);
 		assertion.fileSymbols = &fileSymbols;
+		patch_AddAssertion() = std::move(assertion);
 	}
 
-	// Give patches' PC section pointers to their sections
-	for (uint32_t i = 0; i < nbSections; ++i) {
-		if (sectTypeHasData(fileSections[i]->type)) {
-			for (Patch &patch : fileSections[i]->patches) {
-				linkPatchToPCSect(patch, fileSections);
-			}
-		}
+	linkFileContents(fileSymbols, fileSections);
+}
+
+void obj_ReadFile(char const *fileName, unsigned int fileID) {
+	StagedObjFile staged = {.fileName = fileName, .fileID = fileID};
+
+	if (parseFile(staged, false)) {
+		registerStagedFile(staged);
 	}
+}
 
-	// Give symbols' section pointers to their sections
-	for (uint32_t i = 0; i < nbSymbols; ++i) {
-		if (std::holds_alternative<Label>(fileSymbols[i].data)) {
-			Label &label = std::get<Label>(fileSymbols[i].data);
-			label.section = fileSections[label.sectionID].get();
-			// Give the section a pointer to the symbol as well
-			linkSymToSect(fileSymbols[i], *label.section);
+void obj_ReadBuffer(char const *name, uint8_t const *data, size_t size, unsigned int fileID) {
+	StagedObjFile staged = {.fileName = name, .fileID = fileID};
+
+	if (size == 0) {
+		fatal("File \"%s\" is empty!", name);
+	}
+
+	// If the first byte is 'R', we'll assume it's a RGBDS object file,
+	// and otherwise, that it's a SDCC object file
+	if (data[0] != 'R') {
+#ifndef _MSC_VER
+		// The SDCC reader consumes a `FILE *`, so stream the buffer through stdio
+		FILE *file = fmemopen(const_cast<uint8_t *>(data), size, "rb");
+		if (!file) {
+			fatal("Failed to open buffer \"%s\": %s", name, strerror(errno)); // LCOV_EXCL_LINE
 		}
+		Defer closeFile{[&] { fclose(file); }};
+		readSdccFile(file, name, fileID);
+		return;
+#else
+		// LCOV_EXCL_START
+		fatal("File \"%s\": SDCC objects are not supported here on this platform", name);
+		// LCOV_EXCL_STOP
+#endif
 	}
 
-	// Calling `sect_AddSection` invalidates the contents of `fileSections`!
-	for (uint32_t i = 0; i < nbSections; ++i) {
-		sect_AddSection(std::move(fileSections[i]));
+	ObjFileBuf obj{.file = {}, .buf = {}, .cursor = FileCursor(data, size), .fileName = name};
+	parseObjBuf(obj, staged);
+	registerStagedFile(staged);
+}
+
+void obj_ReadLibraryMember(char const *name, uint8_t const *data, size_t size) {
+	// Members get file IDs past the command line's, allocated as they are loaded
+	unsigned int fileID = nodes.size();
+	nodes.emplace_back();
+	obj_ReadBuffer(name, data, size, fileID);
+}
+
+void obj_ReadFiles(std::vector<char const *> const &fileNames) {
+	size_t nbFiles = fileNames.size();
+	std::vector<StagedObjFile> staged(nbFiles);
+
+	for (size_t i = 0; i < nbFiles; ++i) {
+		staged[i].fileName = fileNames[i];
+		staged[i].fileID = nbFiles - 1 - i;
 	}
 
-	// Fix symbols' section pointers to component sections
-	// This has to run **after** all the `sect_AddSection()` calls,
-	// so that `sect_GetSection()` will work
-	for (uint32_t i = 0; i < nbSymbols; ++i) {
-		if (std::holds_alternative<Label>(fileSymbols[i].data)) {
-			Label &label = std::get<Label>(fileSymbols[i].data);
-			Section *section = label.section;
-			if (section->modifier != SECTION_NORMAL) {
-				// Associate the symbol with the main section, not the "component" one
-				label.section = sect_GetSection(section->name);
-			}
-			if (section->modifier == SECTION_FRAGMENT) {
-				// Add the fragment's offset to the symbol's
-				// (`section->offset` is computed by `sect_AddSection`)
-				label.offset += section->offset;
+#ifdef POSIX_FADV_WILLNEED
+	// Tell the kernel to start reading every input now, so files later in the list are
+	// (at least partially) cached by the time a worker gets to them; this matters on
+	// cold caches and high-latency (e.g. network) file systems. Closing the descriptor
+	// does not cancel the readahead.
+	for (char const *fileName : fileNames) {
+		if (strcmp(fileName, "-") != 0) {
+			if (int fd = open(fileName, O_RDONLY); fd != -1) {
+				(void)posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+				close(fd);
 			}
 		}
 	}
+#endif
+
+	// Parsing is independent per file, so spread it over the shared work pool; only the
+	// registration below needs ordering. Workers must not report diagnostics (nor `exit`
+	// mid-phase), so a file whose quiet parse raises one is dropped and deferred to the
+	// sequential pass below, which re-parses it and reports on this thread.
+	pool_ForEach(nbFiles, [&](size_t i) {
+		jmp_buf env;
+		if (setjmp(env) == 0) {
+			warnings_SetAbortJump(&env);
+			parseFile(staged[i], true);
+		} else {
+			staged[i].deferred = true;
+		}
+		warnings_SetAbortJump(nullptr);
+	});
+
+	// Pre-size the symbol and section tables, now that the object headers have said how many
+	// to expect
+	size_t totalSymbols = 0, totalSections = 0;
+	for (StagedObjFile const &file : staged) {
+		totalSymbols += file.symbols.size();
+		totalSections += file.sections.size();
+	}
+	sym_Reserve(totalSymbols);
+	sect_Reserve(totalSections);
+
+	// Register the files' contents in command-line order, so results are deterministic no
+	// matter how the parsing above was scheduled
+	for (StagedObjFile &file : staged) {
+		if (file.deferred) {
+			obj_ReadFile(file.fileName, file.fileID);
+		} else {
+			registerStagedFile(file);
+		}
+	}
+
+	lib_ResolveSymbols();
+}
+
+void obj_ReadExtraFiles(std::vector<char const *> const &fileNames) {
+	// Profile objects are read after the shared ones, continuing their file ID numbering
+	// (which, as in `obj_ReadFiles`, runs backwards through the list); there are only ever a
+	// handful of them, so no thread pool
+	unsigned int firstID = nodes.size();
+	nodes.resize(firstID + fileNames.size());
+	for (size_t i = 0; i < fileNames.size(); ++i) {
+		obj_ReadFile(fileNames[i], firstID + fileNames.size() - 1 - i);
+	}
+	lib_ResolveSymbols();
 }
 
 void obj_Setup(unsigned int nbFiles) {
@@ -10,7 +10,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
 #include <tuple>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -29,7 +31,11 @@
 static constexpr size_t BANK_SIZE = 0x4000;
 
 static FILE *outputFile;
-static FILE *overlayFile;
+// The overlay image is read fully into memory up front (which also lets it come from a
+// pipe), so untouched regions are copied into banks in bulk instead of through small reads
+static std::vector<uint8_t> overlayContents;
+static size_t overlayOfs; // Read cursor into `overlayContents`; never exceeds its size
+static bool hasOverlay;
 static FILE *symFile;
 static FILE *mapFile;
 
@@ -112,19 +118,11 @@ Section const *out_OverlappingSection(Section const &section) {
 // Performs sanity checks on the overlay file.
 // Returns the number of ROM banks in the overlay file.
 static uint32_t checkOverlaySize() {
-	if (!overlayFile) {
+	if (!hasOverlay) {
 		return 0;
 	}
 
-	if (fseek(overlayFile, 0, SEEK_END) != 0) {
-		warnx("Overlay file is not seekable, cannot check if properly formed");
-		return 0;
-	}
-
-	long overlaySize = ftell(overlayFile);
-
-	// Reset back to beginning
-	fseek(overlayFile, 0, SEEK_SET);
+	size_t overlaySize = overlayContents.size();
 
 	if (overlaySize % BANK_SIZE) {
 		warnx("Overlay file does not have a size multiple of 0x4000");
@@ -155,55 +153,69 @@ static void coverOverlayBanks(uint32_t nbOverlayBanks) {
 	}
 }
 
-static uint8_t getNextFillByte() {
-	if (overlayFile) {
-		int c = getc(overlayFile);
-		if (c != EOF) {
-			return c;
-		}
+// Appends `nbBytes` of padding to `bankBuf`; the bytes come from the overlay file when one
+// is given, and otherwise are a plain fill run.
+static void appendPadding(std::vector<uint8_t> &bankBuf, uint16_t nbBytes) {
+	size_t base = bankBuf.size();
 
+	if (hasOverlay) {
+		size_t avail = overlayContents.size() - overlayOfs;
+		size_t n = nbBytes < avail ? nbBytes : avail;
+		uint8_t const *src = overlayContents.data() + overlayOfs;
+
+		bankBuf.insert(bankBuf.end(), src, src + n);
+		overlayOfs += n;
+		if (n == nbBytes) {
+			return;
+		}
 		if (static bool warned = false; !options.hasPadValue && !warned) {
 			warnx("Output is larger than overlay file, but no padding value was specified");
 			warned = true;
 		}
+		bankBuf.resize(base + nbBytes, options.padValue);
+	} else {
+		bankBuf.resize(base + nbBytes, options.padValue);
 	}
-
-	return options.padValue;
 }
 
 static void
     writeBank(std::deque<Section const *> *bankSections, uint16_t baseOffset, uint16_t size) {
+	// Assemble the bank in memory, so the image goes out in one write per bank instead of
+	// one libc call per padding byte
+	static std::vector<uint8_t> bankBuf;
 	uint16_t offset = 0;
 
+	bankBuf.clear();
+	bankBuf.reserve(size);
+
 	if (bankSections) {
 		for (Section const *section : *bankSections) {
 			assume(section->offset == 0);
 			// Output padding up to the next SECTION
-			while (offset + baseOffset < section->org) {
-				putc(getNextFillByte(), outputFile);
-				++offset;
-			}
+			uint16_t gap = section->org - baseOffset - offset;
+
+			appendPadding(bankBuf, gap);
+			offset += gap;
 
 			// Output the section itself
-			fwrite(section->data.data(), 1, section->size, outputFile);
+			bankBuf.insert(
+			    bankBuf.end(), section->data.data(), section->data.data() + section->size
+			);
 			offset += section->size;
 
-			if (!overlayFile) {
-				continue;
-			}
-			// Skip bytes even with pipes
-			for (uint16_t i = 0; i < section->size; ++i) {
-				getc(overlayFile);
+			if (hasOverlay) {
+				// Skip the bytes the section overlaid
+				size_t avail = overlayContents.size() - overlayOfs;
+				overlayOfs += section->size < avail ? section->size : avail;
 			}
 		}
 	}
 
 	if (!options.disablePadding) {
-		while (offset < size) {
-			putc(getNextFillByte(), outputFile);
-			++offset;
-		}
+		appendPadding(bankBuf, size - offset);
 	}
+
+	fwrite(bankBuf.data(), 1, bankBuf.size(), outputFile);
 }
 
 static void writeROM() {
@@ -226,6 +238,7 @@ static void writeROM() {
 	}};
 
 	if (options.overlayFileName) {
+		FILE *overlayFile;
 		if (strcmp(options.overlayFileName, "-")) {
 			overlayFile = fopen(options.overlayFileName, "rb");
 		} else {
@@ -238,12 +251,21 @@ static void writeROM() {
 			    "Failed to open overlay file \"%s\": %s", options.overlayFileName, strerror(errno)
 			);
 		}
-	}
-	Defer closeOverlayFile{[&] {
-		if (overlayFile) {
+
+		// Slurp the whole image; a short read past this point looks like a short overlay,
+		// which `appendPadding` already warns about when it matters
+		for (uint8_t chunk[65536];;) {
+			size_t n = fread(chunk, 1, sizeof(chunk), overlayFile);
+			overlayContents.insert(overlayContents.end(), chunk, chunk + n);
+			if (n < sizeof(chunk)) {
+				break;
+			}
+		}
+		if (overlayFile != stdin) {
 			fclose(overlayFile);
 		}
-	}};
+		hasOverlay = true;
+	}
 
 	uint32_t nbOverlayBanks = checkOverlaySize();
 
@@ -268,11 +290,54 @@ static void writeROM() {
 	}
 }
 
-static void writeSymName(std::string const &name, FILE *file) {
+// The map and sym writers format lines into this buffer with the helpers below, and each
+// file is flushed with a single write; this and the bespoke formatters keep the cost per
+// symbol far below one fprintf() call each.
+static std::string textBuf;
+
+static void putText(char c) {
+	textBuf.push_back(c);
+}
+
+static void putText(char const *str) {
+	textBuf.append(str);
+}
+
+// Appends `value` in lowercase hexadecimal, zero-padded to at least `width` digits.
+static void putHex(uint32_t value, uint8_t width) {
+	char digits[8];
+	uint8_t len = 0;
+
+	do {
+		digits[len++] = "0123456789abcdef"[value & 0xF];
+		value >>= 4;
+	} while (value);
+	while (len < width) {
+		digits[len++] = '0';
+	}
+	while (len--) {
+		textBuf.push_back(digits[len]);
+	}
+}
+
+static void putDec(uint32_t value) {
+	char digits[10];
+	uint8_t len = 0;
+
+	do {
+		digits[len++] = '0' + value % 10;
+		value /= 10;
+	} while (value);
+	while (len--) {
+		textBuf.push_back(digits[len]);
+	}
+}
+
+static void writeSymName(std::string const &name) {
 	for (char const *ptr = name.c_str(); *ptr != '\0';) {
 		// Output legal ASCII characters as-is
 		if (char c = *ptr; continuesIdentifier(c)) {
-			putc(c, file);
+			putText(c);
 			++ptr;
 			continue;
 		}
@@ -295,34 +360,66 @@ static void writeSymName(std::string const &name, FILE *file) {
 			}
 			break;
 		} while (state != UTF8_ACCEPT);
-		fprintf(file, codepoint <= 0xFFFF ? "\\u%04" PRIx32 : "\\U%08" PRIx32, codepoint);
+		putText(codepoint <= 0xFFFF ? "\\u" : "\\U");
+		putHex(codepoint, codepoint <= 0xFFFF ? 4 : 8);
 	}
 }
 
-// Comparator function for `std::stable_sort` to sort symbols
+// Comparator function for `std::stable_sort` to break ties between same-address symbols
 static bool compareSymbols(SortedSymbol const &sym1, SortedSymbol const &sym2) {
 	std::string const &sym1_name = sym1.sym->name;
 	std::string const &sym2_name = sym2.sym->name;
 	bool sym1_local = sym1_name.find('.') != std::string::npos;
 	bool sym2_local = sym2_name.find('.') != std::string::npos;
 
-	// First, sort by address
-	// Second, sort by locality (global before local)
-	// Third, sort by parent address
-	// Fourth, sort by name
-	return std::tie(sym1.addr, sym1_local, sym1.parentAddr, sym1_name)
-	       < std::tie(sym2.addr, sym2_local, sym2.parentAddr, sym2_name);
+	// First, sort by locality (global before local)
+	// Second, sort by parent address
+	// Third, sort by name
+	return std::tie(sym1_local, sym1.parentAddr, sym1_name)
+	       < std::tie(sym2_local, sym2.parentAddr, sym2_name);
+}
+
+// Sorts a bank's symbols by address with a stable counting sort, comparing names only to
+// break ties; addresses are 16-bit, so one pass over a fixed histogram replaces the
+// string-heavy comparison sort
+static void sortSymbols(std::vector<SortedSymbol> &symList) {
+	// `firstIdx[addr]` becomes the index of the first symbol at `addr` in the sorted order
+	std::vector<uint32_t> firstIdx(0x10001, 0);
+	for (SortedSymbol const &sym : symList) {
+		++firstIdx[sym.addr + 1];
+	}
+	for (uint32_t addr = 0; addr < 0x10000; ++addr) {
+		firstIdx[addr + 1] += firstIdx[addr];
+	}
+
+	std::vector<SortedSymbol> sorted(symList.size());
+	std::vector<uint32_t> nextIdx(firstIdx.begin(), firstIdx.end() - 1);
+	for (SortedSymbol const &sym : symList) {
+		sorted[nextIdx[sym.addr]++] = sym;
+	}
+
+	// Same-address runs kept their input order, so a stable tie-break within each run
+	// reproduces the output of a full stable sort
+	for (uint32_t addr = 0; addr < 0x10000; ++addr) {
+		if (firstIdx[addr + 1] - firstIdx[addr] > 1) {
+			std::stable_sort(
+			    sorted.begin() + firstIdx[addr], sorted.begin() + firstIdx[addr + 1], compareSymbols
+			);
+		}
+	}
+
+	symList = std::move(sorted);
 }
 
 template<typename F>
 static void forEachSortedSection(SortedSections const &bankSections, F callback) {
 	for (Section const *sect : bankSections.zeroLenSections) {
-		for (; sect; sect = sect->nextu.get()) {
+		for (; sect; sect = sect->nextu) {
 			callback(*sect);
 		}
 	}
 	for (Section const *sect : bankSections.sections) {
-		for (; sect; sect = sect->nextu.get()) {
+		for (; sect; sect = sect->nextu) {
 			callback(*sect);
 		}
 	}
@@ -364,14 +461,17 @@ static void writeSymBank(SortedSections const &bankSections, SectionType type, u
 		}
 	});
 
-	std::stable_sort(RANGE(symList), compareSymbols);
+	sortSymbols(symList);
 
 	uint32_t symBank = bank + sectionTypeInfo[type].firstBank;
 
 	for (SortedSymbol &sym : symList) {
-		fprintf(symFile, "%02" PRIx32 ":%04" PRIx16 " ", symBank, sym.addr);
-		writeSymName(sym.sym->name, symFile);
-		putc('\n', symFile);
+		putHex(symBank, 2);
+		putText(':');
+		putHex(sym.addr, 4);
+		putText(' ');
+		writeSymName(sym.sym->name);
+		putText('\n');
 	}
 }
 
@@ -379,36 +479,35 @@ static void writeEmptySpace(uint16_t begin, uint16_t end) {
 	if (begin < end) {
 		uint16_t len = end - begin;
 
-		fprintf(
-		    mapFile,
-		    "\tEMPTY: $%04x-$%04x ($%04" PRIx16 " byte%s)\n",
-		    begin,
-		    end - 1,
-		    len,
-		    len == 1 ? "" : "s"
-		);
+		putText("\tEMPTY: $");
+		putHex(begin, 4);
+		putText("-$");
+		putHex(end - 1, 4);
+		putText(" ($");
+		putHex(len, 4);
+		putText(len == 1 ? " byte)\n" : " bytes)\n");
 	}
 }
 
-static void writeSectionName(std::string const &name, FILE *file) {
+static void writeSectionName(std::string const &name) {
 	for (char c : name) {
 		// Escape characters that need escaping
 		switch (c) {
 		case '\n':
-			fputs("\\n", file);
+			putText("\\n");
 			break;
 		case '\r':
-			fputs("\\r", file);
+			putText("\\r");
 			break;
 		case '\t':
-			fputs("\\t", file);
+			putText("\\t");
 			break;
 		case '\\':
 		case '"':
-			putc('\\', file);
+			putText('\\');
 			[[fallthrough]];
 		default:
-			putc(c, file);
+			putText(c);
 			break;
 		}
 	}
@@ -433,35 +532,36 @@ uint16_t forEachSection(SortedSections const &sectList, F callback) {
 }
 
 static void writeMapSymbols(Section const *sect) {
-	for (uint16_t org = sect->org; sect; sect = sect->nextu.get()) {
+	for (uint16_t org = sect->org; sect; sect = sect->nextu) {
 		for (Symbol *sym : sect->symbols) {
 			// Don't output symbols that begin with an illegal character
 			if (sym->name.empty() || !startsIdentifier(sym->name[0])) {
 				continue;
 			}
 			// Space matches "\tSECTION: $xxxx ..."
-			fprintf(mapFile, "\t         $%04" PRIx32 " = ", sym->label().offset + org);
-			writeSymName(sym->name, mapFile);
-			putc('\n', mapFile);
+			putText("\t         $");
+			putHex(sym->label().offset + org, 4);
+			putText(" = ");
+			writeSymName(sym->name);
+			putText('\n');
 		}
 
 		// Announce the following "piece"
 		if (SectionModifier mod = sect->nextu ? sect->nextu->modifier : SECTION_NORMAL;
 		    mod == SECTION_UNION) {
-			fputs("\t         ; Next union\n", mapFile);
+			putText("\t         ; Next union\n");
 		} else if (mod == SECTION_FRAGMENT) {
-			fputs("\t         ; Next fragment\n", mapFile);
+			putText("\t         ; Next fragment\n");
 		}
 	}
 }
 
 static void writeMapBank(SortedSections const &sectList, SectionType type, uint32_t bank) {
-	fprintf(
-	    mapFile,
-	    "\n%s bank #%" PRIu32 ":\n",
-	    sectionTypeInfo[type].name.c_str(),
-	    bank + sectionTypeInfo[type].firstBank
-	);
+	putText('\n');
+	putText(sectionTypeInfo[type].name.c_str());
+	putText(" bank #");
+	putDec(bank + sectionTypeInfo[type].firstBank);
+	putText(":\n");
 
 	uint16_t prevEndAddr = sectionTypeInfo[type].startAddr;
 	uint16_t used = forEachSection(sectList, [&](Section const &sect) {
@@ -471,13 +571,17 @@ static void writeMapBank(SortedSections const &sectList, SectionType type, uint3
 
 		prevEndAddr = sect.org + sect.size;
 
-		fprintf(mapFile, "\tSECTION: $%04" PRIx16, sect.org);
+		putText("\tSECTION: $");
+		putHex(sect.org, 4);
 		if (sect.size != 0) {
-			fprintf(mapFile, "-$%04x", prevEndAddr - 1);
+			putText("-$");
+			putHex(prevEndAddr - 1, 4);
 		}
-		fprintf(mapFile, " ($%04" PRIx16 " byte%s) [\"", sect.size, sect.size == 1 ? "" : "s");
-		writeSectionName(sect.name, mapFile);
-		fputs("\"]\n", mapFile);
+		putText(" ($");
+		putHex(sect.size, 4);
+		putText(sect.size == 1 ? " byte) [\"" : " bytes) [\"");
+		writeSectionName(sect.name);
+		putText("\"]\n");
 
 		if (!options.noSymInMap) {
 			// Also print symbols in the following "pieces"
@@ -486,7 +590,7 @@ static void writeMapBank(SortedSections const &sectList, SectionType type, uint3
 	});
 
 	if (used == 0) {
-		fputs("\tEMPTY\n", mapFile);
+		putText("\tEMPTY\n");
 	} else {
 		uint16_t bankEndAddr = sectionTypeInfo[type].startAddr + sectionTypeInfo[type].size;
 
@@ -494,12 +598,14 @@ static void writeMapBank(SortedSections const &sectList, SectionType type, uint3
 
 		uint16_t slack = sectionTypeInfo[type].size - used;
 
-		fprintf(mapFile, "\tTOTAL EMPTY: $%04" PRIx16 " byte%s\n", slack, slack == 1 ? "" : "s");
+		putText("\tTOTAL EMPTY: $");
+		putHex(slack, 4);
+		putText(slack == 1 ? " byte\n" : " bytes\n");
 	}
 }
 
 static void writeMapSummary() {
-	fputs("SUMMARY:\n", mapFile);
+	putText("SUMMARY:\n");
 
 	for (uint8_t i = 0; i < SECTTYPE_INVALID; ++i) {
 		SectionType type = typeMap[i];
@@ -521,18 +627,19 @@ static void writeMapSummary() {
 			usedTotal += forEachSection(sections[type][bank], [](Section const &) {});
 		}
 
-		fprintf(
-		    mapFile,
-		    "\t%s: %" PRId32 " byte%s used / %" PRId32 " free",
-		    sectionTypeInfo[type].name.c_str(),
-		    usedTotal,
-		    usedTotal == 1 ? "" : "s",
-		    nbBanks * sectionTypeInfo[type].size - usedTotal
-		);
+		putText('\t');
+		putText(sectionTypeInfo[type].name.c_str());
+		putText(": ");
+		putDec(usedTotal);
+		putText(usedTotal == 1 ? " byte used / " : " bytes used / ");
+		putDec(nbBanks * sectionTypeInfo[type].size - usedTotal);
+		putText(" free");
 		if (sectionTypeInfo[type].firstBank != sectionTypeInfo[type].lastBank || nbBanks > 1) {
-			fprintf(mapFile, " in %u bank%s", nbBanks, nbBanks == 1 ? "" : "s");
+			putText(" in ");
+			putDec(nbBanks);
+			putText(nbBanks == 1 ? " bank" : " banks");
 		}
-		putc('\n', mapFile);
+		putText('\n');
 	}
 }
 
@@ -553,7 +660,8 @@ static void writeSym() {
 	}
 	Defer closeSymFile{[&] { fclose(symFile); }};
 
-	fputs("; File generated by rgblink\n", symFile);
+	textBuf.clear();
+	putText("; File generated by rgblink\n");
 
 	for (uint8_t i = 0; i < SECTTYPE_INVALID; ++i) {
 		SectionType type = typeMap[i];
@@ -579,11 +687,135 @@ static void writeSym() {
 	});
 	for (Symbol *sym : constants) {
 		int32_t val = std::get<int32_t>(sym->data);
-		int width = val < 0x100 ? 2 : val < 0x10000 ? 4 : 8;
-		fprintf(symFile, "%0*" PRIx32 " ", width, val);
-		writeSymName(sym->name, symFile);
-		putc('\n', symFile);
+		uint8_t width = val < 0x100 ? 2 : val < 0x10000 ? 4 : 8;
+		putHex(static_cast<uint32_t>(val), width);
+		putText(' ');
+		writeSymName(sym->name);
+		putText('\n');
+	}
+
+	fwrite(textBuf.data(), 1, textBuf.size(), symFile);
+}
+
+// The binary map format (`--map-format=binary`): everything is little-endian and 32-bit
+// aligned, so tools can mmap the file and binary-search the fixed-width records directly.
+// The header is "RGBM", a revision number, then {count, offset} for the bank, section, and
+// symbol tables, and {offset, size} for the string table; offsets are from the file start.
+// Each bank record is the bank's section type and number, its used byte count, and the
+// index and count of its section records, then of its symbol records. Section records are
+// {name, address, size} and symbol records {name, address}, grouped by bank and sorted by
+// ascending address; names are offsets to NUL-terminated strings within the string table.
+static constexpr uint32_t BINARY_MAP_REV = 1;
+
+// Deduplicates the names referenced by the binary map's records.
+struct MapStringTable {
+	std::vector<uint8_t> bytes;
+	std::unordered_map<std::string, uint32_t> offsets;
+
+	uint32_t get(std::string const &name) {
+		auto [it, inserted] = offsets.try_emplace(name, bytes.size());
+		if (inserted) {
+			bytes.insert(bytes.end(), name.begin(), name.end());
+			bytes.push_back('\0');
+		}
+		return it->second;
+	}
+};
+
+static void writeBinaryMap() {
+	struct BankRecord {
+		uint32_t type, bank, used, firstSection, nbSections, firstSymbol, nbSymbols;
+	};
+	std::vector<BankRecord> bankRecords;
+	std::vector<uint32_t> sectionRecords; // 3 words per record: name, address, size
+	std::vector<uint32_t> symbolRecords;  // 2 words per record: name, address
+	MapStringTable strTab;
+
+	for (uint8_t i = 0; i < SECTTYPE_INVALID; ++i) {
+		SectionType type = typeMap[i];
+
+		for (uint32_t bank = 0; bank < sections[type].size(); ++bank) {
+			BankRecord rec = {
+			    .type = static_cast<uint32_t>(type),
+			    .bank = bank + sectionTypeInfo[type].firstBank,
+			    .used = 0,
+			    .firstSection = static_cast<uint32_t>(sectionRecords.size() / 3),
+			    .nbSections = 0,
+			    .firstSymbol = static_cast<uint32_t>(symbolRecords.size() / 2),
+			    .nbSymbols = 0,
+			};
+
+			rec.used = forEachSection(sections[type][bank], [&](Section const &sect) {
+				sectionRecords.insert(
+				    sectionRecords.end(), {strTab.get(sect.name), sect.org, sect.size}
+				);
+				++rec.nbSections;
+
+				if (options.noSymInMap) {
+					return;
+				}
+				// Also collect symbols in the section's union/fragment "pieces"
+				for (Section const *piece = &sect; piece; piece = piece->nextu) {
+					for (Symbol *sym : piece->symbols) {
+						// Same filter as the text map: skip illegally-named symbols
+						if (sym->name.empty() || !startsIdentifier(sym->name[0])) {
+							continue;
+						}
+						symbolRecords.insert(
+						    symbolRecords.end(),
+						    {strTab.get(sym->name),
+						     static_cast<uint32_t>(sect.org + sym->label().offset)}
+						);
+						++rec.nbSymbols;
+					}
+				}
+			});
+			bankRecords.push_back(rec);
+		}
 	}
+
+	std::vector<uint8_t> out;
+	auto putLong = [&out](uint32_t value) {
+		for (uint8_t shift = 0; shift < 32; shift += 8) {
+			out.push_back(value >> shift);
+		}
+	};
+
+	uint32_t banksOfs = 4 + 9 * sizeof(uint32_t); // Right after the header
+	uint32_t sectionsOfs = banksOfs + bankRecords.size() * 7 * sizeof(uint32_t);
+	uint32_t symbolsOfs = sectionsOfs + sectionRecords.size() * sizeof(uint32_t);
+	uint32_t strTabOfs = symbolsOfs + symbolRecords.size() * sizeof(uint32_t);
+
+	out.reserve(strTabOfs + strTab.bytes.size());
+	out.insert(out.end(), {'R', 'G', 'B', 'M'});
+	putLong(BINARY_MAP_REV);
+	putLong(bankRecords.size());
+	putLong(banksOfs);
+	putLong(sectionRecords.size() / 3);
+	putLong(sectionsOfs);
+	putLong(symbolRecords.size() / 2);
+	putLong(symbolsOfs);
+	putLong(strTabOfs);
+	putLong(strTab.bytes.size());
+
+	for (BankRecord const &rec : bankRecords) {
+		putLong(rec.type);
+		putLong(rec.bank);
+		putLong(rec.used);
+		putLong(rec.firstSection);
+		putLong(rec.nbSections);
+		putLong(rec.firstSymbol);
+		putLong(rec.nbSymbols);
+	}
+	for (uint32_t word : sectionRecords) {
+		putLong(word);
+	}
+	for (uint32_t word : symbolRecords) {
+		putLong(word);
+	}
+	out.insert(out.end(), RANGE(strTab.bytes));
+
+	fwrite(out.data(), 1, out.size(), mapFile);
 }
 
 static void writeMap() {
@@ -592,10 +824,11 @@ static void writeMap() {
 	}
 
 	if (strcmp(options.mapFileName, "-")) {
-		mapFile = fopen(options.mapFileName, "w");
+		mapFile = fopen(options.mapFileName, options.binaryMapFormat ? "wb" : "w");
 	} else {
 		options.mapFileName = "<stdout>";
-		(void)setmode(STDOUT_FILENO, O_TEXT); // May have been set to O_BINARY previously
+		// May have been set to the other mode previously
+		(void)setmode(STDOUT_FILENO, options.binaryMapFormat ? O_BINARY : O_TEXT);
 		mapFile = stdout;
 	}
 	if (!mapFile) {
@@ -603,6 +836,12 @@ static void writeMap() {
 	}
 	Defer closeMapFile{[&] { fclose(mapFile); }};
 
+	if (options.binaryMapFormat) {
+		writeBinaryMap();
+		return;
+	}
+
+	textBuf.clear();
 	writeMapSummary();
 
 	for (uint8_t i = 0; i < SECTTYPE_INVALID; ++i) {
@@ -612,6 +851,8 @@ static void writeMap() {
 			writeMapBank(sections[type][bank], type, bank);
 		}
 	}
+
+	fwrite(textBuf.data(), 1, textBuf.size(), mapFile);
 }
 
 void out_WriteFiles() {
@@ -2,10 +2,13 @@
 
 #include "link/patch.hpp"
 
+#include <algorithm>
 #include <deque>
 #include <inttypes.h>
 #include <limits.h>
 #include <stdint.h>
+#include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
@@ -15,6 +18,8 @@
 #include "opmath.hpp"
 #include "verbosity.hpp"
 
+#include "link/object.hpp"
+#include "link/pool.hpp"
 #include "link/section.hpp"
 #include "link/symbol.hpp"
 #include "link/warning.hpp"
@@ -26,20 +31,34 @@ struct RPNStackEntry {
 	bool errorFlag; // Whether the value is a placeholder inserted for error recovery
 };
 
-static std::deque<RPNStackEntry> rpnStack;
+// Evaluation stack, reused across patches; `clear()` keeps the allocation, so after the
+// deepest expression has been seen, evaluation no longer allocates at all.
+// `thread_local` since sections are patched on a thread pool.
+static thread_local std::vector<RPNStackEntry> rpnStack;
 
 static void pushRPN(int32_t value, bool comesFromError) {
-	rpnStack.push_front({.value = value, .errorFlag = comesFromError});
+	rpnStack.push_back({.value = value, .errorFlag = comesFromError});
 }
 
 // This flag tracks whether the RPN op that is currently being evaluated
 // has popped any values with the error flag set.
-static bool isError = false;
+static thread_local bool isError = false;
+
+// Set while a worker thread evaluates a section's patches speculatively: diagnostics are
+// not printed, only recorded, and the section is re-patched sequentially afterwards so its
+// diagnostics come out in section order, as if patching had been sequential throughout.
+// The patched bytes themselves are identical either way, so re-patching is idempotent.
+static thread_local bool quietEval = false;
+static thread_local bool sawDiagnostic = false;
 
 #define diagnosticAt(patch, id, ...) \
 	do { \
 		bool errorDiag = warnings.getWarningBehavior(id) == WarningBehavior::ERROR; \
-		if (!isError || !errorDiag) { \
+		if (quietEval) { \
+			if (warnings.getWarningBehavior(id) != WarningBehavior::DISABLED) { \
+				sawDiagnostic = true; \
+			} \
+		} else if (!isError || !errorDiag) { \
 			warningAt(patch, id, __VA_ARGS__); \
 		} \
 		if (errorDiag) { \
@@ -47,10 +66,20 @@ static bool isError = false;
 		} \
 	} while (0)
 
+// Like `errorAt`, but suppressed (and only recorded) during speculative evaluation
+#define evalErrorAt(...) \
+	do { \
+		if (quietEval) { \
+			sawDiagnostic = true; \
+		} else { \
+			errorAt(__VA_ARGS__); \
+		} \
+	} while (0)
+
 #define firstErrorAt(...) \
 	do { \
 		if (!isError) { \
-			errorAt(__VA_ARGS__); \
+			evalErrorAt(__VA_ARGS__); \
 			isError = true; \
 		} \
 	} while (0)
@@ -60,9 +89,9 @@ static int32_t popRPN(Patch const &patch) {
 		fatalAt(patch, "Internal error, RPN stack empty");
 	}
 
-	RPNStackEntry entry = rpnStack.front();
+	RPNStackEntry entry = rpnStack.back();
 
-	rpnStack.pop_front();
+	rpnStack.pop_back();
 	isError |= entry.errorFlag;
 	return entry.value;
 }
@@ -79,6 +108,9 @@ static uint32_t getRPNByte(uint8_t const *&expression, int32_t &size, Patch cons
 
 static Symbol const *getSymbol(std::vector<Symbol> const &symbolList, uint32_t index) {
 	assume(index != UINT32_MAX); // PC needs to be handled specially, not here
+	// Parse the record now if the object reader deferred it (a pure read otherwise; the
+	// concurrent phase only ever sees records materialized by `patch_ApplyPatches`' pre-pass)
+	obj_MaterializeSymbol(symbolList, index);
 	Symbol const &symbol = symbolList[index];
 
 	// If the symbol is defined elsewhere...
@@ -91,8 +123,8 @@ static Symbol const *getSymbol(std::vector<Symbol> const &symbolList, uint32_t i
 
 // Compute a patch's value from its RPN string.
 static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fileSymbols) {
-	uint8_t const *expression = patch.rpnExpression.data();
-	int32_t size = static_cast<int32_t>(patch.rpnExpression.size());
+	uint8_t const *expression = patch.rpnExpression->bytes;
+	int32_t size = static_cast<int32_t>(patch.rpnExpression->size);
 
 	rpnStack.clear();
 
@@ -277,7 +309,7 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 			}
 
 			if (Symbol const *symbol = getSymbol(fileSymbols, value); !symbol) {
-				errorAt(
+				evalErrorAt(
 				    patch,
 				    "Requested `BANK()` of undefined symbol `%s`",
 				    fileSymbols[value].name.c_str()
@@ -287,7 +319,7 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 			} else if (std::holds_alternative<Label>(symbol->data)) {
 				value = std::get<Label>(symbol->data).section->bank;
 			} else {
-				errorAt(
+				evalErrorAt(
 				    patch,
 				    "Requested `BANK()` of non-label symbol `%s`",
 				    fileSymbols[value].name.c_str()
@@ -304,7 +336,7 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 			while (getRPNByte(expression, size, patch)) {}
 
 			if (Section const *sect = sect_GetSection(name); !sect) {
-				errorAt(patch, "Requested `BANK()` of undefined section \"%s\"", name);
+				evalErrorAt(patch, "Requested `BANK()` of undefined section \"%s\"", name);
 				isError = true;
 				value = 1;
 			} else {
@@ -315,7 +347,7 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 
 		case RPN_BANK_SELF:
 			if (!patch.pcSection) {
-				errorAt(patch, "PC has no bank outside of a section");
+				evalErrorAt(patch, "PC has no bank outside of a section");
 				isError = true;
 				value = 1;
 			} else {
@@ -329,7 +361,7 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 			while (getRPNByte(expression, size, patch)) {}
 
 			if (Section const *sect = sect_GetSection(name); !sect) {
-				errorAt(patch, "Requested `SIZEOF()` of undefined section \"%s\"", name);
+				evalErrorAt(patch, "Requested `SIZEOF()` of undefined section \"%s\"", name);
 				isError = true;
 				value = 1;
 			} else {
@@ -344,7 +376,7 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 			while (getRPNByte(expression, size, patch)) {}
 
 			if (Section const *sect = sect_GetSection(name); !sect) {
-				errorAt(patch, "Requested `STARTOF()` of undefined section \"%s\"", name);
+				evalErrorAt(patch, "Requested `STARTOF()` of undefined section \"%s\"", name);
 				isError = true;
 				value = 1;
 			} else {
@@ -357,7 +389,7 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 		case RPN_SIZEOF_SECTTYPE:
 			value = getRPNByte(expression, size, patch);
 			if (value < 0 || value >= SECTTYPE_INVALID) {
-				errorAt(patch, "Requested `SIZEOF()` of an invalid section type");
+				evalErrorAt(patch, "Requested `SIZEOF()` of an invalid section type");
 				isError = true;
 				value = 0;
 			} else {
@@ -368,7 +400,7 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 		case RPN_STARTOF_SECTTYPE:
 			value = getRPNByte(expression, size, patch);
 			if (value < 0 || value >= SECTTYPE_INVALID) {
-				errorAt(patch, "Requested `STARTOF()` of an invalid section type");
+				evalErrorAt(patch, "Requested `STARTOF()` of an invalid section type");
 				isError = true;
 				value = 0;
 			} else {
@@ -430,13 +462,15 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 				if (patch.pcSection) {
 					value = patch.pcOffset + patch.pcSection->org;
 				} else {
-					errorAt(patch, "PC has no value outside of a section");
+					evalErrorAt(patch, "PC has no value outside of a section");
 					value = 0;
 					isError = true;
 				}
 			} else if (Symbol const *symbol = getSymbol(fileSymbols, value); !symbol) {
-				errorAt(patch, "Undefined symbol `%s`", fileSymbols[value].name.c_str());
-				sym_TraceLocalAliasedSymbols(fileSymbols[value].name);
+				evalErrorAt(patch, "Undefined symbol `%s`", fileSymbols[value].name.c_str());
+				if (!quietEval) {
+					sym_TraceLocalAliasedSymbols(fileSymbols[value].name);
+				}
 				isError = true;
 			} else if (std::holds_alternative<Label>(symbol->data)) {
 				Label const &label = std::get<Label>(symbol->data);
@@ -451,13 +485,147 @@ static int32_t computeRPNExpr(Patch const &patch, std::vector<Symbol> const &fil
 	}
 
 	if (rpnStack.size() > 1) {
-		errorAt(patch, "RPN stack has %zu entries on exit, not 1", rpnStack.size());
+		evalErrorAt(patch, "RPN stack has %zu entries on exit, not 1", rpnStack.size());
 	}
 
 	isError = false;
 	return popRPN(patch);
 }
 
+// Garbage collection of unreferenced sections (`-g`)
+
+// Unions and fragments were merged as the object files were read, so reachability is
+// tracked per merged section; this maps each component back to its merged section.
+static std::unordered_map<Section const *, Section *> componentOwners;
+static std::unordered_set<Section const *> reachableSections;
+static std::vector<Section *> reachableWorklist;
+
+static void markReachable(Section const *component) {
+	if (!component) {
+		return;
+	}
+
+	auto search = componentOwners.find(component);
+	assume(search != componentOwners.end());
+	if (Section *section = search->second; reachableSections.insert(section).second) {
+		reachableWorklist.push_back(section);
+	}
+}
+
+// Walks a patch's RPN expression without evaluating it, reporting each symbol index and
+// each section name that the expression references.
+template<typename SymFn, typename SectFn>
+static void forEachPatchTarget(Patch const &patch, SymFn onSymIndex, SectFn onSectName) {
+	uint8_t const *expression = patch.rpnExpression->bytes;
+	int32_t size = static_cast<int32_t>(patch.rpnExpression->size);
+
+	while (size > 0) {
+		RPNCommand command = static_cast<RPNCommand>(getRPNByte(expression, size, patch));
+
+		switch (command) {
+		case RPN_BANK_SYM:
+		case RPN_SYM: {
+			uint32_t index = 0;
+			for (uint8_t shift = 0; shift < 32; shift += 8) {
+				index |= getRPNByte(expression, size, patch) << shift;
+			}
+
+			// PC refers to the patched section itself, and is not a symbol reference
+			if (index != UINT32_MAX) {
+				onSymIndex(index);
+			}
+			break;
+		}
+
+		case RPN_BANK_SECT:
+		case RPN_SIZEOF_SECT:
+		case RPN_STARTOF_SECT: {
+			// This has assumptions commented in `computeRPNExpr`'s `RPN_BANK_SECT` case.
+			char const *name = reinterpret_cast<char const *>(expression);
+			while (getRPNByte(expression, size, patch)) {}
+
+			onSectName(name);
+			break;
+		}
+
+		case RPN_SIZEOF_SECTTYPE:
+		case RPN_STARTOF_SECTTYPE:
+		case RPN_BIT_INDEX:
+			getRPNByte(expression, size, patch);
+			break;
+
+		case RPN_CONST:
+			for (uint8_t shift = 0; shift < 32; shift += 8) {
+				getRPNByte(expression, size, patch);
+			}
+			break;
+
+		default: // Operators carry no immediate operands
+			break;
+		}
+	}
+}
+
+// Marks the sections that `patch`'s RPN expression references, without evaluating it.
+static void markPatchTargets(Patch const &patch, std::vector<Symbol> const &fileSymbols) {
+	forEachPatchTarget(
+	    patch,
+	    [&](uint32_t index) {
+		    // Constants reference no section, and undefined symbols are diagnosed when the
+		    // patch is evaluated
+		    if (Symbol const *symbol = getSymbol(fileSymbols, index);
+		        symbol && std::holds_alternative<Label>(symbol->data)) {
+			    markReachable(std::get<Label>(symbol->data).section);
+		    }
+	    },
+	    [](char const *name) { markReachable(sect_GetSection(name)); }
+	);
+}
+
+void patch_PruneSections() {
+	verbosePrint(VERB_NOTICE, "Pruning unreferenced sections...\n");
+
+	sect_ForEach([](Section &section) {
+		for (Section *component = &section; component; component = component->nextu) {
+			componentOwners[component] = &section;
+		}
+	});
+
+	// Fixed-address sections are the roots: the hardware vectors, the header, and anything
+	// placed by the linker script. Assertions must also remain evaluable.
+	sect_ForEach([](Section &section) {
+		if (section.isAddressFixed) {
+			markReachable(&section);
+		}
+	});
+	for (Assertion &assert : assertions) {
+		markReachable(assert.patch.pcSection);
+		markPatchTargets(assert.patch, *assert.fileSymbols);
+	}
+
+	while (!reachableWorklist.empty()) {
+		Section *section = reachableWorklist.back();
+		reachableWorklist.pop_back();
+
+		for (Section *component = section; component; component = component->nextu) {
+			for (Patch const &patch : component->patches) {
+				markPatchTargets(patch, *component->fileSymbols);
+			}
+		}
+	}
+
+	sect_KeepIf([](Section &section) {
+		if (reachableSections.find(&section) != reachableSections.end()) {
+			return true;
+		}
+		verbosePrint(VERB_INFO, "Discarding unreferenced section \"%s\"\n", section.name.c_str());
+		return false;
+	});
+
+	componentOwners.clear();
+	reachableSections.clear();
+}
+
 Assertion &patch_AddAssertion() {
 	return assertions.emplace_front();
 }
@@ -544,7 +712,7 @@ static void applyFilePatches(Section &section, Section &dataSection) {
 		uint8_t typeSize = typeSizes[patch.type];
 
 		if (dataSection.data.size() < offset + typeSize) {
-			errorAt(
+			evalErrorAt(
 			    patch,
 			    "Patch would write %zu bytes past the end of section \"%s\" (%zu bytes long)",
 			    offset + typeSize - dataSection.data.size(),
@@ -583,11 +751,64 @@ static void applyPatches(Section &section) {
 		return;
 	}
 
-	for (Section *component = &section; component; component = component->nextu.get()) {
+	for (Section *component = &section; component; component = component->nextu) {
 		applyFilePatches(*component, section);
 	}
 }
 
 void patch_ApplyPatches() {
-	sect_ForEach(applyPatches);
+	// Patches only write into their own section's data and read addresses that assignment
+	// has already fixed, so sections can be patched concurrently
+	static std::vector<Section *> sects; // `static` so the `sect_ForEach` callback can see it
+	sect_ForEach([](Section &section) { sects.push_back(&section); });
+
+	size_t nbThreads = std::min<size_t>(pool_GetNbThreads(), sects.size());
+
+	// Build the warning-behavior cache up front, so the workers' lookups are pure reads
+	(void)warnings.getWarningBehavior(WARNING_TRUNCATION_1);
+
+	// Materializing a deferred symbol record writes into the shared symbol tables, so parse
+	// every record the patches reference before the workers start; after this pass, the
+	// materialization hook in `getSymbol` only ever reads
+	if (nbThreads > 1 && obj_HasDeferredSymbols()) {
+		for (Section *section : sects) {
+			if (!sectTypeHasData(section->type)) {
+				continue;
+			}
+			for (Section *component = section; component; component = component->nextu) {
+				std::vector<Symbol> const &fileSymbols = *component->fileSymbols;
+				for (Patch const &patch : component->patches) {
+					forEachPatchTarget(
+					    patch,
+					    [&](uint32_t index) { obj_MaterializeSymbol(fileSymbols, index); },
+					    [](char const *) {}
+					);
+				}
+			}
+		}
+	}
+
+	if (nbThreads <= 1) {
+		for (Section *section : sects) {
+			applyPatches(*section);
+		}
+		return;
+	}
+
+	std::vector<uint8_t> needsRerun(sects.size(), 0);
+	pool_ForEach(sects.size(), [&](size_t i) {
+		quietEval = true;
+		sawDiagnostic = false;
+		applyPatches(*sects[i]);
+		needsRerun[i] = sawDiagnostic;
+	});
+	quietEval = false; // The calling thread worked on items too; the re-patches must report
+
+	// Re-patch the sections that had something to report, sequentially and in section
+	// order, so the diagnostics print exactly as they would have without the thread pool
+	for (size_t i = 0; i < sects.size(); ++i) {
+		if (needsRerun[i]) {
+			applyPatches(*sects[i]);
+		}
+	}
 }
@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: MIT
+
+#include "link/plan.hpp"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <optional>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "helpers.hpp" // Defer
+#include "linkdefs.hpp"
+#include "verbosity.hpp"
+
+#include "link/layout.hpp"
+#include "link/main.hpp"
+#include "link/warning.hpp"
+
+// A layout plan is the sequence of layout commands a linker script executed, with every
+// argument already resolved to a number, so replaying it needs no lexing or parsing.
+// The plan also records the content hash of every script file it was compiled from, and
+// is only replayed while those are unchanged; otherwise the script is simply re-run.
+//
+// Opcodes (arguments are decimal; a placement's section name runs to the end of the line):
+//   F <type>          `layout_SetFloatingSectionType`
+//   T <type>          `layout_SetSectionType`
+//   B <type> <bank>   `layout_SetSectionType` with a bank
+//   O <addr>          `layout_SetAddr`
+//   f                 `layout_MakeAddrFloating`
+//   A <align> <ofs>   `layout_AlignTo`
+//   P <length>        `layout_Pad`
+//   S <opt> <name>    `layout_PlaceSection`
+
+struct PlanCommand {
+	char op;
+	uint32_t arg1;
+	uint32_t arg2;
+	std::string name; // Only for 'S'
+};
+
+struct ClosureFile {
+	uint64_t hash;
+	std::string path;
+};
+
+static bool recording;
+static std::vector<PlanCommand> commands;
+static std::vector<ClosureFile> closure;
+
+static char const planHeader[] = "; rgblink layout plan\n";
+
+// FNV-1a, the same file fingerprint the placement cache uses for its options key
+static std::optional<uint64_t> hashFileContents(std::string const &path) {
+	FILE *file = fopen(path.c_str(), "rb");
+	if (!file) {
+		return std::nullopt;
+	}
+	Defer closeFile{[&] { fclose(file); }};
+
+	uint64_t hash = 0xCBF29CE484222325;
+	for (uint8_t chunk[65536];;) {
+		size_t n = fread(chunk, 1, sizeof(chunk), file);
+		for (size_t i = 0; i < n; ++i) {
+			hash = (hash ^ chunk[i]) * 0x100000001B3;
+		}
+		if (n < sizeof(chunk)) {
+			break;
+		}
+	}
+	return ferror(file) ? std::nullopt : std::optional<uint64_t>(hash);
+}
+
+void plan_StartRecording() {
+	recording = true;
+}
+
+void plan_RecordFile(std::string const &path) {
+	if (!recording) {
+		return;
+	}
+	if (std::optional<uint64_t> hash = hashFileContents(path); hash) {
+		closure.push_back({.hash = *hash, .path = path});
+	}
+}
+
+void plan_RecordCommand(char op, uint32_t arg1, uint32_t arg2) {
+	if (recording) {
+		commands.push_back({.op = op, .arg1 = arg1, .arg2 = arg2, .name = std::string()});
+	}
+}
+
+void plan_RecordPlace(std::string const &name, bool isOptional) {
+	if (recording) {
+		commands.push_back({.op = 'S', .arg1 = isOptional, .arg2 = 0, .name = name});
+	}
+}
+
+static void runCommand(PlanCommand const &command) {
+	switch (command.op) {
+	case 'F':
+		layout_SetFloatingSectionType(static_cast<SectionType>(command.arg1));
+		break;
+	case 'T':
+		layout_SetSectionType(static_cast<SectionType>(command.arg1));
+		break;
+	case 'B':
+		layout_SetSectionType(static_cast<SectionType>(command.arg1), command.arg2);
+		break;
+	case 'O':
+		layout_SetAddr(command.arg1);
+		break;
+	case 'f':
+		layout_MakeAddrFloating();
+		break;
+	case 'A':
+		layout_AlignTo(command.arg1, command.arg2);
+		break;
+	case 'P':
+		layout_Pad(command.arg1);
+		break;
+	case 'S':
+		layout_PlaceSection(command.name, command.arg1);
+		break;
+		// LCOV_EXCL_START
+	default:
+		unreachable_(); // The parser below rejects any other opcode
+	}
+	// LCOV_EXCL_STOP
+}
+
+bool plan_TryReplay(char const *linkerScriptName) {
+	FILE *file = fopen(options.layoutPlanName, "r");
+	if (!file) {
+		// The first link of a project has no plan yet
+		verbosePrint(
+		    VERB_NOTICE, "No layout plan at %s, running the linker script\n",
+		    options.layoutPlanName
+		);
+		return false;
+	}
+	Defer closeFile{[&] { fclose(file); }};
+
+	char line[4096];
+	size_t nbFiles;
+	if (!fgets(line, sizeof(line), file) || strcmp(line, planHeader) != 0
+	    || !fgets(line, sizeof(line), file) || sscanf(line, "%zu", &nbFiles) != 1) {
+		warnx("Ignoring layout plan \"%s\": bad header", options.layoutPlanName);
+		return false;
+	}
+
+	// The plan is only valid while every script file it was compiled from is unchanged
+	// (and the script passed on the command line is still the one it came from)
+	for (size_t i = 0; i < nbFiles; ++i) {
+		uint64_t hash;
+		int pathOfs;
+		if (!fgets(line, sizeof(line), file)
+		    || sscanf(line, "%" SCNx64 " %n", &hash, &pathOfs) != 1) {
+			warnx("Ignoring layout plan \"%s\": bad header", options.layoutPlanName);
+			return false;
+		}
+		char *path = line + pathOfs;
+		path[strcspn(path, "\n")] = '\0';
+		if (i == 0 && strcmp(path, linkerScriptName) != 0) {
+			verbosePrint(
+			    VERB_NOTICE, "Ignoring layout plan %s: compiled from a different script\n",
+			    options.layoutPlanName
+			);
+			return false;
+		}
+		if (std::optional<uint64_t> current = hashFileContents(path); !current || *current != hash) {
+			verbosePrint(
+			    VERB_NOTICE, "Ignoring layout plan %s: %s changed\n", options.layoutPlanName, path
+			);
+			return false;
+		}
+	}
+
+	// Parse all commands before executing any, so a corrupt plan does not apply half of a
+	// layout before being rejected
+	std::vector<PlanCommand> parsed;
+	while (fgets(line, sizeof(line), file)) {
+		PlanCommand command = {.op = line[0], .arg1 = 0, .arg2 = 0, .name = std::string()};
+		bool ok;
+		switch (command.op) {
+		case 'F':
+		case 'T':
+			ok = sscanf(line + 1, "%" SCNu32, &command.arg1) == 1
+			     && command.arg1 < SECTTYPE_INVALID;
+			break;
+		case 'B':
+			ok = sscanf(line + 1, "%" SCNu32 " %" SCNu32, &command.arg1, &command.arg2) == 2
+			     && command.arg1 < SECTTYPE_INVALID;
+			break;
+		case 'O':
+		case 'P':
+			ok = sscanf(line + 1, "%" SCNu32, &command.arg1) == 1;
+			break;
+		case 'f':
+			ok = true;
+			break;
+		case 'A':
+			ok = sscanf(line + 1, "%" SCNu32 " %" SCNu32, &command.arg1, &command.arg2) == 2;
+			break;
+		case 'S': {
+			int nameOfs;
+			ok = sscanf(line + 1, "%" SCNu32 " %n", &command.arg1, &nameOfs) == 1;
+			if (ok) {
+				char *name = line + 1 + nameOfs;
+				name[strcspn(name, "\n")] = '\0';
+				command.name = name;
+			}
+			break;
+		}
+		default:
+			ok = false;
+			break;
+		}
+		if (!ok) {
+			warnx("Ignoring layout plan \"%s\": bad command", options.layoutPlanName);
+			return false;
+		}
+		parsed.push_back(std::move(command));
+	}
+
+	verbosePrint(
+	    VERB_NOTICE, "Replaying %zu layout commands from %s\n", parsed.size(),
+	    options.layoutPlanName
+	);
+	for (PlanCommand const &command : parsed) {
+		runCommand(command);
+	}
+	return true;
+}
+
+void plan_Write() {
+	for (PlanCommand const &command : commands) {
+		// The format keeps a placement's section name last, up to the end of the line, so
+		// names containing newlines cannot round-trip
+		if (command.name.find('\n') != std::string::npos
+		    || command.name.find('\r') != std::string::npos) {
+			warnx(
+			    "Not writing layout plan \"%s\": a section name contains a newline",
+			    options.layoutPlanName
+			);
+			return;
+		}
+	}
+
+	FILE *file = fopen(options.layoutPlanName, "w");
+	if (!file) {
+		warnx(
+		    "Failed to write layout plan \"%s\": %s", options.layoutPlanName, strerror(errno)
+		);
+		return;
+	}
+
+	fputs(planHeader, file);
+	fprintf(file, "%zu\n", closure.size());
+	for (ClosureFile const &closureFile : closure) {
+		fprintf(file, "%016" PRIx64 " %s\n", closureFile.hash, closureFile.path.c_str());
+	}
+	for (PlanCommand const &command : commands) {
+		switch (command.op) {
+		case 'F':
+		case 'T':
+		case 'O':
+		case 'P':
+			fprintf(file, "%c %" PRIu32 "\n", command.op, command.arg1);
+			break;
+		case 'B':
+		case 'A':
+			fprintf(file, "%c %" PRIu32 " %" PRIu32 "\n", command.op, command.arg1, command.arg2);
+			break;
+		case 'f':
+			fputs("f\n", file);
+			break;
+		case 'S':
+			fprintf(file, "S %" PRIu32 " %s\n", command.arg1, command.name.c_str());
+			break;
+			// LCOV_EXCL_START
+		default:
+			unreachable_();
+		}
+		// LCOV_EXCL_STOP
+	}
+	fclose(file);
+}
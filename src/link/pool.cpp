@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+
+#include "link/pool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#ifdef _MSC_VER
+	#include <process.h>
+	#define getpid _getpid
+#else
+	#include <unistd.h>
+#endif
+
+// One work pool shared by every parallel phase of the link (object parsing, per-region
+// assignment, patch application). Phases hand `pool_ForEach` a counter-based work list:
+// each thread repeatedly claims the next unclaimed item, which balances uneven item costs
+// without any per-item bookkeeping beyond one atomic increment.
+
+struct Pool {
+	std::mutex mutex;
+	std::condition_variable wake; // Signals workers that `taskID` changed
+	std::condition_variable idle; // Signals the submitter that `nbWorking` reached 0
+	uint64_t taskID = 0;          // Bumped to publish a new task (guarded by `mutex`)
+	size_t nbWorking = 0;         // Workers still running the current task
+	std::function<void(size_t)> const *task = nullptr;
+	size_t nbItems = 0;
+	std::atomic<size_t> nextItem = 0;
+	size_t nbWorkers;
+};
+
+// The pool is leaked rather than destroyed, since its detached workers may still be parked
+// on its condition variable when the process exits
+static Pool *pool = nullptr;
+static bool spawned = false; // Distinguishes "not yet spawned" from "spawned, single-threaded"
+static long owner;           // Forked children (`--profile`) only inherit the calling thread,
+                             // so they must spawn workers of their own
+static size_t nbRequestedThreads = 0; // `--threads`; 0 picks the hardware's concurrency
+
+void pool_SetNbThreads(size_t nbThreads) {
+	nbRequestedThreads = nbThreads;
+}
+
+size_t pool_GetNbThreads() {
+	size_t nbThreads =
+	    nbRequestedThreads ? nbRequestedThreads : std::thread::hardware_concurrency();
+	return nbThreads > 0 ? nbThreads : 1;
+}
+
+static void workerLoop(Pool *p) {
+	uint64_t lastTaskID = 0;
+	for (;;) {
+		{
+			std::unique_lock lock(p->mutex);
+			p->wake.wait(lock, [&] { return p->taskID != lastTaskID; });
+			lastTaskID = p->taskID;
+		}
+		for (size_t i; (i = p->nextItem.fetch_add(1)) < p->nbItems;) {
+			(*p->task)(i);
+		}
+		{
+			std::lock_guard lock(p->mutex);
+			if (--p->nbWorking == 0) {
+				p->idle.notify_one();
+			}
+		}
+	}
+}
+
+// Returns the worker pool, spawning it on first use (and again after a `fork`), or
+// `nullptr` when the work is to run on the calling thread alone
+static Pool *getPool() {
+	if (spawned && owner != static_cast<long>(getpid())) {
+		spawned = false; // The workers did not survive the fork; leak their pool
+		pool = nullptr;
+	}
+	if (!spawned) {
+		spawned = true;
+		owner = static_cast<long>(getpid());
+		if (size_t nbThreads = pool_GetNbThreads(); nbThreads > 1) {
+			pool = new Pool();
+			pool->nbWorkers = nbThreads - 1; // The submitting thread works too
+			for (size_t i = 0; i < pool->nbWorkers; ++i) {
+				std::thread(workerLoop, pool).detach();
+			}
+		}
+	}
+	return pool;
+}
+
+void pool_ForEach(size_t nbItems, std::function<void(size_t)> const &task) {
+	Pool *p = nbItems > 1 ? getPool() : nullptr;
+	if (!p) {
+		for (size_t i = 0; i < nbItems; ++i) {
+			task(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard lock(p->mutex);
+		p->task = &task;
+		p->nbItems = nbItems;
+		p->nextItem = 0;
+		p->nbWorking = p->nbWorkers;
+		++p->taskID;
+	}
+	p->wake.notify_all();
+	for (size_t i; (i = p->nextItem.fetch_add(1)) < nbItems;) {
+		task(i);
+	}
+	std::unique_lock lock(p->mutex);
+	p->idle.wait(lock, [&] { return p->nbWorking == 0; });
+}
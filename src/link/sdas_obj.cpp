@@ -4,7 +4,6 @@
 
 #include <ctype.h>
 #include <inttypes.h>
-#include <memory>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -15,8 +14,10 @@
 #include "helpers.hpp" // assume, literal_strlen
 #include "linkdefs.hpp"
 #include "platform.hpp"
+#include "util.hpp" // fnv1a64
 
 #include "link/fstack.hpp"
+#include "link/object.hpp" // obj_InternRPN
 #include "link/section.hpp"
 #include "link/symbol.hpp"
 #include "link/warning.hpp"
@@ -32,34 +33,38 @@ struct Location {
 	uint32_t lineNo;
 };
 
-static void consumeLF(Location const &where, FILE *file) {
-	if (getc(file) != '\n') {
+static void consumeLF(Location const &where, char *&cursor, char const *end) {
+	if (cursor == end || *cursor++ != '\n') {
 		fatalAt(where, "Bad line ending (CR without LF)");
 	}
 }
 
 static char const *delim = " \f\n\r\t\v"; // Whitespace according to the C and POSIX locales
 
-static int nextLine(std::vector<char> &lineBuf, Location &where, FILE *file) {
+// Returns the first character of the next non-comment line, or EOF, and points `line` at the
+// line's remaining characters; those are NUL-terminated in place within the file buffer, so
+// tokenizing them copies nothing.
+static int nextLine(char *&line, Location &where, char *&cursor, char *end) {
 	int firstChar;
 	for (;;) {
 		++where.lineNo;
-		firstChar = getc(file);
-		lineBuf.clear();
+		if (cursor == end) {
+			return EOF;
+		}
+		firstChar = static_cast<uint8_t>(*cursor++);
 
 		switch (firstChar) {
-		case EOF:
-			return EOF;
 		case ';':
 			// Discard comment line
 			// TODO: if `;!FILE [...]` on the first line (`where.lineNo`), return it
-			do {
-				firstChar = getc(file);
-			} while (firstChar != EOF && firstChar != '\r' && firstChar != '\n');
+			while (cursor != end && *cursor != '\r' && *cursor != '\n') {
+				++cursor;
+			}
+			firstChar = cursor != end ? static_cast<uint8_t>(*cursor++) : EOF;
 			[[fallthrough]];
 		case '\r':
-			if (firstChar == '\r' && getc(file) != '\n') {
-				consumeLF(where, file);
+			if (firstChar == '\r' && (cursor == end || *cursor++ != '\n')) {
+				consumeLF(where, cursor, end);
 			}
 			[[fallthrough]];
 		case '\n':
@@ -68,20 +73,20 @@ static int nextLine(std::vector<char> &lineBuf, Location &where, FILE *file) {
 		break;
 	}
 
-	for (;;) {
-		int c = getc(file);
+	line = cursor;
+	while (cursor != end && *cursor != '\r' && *cursor != '\n') {
+		++cursor;
+	}
+	if (cursor != end) {
+		char lineEnd = *cursor;
 
-		switch (c) {
-		case '\r':
-			consumeLF(where, file);
-			[[fallthrough]];
-		case '\n':
-		case EOF:
-			lineBuf.push_back('\0'); // Terminate the string (space was ensured above)
-			return firstChar;
+		*cursor++ = '\0'; // Terminate the string in place
+		if (lineEnd == '\r') {
+			consumeLF(where, cursor, end);
 		}
-		lineBuf.push_back(c);
 	}
+	// A line ending at EOF is terminated by the buffer's NUL sentinel instead
+	return firstChar;
 }
 
 static uint32_t readNumber(char const *str, char const *&endptr, NumberType base) {
@@ -149,8 +154,20 @@ enum RelocFlags {
 void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &fileSymbols) {
 	Location where{.src = &src, .lineNo = 0};
 
-	std::vector<char> line;
-	line.reserve(256);
+	// Slurp the rest of the file; lines are tokenized in place within this buffer
+	std::vector<char> contents;
+	for (uint8_t chunk[65536];;) {
+		size_t n = fread(chunk, 1, sizeof(chunk), file);
+		contents.insert(contents.end(), chunk, chunk + n);
+		if (n < sizeof(chunk)) {
+			break;
+		}
+	}
+	contents.push_back('\0'); // Terminates a final line that lacks a line ending
+	char *cursor = contents.data();
+	char *end = &contents.back();
+
+	char *line;
 	char const *token;
 
 #define getToken(ptr, ...) \
@@ -181,7 +198,7 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 		} \
 	} while (0)
 
-	int lineType = nextLine(line, where, file);
+	int lineType = nextLine(line, where, cursor, end);
 
 	// The first letter (thus, the line type) identifies the integer type
 	NumberType numberType;
@@ -232,13 +249,13 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 
 	// Header line
 
-	lineType = nextLine(line, where, file);
+	lineType = nextLine(line, where, cursor, end);
 	if (lineType != 'H') {
 		fatalAt(where, "Expected header line, got '%c' line", lineType);
 	}
 	// Expected format: "A areas S global symbols"
 
-	getToken(line.data(), "Empty 'H' line");
+	getToken(line, "Empty 'H' line");
 	uint32_t expectedNbAreas = parseNumber(where, token, numberType);
 
 	expectToken("areas", 'H');
@@ -256,14 +273,14 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 	// Now, let's parse the rest of the lines as they come!
 
 	struct FileSection {
-		std::unique_ptr<Section> section;
+		Section *section; // Arena-allocated, since the file says how many up front but may lie
 		uint16_t writeIndex;
 	};
 	std::vector<FileSection> fileSections;
 	std::vector<uint8_t> data;
 
 	for (;;) {
-		lineType = nextLine(line, where, file);
+		lineType = nextLine(line, where, cursor, end);
 		if (lineType == EOF) {
 			break;
 		}
@@ -277,12 +294,12 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 			if (fileSections.size() == expectedNbAreas) {
 				warningAt(where, "Got more 'A' lines than the expected %" PRIu32, expectedNbAreas);
 			}
-			std::unique_ptr<Section> curSection = std::make_unique<Section>();
+			Section *curSection = &sect_MakeSection();
 
 			curSection->src = where.src;
 			curSection->lineNo = where.lineNo;
 
-			getToken(line.data(), "'A' line is too short");
+			getToken(line, "'A' line is too short");
 			assume(strlen(token) != 0); // This should be impossible, tokens are non-empty
 			// The following is required for fragment offsets to be reliably predicted
 			for (FileSection &entry : fileSections) {
@@ -366,7 +383,7 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 			curSection->fileSymbols = &fileSymbols; // IDs are instead per-section
 			curSection->nextu = nullptr;
 
-			fileSections.push_back({.section = std::move(curSection), .writeIndex = 0});
+			fileSections.push_back({.section = curSection, .writeIndex = 0});
 			break;
 		}
 
@@ -381,14 +398,15 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 			symbol.src = where.src;
 			symbol.lineNo = where.lineNo;
 
-			getToken(line.data(), "'S' line is too short");
+			getToken(line, "'S' line is too short");
 			symbol.name = token;
+			symbol.nameHash = fnv1a64(symbol.name.data(), symbol.name.length());
 
 			getToken(nullptr, "'S' line is too short");
 
 			if (int32_t value = parseNumber(where, &token[3], numberType); !fileSections.empty()) {
 				// Symbols in sections are labels; their value is an offset
-				Section *section = fileSections.back().section.get();
+				Section *section = fileSections.back().section;
 				if (section->isAddressFixed) {
 					assume(value >= section->org && value <= section->org + section->size);
 					value -= section->org;
@@ -464,7 +482,7 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 			}
 
 			data.clear();
-			for (token = strtok(line.data(), delim); token; token = strtok(nullptr, delim)) {
+			for (token = strtok(line, delim); token; token = strtok(nullptr, delim)) {
 				data.push_back(parseByte(where, token, numberType));
 			}
 
@@ -482,7 +500,7 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 			}
 
 			// First two bytes are ignored
-			getToken(line.data(), "'R' line is too short");
+			getToken(line, "'R' line is too short");
 			getToken(nullptr, "'R' line is too short");
 			uint16_t areaIdx;
 
@@ -499,7 +517,7 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 				);
 			}
 			assume(!fileSections.empty()); // There should be at least one, from the above check
-			Section *section = fileSections[areaIdx].section.get();
+			Section *section = fileSections[areaIdx].section;
 			uint16_t *writeIndex = &fileSections[areaIdx].writeIndex;
 			uint8_t writtenOfs = addrSize; // Bytes before this have been written to `->data`
 			uint16_t addr = data[0] | data[1] << 8;
@@ -593,6 +611,8 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 
 				// Turn this into a Patch
 				Patch &patch = section->patches.emplace_back();
+				// Interned into `patch.rpnExpression` once built
+				std::vector<uint8_t> rpn = obj_AcquireRPNBuffer();
 
 				patch.src = where.src;
 				patch.lineNo = where.lineNo;
@@ -661,35 +681,35 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 							    &sym.name.c_str()[1]
 							);
 						}
-						patch.rpnExpression.resize(5);
-						patch.rpnExpression[0] = RPN_BANK_SYM;
-						patch.rpnExpression[1] = idx;
-						patch.rpnExpression[2] = idx >> 8;
-						patch.rpnExpression[3] = idx >> 16;
-						patch.rpnExpression[4] = idx >> 24;
+						rpn.resize(5);
+						rpn[0] = RPN_BANK_SYM;
+						rpn[1] = idx;
+						rpn[2] = idx >> 8;
+						rpn[3] = idx >> 16;
+						rpn[4] = idx >> 24;
 					} else if (sym.name.starts_with("l_")) {
-						patch.rpnExpression.resize(1 + sym.name.length() - 2 + 1);
-						patch.rpnExpression[0] = RPN_SIZEOF_SECT;
+						rpn.resize(1 + sym.name.length() - 2 + 1);
+						rpn[0] = RPN_SIZEOF_SECT;
 						memcpy(
-						    reinterpret_cast<char *>(&patch.rpnExpression[1]),
+						    reinterpret_cast<char *>(&rpn[1]),
 						    &sym.name.c_str()[2],
 						    sym.name.length() - 2 + 1
 						);
 					} else if (sym.name.starts_with("s_")) {
-						patch.rpnExpression.resize(1 + sym.name.length() - 2 + 1);
-						patch.rpnExpression[0] = RPN_STARTOF_SECT;
+						rpn.resize(1 + sym.name.length() - 2 + 1);
+						rpn[0] = RPN_STARTOF_SECT;
 						memcpy(
-						    reinterpret_cast<char *>(&patch.rpnExpression[1]),
+						    reinterpret_cast<char *>(&rpn[1]),
 						    &sym.name.c_str()[2],
 						    sym.name.length() - 2 + 1
 						);
 					} else {
-						patch.rpnExpression.resize(5);
-						patch.rpnExpression[0] = RPN_SYM;
-						patch.rpnExpression[1] = idx;
-						patch.rpnExpression[2] = idx >> 8;
-						patch.rpnExpression[3] = idx >> 16;
-						patch.rpnExpression[4] = idx >> 24;
+						rpn.resize(5);
+						rpn[0] = RPN_SYM;
+						rpn[1] = idx;
+						rpn[2] = idx >> 8;
+						rpn[3] = idx >> 16;
+						rpn[4] = idx >> 24;
 					}
 				} else {
 					if (idx >= fileSections.size()) {
@@ -724,22 +744,22 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 					if (other) {
 						baseValue += other->size;
 					}
-					patch.rpnExpression.resize(1 + name.length() + 1);
-					patch.rpnExpression[0] = RPN_STARTOF_SECT;
+					rpn.resize(1 + name.length() + 1);
+					rpn[0] = RPN_STARTOF_SECT;
 					// The cast is fine, it's just different signedness
 					memcpy(
-					    reinterpret_cast<char *>(&patch.rpnExpression[1]),
+					    reinterpret_cast<char *>(&rpn[1]),
 					    name.c_str(),
 					    name.length() + 1
 					);
 				}
 
-				patch.rpnExpression.push_back(RPN_CONST);
-				patch.rpnExpression.push_back(baseValue);
-				patch.rpnExpression.push_back(baseValue >> 8);
-				patch.rpnExpression.push_back(baseValue >> 16);
-				patch.rpnExpression.push_back(baseValue >> 24);
-				patch.rpnExpression.push_back(RPN_ADD);
+				rpn.push_back(RPN_CONST);
+				rpn.push_back(baseValue);
+				rpn.push_back(baseValue >> 8);
+				rpn.push_back(baseValue >> 16);
+				rpn.push_back(baseValue >> 24);
+				rpn.push_back(RPN_ADD);
 
 				if (patch.type == PATCHTYPE_BYTE) {
 					// Despite the flag's name, as soon as it is set, 3 bytes
@@ -768,31 +788,31 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 						patch.type = PATCHTYPE_JR;
 						// TODO: check the other flags?
 					} else if (flags & 1 << RELOC_EXPR24 && flags & 1 << RELOC_BANKBYTE) {
-						patch.rpnExpression.push_back(RPN_CONST);
-						patch.rpnExpression.push_back(16);
-						patch.rpnExpression.push_back(16 >> 8);
-						patch.rpnExpression.push_back(16 >> 16);
-						patch.rpnExpression.push_back(16 >> 24);
-						patch.rpnExpression.push_back(
+						rpn.push_back(RPN_CONST);
+						rpn.push_back(16);
+						rpn.push_back(16 >> 8);
+						rpn.push_back(16 >> 16);
+						rpn.push_back(16 >> 24);
+						rpn.push_back(
 						    (flags & 1 << RELOC_SIGNED) ? RPN_SHR : RPN_USHR
 						);
 					} else {
 						if (flags & 1 << RELOC_EXPR16 && flags & 1 << RELOC_WHICHBYTE) {
-							patch.rpnExpression.push_back(RPN_CONST);
-							patch.rpnExpression.push_back(8);
-							patch.rpnExpression.push_back(8 >> 8);
-							patch.rpnExpression.push_back(8 >> 16);
-							patch.rpnExpression.push_back(8 >> 24);
-							patch.rpnExpression.push_back(
+							rpn.push_back(RPN_CONST);
+							rpn.push_back(8);
+							rpn.push_back(8 >> 8);
+							rpn.push_back(8 >> 16);
+							rpn.push_back(8 >> 24);
+							rpn.push_back(
 							    (flags & 1 << RELOC_SIGNED) ? RPN_SHR : RPN_USHR
 							);
 						}
-						patch.rpnExpression.push_back(RPN_CONST);
-						patch.rpnExpression.push_back(0xFF);
-						patch.rpnExpression.push_back(0xFF >> 8);
-						patch.rpnExpression.push_back(0xFF >> 16);
-						patch.rpnExpression.push_back(0xFF >> 24);
-						patch.rpnExpression.push_back(RPN_AND);
+						rpn.push_back(RPN_CONST);
+						rpn.push_back(0xFF);
+						rpn.push_back(0xFF >> 8);
+						rpn.push_back(0xFF >> 16);
+						rpn.push_back(0xFF >> 24);
+						rpn.push_back(RPN_AND);
 					}
 				} else if (flags & 1 << RELOC_ISPCREL) {
 					assume(patch.type == PATCHTYPE_WORD);
@@ -804,6 +824,8 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 					    flags & (1 << RELOC_EXPR16 | 1 << RELOC_EXPR24)
 					);
 				}
+
+				patch.rpnExpression = obj_InternRPN(std::move(rpn));
 			}
 
 			// If there is some data left to append, do so
@@ -858,7 +880,7 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 	}
 
 	for (FileSection &entry : fileSections) {
-		std::unique_ptr<Section> &section = entry.section;
+		Section *section = entry.section;
 
 		// RAM sections can have a size, but don't get any data (they shouldn't have any)
 		if (section->type != SECTTYPE_INVALID) {
@@ -898,8 +920,7 @@ void sdobj_ReadFile(FileStackNode const &src, FILE *file, std::vector<Symbol> &f
 			    section->size
 			);
 		}
-		// Calling `sect_AddSection` invalidates the contents of `fileSections`!
-		sect_AddSection(std::move(section));
+		sect_AddSection(*section);
 	}
 
 	// Fix symbols' section pointers to component sections
@@ -2,8 +2,8 @@
 
 #include "link/section.hpp"
 
+#include <deque>
 #include <inttypes.h>
-#include <memory>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,14 +19,61 @@
 #include "link/main.hpp"
 #include "link/warning.hpp"
 
-static InsertionOrderedMap<std::unique_ptr<Section>> sections;
+// Sections are owned by these pools (one block per object file, plus individually made
+// ones); everything else refers to them by pointer, so the pools must never shrink.
+static std::deque<std::vector<Section>> sectionPools;
+static std::deque<Section> looseSections;
+
+// Vector-backed so the iteration passes (assignment, patching, output) walk a dense array;
+// nothing keeps references into the map itself, only the pointed-to sections
+static InsertionOrderedMap<Section *, std::vector> sections;
+
+std::vector<Section> &sect_AdoptPool(std::vector<Section> &&pool) {
+	return sectionPools.emplace_front(std::move(pool));
+}
+
+void sect_Reserve(size_t nbSections) {
+	sections.reserve(nbSections);
+}
+
+Section &sect_MakeSection() {
+	return looseSections.emplace_back();
+}
 
 void sect_ForEach(void (*callback)(Section &)) {
-	for (std::unique_ptr<Section> &ptr : sections) {
+	for (Section *ptr : sections) {
 		callback(*ptr);
 	}
 }
 
+Section &sect_GetNthSection(size_t i) {
+	return *sections[i];
+}
+
+// Sections up to this index were placed (and patched) by the shared link, and must not grow
+// once a profile's objects arrive (`sect_SealSharedSections`)
+static size_t nbSealedSections = 0;
+
+size_t sect_CountSections() {
+	return sections.size();
+}
+
+uint64_t sect_CountPatches() {
+	uint64_t nbPatches = 0;
+	for (Section const *ptr : sections) {
+		nbPatches += ptr->patches.size();
+	}
+	return nbPatches;
+}
+
+uint64_t sect_CountDataBytes() {
+	uint64_t bytes = 0;
+	for (Section const *ptr : sections) {
+		bytes += ptr->data.capacity();
+	}
+	return bytes;
+}
+
 static void checkAgainstFixedAddress(Section const &target, Section const &other, uint16_t org) {
 	if (target.isAddressFixed) {
 		if (target.org != org) {
@@ -121,67 +168,73 @@ static void checkFragmentCompat(Section &target, Section &other) {
 	}
 }
 
-static void mergeSections(Section &target, std::unique_ptr<Section> &&other) {
-	if (target.modifier != other->modifier) {
+static void mergeSections(Section &target, Section &other) {
+	if (target.modifier != other.modifier) {
 		fatalTwoAt(
 		    target,
-		    *other,
+		    other,
 		    "Section \"%s\" is defined as `SECTION %s`, but also as `SECTION %s`",
 		    target.name.c_str(),
 		    sectionModNames[target.modifier],
-		    sectionModNames[other->modifier]
+		    sectionModNames[other.modifier]
 		);
-	} else if (other->modifier == SECTION_NORMAL) {
-		fatalTwoAt(target, *other, "Section \"%s\" is already defined", target.name.c_str());
-	} else if (target.type != other->type) {
+	} else if (other.modifier == SECTION_NORMAL) {
+		fatalTwoAt(target, other, "Section \"%s\" is already defined", target.name.c_str());
+	} else if (target.type != other.type) {
 		fatalTwoAt(
 		    target,
-		    *other,
+		    other,
 		    "Section \"%s\" is defined with type `%s`, but also with type `%s`",
 		    target.name.c_str(),
 		    sectionTypeInfo[target.type].name.c_str(),
-		    sectionTypeInfo[other->type].name.c_str()
+		    sectionTypeInfo[other.type].name.c_str()
 		);
 	}
 
-	if (other->isBankFixed) {
+	if (other.isBankFixed) {
 		if (!target.isBankFixed) {
 			target.isBankFixed = true;
-			target.bank = other->bank;
-		} else if (target.bank != other->bank) {
+			target.bank = other.bank;
+		} else if (target.bank != other.bank) {
 			fatalTwoAt(
 			    target,
-			    *other,
+			    other,
 			    "Section \"%s\" is defined with bank %" PRIu32 ", but also with bank %" PRIu32,
 			    target.name.c_str(),
 			    target.bank,
-			    other->bank
+			    other.bank
 			);
 		}
 	}
 
-	switch (other->modifier) {
+	switch (other.modifier) {
 	case SECTION_UNION:
-		checkSectUnionCompat(target, *other);
-		if (other->size > target.size) {
-			target.size = other->size;
+		checkSectUnionCompat(target, other);
+		if (other.size > target.size) {
+			target.size = other.size;
 		}
 		break;
 
 	case SECTION_FRAGMENT:
-		checkFragmentCompat(target, *other);
+		checkFragmentCompat(target, other);
 		// Append `other` to `target`
-		other->offset = target.size;
-		target.size += other->size;
+		other.offset = target.size;
+		target.size += other.size;
 		// Normally we'd check that `sectTypeHasData`, but SDCC areas may be `_INVALID` here
-		if (!other->data.empty()) {
-			target.data.insert(target.data.end(), RANGE(other->data));
-			// Adjust patches' PC offsets
-			for (Patch &patch : other->patches) {
-				patch.pcOffset += other->offset;
+		if (!other.data.empty()) {
+			// The bytes only move into `target.data` once every fragment has arrived (see
+			// `coalesceFragmentData`), so the combined buffer is allocated exactly once;
+			// the patches' PC offsets can be adjusted right away, though
+			for (Patch &patch : other.patches) {
+				patch.pcOffset += other.offset;
+			}
+		} else {
+			for (Section const *frag = &target; frag; frag = frag->nextu) {
+				if (!frag->data.empty()) {
+					assume(other.size == 0);
+					break;
+				}
 			}
-		} else if (!target.data.empty()) {
-			assume(other->size == 0);
 		}
 		break;
 
@@ -193,28 +246,47 @@ static void mergeSections(Section &target, std::unique_ptr<Section> &&other) {
 
 	// Note that the order in which fragments are stored in the `nextu` list does not
 	// really matter, only that offsets were properly computed above
-	other->nextu = std::move(target.nextu);
-	target.nextu = std::move(other);
+	other.nextu = target.nextu;
+	target.nextu = &other;
 }
 
-void sect_AddSection(std::unique_ptr<Section> &&section) {
+void sect_AddSection(Section &section) {
 	// Check if the section already exists; if not, add it
-	if (Section *target = sect_GetSection(section->name); target) {
-		mergeSections(*target, std::move(section));
-	} else if (section->modifier == SECTION_UNION && sectTypeHasData(section->type)) {
+	if (auto index = sections.findIndex(section.name); index) {
+		if (*index < nbSealedSections) {
+			fatal(
+			    "Section \"%s\" was already placed by the shared link; profile objects cannot "
+			    "merge into it",
+			    section.name.c_str()
+			);
+		}
+		mergeSections(*sections[*index], section);
+	} else if (section.modifier == SECTION_UNION && sectTypeHasData(section.type)) {
 		fatal(
 		    "Section \"%s\" is of type `%s`, which cannot be `UNION`ized",
-		    section->name.c_str(),
-		    sectionTypeInfo[section->type].name.c_str()
+		    section.name.c_str(),
+		    sectionTypeInfo[section.type].name.c_str()
 		);
 	} else {
-		sections.add(section->name, std::move(section));
+		sections.add(section.name, &section);
+	}
+}
+
+void sect_KeepIf(bool (*callback)(Section &)) {
+	InsertionOrderedMap<Section *, std::vector> kept;
+
+	kept.reserve(sections.size());
+	for (Section *section : sections) {
+		if (callback(*section)) {
+			kept.add(section->name, std::move(section));
+		}
 	}
+	sections = std::move(kept);
 }
 
 Section *sect_GetSection(std::string const &name) {
 	auto index = sections.findIndex(name);
-	return index ? sections[*index].get() : nullptr;
+	return index ? sections[*index] : nullptr;
 }
 
 static void doSanityChecks(Section &section) {
@@ -341,6 +413,40 @@ static void doSanityChecks(Section &section) {
 	}
 }
 
-void sect_DoSanityChecks() {
-	sect_ForEach(doSanityChecks);
+// Copies merged fragments' data into the combined section; deferred until every fragment
+// has arrived and the total size is known, so the combined buffer is allocated exactly once
+// instead of growing (and re-copying) with each fragment.
+static void coalesceFragmentData(Section &target) {
+	if (!target.nextu || target.modifier != SECTION_FRAGMENT) {
+		return;
+	}
+
+	bool hasData = false;
+	for (Section const *frag = &target; !hasData && frag; frag = frag->nextu) {
+		hasData = !frag->data.empty();
+	}
+	if (!hasData) {
+		return;
+	}
+
+	target.data.resize(target.size); // Preserves the first fragment's own bytes at offset 0
+	for (Section const *frag = target.nextu; frag; frag = frag->nextu) {
+		if (!frag->data.empty()) {
+			memcpy(&target.data[frag->offset], frag->data.data(), frag->data.size());
+		}
+	}
+}
+
+void sect_SealSharedSections() {
+	nbSealedSections = sections.size();
+}
+
+void sect_DoSanityChecks(size_t firstIdx) {
+	// Every fragment has been merged by now
+	for (size_t i = firstIdx; i < sections.size(); ++i) {
+		coalesceFragmentData(*sections[i]);
+	}
+	for (size_t i = firstIdx; i < sections.size(); ++i) {
+		doSanityChecks(*sections[i]);
+	}
 }
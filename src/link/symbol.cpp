@@ -2,10 +2,12 @@
 
 #include "link/symbol.hpp"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <variant>
@@ -13,13 +15,46 @@
 
 #include "helpers.hpp" // assume
 #include "linkdefs.hpp"
+#include "util.hpp" // fnv1a64
 
 #include "link/fstack.hpp"
+#include "link/object.hpp"
 #include "link/section.hpp"
 #include "link/warning.hpp"
 
-static std::unordered_map<std::string, Symbol *> symbols;
-static std::unordered_map<std::string, std::vector<Symbol *>> localSymbols;
+// Unexported symbols sharing a name are chained through their `nextLocal` members, so the
+// map entry is three words and tracing them allocates nothing
+struct LocalSymbolList {
+	Symbol *head;
+	Symbol *tail;
+	size_t count;
+};
+
+// Both maps are keyed by views of the symbols' own names; symbols live in per-file blocks
+// that never move once registration begins, so the views stay valid. Keys carry the name's
+// precomputed FNV-1a hash (stored in v2 object files), so inserts and lookups skip hashing
+// and only compare characters on bucket collision.
+struct NameKey {
+	uint64_t hash;
+	std::string_view name;
+};
+struct NameKeyHash {
+	size_t operator()(NameKey const &key) const { return key.hash; }
+};
+struct NameKeyEq {
+	bool operator()(NameKey const &lhs, NameKey const &rhs) const { return lhs.name == rhs.name; }
+};
+static std::unordered_map<NameKey, Symbol *, NameKeyHash, NameKeyEq> symbols;
+static std::unordered_map<NameKey, LocalSymbolList, NameKeyHash, NameKeyEq> localSymbols;
+
+// Every imported symbol, in registration order; library resolution walks these to decide
+// which archive members to load
+static std::vector<Symbol const *> importedSymbols;
+
+void sym_Reserve(size_t nbSymbols) {
+	symbols.reserve(nbSymbols);
+	localSymbols.reserve(nbSymbols);
+}
 
 void sym_ForEach(void (*callback)(Symbol &)) {
 	for (auto &it : symbols) {
@@ -27,15 +62,36 @@ void sym_ForEach(void (*callback)(Symbol &)) {
 	}
 }
 
+size_t sym_CountSymbols() {
+	return symbols.size();
+}
+
+size_t sym_CountImports() {
+	return importedSymbols.size();
+}
+
+Symbol const &sym_GetNthImport(size_t i) {
+	return *importedSymbols[i];
+}
+
 void sym_AddSymbol(Symbol &symbol) {
 	if (symbol.type != SYMTYPE_EXPORT) {
-		if (symbol.type != SYMTYPE_IMPORT) {
-			localSymbols[symbol.name].push_back(&symbol);
+		if (symbol.type == SYMTYPE_IMPORT) {
+			importedSymbols.push_back(&symbol);
+		} else {
+			LocalSymbolList &locals =
+			    localSymbols[NameKey{symbol.nameHash, std::string_view(symbol.name)}];
+
+			symbol.nextLocal = nullptr;
+			(locals.head ? locals.tail->nextLocal : locals.head) = &symbol;
+			locals.tail = &symbol;
+			++locals.count;
 		}
 		return;
 	}
 
-	Symbol *other = sym_GetSymbol(symbol.name);
+	auto search = symbols.find(NameKey{symbol.nameHash, std::string_view(symbol.name)});
+	Symbol *other = search != symbols.end() ? search->second : nullptr;
 	int32_t *symValue =
 	    std::holds_alternative<int32_t>(symbol.data) ? &std::get<int32_t>(symbol.data) : nullptr;
 	int32_t *otherValue = other && std::holds_alternative<int32_t>(other->data)
@@ -57,35 +113,41 @@ void sym_AddSymbol(Symbol &symbol) {
 	}
 
 	// If not, add it (potentially replacing the previous same-value symbol)
-	symbols[symbol.name] = &symbol;
+	symbols[NameKey{symbol.nameHash, std::string_view(symbol.name)}] = &symbol;
 }
 
 Symbol *sym_GetSymbol(std::string const &name) {
-	auto search = symbols.find(name);
+	auto search =
+	    symbols.find(NameKey{fnv1a64(name.data(), name.length()), std::string_view(name)});
 	return search != symbols.end() ? search->second : nullptr;
 }
 
 void sym_TraceLocalAliasedSymbols(std::string const &name) {
-	std::vector<Symbol *> const &locals = localSymbols[name];
-	if (locals.empty()) {
+	// Any still-deferred symbol record could bear this name, so parse and register them all;
+	// this only runs on an error path, where the extra work doesn't matter
+	obj_MaterializeAllSymbols();
+	auto search =
+	    localSymbols.find(NameKey{fnv1a64(name.data(), name.length()), std::string_view(name)});
+	if (search == localSymbols.end()) {
 		return;
 	}
+	LocalSymbolList const &locals = search->second;
 
-	bool plural = locals.size() != 1;
+	bool plural = locals.count != 1;
 	fprintf(
 	    stderr,
 	    "    %zu symbol%s with that name %s defined but not exported:\n",
-	    locals.size(),
+	    locals.count,
 	    plural ? "s" : "",
 	    plural ? "are" : "is"
 	);
 
 	int count = 0;
-	for (Symbol *local : locals) {
+	for (Symbol *local = locals.head; local; local = local->nextLocal) {
 		assume(local->src);
 		local->src->printBacktrace(local->lineNo);
-		if (++count == 3 && locals.size() > 3) {
-			fprintf(stderr, "    ...and %zu more\n", locals.size() - 3);
+		if (++count == 3 && locals.count > 3) {
+			fprintf(stderr, "    ...and %zu more\n", locals.count - 3);
 			break;
 		}
 	}
@@ -3,16 +3,24 @@
 #include "link/warning.hpp"
 
 #include <inttypes.h>
+#include <setjmp.h>
+#include <map>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
+#include "backtrace.hpp"
 #include "diagnostics.hpp"
 #include "style.hpp"
 
 #include "link/fstack.hpp"
 #include "link/lexer.hpp"
+#include "link/main.hpp"
 
 // clang-format off: nested initializers
 Diagnostics<WarningLevel, WarningID> warnings = {
@@ -38,6 +46,101 @@ Diagnostics<WarningLevel, WarningID> warnings = {
 };
 // clang-format on
 
+// With `--dedup-diagnostics`, only the first few diagnostics from the same location are
+// printed; further repeats are counted here, and summarized at each error checkpoint.
+// Warnings are keyed by their ID, errors by their (statically-allocated) format string;
+// the location is the nearest named context plus the line number within it, so that every
+// iteration of a loop (and every invocation of the same macro) counts as a repeat.
+static constexpr uint64_t nbRepeatsPrinted = 3;
+template<typename K>
+using RepeatMap = std::map<std::tuple<K, std::string, uint32_t>, uint64_t>;
+static RepeatMap<WarningID> repeatedWarnings;
+static RepeatMap<char const *> repeatedErrors;
+
+template<typename K>
+static bool
+    suppressRepeated(RepeatMap<K> &repeats, K key, FileStackNode const *src, uint32_t lineNo) {
+	if (!options.dedupDiagnostics || !src) {
+		return false;
+	}
+
+	// REPT nodes take their name from their parent, and carry per-iteration counts, so
+	// climb to the nearest named node
+	FileStackNode const *named = src;
+	while (named->type == NODE_REPT && named->parent) {
+		named = named->parent;
+	}
+	if (named->type == NODE_REPT) {
+		return false; // LCOV_EXCL_LINE
+	}
+
+	uint64_t &count = repeats[{key, named->name(), lineNo}];
+	if (count != UINT64_MAX) {
+		++count;
+	}
+	return count > nbRepeatsPrinted;
+}
+
+static void printRepeatLocation(std::string const &context, uint32_t lineNo) {
+	std::vector<std::pair<std::string, uint32_t>> location{
+	    {context, lineNo}
+	};
+	trace_PrintBacktrace(
+	    location,
+	    [](std::pair<std::string, uint32_t> const &loc) { return loc.first.c_str(); },
+	    [](std::pair<std::string, uint32_t> const &loc) { return loc.second; }
+	);
+}
+
+void warning_PrintRepeatSummary() {
+	for (auto const &[key, count] : repeatedWarnings) {
+		if (count <= nbRepeatsPrinted) {
+			continue;
+		}
+		auto const &[id, context, lineNo] = key;
+		bool isError = warnings.getWarningBehavior(id) == WarningBehavior::ERROR;
+		StyleColor color = isError ? STYLE_RED : STYLE_YELLOW;
+		uint64_t extra = count - nbRepeatsPrinted;
+		{
+			StyleSink sink(stderr);
+			sink.set(color, true);
+			sink.printf("%s: ", isError ? "error" : "warning");
+			sink.reset();
+			sink.printf("Warning repeated %" PRIu64 " more time%s", extra, extra == 1 ? "" : "s");
+			sink.set(color, true);
+			sink.printf(isError ? " [-Werror=%s]" : " [-W%s]", warnings.warningFlags[id].name);
+			sink.append('\n');
+		}
+		printRepeatLocation(context, lineNo);
+	}
+	for (auto const &[key, count] : repeatedErrors) {
+		if (count <= nbRepeatsPrinted) {
+			continue;
+		}
+		auto const &[fmt, context, lineNo] = key;
+		uint64_t extra = count - nbRepeatsPrinted;
+		{
+			StyleSink sink(stderr);
+			sink.set(STYLE_RED, true);
+			sink.append("error: ");
+			sink.reset();
+			sink.printf("Error repeated %" PRIu64 " more time%s", extra, extra == 1 ? "" : "s");
+			sink.append('\n');
+		}
+		printRepeatLocation(context, lineNo);
+	}
+	repeatedWarnings.clear();
+	repeatedErrors.clear();
+}
+
+// When set, diagnostics on this thread jump here instead of printing (see
+// `warnings_SetAbortJump`)
+static thread_local jmp_buf *abortJump = nullptr;
+
+void warnings_SetAbortJump(jmp_buf *env) {
+	abortJump = env;
+}
+
 static void printDiag(
     FileStackNode const *src,
     uint32_t lineNo,
@@ -48,16 +151,18 @@ static void printDiag(
     char const *flagfmt,
     char const *flag
 ) {
-	style_Set(stderr, color, true);
-	fprintf(stderr, "%s: ", type);
-	style_Reset(stderr);
-	vfprintf(stderr, fmt, args);
+	StyleSink sink(stderr);
+	sink.set(color, true);
+	sink.printf("%s: ", type);
+	sink.reset();
+	sink.vprintf(fmt, args);
 	if (flagfmt) {
-		style_Set(stderr, color, true);
-		putc(' ', stderr);
-		fprintf(stderr, flagfmt, flag);
+		sink.set(color, true);
+		sink.append(' ');
+		sink.printf(flagfmt, flag);
 	}
-	putc('\n', stderr);
+	sink.append('\n');
+	sink.flush();
 
 	if (src) {
 		src->printBacktrace(lineNo);
@@ -79,6 +184,9 @@ static void abortLinking(char const *verb) {
 }
 
 void warning(FileStackNode const *src, uint32_t lineNo, char const *fmt, ...) {
+	if (abortJump) {
+		longjmp(*abortJump, 1);
+	}
 	va_list args;
 	va_start(args, fmt);
 	printDiag(src, lineNo, fmt, args, "warning", STYLE_YELLOW, nullptr, nullptr);
@@ -86,6 +194,9 @@ void warning(FileStackNode const *src, uint32_t lineNo, char const *fmt, ...) {
 }
 
 void warning(char const *fmt, ...) {
+	if (abortJump) {
+		longjmp(*abortJump, 1);
+	}
 	va_list args;
 	va_start(args, fmt);
 	printDiag(nullptr, 0, fmt, args, "warning", STYLE_YELLOW, nullptr, nullptr);
@@ -93,6 +204,14 @@ void warning(char const *fmt, ...) {
 }
 
 void error(FileStackNode const *src, uint32_t lineNo, char const *fmt, ...) {
+	if (abortJump) {
+		longjmp(*abortJump, 1);
+	}
+	if (suppressRepeated(repeatedErrors, fmt, src, lineNo)) {
+		warnings.incrementErrors(); // Suppressed errors still count toward the total
+		return;
+	}
+
 	va_list args;
 	va_start(args, fmt);
 	printDiag(src, lineNo, fmt, args, "error", STYLE_RED, nullptr, nullptr);
@@ -102,6 +221,9 @@ void error(FileStackNode const *src, uint32_t lineNo, char const *fmt, ...) {
 }
 
 void error(char const *fmt, ...) {
+	if (abortJump) {
+		longjmp(*abortJump, 1);
+	}
 	va_list args;
 	va_start(args, fmt);
 	printDiag(nullptr, 0, fmt, args, "error", STYLE_RED, nullptr, nullptr);
@@ -123,6 +245,9 @@ void scriptError(char const *fmt, ...) {
 
 [[noreturn]]
 void fatal(FileStackNode const *src, uint32_t lineNo, char const *fmt, ...) {
+	if (abortJump) {
+		longjmp(*abortJump, 1);
+	}
 	va_list args;
 	va_start(args, fmt);
 	printDiag(src, lineNo, fmt, args, "FATAL", STYLE_RED, nullptr, nullptr);
@@ -134,6 +259,9 @@ void fatal(FileStackNode const *src, uint32_t lineNo, char const *fmt, ...) {
 
 [[noreturn]]
 void fatal(char const *fmt, ...) {
+	if (abortJump) {
+		longjmp(*abortJump, 1);
+	}
 	va_list args;
 	va_start(args, fmt);
 	printDiag(nullptr, 0, fmt, args, "FATAL", STYLE_RED, nullptr, nullptr);
@@ -152,6 +280,9 @@ void fatalTwo(
     char const *fmt,
     ...
 ) {
+	if (abortJump) {
+		longjmp(*abortJump, 1);
+	}
 	va_list args;
 	style_Set(stderr, STYLE_RED, true);
 	fputs("FATAL: ", stderr);
@@ -170,31 +301,39 @@ void fatalTwo(
 }
 
 void requireZeroErrors() {
+	warning_PrintRepeatSummary();
 	if (warnings.nbErrors != 0) {
 		abortLinking("failed");
 	}
 }
 
 void warning(FileStackNode const *src, uint32_t lineNo, WarningID id, char const *fmt, ...) {
+	if (abortJump) {
+		longjmp(*abortJump, 1);
+	}
+	// Check this first, so that disabled warnings cost nothing beyond this cached load;
+	// no formatting or backtrace work happens for them
+	WarningBehavior behavior = warnings.getWarningBehavior(id);
+	if (behavior == WarningBehavior::DISABLED) {
+		return;
+	}
+	if (suppressRepeated(repeatedWarnings, id, src, lineNo)) {
+		if (behavior == WarningBehavior::ERROR) {
+			warnings.incrementErrors(); // Suppressed errors still count toward the total
+		}
+		return;
+	}
+
 	char const *flag = warnings.warningFlags[id].name;
 	va_list args;
 
 	va_start(args, fmt);
-
-	switch (warnings.getWarningBehavior(id)) {
-	case WarningBehavior::DISABLED:
-		break;
-
-	case WarningBehavior::ENABLED:
+	if (behavior == WarningBehavior::ENABLED) {
 		printDiag(src, lineNo, fmt, args, "warning", STYLE_YELLOW, "[-W%s]", flag);
-		break;
-
-	case WarningBehavior::ERROR:
+	} else {
 		printDiag(src, lineNo, fmt, args, "error", STYLE_RED, "[-Werror=%s]", flag);
 
 		warnings.incrementErrors();
-		break;
 	}
-
 	va_end(args);
 }
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: MIT
+
+#include "lz4.hpp"
+
+#include <string.h>
+
+// The LZ4 block format is a series of "sequences": a token whose high nibble is the literal
+// length and whose low nibble is the match length minus 4, each saturating at 15 with the
+// excess in following bytes (255 = "keep going"); then the literals themselves, then a
+// 2-byte little-endian backwards offset into the output. The block ends with a sequence
+// that stops after its literals. See https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+
+// Spec constraints on encoders: the last 5 bytes are always literals, and the last match
+// must start at least 12 bytes before the end of the block.
+static constexpr size_t LAST_LITERALS = 5;
+static constexpr size_t MATCH_SAFETY_MARGIN = 12;
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+
+static constexpr size_t HASH_LOG = 13; // 8K entries; input blocks are at most 64K
+
+static uint32_t read32(uint8_t const *ptr) {
+	uint32_t value;
+	memcpy(&value, ptr, sizeof(value)); // The compiler turns this into a single load
+	return value;
+}
+
+static size_t hashPos(uint8_t const *ptr) {
+	// Fibonacci hashing over the next 4 bytes
+	return read32(ptr) * 2654435761u >> (32 - HASH_LOG);
+}
+
+static void putLength(std::vector<uint8_t> &out, size_t len) {
+	while (len >= 255) {
+		out.push_back(255);
+		len -= 255;
+	}
+	out.push_back(len);
+}
+
+static void putSequence(
+    std::vector<uint8_t> &out,
+    uint8_t const *literals,
+    size_t nbLiterals,
+    size_t offset,  // 0 for the block-ending sequence
+    size_t matchLen // Ignored then
+) {
+	size_t litNibble = nbLiterals < 15 ? nbLiterals : 15;
+	size_t matchNibble = offset != 0 && matchLen - MIN_MATCH < 15 ? matchLen - MIN_MATCH : 15;
+
+	out.push_back(litNibble << 4 | (offset != 0 ? matchNibble : 0));
+	if (litNibble == 15) {
+		putLength(out, nbLiterals - 15);
+	}
+	out.insert(out.end(), literals, literals + nbLiterals);
+	if (offset != 0) {
+		out.push_back(offset & 0xFF);
+		out.push_back(offset >> 8);
+		if (matchNibble == 15) {
+			putLength(out, matchLen - MIN_MATCH - 15);
+		}
+	}
+}
+
+std::vector<uint8_t> lz4_Compress(uint8_t const *src, size_t size) {
+	std::vector<uint8_t> out;
+	out.reserve(size / 2); // Sections that compress worse than 2:1 are often incompressible
+
+	// Greedy parse: remember the last position each 4-byte prefix hash was seen at, and take
+	// the first match that verifies
+	uint32_t table[1 << HASH_LOG];
+	memset(table, 0xFF, sizeof(table));
+
+	size_t anchor = 0; // Start of the pending literal run
+
+	if (size > MATCH_SAFETY_MARGIN) {
+		for (size_t i = 0; i + MATCH_SAFETY_MARGIN <= size;) {
+			size_t hash = hashPos(&src[i]);
+			uint32_t candidate = table[hash];
+			table[hash] = i;
+
+			if (candidate == UINT32_MAX || i - candidate > MAX_OFFSET
+			    || read32(&src[candidate]) != read32(&src[i])) {
+				++i;
+				continue;
+			}
+
+			size_t matchLen = MIN_MATCH;
+			for (size_t limit = size - LAST_LITERALS; i + matchLen < limit; ++matchLen) {
+				if (src[candidate + matchLen] != src[i + matchLen]) {
+					break;
+				}
+			}
+
+			putSequence(out, &src[anchor], i - anchor, i - candidate, matchLen);
+			i += matchLen;
+			anchor = i;
+		}
+	}
+
+	putSequence(out, &src[anchor], size - anchor, 0, 0);
+	return out;
+}
+
+bool lz4_Decompress(uint8_t const *src, size_t srcSize, uint8_t *dst, size_t dstSize) {
+	size_t si = 0, di = 0;
+
+	while (si < srcSize) {
+		uint8_t token = src[si++];
+
+		size_t litLen = token >> 4;
+		if (litLen == 15) {
+			for (uint8_t byte = 255; byte == 255;) {
+				if (si == srcSize) {
+					return false;
+				}
+				byte = src[si++];
+				litLen += byte;
+			}
+		}
+		if (litLen > srcSize - si || litLen > dstSize - di) {
+			return false;
+		}
+		memcpy(&dst[di], &src[si], litLen);
+		si += litLen;
+		di += litLen;
+
+		if (si == srcSize) {
+			break; // The block-ending sequence stops after its literals
+		}
+
+		if (srcSize - si < 2) {
+			return false;
+		}
+		size_t offset = src[si] | src[si + 1] << 8;
+		si += 2;
+		if (offset == 0 || offset > di) {
+			return false;
+		}
+
+		size_t matchLen = (token & 0xF) + MIN_MATCH;
+		if ((token & 0xF) == 15) {
+			for (uint8_t byte = 255; byte == 255;) {
+				if (si == srcSize) {
+					return false;
+				}
+				byte = src[si++];
+				matchLen += byte;
+			}
+		}
+		if (matchLen > dstSize - di) {
+			return false;
+		}
+		// Copy byte by byte: a match may overlap the bytes it is still producing
+		for (size_t i = 0; i < matchLen; ++i, ++di) {
+			dst[di] = dst[di - offset];
+		}
+	}
+
+	return di == dstSize;
+}
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: MIT
+
+#include "memstats.hpp"
+
+#include <atomic>
+#include <inttypes.h>
+#include <new>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef _MSC_VER
+	#include <sys/resource.h>
+#endif
+
+#include "style.hpp"
+
+static bool statsEnabled = false;
+
+// Cumulative tallies; freed memory is not subtracted, so these measure allocator churn,
+// not the live heap size (which peak RSS approximates)
+static std::atomic<uint64_t> nbAllocations = 0;
+static std::atomic<uint64_t> allocatedBytes = 0;
+
+static void *countedAlloc(size_t size) {
+	nbAllocations.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	// `malloc(0)` may return null, but `operator new` must not
+	void *ptr = malloc(size != 0 ? size : 1);
+	if (!ptr) {
+		// LCOV_EXCL_START
+		fputs("FATAL: Out of memory\n", stderr);
+		abort();
+		// LCOV_EXCL_STOP
+	}
+	return ptr;
+}
+
+// Replace the usual global allocation functions with counting ones. The over-aligned
+// (`std::align_val_t`) overloads are deliberately left alone: none of our types are
+// over-aligned, and the default ones pair consistently among themselves.
+
+void *operator new(size_t size) {
+	return countedAlloc(size);
+}
+
+void *operator new[](size_t size) {
+	return countedAlloc(size);
+}
+
+void *operator new(size_t size, std::nothrow_t const &) noexcept {
+	return countedAlloc(size);
+}
+
+void *operator new[](size_t size, std::nothrow_t const &) noexcept {
+	return countedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, std::nothrow_t const &) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr, std::nothrow_t const &) noexcept {
+	free(ptr);
+}
+
+void mem_EnableStats() {
+	statsEnabled = true;
+}
+
+void mem_ReportStats(std::initializer_list<std::pair<char const *, uint64_t>> counters) {
+	if (!statsEnabled) {
+		return;
+	}
+
+	// LCOV_EXCL_START
+	style_Set(stderr, STYLE_MAGENTA, false);
+	fprintf(
+	    stderr,
+	    "%-19s %14" PRIu64 "\n",
+	    "Heap allocations",
+	    nbAllocations.load(std::memory_order_relaxed)
+	);
+	fprintf(
+	    stderr,
+	    "%-19s %10" PRIu64 " KiB\n",
+	    "Heap bytes alloc'd",
+	    allocatedBytes.load(std::memory_order_relaxed) / 1024
+	);
+	for (auto const &[name, value] : counters) {
+		fprintf(stderr, "%-19s %14" PRIu64 "\n", name, value);
+	}
+#ifndef _MSC_VER
+	if (struct rusage usage; getrusage(RUSAGE_SELF, &usage) == 0) {
+		long maxRssKiB = usage.ru_maxrss;
+#ifdef __APPLE__
+		maxRssKiB /= 1024; // `ru_maxrss` is in bytes on macOS, KiB elsewhere
+#endif
+		fprintf(stderr, "%-19s %10ld KiB\n", "Peak memory (RSS)", maxRssKiB);
+	}
+#endif
+	style_Reset(stderr);
+	// LCOV_EXCL_STOP
+}
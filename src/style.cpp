@@ -122,3 +122,67 @@ void style_Reset(FILE *file) {
 #endif
 	// LCOV_EXCL_STOP
 }
+
+void StyleSink::set(StyleColor color, bool bold) {
+	if (!allowStyle(file)) {
+		return;
+	}
+
+	// LCOV_EXCL_START
+#if STYLE_ANSI
+	// The SGR parameter is always 2 digits, but sized for the full `int` range so the
+	// compiler can prove `snprintf` cannot truncate
+	char seq[16];
+	snprintf(seq, sizeof(seq), "\033[%dm", static_cast<int>(color) + (bold ? 90 : 30));
+	buf.append(seq);
+#else
+	// Console attributes cannot be buffered, so write out everything before the style change
+	flush();
+	style_Set(file, color, bold);
+#endif
+	// LCOV_EXCL_STOP
+}
+
+void StyleSink::reset() {
+	if (!allowStyle(file)) {
+		return;
+	}
+
+	// LCOV_EXCL_START
+#if STYLE_ANSI
+	buf.append("\033[m");
+#else
+	flush();
+	style_Reset(file);
+#endif
+	// LCOV_EXCL_STOP
+}
+
+void StyleSink::printf(char const *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
+void StyleSink::vprintf(char const *fmt, va_list args) {
+	va_list lenArgs;
+	va_copy(lenArgs, args);
+	int len = vsnprintf(nullptr, 0, fmt, lenArgs);
+	va_end(lenArgs);
+	if (len < 0) {
+		return; // LCOV_EXCL_LINE
+	}
+
+	size_t ofs = buf.size();
+	buf.resize(ofs + len + 1);
+	vsnprintf(&buf[ofs], len + 1, fmt, args);
+	buf.pop_back(); // Drop the terminating NUL
+}
+
+void StyleSink::flush() {
+	if (!buf.empty()) {
+		fwrite(buf.data(), 1, buf.size(), file);
+		buf.clear();
+	}
+}
@@ -19,7 +19,8 @@ bool checkVerbosity(Verbosity level) {
 // LCOV_EXCL_START
 
 void incrementVerbosity() {
-	if (verbosity < VERB_VVVVVV) {
+	// Clamp at the compile-time cap, so runtime checks agree with the stripped-out calls
+	if (verbosity < RGBDS_MAX_VERBOSITY) {
 		verbosity = static_cast<Verbosity>(verbosity + 1);
 	}
 }
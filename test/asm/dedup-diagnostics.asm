@@ -0,0 +1,7 @@
+SECTION "test", ROM0
+
+charmap "a", 1
+
+FOR I, 5
+	db "x"
+ENDR
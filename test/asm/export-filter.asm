@@ -0,0 +1,11 @@
+OPT x
+
+; The section floats so that `dw Referenced` becomes a patch instead of constant-folding
+SECTION "test", ROM0
+Exported::
+	db 1
+Referenced:
+	db 2
+Unreferenced:
+	db 3
+	dw Referenced
@@ -194,6 +194,175 @@ for variant in '' '.pipe'; do
 	fi
 done
 
+i="object-cache"
+variant=
+(( tests++ ))
+echo "${bold}${green}${i}...${rescolors}${resbold}"
+cachedir="$(mktemp -d)"
+srcdir="$(mktemp -d)"
+our_rc=0
+cat >"$srcdir"/inc.inc <<EOF
+SECTION "data", ROM0
+	db 42
+EOF
+cat >"$srcdir"/a.asm <<EOF
+INCLUDE "inc.inc"
+SECTION "code", ROM0
+	nop
+EOF
+# A cold cache must miss, then store an entry
+"$RGBASM" -v -v --cache "$cachedir" -I "$srcdir" -o "$o" "$srcdir"/a.asm 2>"$errput"
+if grep -q 'Replayed cached object' "$errput"; then
+	echo "${bold}${red}${i}: unexpected hit on a cold cache!${rescolors}${resbold}"
+	our_rc=1
+fi
+cp "$o" "$gb"
+# An unchanged input closure must replay the stored object byte for byte
+"$RGBASM" -v -v --cache "$cachedir" -I "$srcdir" -o "$o" "$srcdir"/a.asm 2>"$errput"
+if ! grep -q 'Replayed cached object' "$errput"; then
+	echo "${bold}${red}${i}: expected a hit on an unchanged input!${rescolors}${resbold}"
+	our_rc=1
+fi
+tryCmp "$gb" "$o" o
+(( our_rc = our_rc || $? ))
+# Editing an included file must invalidate the entry
+cat >"$srcdir"/inc.inc <<EOF
+SECTION "data", ROM0
+	db 43
+EOF
+"$RGBASM" -v -v --cache "$cachedir" -I "$srcdir" -o "$o" "$srcdir"/a.asm 2>"$errput"
+if grep -q 'Replayed cached object' "$errput"; then
+	echo "${bold}${red}${i}: expected a miss after editing an include!${rescolors}${resbold}"
+	our_rc=1
+fi
+# An object whose assembly used a timestamp built-in must never be cached
+cat >"$srcdir"/ts.asm <<EOF
+SECTION "ts", ROM0
+	db STRLEN("{__ISO_8601_UTC__}")
+EOF
+"$RGBASM" -v -v --cache "$cachedir" -o "$o" "$srcdir"/ts.asm 2>"$errput"
+"$RGBASM" -v -v --cache "$cachedir" -o "$o" "$srcdir"/ts.asm 2>"$errput"
+if grep -q 'Replayed cached object' "$errput"; then
+	echo "${bold}${red}${i}: an object that used a timestamp built-in was cached!${rescolors}${resbold}"
+	our_rc=1
+fi
+rm -rf "$cachedir" "$srcdir"
+(( rc = rc || our_rc ))
+if [[ $our_rc -ne 0 ]]; then
+	(( failed++ ))
+fi
+
+i="token-stream-cache"
+(( tests++ ))
+echo "${bold}${green}${i}...${rescolors}${resbold}"
+cachedir="$(mktemp -d)"
+srcdir="$(mktemp -d)"
+our_rc=0
+cat >"$srcdir"/hdr.inc <<EOF
+MACRO emit_byte
+	db \1 + CONST_BASE
+ENDM
+DEF CONST_BASE EQU 16
+EOF
+cat >"$srcdir"/a.asm <<EOF
+INCLUDE "hdr.inc"
+SECTION "a", ROM0
+	emit_byte 1
+EOF
+cat >"$srcdir"/b.asm <<EOF
+INCLUDE "hdr.inc"
+SECTION "b", ROM0
+	emit_byte 2
+	emit_byte 3
+EOF
+# Reference object, assembled without any cache
+"$RGBASM" -I "$srcdir" -o "$gb" "$srcdir"/b.asm
+# A cold run must store token streams for the files it lexed
+"$RGBASM" --cache "$cachedir" -I "$srcdir" -o "$o" "$srcdir"/a.asm
+if ! ls "$cachedir"/*.lex >/dev/null 2>&1; then
+	echo "${bold}${red}${i}: no token stream was stored on a cold run!${rescolors}${resbold}"
+	our_rc=1
+fi
+# A warm run replays the shared header's stream, and must produce identical output
+"$RGBASM" --cache "$cachedir" -I "$srcdir" -o "$o" "$srcdir"/b.asm
+tryCmp "$gb" "$o" o
+(( our_rc = our_rc || $? ))
+# Corrupted and truncated blobs must be ignored, falling back to re-lexing
+rm -f "$cachedir"/*.d "$cachedir"/*.o
+for blob in "$cachedir"/*.lex; do
+	dd if=/dev/urandom of="$blob" bs=1 count="$(wc -c <"$blob")" conv=notrunc 2>/dev/null
+done
+"$RGBASM" --cache "$cachedir" -I "$srcdir" -o "$o" "$srcdir"/b.asm
+tryCmp "$gb" "$o" o
+(( our_rc = our_rc || $? ))
+rm -f "$cachedir"/*.d "$cachedir"/*.o
+"$RGBASM" --cache "$cachedir" -I "$srcdir" -o "$o" "$srcdir"/a.asm # Store fresh blobs
+for blob in "$cachedir"/*.lex; do
+	head -c 10 "$blob" >"$blob".trunc && mv "$blob".trunc "$blob"
+done
+rm -f "$cachedir"/*.d "$cachedir"/*.o
+"$RGBASM" --cache "$cachedir" -I "$srcdir" -o "$o" "$srcdir"/b.asm
+tryCmp "$gb" "$o" o
+(( our_rc = our_rc || $? ))
+rm -rf "$cachedir" "$srcdir"
+(( rc = rc || our_rc ))
+if [[ $our_rc -ne 0 ]]; then
+	(( failed++ ))
+fi
+
+i="batch"
+(( tests++ ))
+echo "${bold}${green}${i}...${rescolors}${resbold}"
+srcdir="$(mktemp -d)"
+our_rc=0
+cat >"$srcdir"/good1.asm <<EOF
+SECTION "one", ROM0
+	db 1
+EOF
+cat >"$srcdir"/bad.asm <<EOF
+this is not a valid line
+EOF
+cat >"$srcdir"/good2.asm <<EOF
+SECTION "two", ROM0
+	db 2
+EOF
+cat >"$srcdir"/list <<EOF
+# Batch list; one input per line
+$srcdir/good1.asm
+$srcdir/bad.asm
+$srcdir/good2.asm
+EOF
+# One failing file must not stop the batch, but must fail the invocation
+if "$RGBASM" @"$srcdir"/list 2>"$errput"; then
+	echo "${bold}${red}${i}: a failing input did not fail the batch!${rescolors}${resbold}"
+	our_rc=1
+fi
+if ! grep -q 'Failed to assemble 1 of 3 files' "$errput"; then
+	echo "${bold}${red}${i}: unexpected batch summary!${rescolors}${resbold}"
+	cat "$errput"
+	our_rc=1
+fi
+if [[ -e "$srcdir"/bad.o ]]; then
+	echo "${bold}${red}${i}: the failing input produced an object!${rescolors}${resbold}"
+	our_rc=1
+fi
+# The other inputs must still come out, identical to single-file assemblies
+for good in good1 good2; do
+	"$RGBASM" -o "$o" "$srcdir"/$good.asm
+	if [[ ! -e "$srcdir"/$good.o ]]; then
+		echo "${bold}${red}${i}: ${good}.o was not produced!${rescolors}${resbold}"
+		our_rc=1
+	else
+		tryCmp "$o" "$srcdir"/$good.o o
+		(( our_rc = our_rc || $? ))
+	fi
+done
+rm -rf "$srcdir"
+(( rc = rc || our_rc ))
+if [[ $our_rc -ne 0 ]]; then
+	(( failed++ ))
+fi
+
 if [[ "$failed" -eq 0 ]]; then
 	echo "${bold}${green}All ${tests} tests passed!${rescolors}${resbold}"
 else
@@ -1 +1 @@
-opt x ; there is no opt x
+opt z ; there is no opt z
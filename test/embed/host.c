@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: MIT
+
+// Small C host for the embedding API (see include/embed.hpp): assembles two sources that
+// reference each other, links them, checks the ROM bytes, then verifies that a failing
+// input neither takes the host down nor poisons later calls.
+
+#include "embed.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char const *mainSource =
+    "SECTION \"main\", ROM0[0]\n"
+    "Main::\n"
+    "\tcall Helper\n"
+    "\tdb 1\n";
+static char const *helperSource =
+    "SECTION \"helper\", ROM0[$100]\n"
+    "Helper::\n"
+    "\tret\n";
+
+static int failed = 0;
+
+static void check(int ok, char const *what) {
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failed = 1;
+	}
+}
+
+// Assembles and links the two sources, storing the ROM into `*rom`/`*romSize`;
+// returns 0 on success
+static int buildRom(unsigned char **rom, size_t *romSize) {
+	unsigned char *objects[2] = {NULL, NULL};
+	size_t objectSizes[2] = {0, 0};
+	int rc = rgbasm_assemble("main.asm", mainSource, strlen(mainSource), &objects[0],
+	                         &objectSizes[0]);
+	check(rc == 0, "assembling main.asm");
+	if (rc == 0) {
+		rc = rgbasm_assemble("helper.asm", helperSource, strlen(helperSource), &objects[1],
+		                     &objectSizes[1]);
+		check(rc == 0, "assembling helper.asm");
+	}
+	if (rc == 0) {
+		RGBDSObjectBuffer bufs[2] = {
+		    {"main.o",   objects[0], objectSizes[0]},
+		    {"helper.o", objects[1], objectSizes[1]},
+		};
+		rc = rgblink_link(bufs, 2, rom, romSize);
+		check(rc == 0, "linking");
+	}
+	rgbds_free(objects[0]);
+	rgbds_free(objects[1]);
+	return rc;
+}
+
+int main(void) {
+	// A full assemble-and-link round trip must produce the expected ROM bytes
+	unsigned char *rom = NULL;
+	size_t romSize = 0;
+	if (buildRom(&rom, &romSize) != 0) {
+		return 1;
+	}
+	check(romSize >= 0x101, "ROM size");
+	check(romSize >= 3 && rom[0] == 0xCD && rom[1] == 0x00 && rom[2] == 0x01,
+	      "`call Helper` bytes");
+	check(romSize >= 0x101 && rom[0x100] == 0xC9, "`ret` byte");
+
+	// A source that does not assemble must report failure without producing an object
+	char const *badSource = "this is not a valid line\n";
+	unsigned char *badObject = NULL;
+	size_t badObjectSize = 0;
+	check(rgbasm_assemble("bad.asm", badSource, strlen(badSource), &badObject,
+	                      &badObjectSize) != 0,
+	      "assembling bad.asm must fail");
+	check(badObject == NULL && badObjectSize == 0, "no object for bad.asm");
+
+	// An object referencing an undefined symbol must fail to link
+	char const *danglingSource = "SECTION \"dangling\", ROM0\n\tdw UndefinedSym\n";
+	unsigned char *danglingObject = NULL;
+	size_t danglingObjectSize = 0;
+	check(rgbasm_assemble("dangling.asm", danglingSource, strlen(danglingSource),
+	                      &danglingObject, &danglingObjectSize) == 0,
+	      "assembling dangling.asm");
+	RGBDSObjectBuffer danglingBuf = {"dangling.o", danglingObject, danglingObjectSize};
+	unsigned char *badRom = NULL;
+	size_t badRomSize = 0;
+	check(rgblink_link(&danglingBuf, 1, &badRom, &badRomSize) != 0,
+	      "linking dangling.o must fail");
+	check(badRom == NULL && badRomSize == 0, "no ROM for dangling.o");
+	rgbds_free(danglingObject);
+
+	// The failures above must not poison later calls: the same build must still succeed,
+	// with identical output
+	unsigned char *rom2 = NULL;
+	size_t romSize2 = 0;
+	if (buildRom(&rom2, &romSize2) == 0) {
+		check(romSize2 == romSize && memcmp(rom, rom2, romSize) == 0,
+		      "rebuilt ROM differs from the first one");
+	} else {
+		failed = 1;
+	}
+	rgbds_free(rom);
+	rgbds_free(rom2);
+
+	return failed;
+}
@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+
+export LC_ALL=C
+
+# Game Boy release date, 1989-04-21T12:34:56Z (for reproducible test results)
+export SOURCE_DATE_EPOCH=609165296
+
+errput="$(mktemp)"
+
+# Immediate expansion is the desired behavior.
+# shellcheck disable=SC2064
+trap "rm -f ${errput@Q}" EXIT
+
+bold="$(tput bold)"
+resbold="$(tput sgr0)"
+red="$(tput setaf 1)"
+green="$(tput setaf 2)"
+orange="$(tput setaf 3)"
+rescolors="$(tput op)"
+
+# The host is only built by the CMake build (the libraries it links are not part of the
+# default targets), and the API requires `fork`
+if [[ ! -x ./embed_host ]]; then
+	echo "${bold}${orange}Warning: cannot run embedding test! (embed_host is not built)${rescolors}${resbold}"
+	exit 0
+fi
+
+echo "${bold}${green}embed...${rescolors}${resbold}"
+# The intentionally-failing inputs print diagnostics on stderr; only show them on failure
+if ./embed_host 2>"$errput"; then
+	echo "${bold}${green}The embedding test passed!${rescolors}${resbold}"
+else
+	cat "$errput"
+	echo "${bold}${red}The embedding test failed!${rescolors}${resbold}"
+	exit 1
+fi
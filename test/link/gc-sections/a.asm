@@ -0,0 +1,21 @@
+SECTION "root", ROM0[$0]
+	call Used
+	; "assert-kept" is only reachable through this assertion's expression
+	ASSERT AssertKept < $4000
+
+SECTION "used", ROM0
+Used::
+	call Chained
+	db "USEDMARK"
+
+SECTION "chained", ROM0
+Chained::
+	ret
+	db "CHAINMARK"
+
+SECTION "assert-kept", ROM0
+AssertKept::
+	db "ASSERTMARK"
+
+SECTION "unused", ROM0
+	db "UNUSEDMARK"
@@ -0,0 +1,11 @@
+SECTION "packed", ROM0
+Data::
+	; The compressed stream opens with these bytes as plain literals, letting the test
+	; locate the surrounding length and offset fields without parsing the container
+	db "Lz4StreamMarker!"
+	ds 300, $AA ; Long enough to need extended match lengths
+	db 1, 2, 4, 8, 16, 32, 64, 128, 3, 5, 7, 11, 13, 17, 19, 23
+	ds 20, $BB
+
+SECTION "tiny", ROM0
+	db 1, 2, 3 ; Too small to be worth compressing; must round-trip as-is
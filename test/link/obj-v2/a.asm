@@ -0,0 +1,18 @@
+SECTION "header", ROM0[$100]
+	jp Main
+
+SECTION "main", ROM0
+Main::
+	call Helper
+	ld a, BANK(Helper)
+	ld hl, wCounter
+.loop
+	jr .loop
+REPT 4
+	db $42
+ENDR
+
+SECTION "wram", WRAM0
+wCounter:: db
+
+ASSERT Main < $4000
@@ -0,0 +1,10 @@
+SECTION "helper", ROM0
+Helper::
+	ld hl, wCounter
+	inc [hl]
+	ret
+	ds 32, $FE
+
+SECTION "bank data", ROMX, BANK[2]
+	db BANK(@)
+	dw Main
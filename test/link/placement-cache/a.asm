@@ -0,0 +1,11 @@
+SECTION "fixed", ROM0[$0]
+	db $F0, $0D
+
+SECTION "aligned", ROM0, ALIGN[8]
+	ds 32, $A5
+
+SECTION "floating", ROM0
+	db "floating data"
+
+SECTION "banked", ROMX, BANK[2]
+	ds 16, $B2
@@ -0,0 +1,13 @@
+; Same sections as a.asm, except "floating" grew: its cached placement no longer matches
+; the section's constraints and must be rejected, while the others are still reusable
+SECTION "fixed", ROM0[$0]
+	db $F0, $0D
+
+SECTION "aligned", ROM0, ALIGN[8]
+	ds 32, $A5
+
+SECTION "floating", ROM0
+	db "floating data, now longer than before"
+
+SECTION "banked", ROMX, BANK[2]
+	ds 16, $B2
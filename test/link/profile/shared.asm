@@ -0,0 +1,5 @@
+SECTION "shared", ROM0[$0]
+	db $11, $22, $33
+	; Shared code may reference a symbol that each variant defines differently
+	dw Greeting
+	call Greeting
@@ -0,0 +1,4 @@
+SECTION "greeting", ROM0[$200]
+Greeting::
+	ld a, $AA
+	ret
@@ -0,0 +1,7 @@
+SECTION "greeting", ROM0[$200]
+Greeting::
+	ld a, $BB
+	ret
+
+SECTION "extra", ROM0
+	db "only in v2"
@@ -174,6 +174,33 @@ for test in fragment-align/*; do
 	evaluateTest
 done
 
+test="gc-sections"
+startTest
+"$RGBASM" -o "$otemp" "$test"/a.asm
+continueTest
+# Without -g, every section is placed
+rgblinkQuiet -o "$gbtemp" "$otemp"
+for marker in USEDMARK CHAINMARK ASSERTMARK UNUSEDMARK; do
+	if ! grep -aq "$marker" "$gbtemp"; then
+		echo "${bold}${red}${test}: ${marker} missing from the un-collected ROM!${rescolors}${resbold}"
+		our_rc=1
+	fi
+done
+# With -g, the fixed-address root, everything it references (transitively), and the
+# assertion's target survive; the unreferenced section is discarded
+rgblinkQuiet -g -o "$gbtemp" "$otemp"
+for marker in USEDMARK CHAINMARK ASSERTMARK; do
+	if ! grep -aq "$marker" "$gbtemp"; then
+		echo "${bold}${red}${test}: ${marker} was wrongly discarded!${rescolors}${resbold}"
+		our_rc=1
+	fi
+done
+if grep -aq UNUSEDMARK "$gbtemp"; then
+	echo "${bold}${red}${test}: the unreferenced section was not discarded!${rescolors}${resbold}"
+	our_rc=1
+fi
+evaluateTest
+
 test="high-low"
 startTest
 "$RGBASM" -o "$otemp" "$test"/a.asm
@@ -214,6 +241,49 @@ tryDiff "$test"/ref.out.map "$outtemp3"
 tryDiff "$test"/ref.out.sym "$gbtemp2"
 evaluateTest
 
+test="lz4"
+startTest
+"$RGBASM" -o "$otemp" "$test"/a.asm
+continueTest " round-trip"
+rgblinkQuiet -o "$gbtemp" "$otemp"
+"$RGBASM" --obj-compress -o "$otemp" "$test"/a.asm
+rgblinkQuiet -o "$gbtemp2" "$otemp"
+tryCmp "$gbtemp" "$gbtemp2"
+evaluateTest
+
+continueTest " rejection"
+# The packed stream's first sequence carries the 16-byte marker as literals (plus one run
+# byte), so its fields can be located without parsing the container: the extended
+# literal-length byte sits right before the marker, and the 2-byte match offset right
+# after the literals
+marker_ofs="$(grep -abo 'Lz4StreamMarker!' "$otemp" | head -n1 | cut -d: -f1)"
+# A match offset pointing before the start of the output must be rejected
+cp "$otemp" "$gbtemp2"
+printf '\xff\xff' | dd of="$gbtemp2" bs=1 seek=$((marker_ofs + 17)) conv=notrunc 2>/dev/null
+if "$RGBLINK" -o "$gbtemp" "$gbtemp2" 2>"$outtemp"; then
+	echo "${bold}${red}${test}: wild match offset was not rejected!${rescolors}${resbold}"
+	our_rc=1
+fi
+if ! grep -q 'Invalid compressed data' "$outtemp"; then
+	echo "${bold}${red}${test}: unexpected corruption diagnostic!${rescolors}${resbold}"
+	cat "$outtemp"
+	our_rc=1
+fi
+# A literal run claiming more bytes than the stream holds (i.e. a truncated stream) must
+# be rejected rather than read out of bounds
+cp "$otemp" "$gbtemp2"
+printf '\xfa' | dd of="$gbtemp2" bs=1 seek=$((marker_ofs - 1)) conv=notrunc 2>/dev/null
+if "$RGBLINK" -o "$gbtemp" "$gbtemp2" 2>"$outtemp"; then
+	echo "${bold}${red}${test}: truncated stream was not rejected!${rescolors}${resbold}"
+	our_rc=1
+fi
+if ! grep -q 'Invalid compressed data' "$outtemp"; then
+	echo "${bold}${red}${test}: unexpected truncation diagnostic!${rescolors}${resbold}"
+	cat "$outtemp"
+	our_rc=1
+fi
+evaluateTest
+
 test="map-file"
 startTest
 "$RGBASM" -o "$otemp" "$test"/a.asm
@@ -224,6 +294,50 @@ tryDiff "$test"/ref.out.map "$outtemp2"
 tryCmpRom "$test"/ref.out.bin
 evaluateTest
 
+test="obj-v2"
+startTest
+"$RGBASM" -o "$otemp" "$test"/a.asm
+"$RGBASM" -o "$gbtemp2" "$test"/b.asm
+continueTest " parity"
+rgblinkQuiet -o "$gbtemp" "$otemp" "$gbtemp2"
+cp "$gbtemp" "$outtemp2"
+# The v2 container (compressed or not) must link to the same ROM as the v1 objects
+for flag in --obj-v2 --obj-compress; do
+	"$RGBASM" "$flag" -o "$otemp" "$test"/a.asm
+	"$RGBASM" "$flag" -o "$gbtemp2" "$test"/b.asm
+	rgblinkQuiet -o "$gbtemp" "$otemp" "$gbtemp2"
+	tryCmp "$outtemp2" "$gbtemp"
+done
+evaluateTest
+
+continueTest " rejection"
+"$RGBASM" --obj-v2 -o "$otemp" "$test"/a.asm
+# Point the string table (table of contents slot 0, right after the magic and revision)
+# past the end of the file
+cp "$otemp" "$gbtemp2"
+printf '\xff\xff\xff\xff' | dd of="$gbtemp2" bs=1 seek=8 conv=notrunc 2>/dev/null
+if "$RGBLINK" -o "$gbtemp" "$gbtemp2" 2>"$outtemp"; then
+	echo "${bold}${red}${test}: corrupted table of contents was not rejected!${rescolors}${resbold}"
+	our_rc=1
+fi
+if ! grep -q 'String table extends past the end of the file' "$outtemp"; then
+	echo "${bold}${red}${test}: unexpected corruption diagnostic!${rescolors}${resbold}"
+	cat "$outtemp"
+	our_rc=1
+fi
+# A file cut short in the middle of the table of contents must be rejected too
+head -c 40 "$otemp" >"$gbtemp2"
+if "$RGBLINK" -o "$gbtemp" "$gbtemp2" 2>"$outtemp"; then
+	echo "${bold}${red}${test}: truncated object was not rejected!${rescolors}${resbold}"
+	our_rc=1
+fi
+if ! grep -q 'Unexpected end of file' "$outtemp"; then
+	echo "${bold}${red}${test}: unexpected truncation diagnostic!${rescolors}${resbold}"
+	cat "$outtemp"
+	our_rc=1
+fi
+evaluateTest
+
 test="overlay/smaller"
 startTest
 "$RGBASM" -o "$otemp" "$test"/a.asm
@@ -262,6 +376,59 @@ continueTest
 tryCmp "$test"/out.gb "$gbtemp"
 evaluateTest
 
+test="placement-cache"
+startTest
+"$RGBASM" -o "$otemp" "$test"/a.asm
+"$RGBASM" -o "$outtemp3" "$test"/a2.asm
+cachetemp="$(mktemp)"
+rm -f "$cachetemp" # The first cached link must cope with the file not existing yet
+continueTest
+rgblinkQuiet -o "$gbtemp" "$otemp"
+rgblinkQuiet -o "$gbtemp2" --placement-cache "$cachetemp" "$otemp"
+tryCmp "$gbtemp" "$gbtemp2"
+# Relinking with the cache it just wrote must reproduce the same ROM
+rgblinkQuiet -o "$gbtemp2" --placement-cache "$cachetemp" "$otemp"
+tryCmp "$gbtemp" "$gbtemp2"
+# A section whose constraints changed must have its cached placement rejected, falling
+# back to a normal placement
+rgblinkQuiet -o "$gbtemp" "$outtemp3"
+rgblinkQuiet -o "$gbtemp2" --placement-cache "$cachetemp" "$outtemp3"
+tryCmp "$gbtemp" "$gbtemp2"
+# Options that influence placement invalidate the whole cache
+rgblinkQuiet -o "$gbtemp" -d "$otemp"
+rgblinkQuiet -o "$gbtemp2" -d --placement-cache "$cachetemp" "$otemp"
+tryCmp "$gbtemp" "$gbtemp2"
+# A corrupted cache is ignored with a warning, not trusted
+printf 'garbage\n' >"$cachetemp"
+rgblinkQuiet -o "$gbtemp2" --placement-cache "$cachetemp" "$otemp" 2>"$outtemp"
+if ! grep -q 'bad header' "$outtemp"; then
+	echo "${bold}${red}${test}: corrupted cache was not diagnosed!${rescolors}${resbold}"
+	our_rc=1
+fi
+rgblinkQuiet -o "$gbtemp" "$otemp"
+tryCmp "$gbtemp" "$gbtemp2"
+rm -f "$cachetemp"
+evaluateTest
+
+test="profile"
+startTest
+"$RGBASM" -o "$outtemp" "$test"/shared.asm
+"$RGBASM" -o "$outtemp2" "$test"/v1.asm
+"$RGBASM" -o "$outtemp3" "$test"/v2.asm
+continueTest
+# One invocation emits both variants; each must match a plain single-variant link, which
+# covers both the shared bytes and each variant's own
+rgblinkQuiet --profile o="$gbtemp","$outtemp2" --profile o="$gbtemp2","$outtemp3" "$outtemp"
+"$RGBLINK" -o "$otemp" "$outtemp" "$outtemp2"
+tryCmp "$otemp" "$gbtemp"
+"$RGBLINK" -o "$otemp" "$outtemp" "$outtemp3"
+tryCmp "$otemp" "$gbtemp2"
+if cmp -s "$gbtemp" "$gbtemp2"; then
+	echo "${bold}${red}${test}: the two variants came out identical!${rescolors}${resbold}"
+	our_rc=1
+fi
+evaluateTest
+
 test="same-consts"
 startTest
 "$RGBASM" -o "$otemp" "$test"/a.asm
@@ -309,6 +476,17 @@ tryDiff "$test"/ref.out.sym "$outtemp2"
 tryCmpRom "$test"/ref.out.bin
 evaluateTest
 
+test="sdcc/library"
+startTest
+"$RGBASM" -o "$otemp" "$test"/a.asm
+continueTest
+# `lib.lib` archives b.rel and c.rel (only those should be loaded) plus an unused member
+rgblinkQuiet -o "$gbtemp" -n "$outtemp2" -l "$test"/script.link "$otemp" "$test"/lib.lib 2>"$outtemp"
+tryDiff "$test"/out.err "$outtemp"
+tryDiff "$test"/ref.out.sym "$outtemp2"
+tryCmpRom "$test"/ref.out.bin
+evaluateTest
+
 test="sdcc/no-script"
 startTest
 "$RGBASM" -o "$otemp" "$test"/a.asm